@@ -5,4 +5,23 @@ glslc shaders/skybox.vert -o shaders/spv/skybox.vert.spv
 glslc shaders/skybox.frag -o shaders/spv/skybox.frag.spv
 
 glslc shaders/star.vert -o shaders/spv/star.vert.spv
-glslc shaders/star.frag -o shaders/spv/star.frag.spv
\ No newline at end of file
+glslc shaders/star.frag -o shaders/spv/star.frag.spv
+
+glslc shaders/depthPyramid.comp -o shaders/spv/depthPyramid.comp.spv
+glslc shaders/cull.comp -o shaders/spv/cull.comp.spv
+glslc shaders/lightCulling.comp -o shaders/spv/lightCulling.comp.spv
+glslc shaders/bloomDownsample.comp -o shaders/spv/bloomDownsample.comp.spv
+glslc shaders/bloomUpsample.comp -o shaders/spv/bloomUpsample.comp.spv
+glslc shaders/tonemap.comp -o shaders/spv/tonemap.comp.spv
+glslc --target-env=vulkan1.1 shaders/luminanceHistogram.comp -o shaders/spv/luminanceHistogram.comp.spv
+glslc shaders/luminanceAverage.comp -o shaders/spv/luminanceAverage.comp.spv
+
+glslc shaders/impostorBake.vert -o shaders/spv/impostorBake.vert.spv
+glslc shaders/impostorBake.frag -o shaders/spv/impostorBake.frag.spv
+glslc shaders/impostor.vert -o shaders/spv/impostor.vert.spv
+glslc shaders/impostor.frag -o shaders/spv/impostor.frag.spv
+
+glslc shaders/iblEnvironment.comp -o shaders/spv/iblEnvironment.comp.spv
+glslc shaders/iblIrradiance.comp -o shaders/spv/iblIrradiance.comp.spv
+glslc shaders/iblPrefilter.comp -o shaders/spv/iblPrefilter.comp.spv
+glslc shaders/iblBrdf.comp -o shaders/spv/iblBrdf.comp.spv
\ No newline at end of file
@@ -1,28 +1,40 @@
 #version 450
-layout(location = 0) out vec4 outFragColor;
-//layout(location = 1) out vec4 outBrightColor;
+layout(location = 0) out vec4 outFragColor;    // linear HDR, bloom is extracted from it by the post processing
 
 layout(location = 0) in vec2 inTexCoords;
 layout(location = 1) in vec3 inWorldPos;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec4 inPosLightSpace;
+layout(location = 4) in vec4 inTangent;
 
 // material parameters
 layout(set = 2, binding = 0) uniform sampler2D uAlbedoMap;
 layout(set = 2, binding = 1) uniform sampler2D uNormalMap;
-layout(set = 2, binding = 2) uniform sampler2D uMetallicMap;
-layout(set = 2, binding = 3) uniform sampler2D uRoughnessMap;
+layout(set = 2, binding = 2) uniform sampler2D uMetallicRoughnessMap;    // metallic in r, roughness in g
 // layout(set = 3, binding = 4) uniform sampler2D uShadowMap;
 
-const int MAX_LIGHTS = 2;
-
-layout(set = 1, binding = 0) uniform lightsUbo
-{
-	vec3 lightPositions[MAX_LIGHTS];
-	vec4 lightColors[MAX_LIGHTS];
-	float numberOfLights;
-} lights;
-
+struct PointLight {
+	vec4 positionRadius;    // camera relative position, radius
+	vec4 colorIntensity;
+};
+
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+
+// Written by lightCulling.comp
+layout(set = 1, binding = 0) uniform ClusterInfo {
+	mat4 view;
+	vec4 projection;    // P00, P11, near, far
+	vec4 slicing;       // depth slice scale and bias, screen width and height
+	uvec4 grid;         // x, y, z, light count
+} clusters;
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer LightGrid { uint lightCounts[]; };
+layout(std430, set = 1, binding = 3) readonly buffer LightIndices { uint lightIndices[]; };
+
+// Image based lighting from the skybox, precomputed by ImageBasedLighting
+layout(std430, set = 3, binding = 0) readonly buffer Irradiance { vec4 irradianceSH[9]; };    // already convolved with the cosine lobe
+layout(set = 3, binding = 1) uniform samplerCube uPrefilteredMap;                            // GGX prefiltered, roughness 0 to 1 over the mips
+layout(set = 3, binding = 2) uniform sampler2D uBrdfLut;                                     // scale and bias to F0 by NdotV and roughness
 
 const float PI = 3.14159265359;
 
@@ -59,21 +71,35 @@ const float PI = 3.14159265359;
 // }
 
 vec3 getNormalFromMap() {
-	vec3 tangentNormal = texture(uNormalMap, inTexCoords).xyz * 2.0 - 1.0;
-
-	vec3 Q1  = dFdx(inWorldPos);
-	vec3 Q2  = dFdy(inWorldPos);
-	vec2 st1 = dFdx(inTexCoords);
-	vec2 st2 = dFdy(inTexCoords);
+	// Only x and y are stored (BC5), z is always positive in tangent space
+	vec3 tangentNormal;
+	tangentNormal.xy = texture(uNormalMap, inTexCoords).xy * 2.0 - 1.0;
+	tangentNormal.z  = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
+	// Tangents are precomputed per vertex, re-orthogonalize them after interpolation
 	vec3 N   = normalize(inNormal);
-	vec3 T   = normalize(Q1 * st2.t - Q2 * st1.t);
-	vec3 B   = -normalize(cross(N, T));
+	vec3 T   = normalize(inTangent.xyz - N * dot(N, inTangent.xyz));
+	vec3 B   = cross(N, T) * inTangent.w;
 	mat3 TBN = mat3(T, B, N);
 
 	return normalize(TBN * tangentNormal);
 }
 
+// Index of the cluster the fragment falls into, the depth slices are exponential between near and far
+uint getCluster() {
+	float viewDepth = -(clusters.view * vec4(inWorldPos, 1.0)).z;
+	uint slice      = uint(clamp(log(viewDepth) * clusters.slicing.x + clusters.slicing.y, 0.0, float(clusters.grid.z - 1)));
+	uvec2 tile      = min(uvec2(gl_FragCoord.xy / clusters.slicing.zw * vec2(clusters.grid.xy)), clusters.grid.xy - 1);
+	return (slice * clusters.grid.y + tile.y) * clusters.grid.x + tile.x;
+}
+
+// Inverse square falloff windowed to reach zero at the light's radius
+float getAttenuation(float distance, float radius) {
+	float ratio  = distance / radius;
+	float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	return window * window / (distance * distance + 0.0001);
+}
+
 // Normal distribution
 // When the roughness is low (thus the surface is smooth), a highly
 // concentrated number of microfacets are aligned to halfway vectors over a small radius.
@@ -126,10 +152,31 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0) {
 	return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+// Same as fresnelSchlick, but rough surfaces reflect less at grazing angles. For the ambient light there is no single
+// half vector, so the normal is used.
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
+	return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+// Diffuse irradiance arriving around the normal
+vec3 getIrradiance(vec3 n) {
+	return irradianceSH[0].rgb * 0.282095
+	     + irradianceSH[1].rgb * 0.488603 * n.y
+	     + irradianceSH[2].rgb * 0.488603 * n.z
+	     + irradianceSH[3].rgb * 0.488603 * n.x
+	     + irradianceSH[4].rgb * 1.092548 * n.x * n.y
+	     + irradianceSH[5].rgb * 1.092548 * n.y * n.z
+	     + irradianceSH[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+	     + irradianceSH[7].rgb * 1.092548 * n.x * n.z
+	     + irradianceSH[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+}
+
 void main() {
-	vec3 albedo     = pow(texture(uAlbedoMap, inTexCoords).rgb, vec3(2.2));
-	float metallic   = texture(uMetallicMap, inTexCoords).r;
-	float roughness = texture(uRoughnessMap, inTexCoords).r;
+	// The albedo map has an sRGB format, the sampler already returns linear colors
+	vec3 albedo            = texture(uAlbedoMap, inTexCoords).rgb;
+	vec2 metallicRoughness = texture(uMetallicRoughnessMap, inTexCoords).rg;
+	float metallic         = metallicRoughness.r;
+	float roughness        = metallicRoughness.g;
 
 	vec3 normal  = getNormalFromMap();
 	vec3 viewDir = normalize(vec3(0.0, 0.0, 0.0) - inWorldPos); // {0.0, 0.0, 0.0} is camera position which is always zero
@@ -149,14 +196,18 @@ void main() {
 
 	//  ------------------------- reflectance equation ------------------------------
 	vec3 Lo = vec3(0.0);
-	for(int i = 0; i < lights.numberOfLights; ++i)    // loop over light sources in this case we have only one so this for loop isn't even needed
+	uint cluster    = getCluster();
+	uint lightCount = min(lightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+	for(uint i = 0; i < lightCount; ++i)    // only the lights that reach this fragment's cluster
 	{
+		PointLight light = lights[lightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+
 		// calculate per-light radiance
-		vec3 L            = normalize(lights.lightPositions[i] - inWorldPos);    // L = radiance
+		vec3 L            = normalize(light.positionRadius.xyz - inWorldPos);    // L = radiance
 		vec3 H            = normalize(viewDir + L);
-		float distance    = length(lights.lightPositions[i] - inWorldPos);
-		float attenuation = 1.0 / (distance * distance);
-		vec3 radiance     = (lights.lightColors[i].rgb * lights.lightColors[i].w);
+		float distance    = length(light.positionRadius.xyz - inWorldPos);
+		float attenuation = getAttenuation(distance, light.positionRadius.w);
+		vec3 radiance     = light.colorIntensity.rgb * light.colorIntensity.w * attenuation;
 
 		// Cook-Torrance BRDF
 		float NDF = DistributionGGX(normal, H, roughness);
@@ -181,22 +232,25 @@ void main() {
 		Lo += (diffuseFraction * albedo / PI + specular) * radiance * NdotL;
 	}
 
-	vec3 ambient = vec3(0.00) * albedo;
+	// ------------------------- ambient light from the skybox -----------------------
+	float NdotV          = max(dot(normal, viewDir), 0.0);
+	vec3 F               = fresnelSchlickRoughness(NdotV, F0, roughness);
+	vec3 diffuseFraction = (vec3(1.0) - F) * (1.0 - metallic);
+	vec3 diffuse         = max(getIrradiance(normal), 0.0) * albedo / PI;
+
+	// Split sum: the prefiltered environment times the BRDF's response to F0
+	vec3 reflection  = reflect(-viewDir, normal);
+	float maxLevel   = float(textureQueryLevels(uPrefilteredMap) - 1);
+	vec3 prefiltered = textureLod(uPrefilteredMap, reflection, roughness * maxLevel).rgb;
+	vec2 brdf        = texture(uBrdfLut, vec2(NdotV, roughness)).rg;
+	vec3 specular    = prefiltered * (F * brdf.x + brdf.y);
+
+	vec3 ambient = diffuseFraction * diffuse + specular;
 
 	vec3 color = ambient + Lo;
 
-	// color = color / (color + vec3(1.0));    // HDR note that we're doing hdr in hdr shader so no need to do it twice here
-	color = pow(color, vec3(1.0 / 2.2));    // gamma correction back to srgb
+	// The HDR target stays linear, tonemap.comp does the exposure and the gamma correction
 	//float shadow = 1.0 - isInShadow(inPosLightSpace);
 
 	outFragColor = vec4(color, 1.0);
-	// float brightness = dot(outFragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-	// if (brightness > 2.0)
-	// {
-	// 	outBrightColor = vec4(color, 1.0);
-	// }
-	// else
-	// {
-	// 	outBrightColor = vec4(0.0, 0.0, 0.0, 1.0);
-	// }
 }
\ No newline at end of file
@@ -1,12 +1,13 @@
 #version 450
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+layout(location = 0) in vec4 inPos;              // quantized to the model bounds, w is the tangent handedness (0 = -1, 1 = +1)
+layout(location = 1) in vec4 inNormalTangent;    // octahedral normal (xy) and tangent (zw)
 layout(location = 2) in vec2 inTexCoords;
 
 layout(location = 0) out vec2 outTexCoords;
 layout(location = 1) out vec3 outWorldPos;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec4 outPosLightSpace;
+layout(location = 4) out vec4 outTangent;
 
 layout(set = 0, binding = 0) uniform GlobalUbo
 {
@@ -20,10 +21,17 @@ layout(push_constant) uniform Push
 	mat4 normalMatrix;
 } push;
 
+vec3 octDecode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
 void main() {
 	outTexCoords = inTexCoords;
-	outWorldPos  = vec3(push.modelMatrix * vec4(inPos, 1.0));
-	outNormal    = mat3(push.normalMatrix) * inNormal;
+	outWorldPos  = vec3(push.modelMatrix * vec4(inPos.xyz, 1.0));
+	outNormal    = mat3(push.normalMatrix) * octDecode(inNormalTangent.xy);
+	outTangent   = vec4(mat3(push.normalMatrix) * octDecode(inNormalTangent.zw), inPos.w * 2.0 - 1.0);
 	outPosLightSpace = ubo.lightMatrix * vec4(outWorldPos, 1.0);
 
 	gl_Position = ubo.projectionView * vec4(outWorldPos, 1.0);
@@ -0,0 +1,80 @@
+#version 450
+layout(location = 0) out vec4 outFragColor;    // linear HDR like PBR.frag
+
+layout(location = 0) in vec2 inTexCoords;
+layout(location = 1) in vec3 inWorldPos;
+layout(location = 2) in vec4 inRotation;
+
+layout(set = 2, binding = 0) uniform sampler2D uAlbedoAtlas;
+layout(set = 2, binding = 1) uniform sampler2D uNormalAtlas;    // model space
+
+struct PointLight {
+	vec4 positionRadius;    // camera relative position, radius
+	vec4 colorIntensity;
+};
+
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+
+// Written by lightCulling.comp
+layout(set = 1, binding = 0) uniform ClusterInfo {
+	mat4 view;
+	vec4 projection;    // P00, P11, near, far
+	vec4 slicing;       // depth slice scale and bias, screen width and height
+	uvec4 grid;         // x, y, z, light count
+} clusters;
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer LightGrid { uint lightCounts[]; };
+layout(std430, set = 1, binding = 3) readonly buffer LightIndices { uint lightIndices[]; };
+
+layout(push_constant) uniform Push {
+	uint gridSize;
+	uint emissive;
+} push;
+
+const float PI = 3.14159265359;
+
+vec3 rotate(vec4 q, vec3 v) {
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+uint getCluster() {
+	float viewDepth = -(clusters.view * vec4(inWorldPos, 1.0)).z;
+	uint slice      = uint(clamp(log(viewDepth) * clusters.slicing.x + clusters.slicing.y, 0.0, float(clusters.grid.z - 1)));
+	uvec2 tile      = min(uvec2(gl_FragCoord.xy / clusters.slicing.zw * vec2(clusters.grid.xy)), clusters.grid.xy - 1);
+	return (slice * clusters.grid.y + tile.y) * clusters.grid.x + tile.x;
+}
+
+float getAttenuation(float distance, float radius) {
+	float ratio  = distance / radius;
+	float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	return window * window / (distance * distance + 0.0001);
+}
+
+void main() {
+	vec4 albedo = texture(uAlbedoAtlas, inTexCoords);
+	if(albedo.a < 0.5) discard;
+
+	if(push.emissive != 0) {
+		outFragColor = vec4(albedo.rgb, 1.0);
+		return;
+	}
+
+	// Only a few pixels big, diffuse lighting is all that is visible of the material at that size
+	vec3 normal = normalize(rotate(inRotation, texture(uNormalAtlas, inTexCoords).xyz * 2.0 - 1.0));
+
+	vec3 Lo         = vec3(0.0);
+	uint cluster    = getCluster();
+	uint lightCount = min(lightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+	for(uint i = 0; i < lightCount; ++i) {
+		PointLight light = lights[lightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+
+		vec3 L            = normalize(light.positionRadius.xyz - inWorldPos);
+		float distance    = length(light.positionRadius.xyz - inWorldPos);
+		float attenuation = getAttenuation(distance, light.positionRadius.w);
+		vec3 radiance     = light.colorIntensity.rgb * light.colorIntensity.w * attenuation;
+
+		Lo += albedo.rgb / PI * radiance * max(dot(normal, L), 0.0);
+	}
+
+	outFragColor = vec4(Lo, 1.0);
+}
@@ -0,0 +1,59 @@
+#version 450
+// Expands every instance into a quad facing the atlas frame closest to the direction the camera sees it from
+layout(location = 0) in vec4 inCenterRadius;    // camera relative
+layout(location = 1) in vec4 inRotation;        // quaternion, xyzw
+
+layout(location = 0) out vec2 outTexCoords;
+layout(location = 1) out vec3 outWorldPos;
+layout(location = 2) out vec4 outRotation;
+
+layout(set = 0, binding = 0) uniform GlobalUbo
+{
+    mat4 projectionView;
+	mat4 lightMatrix;
+} ubo;
+
+layout(push_constant) uniform Push {
+	uint gridSize;
+	uint emissive;
+} push;
+
+const vec2 CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+vec3 rotate(vec4 q, vec3 v) {
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+vec2 octEncode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return n.xy;
+}
+
+vec3 octDecode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+void main() {
+	vec3 center  = inCenterRadius.xyz;
+	float radius = inCenterRadius.w;
+
+	// Direction towards the camera in model space, the atlas frames were rendered from there
+	vec3 toCamera = rotate(vec4(-inRotation.xyz, inRotation.w), normalize(-center));
+	uvec2 cell    = min(uvec2((octEncode(toCamera) * 0.5 + 0.5) * float(push.gridSize)), uvec2(push.gridSize - 1));
+
+	// Same basis the frame was baked with (see FrameBasis in impostors.cpp)
+	vec3 forward   = octDecode((vec2(cell) + 0.5) / float(push.gridSize) * 2.0 - 1.0);
+	vec3 reference = abs(forward.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right     = normalize(cross(reference, forward));
+	vec3 up        = cross(forward, right);
+
+	vec2 corner  = CORNERS[gl_VertexIndex];
+	outWorldPos  = center + rotate(inRotation, right * corner.x + up * corner.y) * radius;
+	outTexCoords = (vec2(cell) + vec2(corner.x, -corner.y) * 0.5 + 0.5) / float(push.gridSize);
+	outRotation  = inRotation;
+
+	gl_Position = ubo.projectionView * vec4(outWorldPos, 1.0);
+}
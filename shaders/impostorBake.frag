@@ -0,0 +1,30 @@
+#version 450
+layout(location = 0) out vec4 outAlbedo;    // alpha marks the texels the model covers
+layout(location = 1) out vec4 outNormal;    // model space, scaled to 0..1
+
+layout(location = 0) in vec2 inTexCoords;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec4 inTangent;
+
+layout(set = 0, binding = 0) uniform sampler2D uAlbedoMap;
+layout(set = 0, binding = 1) uniform sampler2D uNormalMap;
+layout(set = 0, binding = 2) uniform sampler2D uMetallicRoughnessMap;
+
+// Same as PBR.frag, the normal map detail survives in the atlas
+vec3 getNormalFromMap() {
+	vec3 tangentNormal;
+	tangentNormal.xy = texture(uNormalMap, inTexCoords).xy * 2.0 - 1.0;
+	tangentNormal.z  = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+
+	vec3 N   = normalize(inNormal);
+	vec3 T   = normalize(inTangent.xyz - N * dot(N, inTangent.xyz));
+	vec3 B   = cross(N, T) * inTangent.w;
+	mat3 TBN = mat3(T, B, N);
+
+	return normalize(TBN * tangentNormal);
+}
+
+void main() {
+	outAlbedo = vec4(texture(uAlbedoMap, inTexCoords).rgb, 1.0);
+	outNormal = vec4(getNormalFromMap() * 0.5 + 0.5, 1.0);
+}
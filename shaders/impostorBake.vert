@@ -0,0 +1,35 @@
+#version 450
+// Renders a model into one frame of its impostor atlas. The orthographic projection fits the model's bounding sphere
+// into the frame, seen from `forward`.
+layout(location = 0) in vec4 inPos;              // quantized to the model bounds, w is the tangent handedness (0 = -1, 1 = +1)
+layout(location = 1) in vec4 inNormalTangent;    // octahedral normal (xy) and tangent (zw)
+layout(location = 2) in vec2 inTexCoords;
+
+layout(location = 0) out vec2 outTexCoords;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec4 outTangent;
+
+layout(push_constant) uniform Push {
+	mat4 dequantization;
+	vec4 right;      // w is the bounding radius
+	vec4 up;
+	vec4 forward;    // towards the viewer
+} push;
+
+vec3 octDecode(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+void main() {
+	vec3 position = vec3(push.dequantization * vec4(inPos.xyz, 1.0));
+	float radius  = push.right.w;
+
+	outTexCoords = inTexCoords;
+	outNormal    = octDecode(inNormalTangent.xy);
+	outTangent   = vec4(octDecode(inNormalTangent.zw), inPos.w * 2.0 - 1.0);
+
+	// Up is the top of the frame, clip space y points down. The nearest point of the sphere has depth 0
+	gl_Position = vec4(dot(position, push.right.xyz) / radius, -dot(position, push.up.xyz) / radius, 0.5 - 0.5 * dot(position, push.forward.xyz) / radius, 1.0);
+}
@@ -8,5 +8,7 @@ layout (location = 0) out vec4 outFragColor;
 
 void main() 
 {
-	outFragColor = texture(uSamplerCubeMap, inUVW) - vec4(0.7, 0.7, 0.7, 0.0);
+	// The cubemap holds sRGB values, the HDR target is linear
+	vec4 color   = texture(uSamplerCubeMap, inUVW) - vec4(0.7, 0.7, 0.7, 0.0);
+	outFragColor = vec4(pow(max(color.rgb, 0.0), vec3(2.2)), color.a);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #version 450
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inNormalTangent;
 layout(location = 2) in vec2 inTexCoord;
 
 layout (location = 0) out vec3 outUVW;
@@ -18,8 +18,9 @@ layout(push_constant) uniform Push
 
 void main() 
 {
-	outUVW = inPosition;
+	// The quantized position is only meaningful after the model matrix, the skybox is centered so the direction stays the same
+	vec4 positionWorld = push.modelMatrix * vec4(inPosition.xyz, 1.0);
+	outUVW             = positionWorld.xyz;
 
-	vec4 positionWorld = push.modelMatrix * vec4(inPosition, 1.0);
     gl_Position = ubo.projectionView * positionWorld;
 }
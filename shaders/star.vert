@@ -1,6 +1,6 @@
 #version 450
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec4 inNormalTangent;
 layout(location = 2) in vec2 inTexCoords;
 
 layout(location = 0) out vec2 outTexCoords;
@@ -18,6 +18,6 @@ layout(push_constant) uniform Push
 void main() 
 {
     outTexCoords = inTexCoords;
-    vec3 posWorld = vec3(push.modelMatrix * vec4(inPos, 1.0));
+    vec3 posWorld = vec3(push.modelMatrix * vec4(inPos.xyz, 1.0));
 	gl_Position = ubo.projectionView * vec4(posWorld, 1.0);
 }
\ No newline at end of file
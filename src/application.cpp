@@ -1,5 +1,8 @@
 #include "application.h"
 
+#include "profiler.h"
+#include "vulkan/uploadQueue.h"
+
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_core.h>
 
@@ -10,56 +13,49 @@
 #include "imgui/backends/imgui_impl_vulkan.h"
 #include "stbimage/stb_image.h"
 
+#include <algorithm>
 #include <array>
-#include <chrono>
 #include <future>
 #include <glm/glm.hpp>
 
-// Timer for benchmarking
-class Timer {
-public:
-	std::chrono::time_point<std::chrono::high_resolution_clock> m_Start, m_End;
-
-	Timer() { m_Start = std::chrono::high_resolution_clock::now(); }
-
-	~Timer() {
-		m_End           = std::chrono::high_resolution_clock::now();
-		double duration = (m_End - m_Start).count() / 1000.0;
-		std::cout << "Timer Took " << duration << "ms" << std::endl;
-	}
-};
-
 struct GlobalUbo {
 	glm::mat4 projectionView {1.0f};
 	glm::mat4 lightMatrix {1.0f};
 };
 
-static const uint32_t MAX_LIGHTS = 2;
-
-struct LightsUbo {
-	glm::vec3 lightPositions[MAX_LIGHTS];
-	alignas(16) glm::vec4 lightColors[MAX_LIGHTS];
-	float numberOfLights;
-};
-
-Application::Application() {
+Application::Application(Benchmark* benchmark, const SceneSettings& scene):
+	m_Window(benchmark ? benchmark->GetOptions().width : 1600, benchmark ? benchmark->GetOptions().height : 900, "Space Sim", benchmark != nullptr), m_Benchmark(benchmark) {
 	m_GlobalPool = DescriptorPool::Builder(m_Device)
 	                   .SetMaxSets((Swapchain::MAX_FRAMES_IN_FLIGHT) *100)
 	                   .SetPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
 	                   .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (Swapchain::MAX_FRAMES_IN_FLIGHT) *100)
+	                   .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4)
 	                   .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, (Swapchain::MAX_FRAMES_IN_FLIGHT) *100)    // one for each figure
 	                   .Build();
-	LoadGameObjects();
 
-	WindowInfo winInfo;
-	winInfo.windowPtr  = m_Window.GetGLFWwindow();
-	winInfo.windowSize = {m_Window.GetExtent().height, m_Window.GetExtent().width};
-	Input::Instantiate(winInfo);
-	Input::SetCallbacks();
-	glfwSetInputMode(m_Window.GetGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	/*
+        The game thread can be filling frame N+1 while the renderer still has MAX_FRAMES_IN_FLIGHT
+        frames queued, so the ring needs one region more than there are frames in flight before a
+        region is guaranteed to be free again.
+    */
+	m_UniformRing = std::make_unique<UniformRing>(m_Device, *m_GlobalPool, Swapchain::MAX_FRAMES_IN_FLIGHT + 1);
+
+	LoadGameObjects(scene);
+
+	if(!m_Window.IsHeadless()) {
+		WindowInfo winInfo;
+		winInfo.windowPtr  = m_Window.GetGLFWwindow();
+		winInfo.windowSize = {m_Window.GetExtent().height, m_Window.GetExtent().width};
+		Input::Instantiate(winInfo);
+		Input::SetCallbacks();
+		glfwSetInputMode(m_Window.GetGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 
 	//Renderer Creation
 	m_Renderer = std::make_unique<Renderer>(m_Window, m_Device, m_GlobalPool->GetDescriptorPool());
+
+	// Benchmark runs have to be comparable, they always render at the full resolution
+	if(m_Benchmark) m_Renderer->GetDynamicResolution().GetEnabled() = false;
 }
 
 Application::~Application() {}
@@ -67,21 +63,48 @@ Application::~Application() {}
 void Application::Start() {
 	Sync syncObj;
 
-	std::thread gameThread {[&]() { Run(syncObj); }};
+	std::thread gameThread {[&]() {
+		CpuProfiler::RegisterThread("Game");
+		Run(syncObj);
+	}};
 
-	std::thread renderThread {[&]() { Render(syncObj); }};
+	std::thread renderThread {[&]() {
+		CpuProfiler::RegisterThread("Render");
+		Render(syncObj);
+	}};
 
 	renderThread.join();
 	gameThread.join();
 }
 
 void Application::Render(Sync& syncObj) {
+	uint64_t lastFrameEnd  = CpuProfiler::Now();
+	uint64_t gpuFrameCount = 0;
+
 	while(!syncObj.stop) {
+		PROFILE_ZONE("Render frame");
+
 		std::unique_lock<std::mutex> lock(syncObj.mutex);
-		syncObj.conditionVar.wait(lock, [&]() { return syncObj.isGameLogicFinished; });
+		{
+			PROFILE_ZONE("Wait for game");
+			syncObj.conditionVar.wait(lock, [&]() { return syncObj.isGameLogicFinished; });
+		}
 		syncObj.isRenderingFinished = false;
 		// Pass RenderImgui function pointer because we need to render ImGui with valid command buffer and we don't have access to that from application
-		m_Renderer->Render(m_FrameInfoCopy, [this](VkCommandBuffer& commandBuffer) { RenderImGui(commandBuffer); });
+		m_Renderer->Render(m_FrameInfoCopy, [this](VkCommandBuffer& commandBuffer) {
+			if(m_Benchmark == nullptr) RenderImGui(commandBuffer);
+		});
+
+		if(m_Benchmark != nullptr) {
+			uint64_t now = CpuProfiler::Now();
+			if(m_MeasureFrameCopy) m_Benchmark->AddFrame(static_cast<float>(now - lastFrameEnd) * 1e-6f, m_Renderer->GetCpuFrameTime());
+			lastFrameEnd = now;
+
+			// Read back frames in flight later, so they belong to slightly earlier frames
+			GpuProfiler& profiler = m_Renderer->GetGpuProfiler();
+			if(m_MeasureFrameCopy && profiler.GetFrameCount() != gpuFrameCount) m_Benchmark->AddGpuTime(profiler.GetFrameTime());
+			gpuFrameCount = profiler.GetFrameCount();
+		}
 		syncObj.isGameLogicFinished = false;
 		syncObj.cpuFramesAhead--;
 		syncObj.conditionVar.notify_all();
@@ -93,78 +116,125 @@ void Application::Render(Sync& syncObj) {
 }
 
 void Application::Run(Sync& syncObj) {
-	// GLOBAL UBO
-	std::vector<Binding> globalUboBindings;
-	globalUboBindings.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, sizeof(GlobalUbo), 0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
-	std::vector<std::shared_ptr<Uniform>> globalUniforms;
-	for(int i = 0; i < Swapchain::MAX_FRAMES_IN_FLIGHT; i++) { globalUniforms.push_back(std::make_shared<Uniform>(m_Device, globalUboBindings, *m_GlobalPool)); }
-
 	// We could move that to renderer but maybe we'll want to change skybox from application side in the future
 	// SKYBOX UBO
 	std::vector<Binding> skyboxBindings;
 	skyboxBindings.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, m_Skybox.GetCubemap().GetCubeMapImageSampler(), m_Skybox.GetCubemap().GetCubeMapImageView(),
 	                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
 	Uniform skyboxUniform(m_Device, skyboxBindings, *m_GlobalPool);
-
-	// LIGHTS UBO
-	std::vector<Binding> LightBindings;
-	LightBindings.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(LightsUbo), 0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
-	Uniform LightsUniform(m_Device, LightBindings, *m_GlobalPool);
+	// Replaces the placeholder cubemap set above once the skybox is streamed in, the placeholder one stays alive since frames in flight may still use it
+	std::unique_ptr<Uniform> streamedSkyboxUniform;
 
 	// Frame Info struct creation
-	m_FrameInfo.skybox              = &m_Skybox;
-	m_FrameInfo.skyboxDescriptorSet = skyboxUniform.GetDescriptorSet();
-	m_FrameInfo.lightsDescriptorSet = LightsUniform.GetDescriptorSet();
+	m_FrameInfo.skybox               = &m_Skybox;
+	m_FrameInfo.skyboxDescriptorSet  = skyboxUniform.GetDescriptorSet();
+	m_FrameInfo.uniformDescriptorSet = m_UniformRing->GetDescriptorSet();
+	m_FrameInfo.gameObjects          = &m_GameObjects;
+	m_FrameInfo.stars                = &m_Stars;
+
+	double lastFrameTime = glfwGetTime();
 
 	// Main Loop
 	while(!m_Window.ShouldClose()) {
+		PROFILE_ZONE("Game frame");
+
+		// Without it the input is sampled first and the finished frame then waits for a free frame in flight, up to
+		// frames in flight times the GPU frame time. Waiting here instead, while the render thread is idle, lets the
+		// frame be submitted right after its input was sampled.
+		if(m_LowLatency.load(std::memory_order_relaxed)) {
+			PROFILE_ZONE("Wait for GPU");
+			std::unique_lock<std::mutex> lock(syncObj.mutex);
+			syncObj.conditionVar.wait(lock, [&]() { return syncObj.cpuFramesAhead < 1; });
+			m_Renderer->WaitForNextFrame();
+		}
+
+		double time           = m_Benchmark ? m_Benchmark->GetTime() : glfwGetTime();
+		m_FrameInfo.frameTime = static_cast<float>(time - lastFrameTime);
+		lastFrameTime         = time;
+
 		m_Spaceship->GetObjectTransform().rotation.x = m_SpaceshipRotationX;
 		m_Spaceship->GetObjectTransform().rotation.y = m_SpaceshipRotationY;
-		m_Spaceship->GetObjectTransform().rotation.z = glfwGetTime() * 10;
-		glfwPollEvents();
-		Input::ProcessInput();
+		m_Spaceship->GetObjectTransform().rotation.z = time * 10;
+		if(m_Benchmark) {
+			m_MeasureFrame        = m_Benchmark->NextFrame(m_Streamer.GetPendingCount() == 0);
+			m_FrameInfo.inputTime = CpuProfiler::Now();
+		}
+		else {
+			PROFILE_ZONE("Input");
+			glfwPollEvents();
+			Input::ProcessInput();
+			m_FrameInfo.inputTime = CpuProfiler::Now();
+		}
 
 		// Fill FrameInfo struct
-		int frameIndex                  = m_Renderer->GetFrameIndex();
-		m_FrameInfo.camera              = m_Camera;
-		m_FrameInfo.globalDescriptorSet = globalUniforms[frameIndex]->GetDescriptorSet();
-		m_FrameInfo.gameObjects         = m_GameObjects;
-		m_FrameInfo.stars               = m_Stars;
+		m_FrameInfo.camera = m_Camera;
 
 		Update(m_FrameInfo);
 
 		// Camera Update
-		Input::GetInput(m_Camera);
-		m_Camera.SetPerspective(45.0f, m_Renderer->GetAspectRatio(), 0.1f, 100.0f);
-		m_Camera.MoveCamera(Input::mouseX - m_Window.GetExtent().width / 2.0, Input::mouseY - m_Window.GetExtent().height / 2.0);
+		m_Camera.SetPerspective(45.0f, m_Renderer->GetAspectRatio(), 0.1f, m_FarPlane);
+		if(m_Benchmark) { m_Benchmark->UpdateCamera(m_Camera, m_Spaceship->GetObjectTransform().translation); }
+		else {
+			Input::GetInput(m_Camera);
+			m_Camera.MoveCamera(Input::mouseX - m_Window.GetExtent().width / 2.0, Input::mouseY - m_Window.GetExtent().height / 2.0);
+		}
 
-		// UBO update
+		// UBO update, everything goes to this frame's region of the uniform ring
+		m_UniformRing->BeginFrame();
 		{
 			{
 				// global ubo
 				GlobalUbo ubo {};
-				ubo.projectionView = m_Camera.GetProj() * m_Camera.GetView();
-				ubo.lightMatrix    = glm::mat4(1.0f);    // for now we don't need that
-				globalUniforms[frameIndex]->GetUboBuffer(0)->WriteToBuffer(&ubo);
-				globalUniforms[frameIndex]->GetUboBuffer(0)->Flush();
-			}
-			{
-				// lights ubo
-				LightsUbo ubo;
-				ubo.numberOfLights    = 1;
-				ubo.lightColors[0]    = {1.0, 1.0, 1.0, 20.0f};
-				ubo.lightPositions[0] = m_LightSphere->GetObjectTransform().translation - m_Camera.m_Translation;
-				LightsUniform.GetUboBuffer(0)->WriteToBuffer(&ubo);
-				LightsUniform.GetUboBuffer(0)->Flush();
+				ubo.projectionView          = m_Camera.GetProj() * m_Camera.GetView();
+				ubo.lightMatrix             = glm::mat4(1.0f);    // for now we don't need that
+				m_FrameInfo.globalUboOffset = m_UniformRing->Push(ubo);
 			}
 		}
 
+		m_FrameInfo.exposure = Input::exposure;
+
+		// Lights are binned into clusters by the renderer, their count is not limited by a uniform buffer
+		m_FrameInfo.lights.clear();
+		{
+			PointLight light {};
+			light.position  = m_LightSphere->GetObjectTransform().translation - m_Camera.m_Translation;
+			light.radius    = 100.0f;
+			light.color     = {1.0f, 1.0f, 1.0f};
+			light.intensity = 20.0f;
+			m_FrameInfo.lights.push_back(light);
+		}
+		for(const SceneLight& sceneLight : m_SceneLights) {
+			PointLight light = sceneLight.light;
+			light.position   = sceneLight.position - m_Camera.m_Translation;
+			m_FrameInfo.lights.push_back(light);
+		}
+
 		std::unique_lock<std::mutex> lock(syncObj.mutex);
-		syncObj.conditionVar.wait(lock, [&]() { return syncObj.cpuFramesAhead < 1; });
+		{
+			PROFILE_ZONE("Wait for render");
+			syncObj.conditionVar.wait(lock, [&]() { return syncObj.cpuFramesAhead < 1; });
+		}
+
+		PROFILE_ZONE("Streaming");
+
+		// The render thread is not recording while we hold the lock, so streamed in resources can be swapped in here.
+		// Assets only become ready in Update, so the model (and its dequantization) can't change halfway through a frame
+		m_Streamer.Update();
+		std::erase_if(m_StreamingObjects, [](const std::shared_ptr<Object>& object) { return object->UpdateStreaming(); });
+		if(!streamedSkyboxUniform && m_Skybox.IsCubemapReady()) {
+			skyboxBindings[0].sampler       = m_Skybox.GetCubemap().GetCubeMapImageSampler();
+			skyboxBindings[0].imageView     = m_Skybox.GetCubemap().GetCubeMapImageView();
+			streamedSkyboxUniform           = std::make_unique<Uniform>(m_Device, skyboxBindings, *m_GlobalPool);
+			m_FrameInfo.skyboxDescriptorSet = streamedSkyboxUniform->GetDescriptorSet();
+		}
+
 		syncObj.isGameLogicFinished = true;
 		m_FrameInfoCopy             = m_FrameInfo;
+		m_MeasureFrameCopy          = m_MeasureFrame;
 		syncObj.conditionVar.notify_all();
 		syncObj.cpuFramesAhead++;
+
+		if(m_Benchmark && m_Benchmark->IsFinished()) m_Window.Close();
 	}
 
 	std::unique_lock<std::mutex> lock(syncObj.mutex);
@@ -174,7 +244,8 @@ void Application::Run(Sync& syncObj) {
 	syncObj.conditionVar.notify_all();
 
 	syncObj.conditionVar.wait(lock, [&]() { return syncObj.canClose; });
-	vkDeviceWaitIdle(m_Device.GetDevice());
+	// The one wait of the teardown, the renderer's subsystems and the images destroyed after it don't wait themselves
+	m_Device.WaitIdle();
 }
 
 /**
@@ -182,11 +253,21 @@ void Application::Run(Sync& syncObj) {
  */
 void Application::Update(const FrameInfo& frameInfo) {}
 
-void Application::LoadGameObjects() {
+void Application::LoadGameObjects(const SceneSettings& scene) {
 	ObjectInfo objInfo;
 	objInfo.descriptorPool = m_GlobalPool.get();
 	objInfo.device         = &m_Device;
 	objInfo.sampler        = &m_Sampler;
+	objInfo.streamer       = &m_Streamer;
+
+	// Shared by every object whose textures are still loading
+	std::vector<Binding> placeholderBindings;
+	for(uint32_t i = 0; i < AssetStreamer::PLACEHOLDER_COUNT; i++) {
+		Image& image = m_Streamer.GetPlaceholderTexture(static_cast<AssetStreamer::PlaceholderTexture>(i));
+		placeholderBindings.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, m_Sampler.GetSampler(), image.GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+	}
+	m_PlaceholderMaterial       = std::make_unique<Uniform>(m_Device, placeholderBindings, *m_GlobalPool);
+	objInfo.placeholderMaterial = m_PlaceholderMaterial.get();
 
 	// ----------------- Object Creation -----------------------
 
@@ -208,9 +289,25 @@ void Application::LoadGameObjects() {
 		m_LightSphere            = std::make_shared<Object>(objInfo, objTransform, "../../assets/models/sphere.obj", "../../assets/textures/empty_roughness.jpg");
 		m_Stars.emplace(m_LightSphere->GetObjectID(), m_LightSphere);
 	}
+
+	if(scene.GetTotalCount() > 0) {
+		SceneGenerator generator(scene);
+		generator.Generate(objInfo, m_GameObjects, m_Stars, m_SceneLights);
+		m_FarPlane = std::max(m_FarPlane, static_cast<float>(generator.GetRadius() * 2.0));
+		std::cout << "generated " << scene.GetTotalCount() << " objects and lights with seed " << scene.seed << std::endl;
+	}
+
+	// Instances share the material of their prototype, it only has to be checked once
+	for(const Map* objects : {&m_GameObjects, &m_Stars}) {
+		for(const auto& [id, object] : *objects) {
+			if(!object->IsInstance()) m_StreamingObjects.push_back(object);
+		}
+	}
 }
 
 void Application::RenderImGui(VkCommandBuffer& commandBuffer) {
+	PROFILE_ZONE("ImGui");
+
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
@@ -222,8 +319,216 @@ void Application::RenderImGui(VkCommandBuffer& commandBuffer) {
 	ImGui::SliderFloat("Rotation y", &m_SpaceshipRotationY, 0.0f, 360.0f);
 	ImGui::SliderFloat("Rotation z", &m_SpaceshipRotationZ, 0.0f, 360.0f);
 
+	ImGui::Text("Mesh LOD");
+	ImGui::SliderFloat("Max pixel error", &m_Renderer->GetLodPixelError(), 0.0f, 16.0f);
+	ImGui::Text("Triangles: %u", m_Renderer->GetDrawnTriangleCount());
+
+	ImGui::Text("Impostors");
+	ImGui::SliderFloat("Max size (px)", &m_Renderer->GetImpostorPixelSize(), 0.0f, 128.0f);
+	ImGui::Text("Impostors: %u, atlases: %u", m_Renderer->GetImpostors().GetImpostorCount(), m_Renderer->GetImpostors().GetAtlasCount());
+
+	const OcclusionCuller& culler = m_Renderer->GetOcclusionCuller();
+	ImGui::Text("Occlusion culling");
+	ImGui::Text("Objects drawn: %u / %u", culler.GetDrawnObjectCount(), culler.GetObjectCount());
+	ImGui::Text("Lights: %u", m_Renderer->GetLightClusters().GetLightCount());
+
+	ImGui::Text("Post processing");
+	ImGui::Checkbox("Auto exposure", &m_Renderer->GetAutoExposureEnabled());
+	if(m_Renderer->GetAutoExposureEnabled()) {
+		ImGui::SliderFloat("Adaptation speed", &m_Renderer->GetExposureAdaptationSpeed(), 0.1f, 10.0f);
+	} else {
+		ImGui::SliderFloat("Exposure", &Input::exposure, 0.0f, 10.0f);
+	}
+	ImGui::SliderFloat("Bloom strength", &m_Renderer->GetBloomStrength(), 0.0f, 2.0f);
+
+	DynamicResolution& dynamicResolution = m_Renderer->GetDynamicResolution();
+	ImGui::Text("Dynamic resolution");
+	if(dynamicResolution.IsSupported()) {
+		ImGui::Checkbox("Enabled", &dynamicResolution.GetEnabled());
+		ImGui::SliderFloat("GPU budget (ms)", &dynamicResolution.GetFrameBudget(), 4.0f, 33.3f);
+		ImGui::SliderFloat("Min scale", &dynamicResolution.GetMinScale(), 0.25f, 1.0f);
+		ImGui::Text("GPU time: %.2f ms", dynamicResolution.GetGpuTime());
+	} else {
+		ImGui::Text("Not supported, no timestamps on the graphics queue");
+	}
+	ImGui::Text("Render resolution: %u x %u", m_Renderer->GetRenderExtent().width, m_Renderer->GetRenderExtent().height);
+
+	// Same order as VkPresentModeKHR
+	static const char* presentModes[] = {"Immediate", "Mailbox", "V-Sync (FIFO)", "FIFO relaxed"};
+
+	PresentSettings present = m_Renderer->GetPresentSettings();
+	int presentMode         = static_cast<int>(present.presentMode);
+	int imageCount          = static_cast<int>(present.imageCount);
+	int framesInFlight      = static_cast<int>(present.framesInFlight);
+	ImGui::Text("Presentation");
+	bool presentChanged = ImGui::Combo("Present mode", &presentMode, presentModes, IM_ARRAYSIZE(presentModes));
+	presentChanged |= ImGui::SliderInt("Swapchain images", &imageCount, 1, 4);
+	presentChanged |= ImGui::SliderInt("Frames in flight", &framesInFlight, 1, Swapchain::MAX_FRAMES_IN_FLIGHT);
+	if(presentChanged) {
+		present.presentMode    = static_cast<VkPresentModeKHR>(presentMode);
+		present.imageCount     = static_cast<uint32_t>(imageCount);
+		present.framesInFlight = static_cast<uint32_t>(framesInFlight);
+		m_Renderer->SetPresentSettings(present);
+	}
+	if(m_Renderer->GetPresentMode() != present.presentMode && m_Renderer->GetPresentMode() < IM_ARRAYSIZE(presentModes)) {
+		ImGui::Text("Not supported, using %s", presentModes[m_Renderer->GetPresentMode()]);
+	}
+	bool lowLatency = m_LowLatency.load(std::memory_order_relaxed);
+	if(ImGui::Checkbox("Low latency", &lowLatency)) m_LowLatency.store(lowLatency, std::memory_order_relaxed);
+
+	if(m_Streamer.GetPendingCount() > 0) { ImGui::Text("Streaming %u assets", m_Streamer.GetPendingCount()); }
+
 	ImGui::End();
 
+	RenderMemoryView();
+	RenderGpuProfilerView();
+	RenderCpuProfilerView();
+
 	ImGui::Render();
 	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-}
\ No newline at end of file
+}
+
+void Application::RenderMemoryView() {
+	Allocator& allocator = m_Device.GetAllocator();
+	AllocatorStats stats = allocator.GetStats();
+
+	ImGui::Begin("Memory", (bool*) false, 0);
+
+	ImGui::Text("vkAllocateMemory objects: %u / %u", stats.deviceMemoryCount, stats.maxMemoryAllocationCount);
+	ImGui::Text("Slabs: %u", stats.slabCount);
+
+	const float mb = 1.0f / (1024.0f * 1024.0f);
+	for(size_t i = 0; i < stats.heaps.size(); i++) {
+		const HeapStats& heap = stats.heaps[i];
+		if(heap.reservedBytes == 0) continue;
+
+		ImGui::Separator();
+		ImGui::Text("Heap %zu (%s, %.0f MiB)", i, heap.deviceLocal ? "device local" : "host", heap.heapSize * mb);
+		ImGui::Text("Used %.2f / reserved %.2f MiB", heap.usedBytes * mb, heap.reservedBytes * mb);
+		ImGui::Text("%u allocations, %u blocks, %u dedicated (%.2f MiB)", heap.allocationCount, heap.blockCount, heap.dedicatedCount, heap.dedicatedBytes * mb);
+		ImGui::ProgressBar(heap.reservedBytes ? (float) heap.usedBytes / (float) heap.reservedBytes : 0.0f);
+	}
+
+	// One bar per VkDeviceMemory, used ranges in red
+	if(ImGui::CollapsingHeader("Blocks")) {
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		float width          = ImGui::GetContentRegionAvail().x;
+		for(const MemoryBlockInfo& block : allocator.GetBlockInfo()) {
+			ImGui::Text("Type %u, heap %u, %.2f MiB%s", block.memoryTypeIndex, block.heapIndex, block.size * mb, block.dedicated ? " (dedicated)" : "");
+
+			ImVec2 start = ImGui::GetCursorScreenPos();
+			drawList->AddRectFilled(start, ImVec2(start.x + width, start.y + 12.0f), IM_COL32(40, 120, 40, 255));
+			for(auto& [offset, size] : block.usedRanges) {
+				float x0 = start.x + width * (float) offset / (float) block.size;
+				float x1 = start.x + width * (float) (offset + size) / (float) block.size;
+				drawList->AddRectFilled(ImVec2(x0, start.y), ImVec2(std::max(x1, x0 + 1.0f), start.y + 12.0f), IM_COL32(200, 60, 60, 255));
+			}
+			ImGui::Dummy(ImVec2(width, 14.0f));
+		}
+	}
+
+	ImGui::End();
+}
+
+void Application::RenderGpuProfilerView() {
+	GpuProfiler& profiler = m_Renderer->GetGpuProfiler();
+
+	ImGui::Begin("GPU profiler", (bool*) false, 0);
+
+	if(!profiler.IsSupported()) {
+		ImGui::Text("Not supported, no timestamps on the graphics queue");
+		ImGui::End();
+		return;
+	}
+
+	// One row per pass and frame, the perf dashboards import it as is
+	if(profiler.IsCapturing()) {
+		if(ImGui::Button("Stop CSV capture")) profiler.StopCapture();
+	} else if(ImGui::Button("Start CSV capture")) {
+		if(!profiler.StartCapture("gpu_profile.csv")) std::cerr << "Failed to open gpu_profile.csv" << std::endl;
+	}
+
+	float total = 0.0f;
+	for(const GpuProfiler::ScopeStats& scope : profiler.GetScopes()) total += scope.time;
+	ImGui::Text("Total: %.2f ms", total);
+
+	// Input sampled to GPU done, scanout comes on top of it
+	char latency[48];
+	snprintf(latency, sizeof(latency), "%.2f ms%s", profiler.GetInputLatency(), profiler.IsInputLatencyCalibrated() ? "" : " (upper bound)");
+	ImGui::PlotLines("Input latency", profiler.GetInputLatencyHistory().data(), GpuProfiler::HISTORY_SIZE, profiler.GetInputLatencyHistoryOffset(), latency, 0.0f, FLT_MAX,
+	                 ImVec2(0.0f, 40.0f));
+
+	for(const GpuProfiler::ScopeStats& scope : profiler.GetScopes()) {
+		ImGui::Separator();
+
+		char overlay[32];
+		snprintf(overlay, sizeof(overlay), "%.3f ms", scope.time);
+		ImGui::PlotLines(scope.name, scope.history.data(), GpuProfiler::HISTORY_SIZE, scope.historyOffset, overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+
+		if(profiler.HasPipelineStatistics()) {
+			ImGui::Text("Vertex: %llu, fragment: %llu, compute: %llu", static_cast<unsigned long long>(scope.vertexInvocations),
+			            static_cast<unsigned long long>(scope.fragmentInvocations), static_cast<unsigned long long>(scope.computeInvocations));
+		}
+	}
+
+	ImGui::End();
+}
+
+void Application::RenderCpuProfilerView() {
+	ImGui::Begin("CPU profiler", (bool*) false, 0);
+
+	bool recording = CpuProfiler::enabled.load();
+	if(ImGui::Checkbox("Record", &recording)) CpuProfiler::enabled.store(recording);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &m_CpuProfilerPaused);
+	ImGui::SameLine();
+	if(ImGui::Button("Export trace")) {
+		if(!CpuProfiler::WriteChromeTrace("cpu_trace.json")) std::cerr << "Failed to write cpu_trace.json" << std::endl;
+	}
+	ImGui::SliderFloat("Window (ms)", &m_FlameWindow, 5.0f, 200.0f);
+
+	if(!m_CpuProfilerPaused || m_CpuSnapshotEnd == 0) {
+		m_CpuSnapshotEnd = CpuProfiler::Now();
+		m_CpuSnapshot    = CpuProfiler::Snapshot(m_CpuSnapshotEnd - std::min(m_CpuSnapshotEnd, static_cast<uint64_t>(200.0 * 1e6)));
+	}
+
+	uint64_t windowEnd   = m_CpuSnapshotEnd;
+	uint64_t windowStart = windowEnd - std::min(windowEnd, static_cast<uint64_t>(m_FlameWindow * 1e6));
+	double windowLength  = static_cast<double>(std::max<uint64_t>(windowEnd - windowStart, 1));
+
+	// One row per nesting level, the zones of a thread stack downwards
+	const float rowHeight = 18.0f;
+	ImDrawList* drawList  = ImGui::GetWindowDrawList();
+	float width           = ImGui::GetContentRegionAvail().x;
+	for(const CpuProfiler::ThreadEvents& thread : m_CpuSnapshot) {
+		uint32_t maxDepth = 0;
+		for(const CpuProfiler::Event& event : thread.events) maxDepth = std::max(maxDepth, event.depth);
+
+		ImGui::Separator();
+		ImGui::Text("%s", thread.name.c_str());
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+
+		for(const CpuProfiler::Event& event : thread.events) {
+			if(event.end < windowStart || event.start > windowEnd) continue;
+
+			float x0 = origin.x + static_cast<float>((std::max(event.start, windowStart) - windowStart) / windowLength) * width;
+			float x1 = origin.x + static_cast<float>((std::min(event.end, windowEnd) - windowStart) / windowLength) * width;
+			ImVec2 min(x0, origin.y + event.depth * rowHeight);
+			ImVec2 max(std::max(x1, x0 + 1.0f), min.y + rowHeight - 1.0f);
+
+			// Same zone, same color in every frame
+			float hue = static_cast<float>(std::hash<std::string_view> {}(event.name) % 360) / 360.0f;
+			drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.7f));
+			if(max.x - min.x > 30.0f) {
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_WHITE, event.name);
+				drawList->PopClipRect();
+			}
+			if(ImGui::IsMouseHoveringRect(min, max)) ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end - event.start) * 1e-6);
+		}
+
+		ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+	}
+
+	ImGui::End();
+}
@@ -1,14 +1,20 @@
 #pragma once
+#include "benchmark.h"
 #include "camera.h"
 #include "input.h"
 #include "object.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "sceneGenerator.h"
+#include "vulkan/assetStreamer.h"
 #include "vulkan/descriptors.h"
 #include "vulkan/device.h"
 #include "vulkan/skybox.h"
 #include "vulkan/uniform.h"
+#include "vulkan/uniformRing.h"
 #include "vulkan/window.h"
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -26,7 +32,9 @@ struct Sync {
 
 class Application {
 public:
-	Application();
+	// With a benchmark the window is headless and the camera follows the benchmark's path instead of the input. The
+	// generated scene is added around the spaceship, in both modes.
+	Application(Benchmark* benchmark = nullptr, const SceneSettings& scene = {});
 	~Application();
 
 	Window m_Window {1600, 900, "Space Sim"};
@@ -36,28 +44,53 @@ public:
 	FrameInfo m_FrameInfoCopy {};
 	void Start();
 
+	inline size_t GetObjectCount() const { return m_GameObjects.size() + m_Stars.size(); }
+	inline size_t GetLightCount() const { return m_SceneLights.size() + 1; }
+
 private:
-	void LoadGameObjects();
+	void LoadGameObjects(const SceneSettings& scene);
 	void Update(const FrameInfo& frameInfo);
 
 	void Run(Sync& syncObj);
 	void Render(Sync& syncObj);
 
 	void RenderImGui(VkCommandBuffer& commandBuffer);
+	void RenderMemoryView();
+	void RenderGpuProfilerView();
+	void RenderCpuProfilerView();
 
+	AssetStreamer m_Streamer {m_Device};
 	Camera m_Camera {};
 
 	std::unique_ptr<DescriptorPool> m_GlobalPool {};
+	std::unique_ptr<UniformRing> m_UniformRing;
 	Map m_GameObjects;
 	Map m_Stars;
+	std::vector<std::shared_ptr<Object>> m_StreamingObjects;    // one per material that is still loading
 
 	Sampler m_Sampler {m_Device};
+	std::unique_ptr<Uniform> m_PlaceholderMaterial;
 
 	std::shared_ptr<Object> m_Spaceship;
 	std::shared_ptr<Object> m_LightSphere;
-	Skybox m_Skybox {m_Device, "../../assets/textures/stars"};
+	std::vector<SceneLight> m_SceneLights;
+	float m_FarPlane = 100.0f;    // pushed out to fit a large generated scene
+	Skybox m_Skybox {m_Device, m_Streamer, "../../assets/textures/stars"};
 
 	float m_SpaceshipRotationX = 0;
 	float m_SpaceshipRotationY = 0;
 	float m_SpaceshipRotationZ = 180;
+
+	Benchmark* m_Benchmark = nullptr;
+	bool m_MeasureFrame     = false;    // handed to the render thread with the frame info
+	bool m_MeasureFrameCopy = false;
+
+	// Waits for the GPU before the input is sampled instead of after the simulation, set from the UI on the render thread
+	std::atomic<bool> m_LowLatency {false};
+
+	// Flame view of the CPU profiler
+	bool m_CpuProfilerPaused = false;
+	float m_FlameWindow      = 50.0f;    // milliseconds
+	std::vector<CpuProfiler::ThreadEvents> m_CpuSnapshot;
+	uint64_t m_CpuSnapshotEnd = 0;
 };
\ No newline at end of file
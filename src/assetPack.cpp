@@ -0,0 +1,76 @@
+#include "assetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+static std::unique_ptr<AssetPack> s_MountedPack;
+
+bool AssetPack::Mount(const std::string& packPath, const std::string& rootDirectory) {
+	auto pack = std::make_unique<AssetPack>();
+	if(!pack->Open(packPath, rootDirectory)) {
+		s_MountedPack.reset();
+		return false;
+	}
+	s_MountedPack = std::move(pack);
+	return true;
+}
+
+const AssetPack* AssetPack::GetMounted() { return s_MountedPack.get(); }
+
+/**
+ * @brief FNV-1a of the path, stable across platforms and builds since it is stored in the pack
+ */
+uint64_t AssetPack::HashPath(const std::string& path) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(char c : path) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+bool AssetPack::Open(const std::string& packPath, const std::string& rootDirectory) {
+	if(!m_File.Open(packPath)) return false;
+
+	const uint8_t* bytes = m_File.GetData();
+	const uint64_t size  = m_File.GetSize();
+
+	AssetPackHeader header;
+	if(size < sizeof(header)) return false;
+	std::memcpy(&header, bytes, sizeof(header));
+	if(header.magic != MAGIC || header.version != VERSION || header.alignment != ALIGNMENT) return false;
+
+	// A truncated pack (interrupted copy to the file server) must not be read past its end
+	auto fits = [&](uint64_t offset, uint64_t blobSize) { return offset <= size && blobSize <= size - offset; };
+	if(!fits(header.tocOffset, uint64_t(header.entryCount) * sizeof(AssetPackEntry)) || !fits(header.namesOffset, header.namesSize)) return false;
+
+	m_Entries.resize(header.entryCount);
+	std::memcpy(m_Entries.data(), bytes + header.tocOffset, m_Entries.size() * sizeof(AssetPackEntry));
+	for(const auto& entry : m_Entries) {
+		if(!fits(entry.offset, entry.storedSize) || uint64_t(entry.nameOffset) + entry.nameLength > header.namesSize) return false;
+		if(entry.compression != COMPRESSION_NONE && entry.compression != COMPRESSION_LZ4) return false;
+	}
+
+	m_Names = reinterpret_cast<const char*>(bytes + header.namesOffset);
+	m_Root  = std::filesystem::path(rootDirectory).lexically_normal().generic_string();
+	return true;
+}
+
+/**
+ * @brief Looks `filepath` up by the path relative to the pack root. The table of contents is sorted by hash so
+ * this is a binary search, the name comparison only runs for entries whose hash matches.
+ */
+const AssetPackEntry* AssetPack::Find(const std::string& filepath) const {
+	std::string key = std::filesystem::path(filepath).lexically_normal().lexically_relative(m_Root).generic_string();
+	// Outside of the root, the pack can't have it
+	if(key.empty() || key.starts_with("..")) return nullptr;
+
+	const uint64_t hash = HashPath(key);
+	auto entry          = std::lower_bound(m_Entries.begin(), m_Entries.end(), hash, [](const AssetPackEntry& entry, uint64_t hash) { return entry.pathHash < hash; });
+	for(; entry != m_Entries.end() && entry->pathHash == hash; ++entry) {
+		if(entry->nameLength == key.size() && std::memcmp(m_Names + entry->nameOffset, key.data(), key.size()) == 0) return &*entry;
+	}
+	return nullptr;
+}
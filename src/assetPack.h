@@ -0,0 +1,71 @@
+#pragma once
+
+#include "mappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Asset pack, every asset of the game in one file so starting it needs a single open instead of hundreds.
+ * The header is followed by the entry data, then the table of contents sorted by path hash and the path names
+ * the entries point into. Entries start on 64 KiB boundaries so an uncompressed entry is read straight from the
+ * mapping with the same alignment a file of its own would have.
+ */
+struct AssetPackHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t alignment;
+	uint64_t tocOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+struct AssetPackEntry {
+	uint64_t pathHash;    // AssetPack::HashPath of the path relative to the pack root
+	uint64_t offset;
+	uint64_t storedSize;    // Bytes in the pack, smaller than `size` if the entry is compressed
+	uint64_t size;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t compression;
+	uint32_t reserved;
+};
+
+class AssetPack {
+public:
+	static constexpr uint32_t MAGIC     = 0x4b415041;    // "APAK"
+	static constexpr uint32_t VERSION   = 1;
+	static constexpr uint64_t ALIGNMENT = 64 * 1024;
+
+	enum Compression : uint32_t { COMPRESSION_NONE = 0, COMPRESSION_LZ4 = 1 };
+
+	/**
+	 * @brief Maps the pack at `packPath` for every MappedFile opened afterwards. `rootDirectory` is the folder the
+	 * paths in the pack are relative to, so the game keeps opening "../../assets/..." whether it runs from a pack
+	 * or from loose files. Returns false and leaves nothing mounted if there is no valid pack.
+	 */
+	static bool Mount(const std::string& packPath, const std::string& rootDirectory);
+
+	// The mounted pack, null if the assets are loose files
+	static const AssetPack* GetMounted();
+
+	static uint64_t HashPath(const std::string& path);
+
+	// The entry `filepath` is stored under, null if it isn't in the pack
+	const AssetPackEntry* Find(const std::string& filepath) const;
+
+	// Points into the mapping, the stored (possibly compressed) bytes of `entry`
+	inline const uint8_t* GetData(const AssetPackEntry& entry) const { return m_File.GetData() + entry.offset; }
+
+	inline size_t GetEntryCount() const { return m_Entries.size(); }
+
+private:
+	bool Open(const std::string& packPath, const std::string& rootDirectory);
+
+	MappedFile m_File;
+	std::string m_Root;
+	std::vector<AssetPackEntry> m_Entries;
+	const char* m_Names = nullptr;
+};
@@ -0,0 +1,92 @@
+#include "benchmark.h"
+
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+Benchmark::Benchmark(const BenchmarkOptions& options): m_Options(options) {
+	m_FrameTimes.reserve(m_Options.frames);
+	m_CpuTimes.reserve(m_Options.frames);
+	m_GpuTimes.reserve(m_Options.frames);
+}
+
+bool Benchmark::NextFrame(bool sceneLoaded) {
+	m_Frame++;
+
+	if(!sceneLoaded || m_WarmupFrames < m_Options.warmupFrames) {
+		if(sceneLoaded) m_WarmupFrames++;
+		return false;
+	}
+
+	m_MeasuredFrames++;
+	return true;
+}
+
+void Benchmark::UpdateCamera(Camera& camera, const glm::dvec3& target) const {
+	double angle  = 2.0 * glm::pi<double>() * m_MeasuredFrames / m_Options.frames;
+	double radius = 12.0 + 48.0 * (0.5 - 0.5 * std::cos(angle * 2.0));
+
+	glm::dvec3 offset = {radius * std::sin(angle), 4.0 * std::sin(angle * 3.0), radius * std::cos(angle)};
+	camera.LookAt(target + offset, target);
+}
+
+void Benchmark::AddFrame(float frameTime, float cpuTime) {
+	m_FrameTimes.push_back(frameTime);
+	m_CpuTimes.push_back(cpuTime);
+}
+
+void Benchmark::AddGpuTime(float gpuTime) { m_GpuTimes.push_back(gpuTime); }
+
+/**
+ * @brief Nearest rank percentiles, there are no samples when the GPU has no timestamps
+ */
+static void WriteStats(std::ostream& out, const char* name, std::vector<float> samples) {
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&](double p) {
+		if(samples.empty()) return 0.0f;
+		size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	};
+
+	double sum = 0.0;
+	for(float sample : samples) sum += sample;
+
+	out << "  \"" << name << "\": {\"samples\": " << samples.size() << ", \"mean\": " << (samples.empty() ? 0.0 : sum / samples.size()) << ", \"min\": " << percentile(0.0)
+	    << ", \"p50\": " << percentile(0.5) << ", \"p90\": " << percentile(0.9) << ", \"p95\": " << percentile(0.95) << ", \"p99\": " << percentile(0.99)
+	    << ", \"max\": " << percentile(1.0) << "}";
+}
+
+bool Benchmark::WriteResults(const std::string& deviceName, size_t objectCount, size_t lightCount) const {
+	std::ostringstream json;
+	json << "{\n";
+	json << "  \"device\": \"";
+	for(char c : deviceName) {
+		if(c == '"' || c == '\\') json << '\\';
+		json << c;
+	}
+	json << "\",\n";
+	json << "  \"width\": " << m_Options.width << ",\n";
+	json << "  \"height\": " << m_Options.height << ",\n";
+	json << "  \"frames\": " << m_Options.frames << ",\n";
+	json << "  \"objects\": " << objectCount << ",\n";
+	json << "  \"lights\": " << lightCount << ",\n";
+	json << "  \"unit\": \"ms\",\n";
+	WriteStats(json, "frame_time", m_FrameTimes);
+	json << ",\n";
+	WriteStats(json, "cpu_time", m_CpuTimes);
+	json << ",\n";
+	WriteStats(json, "gpu_time", m_GpuTimes);
+	json << "\n}\n";
+
+	std::cout << json.str();
+
+	std::ofstream file(m_Options.output, std::ios::out | std::ios::trunc);
+	if(!file.is_open()) return false;
+	file << json.str();
+	return file.good();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "camera.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchmarkOptions {
+	uint32_t frames       = 1000;
+	uint32_t warmupFrames = 100;    // rendered once the scene finished streaming in, before measuring
+	uint32_t width        = 1280;
+	uint32_t height       = 720;
+	std::string output    = "benchmark.json";
+};
+
+/**
+ * @brief Flies the camera along a fixed path for a number of frames and writes frame time percentiles as JSON.
+ *
+ * Renders headless, without a window or a surface, so it runs on machines without a display or a GPU, e.g. CI with Mesa
+ * lavapipe:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./SpaceSim --benchmark --frames 500
+ * The simulation steps at a fixed rate instead of following the wall clock, every run renders the same frames.
+ */
+class Benchmark {
+public:
+	static constexpr double TIME_STEP = 1.0 / 60.0;
+
+	Benchmark(const BenchmarkOptions& options);
+
+	inline const BenchmarkOptions& GetOptions() const { return m_Options; }
+
+	//
+	// Game thread
+	//
+
+	// Steps to the next frame and returns whether it is measured. The warmup only counts frames after the scene loaded.
+	bool NextFrame(bool sceneLoaded);
+
+	inline bool IsFinished() const { return m_MeasuredFrames >= m_Options.frames; }
+
+	// Simulated seconds since the start
+	inline double GetTime() const { return static_cast<double>(m_Frame) * TIME_STEP; }
+
+	// One orbit around `target` over the measured frames, moving in and out to go through the LODs
+	void UpdateCamera(Camera& camera, const glm::dvec3& target) const;
+
+	//
+	// Render thread
+	//
+
+	// Milliseconds between the ends of two frames and of CPU work in the last one
+	void AddFrame(float frameTime, float cpuTime);
+	void AddGpuTime(float gpuTime);
+
+	// Once both threads stopped, also prints the results. The scene size goes along for scaling curves.
+	bool WriteResults(const std::string& deviceName, size_t objectCount, size_t lightCount) const;
+
+private:
+	BenchmarkOptions m_Options;
+
+	uint64_t m_Frame          = 0;
+	uint32_t m_WarmupFrames   = 0;
+	uint32_t m_MeasuredFrames = 0;
+
+	std::vector<float> m_FrameTimes;
+	std::vector<float> m_CpuTimes;
+	std::vector<float> m_GpuTimes;
+};
@@ -16,6 +16,8 @@ void printMat(const glm::mat4& mat) {
 
 void Camera::SetPerspective(const float& fov, const float& aspectRatio, const float& near, const float& far) {
 	m_Projection = glm::perspective(glm::radians(fov), aspectRatio, near, far);
+	m_Near       = near;
+	m_Far        = far;
 }
 
 void Camera::MoveCamera(const float& x, const float& y) {
@@ -45,6 +47,20 @@ void Camera::MoveCamera(const float& x, const float& y) {
 
 	m_View = glm::toMat4(m_Orientation);
 
+	m_CameraFront = glm::vec3(m_View[0][2], m_View[1][2], m_View[2][2]);
+	m_CameraRight = glm::vec3(m_View[0][0], m_View[1][0], m_View[2][0]);
+	m_CameraUp    = glm::vec3(m_View[0][1], m_View[1][1], m_View[2][1]);
+}
+
+/**
+ * @brief Places the camera at `position` facing `target`, the view stays a pure rotation like the one MoveCamera builds
+ */
+void Camera::LookAt(const glm::dvec3& position, const glm::dvec3& target) {
+	m_Translation = position;
+
+	m_View        = glm::lookAt(glm::vec3(0.0f), glm::vec3(glm::normalize(target - position)), glm::vec3(0.0f, 1.0f, 0.0f));
+	m_Orientation = glm::quat_cast(m_View);
+
 	m_CameraFront = glm::vec3(m_View[0][2], m_View[1][2], m_View[2][2]);
 	m_CameraRight = glm::vec3(m_View[0][0], m_View[1][0], m_View[2][0]);
 	m_CameraUp    = glm::vec3(m_View[0][1], m_View[1][1], m_View[2][1]);
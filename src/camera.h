@@ -7,11 +7,16 @@ class Camera {
 public:
 	void SetPerspective(const float& fov, const float& aspectRatio, const float& near, const float& far);
 	void MoveCamera(const float& x, const float& y);
+	void LookAt(const glm::dvec3& position, const glm::dvec3& target);
 
 	inline glm::mat4& GetView() { return m_View; }
 
 	inline glm::mat4& GetProj() { return m_Projection; }
 
+	inline float GetNear() const { return m_Near; }
+
+	inline float GetFar() const { return m_Far; }
+
 	glm::dvec3 m_Translation = {0.0, 0.0, 0.0};
 	glm::vec3 m_CameraFront  = {0.0, 0.0, 1.0};
 	glm::vec3 m_CameraRight  = {1.0, 0.0, 0.0};
@@ -22,4 +27,6 @@ public:
 private:
 	glm::mat4 m_View;
 	glm::mat4 m_Projection;
+	float m_Near = 0.1f;
+	float m_Far  = 100.0f;
 };
\ No newline at end of file
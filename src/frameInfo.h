@@ -2,12 +2,14 @@
 
 #include "camera.h"
 #include "object.h"
+#include "vulkan/lightClusters.h"
 #include "vulkan/descriptors.h"
 #include "vulkan/sampler.h"
 #include "vulkan/skybox.h"
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 using Map = std::unordered_map<int, std::shared_ptr<Object>>;
@@ -15,10 +17,15 @@ using Map = std::unordered_map<int, std::shared_ptr<Object>>;
 struct FrameInfo {
 	VkCommandBuffer commandBuffer;
 	Camera camera;
-	VkDescriptorSet globalDescriptorSet;
-	VkDescriptorSet lightsDescriptorSet;
+	VkDescriptorSet uniformDescriptorSet;    // UniformRing set, bound with the offsets below
+	uint32_t globalUboOffset;
+	std::vector<PointLight> lights;    // relative to the camera
+	float exposure;         // manual exposure, used when the auto exposure is turned off
+	float frameTime;        // seconds since the last frame
+	uint64_t inputTime;     // CpuProfiler::Now() when the input of this frame was sampled
 	Skybox* skybox;
 	VkDescriptorSet skyboxDescriptorSet;
-	Map gameObjects;
-	Map stars;
+	// Owned by the application and not changed while it runs, so every frame only copies the pointers
+	const Map* gameObjects;
+	const Map* stars;
 };
\ No newline at end of file
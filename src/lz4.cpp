@@ -0,0 +1,117 @@
+#include "lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t MIN_MATCH           = 4;
+static constexpr size_t LAST_LITERALS       = 5;     // the block always ends with at least 5 literals
+static constexpr size_t MATCH_SAFE_DISTANCE = 12;    // and the last match starts at least 12 bytes before its end
+static constexpr size_t MAX_OFFSET          = 65535;
+static constexpr uint32_t HASH_BITS         = 16;
+
+static void WriteLength(std::vector<uint8_t>& out, size_t length) {
+	length -= 15;
+	for(; length >= 255; length -= 255) out.push_back(255);
+	out.push_back(static_cast<uint8_t>(length));
+}
+
+std::vector<uint8_t> Lz4::Compress(const uint8_t* data, size_t size) {
+	std::vector<uint8_t> out;
+	out.reserve(size + size / 255 + 16);
+
+	// Last position (+ 1) a 4 byte sequence was seen at, 0 for never
+	std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+
+	size_t anchor   = 0;
+	size_t position = 0;
+	while(position + MATCH_SAFE_DISTANCE <= size) {
+		uint32_t sequence;
+		std::memcpy(&sequence, data + position, 4);
+		uint32_t hash    = (sequence * 2654435761u) >> (32 - HASH_BITS);
+		size_t candidate = table[hash];
+		table[hash]      = static_cast<uint32_t>(position + 1);
+
+		if(candidate == 0 || position - (candidate - 1) > MAX_OFFSET || std::memcmp(data + candidate - 1, data + position, MIN_MATCH) != 0) {
+			position++;
+			continue;
+		}
+		candidate--;
+
+		size_t length = MIN_MATCH;
+		while(position + length < size - LAST_LITERALS && data[candidate + length] == data[position + length]) length++;
+		// The match may also start earlier than where the hash found it
+		while(position > anchor && candidate > 0 && data[position - 1] == data[candidate - 1]) {
+			position--;
+			candidate--;
+			length++;
+		}
+
+		size_t literalLength = position - anchor;
+		size_t matchLength   = length - MIN_MATCH;
+		out.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchLength, 15)));
+		if(literalLength >= 15) WriteLength(out, literalLength);
+		out.insert(out.end(), data + anchor, data + position);
+
+		size_t offset = position - candidate;
+		out.push_back(static_cast<uint8_t>(offset & 0xff));
+		out.push_back(static_cast<uint8_t>(offset >> 8));
+		if(matchLength >= 15) WriteLength(out, matchLength);
+
+		position += length;
+		anchor = position;
+	}
+
+	size_t literalLength = size - anchor;
+	out.push_back(static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4));
+	if(literalLength >= 15) WriteLength(out, literalLength);
+	out.insert(out.end(), data + anchor, data + size);
+	return out;
+}
+
+bool Lz4::Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationSize) {
+	size_t in  = 0;
+	size_t out = 0;
+
+	auto readLength = [&](size_t& length) {
+		if(length != 15) return true;
+		uint8_t byte;
+		do {
+			if(in >= sourceSize) return false;
+			byte = source[in++];
+			length += byte;
+		} while(byte == 255);
+		return true;
+	};
+
+	while(in < sourceSize) {
+		uint8_t token        = source[in++];
+		size_t literalLength = token >> 4;
+		if(!readLength(literalLength) || literalLength > sourceSize - in || literalLength > destinationSize - out) return false;
+
+		if(literalLength > 0) std::memcpy(destination + out, source + in, literalLength);
+		in += literalLength;
+		out += literalLength;
+
+		// The last sequence has no match
+		if(in == sourceSize) break;
+
+		if(sourceSize - in < 2) return false;
+		size_t offset = source[in] | (size_t(source[in + 1]) << 8);
+		in += 2;
+		if(offset == 0 || offset > out) return false;
+
+		size_t matchLength = token & 15;
+		if(!readLength(matchLength)) return false;
+		matchLength += MIN_MATCH;
+		if(matchLength > destinationSize - out) return false;
+
+		// A match closer than its length repeats the bytes it is writing, it has to be copied front to back
+		const uint8_t* match = destination + out - offset;
+		if(offset >= matchLength) std::memcpy(destination + out, match, matchLength);
+		else {
+			for(size_t i = 0; i < matchLength; i++) destination[out + i] = match[i];
+		}
+		out += matchLength;
+	}
+	return out == destinationSize;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md) without the frame around it,
+ * the caller stores the decompressed size. Compression is a single greedy pass with a hash table of 4 byte sequences,
+ * fast enough for packing but far from the ratio of the reference high compression mode.
+ */
+class Lz4 {
+public:
+	static std::vector<uint8_t> Compress(const uint8_t* data, size_t size);
+
+	// Returns false if `source` is not a valid block or doesn't decompress to exactly `destinationSize` bytes
+	static bool Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationSize);
+};
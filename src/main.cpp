@@ -1,14 +1,76 @@
 #include "application.h"
+#include "assetPack.h"
+#include "sceneGenerator.h"
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <string>
 
-int main() {
-	Application app;
+/**
+ * @brief Returns whether --benchmark was given, throws on unknown or malformed arguments. --verbose is applied right away.
+ */
+static bool ParseArguments(int argc, char** argv, BenchmarkOptions& benchmark, SceneSettings& scene) {
+	bool enabled = false;
+	for(int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if(argument == "--benchmark") {
+			enabled = true;
+			continue;
+		}
+		if(argument == "--verbose") {
+			Model::s_PrintImportReports = true;
+			continue;
+		}
+
+		if(i + 1 == argc) { throw std::runtime_error("missing value for " + argument); }
+		std::string value = argv[++i];
+
+		if(argument == "--frames") benchmark.frames = std::stoul(value);
+		else if(argument == "--warmup") benchmark.warmupFrames = std::stoul(value);
+		else if(argument == "--width") benchmark.width = std::stoul(value);
+		else if(argument == "--height") benchmark.height = std::stoul(value);
+		else if(argument == "--output") benchmark.output = value;
+		else if(argument == "--ships") scene.ships = std::stoul(value);
+		else if(argument == "--asteroids") scene.asteroids = std::stoul(value);
+		else if(argument == "--lights") scene.lights = std::stoul(value);
+		else if(argument == "--systems") scene.starSystems = std::stoul(value);
+		else if(argument == "--seed") scene.seed = std::stoull(value);
+		else if(argument == "--scene-radius") scene.radius = std::stod(value);
+		else if(argument == "--distribution") {
+			if(!SceneGenerator::ParseDistribution(value, scene.distribution)) { throw std::runtime_error("unknown distribution " + value + ", expected uniform, clustered or ring"); }
+		}
+		else {
+			throw std::runtime_error("unknown argument " + argument +
+			                         ", expected [--benchmark] [--verbose] [--frames N] [--warmup N] [--width N] [--height N] [--output file] [--ships N] [--asteroids N] [--lights N] "
+			                         "[--systems N] [--seed N] [--distribution uniform|clustered|ring] [--scene-radius R]");
+		}
+	}
+
+	if(enabled && (benchmark.frames == 0 || benchmark.width == 0 || benchmark.height == 0)) { throw std::runtime_error("benchmark frames and resolution can't be 0!"); }
+	return enabled;
+}
+
+int main(int argc, char** argv) {
+	// Has to happen before the Application is constructed, it already loads shaders and textures. Without a pack the loose files are used.
+	if(AssetPack::Mount("../../assets.pack", "../../")) { std::cout << "mounted ../../assets.pack, " << AssetPack::GetMounted()->GetEntryCount() << " assets" << std::endl; }
 
 	try {
+		// --benchmark renders headless along a fixed camera path and writes frame time percentiles, the generated scene
+		// options work with and without it
+		BenchmarkOptions options;
+		SceneSettings scene;
+		std::unique_ptr<Benchmark> benchmark;
+		if(ParseArguments(argc, argv, options, scene)) benchmark = std::make_unique<Benchmark>(options);
+
+		Application app(benchmark.get(), scene);
 		app.Start();
+
+		if(benchmark && !benchmark->WriteResults(app.m_Device.GetDeviceProperties().deviceName, app.GetObjectCount(), app.GetLightCount())) {
+			std::cerr << "failed to write " << options.output << std::endl;
+			return EXIT_FAILURE;
+		}
 	} catch(const std::exception& e) {
 		std::cerr << e.what() << std::endl;
 		return EXIT_FAILURE;
@@ -0,0 +1,113 @@
+#include "mappedFile.h"
+
+#include "assetPack.h"
+#include "lz4.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+/**
+ * @brief Maps the file, returns false if it doesn't exist, can't be read or is empty
+ */
+bool MappedFile::Open(const std::string& filepath) {
+	Close();
+
+	if(const AssetPack* pack = AssetPack::GetMounted()) {
+		if(const AssetPackEntry* entry = pack->Find(filepath)) {
+			if(entry->size == 0) return false;
+
+			if(entry->compression == AssetPack::COMPRESSION_LZ4) {
+				m_Storage.resize(entry->size);
+				if(!Lz4::Decompress(pack->GetData(*entry), entry->storedSize, m_Storage.data(), m_Storage.size())) {
+					m_Storage = {};
+					return false;
+				}
+				m_Data = m_Storage.data();
+			}
+			else m_Data = pack->GetData(*entry);
+
+			m_Size = entry->size;
+			return true;
+		}
+	}
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data     = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if(!data) {
+		if(mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_File    = file;
+	m_Mapping = mapping;
+	m_Data    = static_cast<const uint8_t*>(data);
+	m_Size    = static_cast<size_t>(size.QuadPart);
+#else
+	int file = open(filepath.c_str(), O_RDONLY);
+	if(file < 0) return false;
+
+	struct stat info;
+	if(fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps the file alive on its own
+	close(file);
+	if(data == MAP_FAILED) return false;
+
+	// Everything we map is read front to back exactly once
+	madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+	m_Data = static_cast<const uint8_t*>(data);
+	m_Size = static_cast<size_t>(info.st_size);
+#endif
+	m_Mapped = true;
+	return true;
+}
+
+void MappedFile::Close() {
+	if(!m_Data) return;
+
+	if(!m_Mapped) {
+		m_Storage = {};
+		m_Data    = nullptr;
+		m_Size    = 0;
+		return;
+	}
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_Data);
+	CloseHandle(m_Mapping);
+	CloseHandle(m_File);
+	m_File    = nullptr;
+	m_Mapping = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+	m_Data   = nullptr;
+	m_Size   = 0;
+	m_Mapped = false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Read only memory mapping of a whole file. The pages are only read from disk when they are touched.
+ *
+ * If an AssetPack is mounted, files stored in it are opened from the pack instead. Uncompressed entries point
+ * straight into the pack's mapping, compressed ones are decompressed into memory owned by the MappedFile.
+ */
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&)            = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filepath);
+	void Close();
+
+	inline bool IsOpen() const { return m_Data != nullptr; }
+
+	inline const uint8_t* GetData() const { return m_Data; }
+
+	inline size_t GetSize() const { return m_Size; }
+
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size         = 0;
+	bool m_Mapped         = false;    // false if m_Data belongs to the mounted pack or m_Storage
+	std::vector<uint8_t> m_Storage;
+
+#if defined(_WIN32)
+	void* m_File    = nullptr;
+	void* m_Mapping = nullptr;
+#endif
+};
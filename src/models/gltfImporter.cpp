@@ -0,0 +1,385 @@
+#include "gltfImporter.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <stbimage/stb_image.h>
+
+static constexpr uint32_t GLB_MAGIC      = 0x46546c67;    // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON = 0x4e4f534a;    // "JSON"
+static constexpr uint32_t GLB_CHUNK_BIN  = 0x004e4942;    // "BIN\0"
+static constexpr int MAX_NODE_DEPTH      = 64;
+
+// Accessor component types
+static constexpr int64_t GLTF_BYTE           = 5120;
+static constexpr int64_t GLTF_UNSIGNED_BYTE  = 5121;
+static constexpr int64_t GLTF_SHORT          = 5122;
+static constexpr int64_t GLTF_UNSIGNED_SHORT = 5123;
+static constexpr int64_t GLTF_UNSIGNED_INT   = 5125;
+static constexpr int64_t GLTF_FLOAT          = 5126;
+static constexpr int64_t GLTF_TRIANGLES      = 4;
+
+static size_t ComponentSize(int64_t componentType) {
+	switch(componentType) {
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT: return 4;
+		default: throw std::runtime_error("invalid accessor component type");
+	}
+}
+
+/**
+ * @brief Reads one component and applies the normalization of the accessor
+ */
+static float ReadComponent(const uint8_t* data, int64_t componentType, bool normalized) {
+	switch(componentType) {
+		case GLTF_BYTE: {
+			int8_t value;
+			std::memcpy(&value, data, 1);
+			return normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case GLTF_UNSIGNED_BYTE: return normalized ? data[0] / 255.0f : data[0];
+		case GLTF_SHORT: {
+			int16_t value;
+			std::memcpy(&value, data, 2);
+			return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+		}
+		case GLTF_UNSIGNED_SHORT: {
+			uint16_t value;
+			std::memcpy(&value, data, 2);
+			return normalized ? value / 65535.0f : value;
+		}
+		case GLTF_UNSIGNED_INT: {
+			uint32_t value;
+			std::memcpy(&value, data, 4);
+			return static_cast<float>(value);
+		}
+		default: {
+			float value;
+			std::memcpy(&value, data, 4);
+			return value;
+		}
+	}
+}
+
+void GltfImporter::Open(const std::string& filepath) {
+	m_Filepath = filepath;
+	if(!m_File.Open(filepath)) { throw std::runtime_error("failed to open model " + filepath + "!"); }
+
+	const uint8_t* data = m_File.GetData();
+	size_t size         = m_File.GetSize();
+
+	uint32_t header[5];
+	if(size < sizeof(header)) { throw std::runtime_error("failed to load " + filepath + ": not a glb file!"); }
+	std::memcpy(header, data, sizeof(header));
+	if(header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size) { throw std::runtime_error("failed to load " + filepath + ": not a glTF 2.0 binary!"); }
+	size = header[2];
+
+	// The JSON chunk always comes first, the optional BIN chunk right after it
+	uint32_t jsonLength = header[3];
+	if(header[4] != GLB_CHUNK_JSON || 20ull + jsonLength > size) { throw std::runtime_error("failed to load " + filepath + ": missing JSON chunk!"); }
+	m_Json = JsonValue::Parse(std::string_view(reinterpret_cast<const char*>(data + 20), jsonLength));
+
+	size_t binOffset = 20 + ((jsonLength + 3) & ~3u);
+	if(binOffset + 8 <= size) {
+		uint32_t chunk[2];
+		std::memcpy(chunk, data + binOffset, sizeof(chunk));
+		if(chunk[1] == GLB_CHUNK_BIN && binOffset + 8 + chunk[0] <= size) {
+			m_Binary     = data + binOffset + 8;
+			m_BinarySize = chunk[0];
+		}
+	}
+
+	if(m_Json["asset"]["version"].GetString().rfind("2.", 0) != 0) { throw std::runtime_error("failed to load " + filepath + ": unsupported glTF version!"); }
+}
+
+/**
+ * @brief Start, size and stride (0 when tightly packed) of a buffer view inside the binary chunk
+ */
+const uint8_t* GltfImporter::GetBufferView(size_t bufferView, size_t& size, size_t& stride) const {
+	const JsonValue& view = m_Json["bufferViews"][bufferView];
+	if(view.IsNull()) throw std::runtime_error("missing buffer view");
+
+	// A .glb only has the one buffer that lives in its binary chunk
+	const JsonValue& buffer = m_Json["buffers"][view["buffer"].GetInt()];
+	if(view["buffer"].GetInt() != 0 || buffer.Has("uri") || !m_Binary) throw std::runtime_error("external buffers are not supported");
+
+	uint64_t offset = view["byteOffset"].GetInt(0);
+	size            = view["byteLength"].GetInt(0);
+	stride          = view["byteStride"].GetInt(0);
+	if(offset + size > m_BinarySize) throw std::runtime_error("buffer view out of range");
+	return m_Binary + offset;
+}
+
+template <int N> void GltfImporter::ReadAccessor(size_t index, std::vector<glm::vec<N, float>>& out) const {
+	static const char* TYPES[] = {"", "SCALAR", "VEC2", "VEC3", "VEC4"};
+
+	const JsonValue& accessor = m_Json["accessors"][index];
+	if(accessor.IsNull()) throw std::runtime_error("missing accessor");
+	if(accessor.Has("sparse")) throw std::runtime_error("sparse accessors are not supported");
+	if(accessor["type"].GetString() != TYPES[N]) throw std::runtime_error("unexpected accessor type");
+
+	size_t count          = accessor["count"].GetInt(0);
+	int64_t componentType = accessor["componentType"].GetInt();
+	bool normalized       = accessor["normalized"].GetBool();
+	size_t elementSize    = ComponentSize(componentType) * N;
+
+	out.assign(count, glm::vec<N, float>(0.0f));
+	if(!accessor.Has("bufferView") || count == 0) return;
+
+	size_t viewSize, stride;
+	const uint8_t* data = GetBufferView(accessor["bufferView"].GetInt(), viewSize, stride);
+	size_t offset       = accessor["byteOffset"].GetInt(0);
+	if(stride == 0) stride = elementSize;
+	if(offset + (count - 1) * stride + elementSize > viewSize) throw std::runtime_error("accessor out of range");
+	data += offset;
+
+	// Same layout as ours, nothing to convert
+	if(componentType == GLTF_FLOAT && stride == sizeof(glm::vec<N, float>)) {
+		std::memcpy(out.data(), data, count * stride);
+		return;
+	}
+
+	size_t componentSize = ComponentSize(componentType);
+	for(size_t i = 0; i < count; i++) {
+		for(int c = 0; c < N; c++) out[i][c] = ReadComponent(data + i * stride + c * componentSize, componentType, normalized);
+	}
+}
+
+void GltfImporter::ReadIndices(size_t index, std::vector<uint32_t>& out) const {
+	const JsonValue& accessor = m_Json["accessors"][index];
+	if(accessor.IsNull() || accessor["type"].GetString() != "SCALAR") throw std::runtime_error("invalid index accessor");
+	if(accessor.Has("sparse")) throw std::runtime_error("sparse accessors are not supported");
+
+	size_t count          = accessor["count"].GetInt(0);
+	int64_t componentType = accessor["componentType"].GetInt();
+	if(componentType != GLTF_UNSIGNED_BYTE && componentType != GLTF_UNSIGNED_SHORT && componentType != GLTF_UNSIGNED_INT) throw std::runtime_error("invalid index type");
+
+	out.assign(count, 0);
+	if(!accessor.Has("bufferView") || count == 0) return;
+
+	size_t viewSize, stride;
+	size_t componentSize = ComponentSize(componentType);
+	const uint8_t* data  = GetBufferView(accessor["bufferView"].GetInt(), viewSize, stride);
+	size_t offset        = accessor["byteOffset"].GetInt(0);
+	if(stride == 0) stride = componentSize;
+	if(offset + (count - 1) * stride + componentSize > viewSize) throw std::runtime_error("accessor out of range");
+	data += offset;
+
+	if(componentType == GLTF_UNSIGNED_INT && stride == sizeof(uint32_t)) {
+		std::memcpy(out.data(), data, count * sizeof(uint32_t));
+		return;
+	}
+	for(size_t i = 0; i < count; i++) out[i] = static_cast<uint32_t>(ReadComponent(data + i * stride, componentType, false));
+}
+
+void GltfImporter::AddPrimitive(const JsonValue& primitive, const glm::mat4& transform) {
+	// Points and lines can't be drawn by our pipelines
+	if(primitive["mode"].GetInt(GLTF_TRIANGLES) != GLTF_TRIANGLES) return;
+
+	const JsonValue& attributes = primitive["attributes"];
+	if(!attributes.Has("POSITION")) return;
+
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> texCoords;
+	ReadAccessor(attributes["POSITION"].GetInt(), positions);
+	if(attributes.Has("NORMAL")) ReadAccessor(attributes["NORMAL"].GetInt(), normals);
+	if(attributes.Has("TEXCOORD_0")) ReadAccessor(attributes["TEXCOORD_0"].GetInt(), texCoords);
+
+	std::vector<uint32_t> indices;
+	if(primitive.Has("indices")) { ReadIndices(primitive["indices"].GetInt(), indices); }
+	else {
+		indices.resize(positions.size());
+		for(uint32_t i = 0; i < indices.size(); i++) indices[i] = i;
+	}
+	indices.resize(indices.size() / 3 * 3);
+	for(uint32_t index : indices) {
+		if(index >= positions.size()) throw std::runtime_error("index out of range");
+	}
+
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+	bool mirrored          = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+	auto makeVertex = [&](uint32_t i) {
+		Model::Vertex vertex {};
+		vertex.position = glm::vec3(transform * glm::vec4(positions[i], 1.0f));
+		if(i < normals.size()) vertex.normal = glm::normalize(normalMatrix * normals[i]);
+		// glTF already has its uv origin in the top left corner like Vulkan, no flip needed unlike OBJ
+		if(i < texCoords.size()) vertex.texCoord = texCoords[i];
+		return vertex;
+	};
+
+	std::vector<Model::Vertex>& vertices = *m_Vertices;
+	uint32_t base                        = static_cast<uint32_t>(vertices.size());
+
+	if(normals.empty()) {
+		// Primitives without normals are flat shaded, so no vertex can be shared between triangles
+		for(size_t t = 0; t < indices.size(); t += 3) {
+			Model::Vertex corners[3] = {makeVertex(indices[t]), makeVertex(indices[t + 1]), makeVertex(indices[t + 2])};
+			glm::vec3 normal         = glm::cross(corners[1].position - corners[0].position, corners[2].position - corners[0].position);
+			if(mirrored) normal = -normal;
+			normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3 {0.0f, 1.0f, 0.0f};
+			for(Model::Vertex& corner : corners) {
+				corner.normal = normal;
+				vertices.push_back(corner);
+			}
+		}
+		for(size_t i = 0; i < indices.size(); i++) indices[i] = static_cast<uint32_t>(i);
+	}
+	else {
+		for(uint32_t i = 0; i < positions.size(); i++) vertices.push_back(makeVertex(i));
+	}
+
+	// A mirroring transform turns the triangles inside out
+	for(size_t t = 0; t < indices.size(); t += 3) {
+		m_Indices->push_back(base + indices[t]);
+		m_Indices->push_back(base + indices[t + (mirrored ? 2 : 1)]);
+		m_Indices->push_back(base + indices[t + (mirrored ? 1 : 2)]);
+	}
+}
+
+void GltfImporter::AddNode(size_t index, const glm::mat4& parentTransform, int depth) {
+	if(depth > MAX_NODE_DEPTH) throw std::runtime_error("node hierarchy too deep");
+
+	const JsonValue& node = m_Json["nodes"][index];
+	if(node.IsNull()) throw std::runtime_error("missing node");
+
+	glm::mat4 local {1.0f};
+	if(node.Has("matrix")) {
+		// Column major, same as glm
+		for(int i = 0; i < 16; i++) local[i / 4][i % 4] = static_cast<float>(node["matrix"][i].GetNumber(i % 5 == 0 ? 1.0 : 0.0));
+	}
+	else {
+		const JsonValue& t = node["translation"];
+		const JsonValue& r = node["rotation"];
+		const JsonValue& s = node["scale"];
+		glm::quat rotation(static_cast<float>(r[3].GetNumber(1.0)), static_cast<float>(r[0].GetNumber()), static_cast<float>(r[1].GetNumber()), static_cast<float>(r[2].GetNumber()));
+
+		local = glm::translate(local, glm::vec3(t[0].GetNumber(), t[1].GetNumber(), t[2].GetNumber()));
+		local = local * glm::mat4_cast(rotation);
+		local = glm::scale(local, glm::vec3(s[0].GetNumber(1.0), s[1].GetNumber(1.0), s[2].GetNumber(1.0)));
+	}
+	glm::mat4 transform = parentTransform * local;
+
+	if(node.Has("mesh")) {
+		for(const JsonValue& primitive : m_Json["meshes"][node["mesh"].GetInt()]["primitives"].GetArray()) AddPrimitive(primitive, transform);
+	}
+	for(const JsonValue& child : node["children"].GetArray()) AddNode(child.GetInt(), transform, depth + 1);
+}
+
+void GltfImporter::Load(const std::string& filepath, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices) {
+	Open(filepath);
+
+	vertices.clear();
+	indices.clear();
+	m_Vertices = &vertices;
+	m_Indices  = &indices;
+
+	try {
+		const JsonValue& scene = m_Json["scenes"][m_Json["scene"].GetInt(0)];
+		if(!scene.IsNull()) {
+			for(const JsonValue& node : scene["nodes"].GetArray()) AddNode(node.GetInt(), glm::mat4 {1.0f}, 0);
+		}
+		else {
+			// No scene, the meshes are all there is
+			for(const JsonValue& mesh : m_Json["meshes"].GetArray()) {
+				for(const JsonValue& primitive : mesh["primitives"].GetArray()) AddPrimitive(primitive, glm::mat4 {1.0f});
+			}
+		}
+	} catch(const std::exception& e) { throw std::runtime_error("failed to load " + filepath + ": " + e.what() + "!"); }
+
+	if(indices.empty()) { throw std::runtime_error("failed to load " + filepath + ": no triangle meshes!"); }
+}
+
+/**
+ * @brief Finds the textures of the first material the file uses and maps them onto the albedo, normal, metallic and
+ * roughness slots. Slots the material has no texture for keep the fallback.
+ */
+std::array<TextureSource, 4> GltfImporter::LoadMaterial(const std::string& filepath, const std::array<TextureSource, 4>& fallback) {
+	GltfImporter importer;
+	importer.Open(filepath);
+	const JsonValue& json = importer.m_Json;
+
+	int64_t materialIndex = -1;
+	for(const JsonValue& mesh : json["meshes"].GetArray()) {
+		for(const JsonValue& primitive : mesh["primitives"].GetArray()) {
+			if(materialIndex < 0 && primitive.Has("material")) materialIndex = primitive["material"].GetInt();
+		}
+	}
+
+	std::array<TextureSource, 4> textures = fallback;
+	if(materialIndex < 0) return textures;
+
+	auto resolve = [&](const JsonValue& textureInfo, int32_t channel, TextureSource& out) {
+		if(!textureInfo.Has("index")) return;
+		const JsonValue& image = json["images"][json["textures"][textureInfo["index"].GetInt()]["source"].GetInt(-1)];
+		if(image.IsNull()) return;
+
+		TextureSource source;
+		source.channel = channel;
+		if(image.Has("bufferView")) {
+			source.filepath      = filepath;
+			source.embeddedImage = static_cast<int32_t>(json["textures"][textureInfo["index"].GetInt()]["source"].GetInt());
+		}
+		else {
+			const std::string& uri = image["uri"].GetString();
+			if(uri.empty() || uri.rfind("data:", 0) == 0) return;    // data uris are not supported
+			source.filepath = (std::filesystem::path(filepath).parent_path() / uri).string();
+		}
+		out = source;
+	};
+
+	const JsonValue& material = json["materials"][materialIndex];
+	const JsonValue& pbr      = material["pbrMetallicRoughness"];
+	resolve(pbr["baseColorTexture"], -1, textures[0]);
+	resolve(material["normalTexture"], -1, textures[1]);
+	resolve(pbr["metallicRoughnessTexture"], 2, textures[2]);
+	resolve(pbr["metallicRoughnessTexture"], 1, textures[3]);
+	return textures;
+}
+
+/**
+ * @brief Decodes a texture to 8 bit RGBA
+ */
+std::vector<uint8_t> GltfImporter::DecodeImage(const TextureSource& source, uint32_t& width, uint32_t& height) {
+	int w = 0, h = 0, channels;
+	stbi_uc* pixels = nullptr;
+
+	if(source.embeddedImage >= 0) {
+		GltfImporter importer;
+		importer.Open(source.filepath);
+
+		const JsonValue& image = importer.m_Json["images"][source.embeddedImage];
+		size_t size, stride;
+		const uint8_t* data = importer.GetBufferView(image["bufferView"].GetInt(), size, stride);
+		pixels              = stbi_load_from_memory(data, static_cast<int>(size), &w, &h, &channels, STBI_rgb_alpha);
+	}
+	else {
+		MappedFile file;
+		if(file.Open(source.filepath)) pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &w, &h, &channels, STBI_rgb_alpha);
+	}
+
+	if(!pixels) { throw std::runtime_error(std::string("failed to load texture image! " + source.filepath)); }
+
+	width  = static_cast<uint32_t>(w);
+	height = static_cast<uint32_t>(h);
+	std::vector<uint8_t> result(pixels, pixels + size_t(w) * h * 4);
+	stbi_image_free(pixels);
+
+	if(source.channel >= 0) {
+		for(size_t i = 0; i < result.size(); i += 4) {
+			uint8_t value = result[i + source.channel];
+			result[i] = result[i + 1] = result[i + 2] = value;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../mappedFile.h"
+#include "../vulkan/model.h"
+#include "json.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Where the pixels of a texture come from, a plain image file or an image embedded in a .glb
+ */
+struct TextureSource {
+	std::string filepath;
+	int32_t embeddedImage = -1;    // index into the images of the .glb at `filepath`
+	int32_t channel       = -1;    // copy this channel into rgb, glTF packs roughness (g) and metallic (b) into one texture
+
+	TextureSource() = default;
+	TextureSource(const std::string& path): filepath(path) {}
+	TextureSource(const char* path): filepath(path) {}
+};
+
+/**
+ * @brief glTF 2.0 binary (.glb) importer.
+ *
+ * The file is mapped, only the JSON chunk is parsed, vertex attributes and indices are read straight out of
+ * the binary chunk (a plain copy when the accessor is tightly packed in the layout we need). Every triangle
+ * primitive the default scene references is merged into one mesh with its node transform applied.
+ */
+class GltfImporter {
+public:
+	void Load(const std::string& filepath, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	static std::array<TextureSource, 4> LoadMaterial(const std::string& filepath, const std::array<TextureSource, 4>& fallback);
+
+	static std::vector<uint8_t> DecodeImage(const TextureSource& source, uint32_t& width, uint32_t& height);
+
+private:
+	void Open(const std::string& filepath);
+	void AddNode(size_t node, const glm::mat4& parentTransform, int depth);
+	void AddPrimitive(const JsonValue& primitive, const glm::mat4& transform);
+
+	template <int N> void ReadAccessor(size_t accessor, std::vector<glm::vec<N, float>>& out) const;
+	void ReadIndices(size_t accessor, std::vector<uint32_t>& out) const;
+	const uint8_t* GetBufferView(size_t bufferView, size_t& size, size_t& stride) const;
+
+	MappedFile m_File;
+	std::string m_Filepath;
+	JsonValue m_Json;
+	const uint8_t* m_Binary = nullptr;
+	size_t m_BinarySize     = 0;
+
+	std::vector<Model::Vertex>* m_Vertices = nullptr;
+	std::vector<uint32_t>* m_Indices       = nullptr;
+};
@@ -0,0 +1,180 @@
+#include "json.h"
+
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+
+static const JsonValue NULL_VALUE {};
+
+// Nesting deeper than this is not a glTF file, stop before the stack runs out
+static constexpr int MAX_DEPTH = 256;
+
+struct JsonValue::Parser {
+	std::string_view text;
+	size_t position = 0;
+
+	[[noreturn]] void Fail(const char* what) { throw std::runtime_error("failed to parse json at offset " + std::to_string(position) + ": " + what + "!"); }
+
+	void SkipWhitespace() {
+		while(position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) position++;
+	}
+
+	char Peek() {
+		SkipWhitespace();
+		if(position >= text.size()) Fail("unexpected end");
+		return text[position];
+	}
+
+	void Expect(char c) {
+		if(Peek() != c) Fail("unexpected character");
+		position++;
+	}
+
+	bool Consume(std::string_view word) {
+		if(text.substr(position, word.size()) != word) return false;
+		position += word.size();
+		return true;
+	}
+
+	void AppendUtf8(std::string& out, uint32_t codepoint) {
+		if(codepoint < 0x80) { out += static_cast<char>(codepoint); }
+		else if(codepoint < 0x800) {
+			out += static_cast<char>(0xc0 | (codepoint >> 6));
+			out += static_cast<char>(0x80 | (codepoint & 0x3f));
+		}
+		else if(codepoint < 0x10000) {
+			out += static_cast<char>(0xe0 | (codepoint >> 12));
+			out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (codepoint & 0x3f));
+		}
+		else {
+			out += static_cast<char>(0xf0 | (codepoint >> 18));
+			out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+			out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (codepoint & 0x3f));
+		}
+	}
+
+	uint32_t ParseHex4() {
+		if(position + 4 > text.size()) Fail("unexpected end");
+		uint32_t value = 0;
+		auto [next, error] = std::from_chars(text.data() + position, text.data() + position + 4, value, 16);
+		if(error != std::errc() || next != text.data() + position + 4) Fail("invalid unicode escape");
+		position += 4;
+		return value;
+	}
+
+	std::string ParseString() {
+		Expect('"');
+		std::string result;
+		while(true) {
+			if(position >= text.size()) Fail("unterminated string");
+			char c = text[position++];
+			if(c == '"') break;
+			if(c != '\\') {
+				result += c;
+				continue;
+			}
+
+			if(position >= text.size()) Fail("unterminated string");
+			switch(text[position++]) {
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u': {
+					uint32_t codepoint = ParseHex4();
+					// Surrogate pair
+					if(codepoint >= 0xd800 && codepoint < 0xdc00 && Consume("\\u")) { codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (ParseHex4() - 0xdc00); }
+					AppendUtf8(result, codepoint);
+					break;
+				}
+				default: Fail("invalid escape");
+			}
+		}
+		return result;
+	}
+
+	JsonValue ParseValue(int depth) {
+		if(depth > MAX_DEPTH) Fail("nested too deep");
+
+		JsonValue value;
+		char c = Peek();
+		if(c == '{') {
+			position++;
+			value.m_Type = JSON_OBJECT;
+			if(Peek() == '}') {
+				position++;
+				return value;
+			}
+			while(true) {
+				std::string key = ParseString();
+				Expect(':');
+				value.m_Object[std::move(key)] = ParseValue(depth + 1);
+				if(Peek() == ',') {
+					position++;
+					continue;
+				}
+				Expect('}');
+				return value;
+			}
+		}
+		if(c == '[') {
+			position++;
+			value.m_Type = JSON_ARRAY;
+			if(Peek() == ']') {
+				position++;
+				return value;
+			}
+			while(true) {
+				value.m_Array.push_back(ParseValue(depth + 1));
+				if(Peek() == ',') {
+					position++;
+					continue;
+				}
+				Expect(']');
+				return value;
+			}
+		}
+		if(c == '"') {
+			value.m_Type   = JSON_STRING;
+			value.m_String = ParseString();
+			return value;
+		}
+		if(Consume("true") || Consume("false")) {
+			value.m_Type = JSON_BOOL;
+			value.m_Bool = text[position - 2] == 'u';    // tr(u)e
+			return value;
+		}
+		if(Consume("null")) return value;
+
+		auto [next, error] = std::from_chars(text.data() + position, text.data() + text.size(), value.m_Number);
+		if(error != std::errc()) Fail("unexpected character");
+		value.m_Type = JSON_NUMBER;
+		position     = next - text.data();
+		return value;
+	}
+};
+
+JsonValue JsonValue::Parse(std::string_view text) {
+	Parser parser {text};
+	JsonValue value = parser.ParseValue(0);
+	parser.SkipWhitespace();
+	if(parser.position != text.size()) parser.Fail("trailing characters");
+	return value;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+	if(m_Type != JSON_OBJECT) return NULL_VALUE;
+	auto it = m_Object.find(key);
+	return it != m_Object.end() ? it->second : NULL_VALUE;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+	if(m_Type != JSON_ARRAY || index >= m_Array.size()) return NULL_VALUE;
+	return m_Array[index];
+}
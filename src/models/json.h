@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Small JSON document model, enough to read glTF headers. Parse errors throw std::runtime_error.
+ *
+ * Lookups of missing keys or indices return a null value instead of throwing, so optional
+ * properties can be read with a default: `node["scale"][0].GetNumber(1.0)`.
+ */
+class JsonValue {
+public:
+	enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+	static JsonValue Parse(std::string_view text);
+
+	inline Type GetType() const { return m_Type; }
+
+	inline bool IsNull() const { return m_Type == JSON_NULL; }
+
+	inline bool Has(const std::string& key) const { return m_Type == JSON_OBJECT && m_Object.count(key) > 0; }
+
+	inline size_t Size() const { return m_Type == JSON_ARRAY ? m_Array.size() : m_Type == JSON_OBJECT ? m_Object.size() : 0; }
+
+	const JsonValue& operator[](const std::string& key) const;
+	const JsonValue& operator[](size_t index) const;
+
+	double GetNumber(double fallback = 0.0) const { return m_Type == JSON_NUMBER ? m_Number : fallback; }
+
+	int64_t GetInt(int64_t fallback = 0) const { return m_Type == JSON_NUMBER ? static_cast<int64_t>(m_Number) : fallback; }
+
+	bool GetBool(bool fallback = false) const { return m_Type == JSON_BOOL ? m_Bool : fallback; }
+
+	const std::string& GetString() const { return m_String; }
+
+	inline const std::vector<JsonValue>& GetArray() const { return m_Array; }
+
+	inline const std::map<std::string, JsonValue>& GetObject() const { return m_Object; }
+
+private:
+	struct Parser;
+
+	Type m_Type     = JSON_NULL;
+	bool m_Bool     = false;
+	double m_Number = 0.0;
+	std::string m_String;
+	std::vector<JsonValue> m_Array;
+	std::map<std::string, JsonValue> m_Object;
+};
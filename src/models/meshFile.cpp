@@ -0,0 +1,115 @@
+#include "meshFile.h"
+
+#include "../utilities.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+static constexpr const char* MESH_CACHE_DIRECTORY = "../../assets/cache/";
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+/**
+ * @brief Maps a baked mesh, returns false if there is none or it was baked from a different version of the source
+ */
+bool MeshFile::Open(const std::string& filepath, uint64_t sourceHash) {
+	if(!m_File.Open(filepath)) return false;
+
+	const uint8_t* bytes = m_File.GetData();
+	const uint64_t size  = m_File.GetSize();
+
+	MeshFileHeader header;
+	if(size < sizeof(header)) return false;
+	std::memcpy(&header, bytes, sizeof(header));
+
+	if(header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash || header.vertexStride != sizeof(Model::PackedVertex)) {
+		m_File.Close();
+		return false;
+	}
+
+	// A truncated file (crash while baking) must not be read past its end
+	auto fits = [&](uint64_t offset, uint64_t blobSize) { return offset % ALIGNMENT == 0 && offset <= size && blobSize <= size - offset; };
+	if(!fits(header.vertexOffset, uint64_t(header.vertexCount) * sizeof(Model::PackedVertex)) || !fits(header.indexOffset, uint64_t(header.indexCount) * sizeof(uint32_t))
+	   || !fits(header.lodOffset, uint64_t(header.lodCount) * sizeof(Model::Lod))) {
+		m_File.Close();
+		return false;
+	}
+
+	m_Data.vertices    = reinterpret_cast<const Model::PackedVertex*>(bytes + header.vertexOffset);
+	m_Data.vertexCount = header.vertexCount;
+	m_Data.indices     = reinterpret_cast<const uint32_t*>(bytes + header.indexOffset);
+	m_Data.indexCount  = header.indexCount;
+	m_Data.lods        = reinterpret_cast<const Model::Lod*>(bytes + header.lodOffset);
+	m_Data.lodCount    = header.lodCount;
+	std::memcpy(&m_Data.dequantization, header.dequantization, sizeof(header.dequantization));
+	m_Data.boundingRadius = header.boundingRadius;
+	return true;
+}
+
+/**
+ * @brief Bakes `data` into a .mesh file. The file is written under a temporary name and renamed, so other threads
+ * and later runs either see the old file or the complete new one.
+ */
+bool MeshFile::Write(const std::string& filepath, uint64_t sourceHash, const Model::MeshData& data) {
+	MeshFileHeader header {};
+	header.magic        = MAGIC;
+	header.version      = VERSION;
+	header.sourceHash   = sourceHash;
+	header.vertexCount  = data.vertexCount;
+	header.vertexStride = sizeof(Model::PackedVertex);
+	header.indexCount   = data.indexCount;
+	header.lodCount     = data.lodCount;
+	header.vertexOffset = AlignUp(sizeof(header), ALIGNMENT);
+	header.indexOffset  = AlignUp(header.vertexOffset + uint64_t(data.vertexCount) * sizeof(Model::PackedVertex), ALIGNMENT);
+	header.lodOffset    = AlignUp(header.indexOffset + uint64_t(data.indexCount) * sizeof(uint32_t), ALIGNMENT);
+	std::memcpy(header.dequantization, &data.dequantization, sizeof(header.dequantization));
+	header.boundingRadius = data.boundingRadius;
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(filepath).parent_path(), error);
+
+	std::ostringstream temporaryPath;
+	temporaryPath << filepath << "." << std::this_thread::get_id() << ".tmp";
+
+	{
+		std::ofstream file(temporaryPath.str(), std::ios::binary | std::ios::trunc);
+		if(!file) return false;
+
+		auto writeAt = [&](uint64_t offset, const void* blob, uint64_t blobSize) {
+			static const char zeros[ALIGNMENT] = {};
+			uint64_t position                  = static_cast<uint64_t>(file.tellp());
+			file.write(zeros, static_cast<std::streamsize>(offset - position));
+			file.write(static_cast<const char*>(blob), static_cast<std::streamsize>(blobSize));
+		};
+		writeAt(0, &header, sizeof(header));
+		writeAt(header.vertexOffset, data.vertices, uint64_t(data.vertexCount) * sizeof(Model::PackedVertex));
+		writeAt(header.indexOffset, data.indices, uint64_t(data.indexCount) * sizeof(uint32_t));
+		writeAt(header.lodOffset, data.lods, uint64_t(data.lodCount) * sizeof(Model::Lod));
+
+		if(!file) {
+			file.close();
+			std::filesystem::remove(temporaryPath.str(), error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath.str(), filepath, error);
+	if(error) {
+		std::filesystem::remove(temporaryPath.str(), error);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Where the baked version of a source mesh lives. The full source path is hashed into the name so
+ * models with the same file name in different folders don't overwrite each other.
+ */
+std::string MeshFile::GetCachePath(const std::string& sourceFilepath) {
+	std::ostringstream path;
+	path << MESH_CACHE_DIRECTORY << std::filesystem::path(sourceFilepath).stem().string() << "-" << std::hex << HashBytes(sourceFilepath.data(), sourceFilepath.size()) << ".mesh";
+	return path.str();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../mappedFile.h"
+#include "../vulkan/model.h"
+
+#include <string>
+
+/**
+ * @brief Baked .mesh file, a header followed by the packed vertices, indices and LOD ranges, each aligned to 64 bytes.
+ * Everything is stored in the layout the GPU uses, so a loaded file is handed to the upload queue without any parsing.
+ */
+struct MeshFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;    // HashBytes of the file the mesh was imported from
+
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	uint32_t indexCount;
+	uint32_t lodCount;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t lodOffset;
+
+	float dequantization[16];
+	float boundingRadius;
+	uint32_t padding;
+};
+
+class MeshFile {
+public:
+	static constexpr uint32_t MAGIC     = 0x4853454d;    // "MESH"
+	static constexpr uint32_t VERSION   = 2;    // bump whenever the importer or the packing changes its output, the source hash alone does not catch that
+	static constexpr uint64_t ALIGNMENT = 64;
+
+	bool Open(const std::string& filepath, uint64_t sourceHash);
+
+	static bool Write(const std::string& filepath, uint64_t sourceHash, const Model::MeshData& data);
+
+	static std::string GetCachePath(const std::string& sourceFilepath);
+
+	// Points into the mapping, only valid while the MeshFile is open
+	inline const Model::MeshData& GetData() const { return m_Data; }
+
+private:
+	MappedFile m_File;
+	Model::MeshData m_Data {};
+};
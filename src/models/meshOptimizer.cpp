@@ -0,0 +1,247 @@
+#include "meshOptimizer.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+
+/**
+ * @brief Reorders triangles so vertices are still in the post transform cache when they are used again
+ *
+ * Fans around one vertex at a time and picks the next vertex to fan around among the ones just used, preferring
+ * those that are still in the cache and have few triangles left.
+ *
+ * @param clusters If not null receives the first triangle of every run where Tipsify had to jump to a vertex that is no longer cached
+ */
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters) {
+	ASSERT(indices.size() % 3 == 0);    // Only triangle lists can be optimized
+
+	const size_t triangleCount = indices.size() / 3;
+
+	// Triangles around every vertex
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for(uint32_t index : indices) offsets[index + 1]++;
+	for(size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for(size_t t = 0; t < triangleCount; t++) {
+		for(int k = 0; k < 3; k++) adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+	}
+
+	std::vector<uint32_t> live(vertexCount);
+	for(size_t v = 0; v < vertexCount; v++) live[v] = offsets[v + 1] - offsets[v];
+
+	// A vertex is cached while less than cacheSize vertices were added after it
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	auto isCached      = [&](uint32_t v) { return timestamp - cacheTime[v] <= cacheSize; };
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	size_t cursor    = 0;
+	auto nextInOrder = [&]() {
+		while(cursor < vertexCount && live[cursor] == 0) cursor++;
+		return cursor < vertexCount ? static_cast<uint32_t>(cursor) : ~0u;
+	};
+
+	if(clusters) { clusters->clear(); }
+
+	uint32_t fanning = nextInOrder();
+	while(fanning != ~0u) {
+		if(clusters && clusters->empty()) { clusters->push_back(0); }
+
+		candidates.clear();
+		for(uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+			uint32_t t = adjacency[i];
+			if(emitted[t]) continue;
+
+			for(int k = 0; k < 3; k++) {
+				uint32_t v = indices[t * 3 + k];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if(!isCached(v)) { cacheTime[v] = timestamp++; }
+			}
+			emitted[t] = true;
+		}
+
+		// Prefer the vertex that entered the cache earliest, as long as its remaining fan still fits in the cache
+		uint32_t next    = ~0u;
+		int64_t priority = -1;
+		for(uint32_t v : candidates) {
+			if(live[v] == 0) continue;
+
+			int64_t p = 0;
+			if(timestamp - cacheTime[v] + 2 * live[v] <= cacheSize) { p = timestamp - cacheTime[v]; }
+			if(p > priority) {
+				priority = p;
+				next     = v;
+			}
+		}
+
+		if(next == ~0u) {
+			// Dead end, go back to a recently used vertex that still has triangles
+			while(!deadEnds.empty()) {
+				uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if(live[v] > 0) {
+					next = v;
+					break;
+				}
+			}
+			if(next == ~0u) { next = nextInOrder(); }
+
+			if(clusters && next != ~0u && !isCached(next)) { clusters->push_back(static_cast<uint32_t>(result.size() / 3)); }
+		}
+		fanning = next;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Vertex cache optimizes the triangles and then sorts the resulting clusters so the ones facing away from the
+ * center of the mesh are drawn first, they are the most likely to occlude the rest.
+ *
+ * @param threshold How much worse than the vertex cache optimized order the ACMR may get, clusters are split as long as they stay below it
+ */
+std::vector<uint32_t> MeshOptimizer::OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold, uint32_t cacheSize) {
+	const size_t vertexCount = positions.size();
+
+	std::vector<uint32_t> hardClusters;
+	std::vector<uint32_t> ordered = OptimizeVertexCache(indices, vertexCount, cacheSize, &hardClusters);
+	const uint32_t triangleCount  = static_cast<uint32_t>(ordered.size() / 3);
+	if(triangleCount == 0) return ordered;
+	hardClusters.push_back(triangleCount);
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	auto countMisses   = [&](uint32_t triangle) {
+		uint32_t misses = 0;
+		for(int k = 0; k < 3; k++) {
+			uint32_t v = ordered[triangle * 3 + k];
+			if(timestamp - cacheTime[v] > cacheSize) {
+				cacheTime[v] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto flush = [&]() { timestamp += cacheSize + 1; };
+
+	// Split the hard clusters further wherever their ACMR got as good as the whole cluster's
+	std::vector<uint32_t> clusters;
+	for(size_t c = 0; c + 1 < hardClusters.size(); c++) {
+		uint32_t start = hardClusters[c], end = hardClusters[c + 1];
+		if(start == end) continue;
+
+		flush();
+		uint32_t misses = 0;
+		for(uint32_t t = start; t < end; t++) misses += countMisses(t);
+		float target = threshold * float(misses) / float(end - start);
+
+		flush();
+		clusters.push_back(start);
+		uint32_t clusterStart = start, clusterMisses = 0;
+		for(uint32_t t = start; t < end; t++) {
+			clusterMisses += countMisses(t);
+			if(t + 1 < end && float(clusterMisses) / float(t + 1 - clusterStart) <= target) {
+				clusters.push_back(t + 1);
+				clusterStart  = t + 1;
+				clusterMisses = 0;
+				flush();
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Area weighted centroid of the mesh and of every cluster
+	auto triangleData = [&](uint32_t t, glm::vec3& centroid, glm::vec3& normal) {
+		glm::vec3 p0 = positions[ordered[t * 3 + 0]];
+		glm::vec3 p1 = positions[ordered[t * 3 + 1]];
+		glm::vec3 p2 = positions[ordered[t * 3 + 2]];
+		normal       = glm::cross(p1 - p0, p2 - p0);
+		centroid     = (p0 + p1 + p2) / 3.0f;
+		return glm::length(normal);
+	};
+
+	glm::vec3 meshCentroid {0.0f};
+	float meshArea = 0.0f;
+	for(uint32_t t = 0; t < triangleCount; t++) {
+		glm::vec3 centroid, normal;
+		float area = triangleData(t, centroid, normal);
+		meshCentroid += centroid * area;
+		meshArea += area;
+	}
+	if(meshArea > 0.0f) { meshCentroid /= meshArea; }
+
+	const size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for(size_t c = 0; c < clusterCount; c++) {
+		glm::vec3 clusterCentroid {0.0f}, clusterNormal {0.0f};
+		float clusterArea = 0.0f;
+		for(uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			glm::vec3 centroid, normal;
+			float area = triangleData(t, centroid, normal);
+			clusterCentroid += centroid * area;
+			clusterNormal += normal;
+			clusterArea += area;
+		}
+
+		float normalLength = glm::length(clusterNormal);
+		if(clusterArea == 0.0f || normalLength == 0.0f) continue;
+		sortKeys[c] = glm::dot(clusterCentroid / clusterArea - meshCentroid, clusterNormal / normalLength);
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for(uint32_t c = 0; c < clusterCount; c++) order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) { return sortKeys[l] > sortKeys[r]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(ordered.size());
+	for(uint32_t c : order) { result.insert(result.end(), ordered.begin() + clusters[c] * 3, ordered.begin() + clusters[c + 1] * 3); }
+	return result;
+}
+
+/**
+ * @brief Renumbers the vertices in the order the indices first use them
+ *
+ * @return Remap table, new index of every old vertex or ~0u for vertices no triangle uses
+ */
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount) {
+	std::vector<uint32_t> remap(vertexCount, ~0u);
+	uint32_t next = 0;
+	for(uint32_t& index : indices) {
+		if(remap[index] == ~0u) { remap[index] = next++; }
+		index = remap[index];
+	}
+	return remap;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	uint32_t timestamp   = cacheSize + 1;
+	uint32_t misses      = 0;
+	uint32_t uniqueCount = 0;
+
+	for(uint32_t index : indices) {
+		if(timestamp - cacheTime[index] > cacheSize) {
+			cacheTime[index] = timestamp++;
+			misses++;
+		}
+		if(!used[index]) {
+			used[index] = true;
+			uniqueCount++;
+		}
+	}
+
+	VertexCacheStats stats {};
+	if(indices.size() >= 3) { stats.acmr = float(misses) / float(indices.size() / 3); }
+	if(uniqueCount > 0) { stats.atvr = float(misses) / float(uniqueCount); }
+	return stats;
+}
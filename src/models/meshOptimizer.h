@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief How well an index buffer uses the post transform vertex cache, measured with a FIFO cache
+ *
+ * acmr Average cache miss ratio, vertex shader invocations per triangle (0.5 is the ideal for big grids, 3 is the worst)
+ * atvr Average transformed vertex ratio, vertex shader invocations per vertex (1 is the ideal)
+ */
+struct VertexCacheStats {
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+/**
+ * @brief Offline reordering of triangle lists so they are cheaper to draw.
+ *
+ * OptimizeVertexCache uses Tipsify (Sander et al. 2007), OptimizeOverdraw sorts the clusters Tipsify
+ * produced so outward facing parts of the mesh are drawn first, and OptimizeVertexFetch renumbers
+ * the vertices in the order they are first used so the vertex buffer is read front to back.
+ */
+class MeshOptimizer {
+public:
+	// Smaller than the caches of current GPUs on purpose, Tipsify degrades gracefully on bigger ones but not on smaller ones
+	static constexpr uint32_t CACHE_SIZE = 16;
+
+	static std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE, std::vector<uint32_t>* clusters = nullptr);
+
+	static std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE);
+
+	static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+};
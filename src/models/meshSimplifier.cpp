@@ -0,0 +1,278 @@
+#include "meshSimplifier.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// Border edges get a much heavier quadric than surface planes so they barely move
+static constexpr double BORDER_WEIGHT = 10.0;
+
+static inline uint64_t EdgeKey(uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; }
+
+void MeshSimplifier::Quadric::AddPlane(const glm::dvec3& n, double d, double w) {
+	a00 += w * n.x * n.x;
+	a01 += w * n.x * n.y;
+	a02 += w * n.x * n.z;
+	a03 += w * n.x * d;
+	a11 += w * n.y * n.y;
+	a12 += w * n.y * n.z;
+	a13 += w * n.y * d;
+	a22 += w * n.z * n.z;
+	a23 += w * n.z * d;
+	a33 += w * d * d;
+	weight += w;
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric& o) {
+	a00 += o.a00;
+	a01 += o.a01;
+	a02 += o.a02;
+	a03 += o.a03;
+	a11 += o.a11;
+	a12 += o.a12;
+	a13 += o.a13;
+	a22 += o.a22;
+	a23 += o.a23;
+	a33 += o.a33;
+	weight += o.weight;
+}
+
+/**
+ * @brief Sum of squared distances to all planes, divided by their weight so the result is a squared distance
+ */
+double MeshSimplifier::Quadric::Evaluate(const glm::dvec3& p) const {
+	double error = a00 * p.x * p.x + 2.0 * a01 * p.x * p.y + 2.0 * a02 * p.x * p.z + 2.0 * a03 * p.x + a11 * p.y * p.y + 2.0 * a12 * p.y * p.z + 2.0 * a13 * p.y + a22 * p.z * p.z + 2.0 * a23 * p.z
+	             + a33;
+	return weight > 0.0 ? std::abs(error) / weight : 0.0;
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<glm::vec3>& positions) {
+	// Vertices that only differ in normal or uv have to move together, otherwise seams tear open
+	std::unordered_map<glm::vec3, uint32_t> groups;
+	m_Group.resize(positions.size());
+	for(size_t i = 0; i < positions.size(); i++) {
+		auto [it, inserted] = groups.try_emplace(positions[i], static_cast<uint32_t>(m_GroupPositions.size()));
+		if(inserted) {
+			m_GroupPositions.push_back(positions[i]);
+			m_Representative.push_back(static_cast<uint32_t>(i));
+		}
+		m_Group[i] = it->second;
+	}
+}
+
+/**
+ * @brief Would collapsing `from` onto `to` turn any of the surrounding triangles over
+ */
+bool MeshSimplifier::Flips(const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to) const {
+	for(uint32_t i = m_TriangleOffsets[from]; i < m_TriangleOffsets[from + 1]; i++) {
+		const uint32_t* triangle = &triangles[m_GroupTriangles[i] * 3];
+		uint32_t g[3]            = {m_Group[triangle[0]], m_Group[triangle[1]], m_Group[triangle[2]]};
+		if(g[0] == to || g[1] == to || g[2] == to) continue;    // this one collapses away
+
+		glm::vec3 p[3]   = {m_GroupPositions[g[0]], m_GroupPositions[g[1]], m_GroupPositions[g[2]]};
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		for(int k = 0; k < 3; k++) {
+			if(g[k] == from) p[k] = m_GroupPositions[to];
+		}
+		glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+		float lengths = glm::length(before) * glm::length(after);
+		if(lengths == 0.0f || glm::dot(before, after) < 0.25f * lengths) return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Collapses edges until the index count drops to `targetIndexCount` or every remaining collapse would move the surface by more than `maxError`
+ *
+ * @param resultError Biggest distance (in model space) a collapse moved the surface by
+ */
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError) {
+	ASSERT(indices.size() % 3 == 0);    // Only triangle lists can be simplified
+
+	std::vector<uint32_t> result = indices;
+	const uint32_t groupCount    = static_cast<uint32_t>(m_GroupPositions.size());
+	double maxCost               = double(maxError) * double(maxError);
+	double worstCost             = 0.0;
+
+	std::vector<uint64_t> edges;
+	std::vector<bool> border(groupCount);
+
+	auto findEdges = [&]() {
+		edges.clear();
+		for(size_t i = 0; i < result.size(); i += 3) {
+			for(int k = 0; k < 3; k++) { edges.push_back(EdgeKey(m_Group[result[i + k]], m_Group[result[i + (k + 1) % 3]])); }
+		}
+		std::sort(edges.begin(), edges.end());
+
+		// An edge that only one triangle uses is on an open border
+		std::fill(border.begin(), border.end(), false);
+		for(size_t i = 0; i < edges.size();) {
+			size_t j = i;
+			while(j < edges.size() && edges[j] == edges[i]) j++;
+			if(j - i == 1) {
+				border[edges[i] >> 32]        = true;
+				border[edges[i] & 0xffffffff] = true;
+			}
+			i = j;
+		}
+	};
+
+	// Planes of every triangle, weighted by area
+	std::vector<Quadric> quadrics(groupCount);
+	for(size_t i = 0; i < result.size(); i += 3) {
+		uint32_t g[3]     = {m_Group[result[i]], m_Group[result[i + 1]], m_Group[result[i + 2]]};
+		glm::dvec3 p0     = m_GroupPositions[g[0]];
+		glm::dvec3 p1     = m_GroupPositions[g[1]];
+		glm::dvec3 p2     = m_GroupPositions[g[2]];
+		glm::dvec3 n      = glm::cross(p1 - p0, p2 - p0);
+		double doubleArea = glm::length(n);
+		if(doubleArea == 0.0) continue;
+		n /= doubleArea;
+
+		Quadric q;
+		q.AddPlane(n, -glm::dot(n, p0), doubleArea * 0.5);
+		for(uint32_t group : g) quadrics[group].Add(q);
+	}
+
+	// Border edges also get a plane through the edge perpendicular to the triangle
+	findEdges();
+	for(size_t i = 0; i < result.size(); i += 3) {
+		uint32_t g[3] = {m_Group[result[i]], m_Group[result[i + 1]], m_Group[result[i + 2]]};
+		glm::dvec3 n  = glm::cross(glm::dvec3(m_GroupPositions[g[1]]) - glm::dvec3(m_GroupPositions[g[0]]), glm::dvec3(m_GroupPositions[g[2]]) - glm::dvec3(m_GroupPositions[g[0]]));
+		if(glm::length(n) == 0.0) continue;
+		n = glm::normalize(n);
+
+		for(int k = 0; k < 3; k++) {
+			uint32_t a   = g[k], b = g[(k + 1) % 3];
+			uint64_t key = EdgeKey(a, b);
+			auto range   = std::equal_range(edges.begin(), edges.end(), key);
+			if(range.second - range.first != 1) continue;
+
+			glm::dvec3 edge = glm::dvec3(m_GroupPositions[b]) - glm::dvec3(m_GroupPositions[a]);
+			double length   = glm::length(edge);
+			if(length == 0.0) continue;
+			glm::dvec3 plane = glm::normalize(glm::cross(edge, n));
+
+			Quadric q;
+			q.AddPlane(plane, -glm::dot(plane, glm::dvec3(m_GroupPositions[a])), length * length * BORDER_WEIGHT);
+			quadrics[a].Add(q);
+			quadrics[b].Add(q);
+		}
+	}
+
+	std::vector<uint32_t> remap(groupCount);
+	std::vector<bool> locked(groupCount);
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> vertexRemap(m_Group.size());
+
+	while(result.size() > targetIndexCount) {
+		findEdges();
+
+		// Triangles around every group
+		size_t triangleCount = result.size() / 3;
+		m_TriangleOffsets.assign(groupCount + 1, 0);
+		for(uint32_t index : result) m_TriangleOffsets[m_Group[index] + 1]++;
+		for(uint32_t g = 0; g < groupCount; g++) m_TriangleOffsets[g + 1] += m_TriangleOffsets[g];
+		m_GroupTriangles.resize(result.size());
+		std::vector<uint32_t> fill(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+		for(size_t t = 0; t < triangleCount; t++) {
+			for(int k = 0; k < 3; k++) m_GroupTriangles[fill[m_Group[result[t * 3 + k]]]++] = static_cast<uint32_t>(t);
+		}
+
+		// Cheapest direction of every edge
+		collapses.clear();
+		for(size_t i = 0; i < edges.size();) {
+			size_t j = i;
+			while(j < edges.size() && edges[j] == edges[i]) j++;
+			bool borderEdge = j - i == 1;
+
+			uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+			uint32_t b = static_cast<uint32_t>(edges[i] & 0xffffffff);
+			i          = j;
+			if(a == b) continue;
+
+			Collapse best {0, 0, -1.0};
+			for(auto [from, to] : {std::pair {a, b}, std::pair {b, a}}) {
+				// Border vertices may only slide along the border
+				if(border[from] && !borderEdge) continue;
+
+				Quadric q = quadrics[from];
+				q.Add(quadrics[to]);
+				double cost = q.Evaluate(m_GroupPositions[to]);
+				if(best.cost < 0.0 || cost < best.cost) best = {from, to, cost};
+			}
+			if(best.cost >= 0.0 && best.cost <= maxCost) collapses.push_back(best);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+		// Every collapse removes about two triangles, don't overshoot the target in one pass
+		size_t collapseLimit = std::max<size_t>(1, (result.size() - targetIndexCount) / 6);
+		size_t collapseCount = 0;
+
+		for(uint32_t g = 0; g < groupCount; g++) remap[g] = g;
+		std::fill(locked.begin(), locked.end(), false);
+
+		for(const Collapse& collapse : collapses) {
+			if(collapseCount >= collapseLimit) break;
+			if(locked[collapse.from] || locked[collapse.to]) continue;
+			if(Flips(result, collapse.from, collapse.to)) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].Add(quadrics[collapse.from]);
+			worstCost = std::max(worstCost, collapse.cost);
+			collapseCount++;
+
+			// The neighbourhood of a collapsed vertex changed, its flip test results are stale until the next pass
+			for(uint32_t i = m_TriangleOffsets[collapse.from]; i < m_TriangleOffsets[collapse.from + 1]; i++) {
+				const uint32_t* triangle = &result[m_GroupTriangles[i] * 3];
+				for(int k = 0; k < 3; k++) locked[m_Group[triangle[k]]] = true;
+			}
+		}
+
+		if(collapseCount == 0) break;
+
+		// A collapsed vertex takes the vertex of the target position it shares a triangle with, that keeps uvs continuous
+		std::fill(vertexRemap.begin(), vertexRemap.end(), ~0u);
+		for(size_t i = 0; i < result.size(); i += 3) {
+			for(int k = 0; k < 3; k++) {
+				uint32_t vertex = result[i + k];
+				uint32_t target = remap[m_Group[vertex]];
+				if(target == m_Group[vertex] || vertexRemap[vertex] != ~0u) continue;
+				for(int o = 1; o < 3; o++) {
+					uint32_t other = result[i + (k + o) % 3];
+					if(m_Group[other] == target) {
+						vertexRemap[vertex] = other;
+						break;
+					}
+				}
+			}
+		}
+
+		size_t write = 0;
+		for(size_t i = 0; i < result.size(); i += 3) {
+			uint32_t triangle[3];
+			for(int k = 0; k < 3; k++) {
+				uint32_t vertex = result[i + k];
+				uint32_t target = remap[m_Group[vertex]];
+				if(target != m_Group[vertex]) vertex = vertexRemap[vertex] != ~0u ? vertexRemap[vertex] : m_Representative[target];
+				triangle[k] = vertex;
+			}
+
+			uint32_t g0 = m_Group[triangle[0]], g1 = m_Group[triangle[1]], g2 = m_Group[triangle[2]];
+			if(g0 == g1 || g1 == g2 || g0 == g2) continue;
+
+			result[write++] = triangle[0];
+			result[write++] = triangle[1];
+			result[write++] = triangle[2];
+		}
+		result.resize(write);
+	}
+
+	resultError = static_cast<float>(std::sqrt(worstCost));
+	return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Quadric error metric mesh simplification.
+ *
+ * Edges are collapsed onto one of their end points, so the simplified index lists keep using
+ * the original vertices and every LOD of a model can share one vertex buffer. Vertices that share
+ * a position (UV or normal seams) are collapsed together. Open borders are only allowed to slide
+ * along themselves so silhouettes of open meshes don't get eaten.
+ */
+class MeshSimplifier {
+public:
+	MeshSimplifier(const std::vector<glm::vec3>& positions);
+
+	std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError);
+
+private:
+	struct Quadric {
+		// Upper triangle of the symmetric 4x4 matrix
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33    = 0;
+		double weight = 0;
+
+		void AddPlane(const glm::dvec3& normal, double distance, double planeWeight);
+		void Add(const Quadric& other);
+		double Evaluate(const glm::dvec3& position) const;
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	bool Flips(const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to) const;
+
+	std::vector<uint32_t> m_Group;              // vertex -> position group
+	std::vector<glm::vec3> m_GroupPositions;    // position of every group
+	std::vector<uint32_t> m_Representative;     // one vertex of every group
+
+	// Per pass adjacency, triangles (as group triples) around every group in CSR form
+	std::vector<uint32_t> m_TriangleOffsets;
+	std::vector<uint32_t> m_GroupTriangles;
+};
@@ -0,0 +1,408 @@
+#include "objImporter.h"
+
+#include "../mappedFile.h"
+#include "../profiler.h"
+#include "../utilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// Chunks smaller than this are not worth a thread
+static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+static constexpr uint32_t MISSING      = ~0u;
+
+namespace {
+	enum LineType { LINE_OTHER, LINE_POSITION, LINE_TEXCOORD, LINE_NORMAL, LINE_FACE };
+
+	inline bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	inline const char* SkipBlanks(const char* p, const char* end) {
+		while(p < end && IsBlank(*p)) p++;
+		return p;
+	}
+
+	// Moves `p` past the keyword of the line
+	LineType Classify(const char*& p, const char* end) {
+		p = SkipBlanks(p, end);
+		if(end - p < 2) return LINE_OTHER;
+
+		if(p[0] == 'v') {
+			if(IsBlank(p[1])) {
+				p += 1;
+				return LINE_POSITION;
+			}
+			if(end - p >= 3 && IsBlank(p[2])) {
+				LineType type = p[1] == 't' ? LINE_TEXCOORD : p[1] == 'n' ? LINE_NORMAL : LINE_OTHER;
+				if(type != LINE_OTHER) p += 2;
+				return type;
+			}
+		}
+		else if(p[0] == 'f' && IsBlank(p[1])) {
+			p += 1;
+			return LINE_FACE;
+		}
+		return LINE_OTHER;
+	}
+
+	const char* ParseFloat(const char* p, const char* end, float& value) {
+		p = SkipBlanks(p, end);
+		if(p < end && *p == '+') p++;
+		auto [next, error] = std::from_chars(p, end, value);
+		if(error != std::errc()) throw std::runtime_error("expected a number");
+		return next;
+	}
+
+	const char* ParseInteger(const char* p, const char* end, long long& value) {
+		auto [next, error] = std::from_chars(p, end, value);
+		if(error != std::errc()) throw std::runtime_error("expected a face index");
+		return next;
+	}
+
+	/**
+	 * @brief Turns a 1 based (or negative, relative to the end) OBJ index into a 0 based one
+	 */
+	uint32_t ResolveIndex(long long index, uint32_t declaredCount, uint32_t totalCount) {
+		long long resolved = index > 0 ? index - 1 : static_cast<long long>(declaredCount) + index;
+		if(index == 0 || resolved < 0 || resolved >= totalCount) throw std::runtime_error("index out of range");
+		return static_cast<uint32_t>(resolved);
+	}
+
+	/**
+	 * @brief Open addressing (linear probing) set of vertices that compares every attribute, not just the position
+	 */
+	class VertexTable {
+	public:
+		VertexTable(size_t maxCount) {
+			size_t capacity = 16;
+			while(capacity < maxCount + maxCount / 2) capacity *= 2;
+			m_Slots.assign(capacity, MISSING);
+			m_Mask = capacity - 1;
+		}
+
+		// Index of `vertex` in `vertices`, appended if it isn't in there yet
+		uint32_t Insert(const Model::Vertex& vertex, std::vector<Model::Vertex>& vertices) {
+			for(size_t slot = Hash(vertex) & m_Mask;; slot = (slot + 1) & m_Mask) {
+				uint32_t index = m_Slots[slot];
+				if(index == MISSING) {
+					index         = static_cast<uint32_t>(vertices.size());
+					m_Slots[slot] = index;
+					vertices.push_back(vertex);
+					return index;
+				}
+				if(vertices[index] == vertex) return index;
+			}
+		}
+
+	private:
+		static uint64_t Hash(const Model::Vertex& vertex) {
+			// + 0.0f turns -0 into 0, they compare equal so they have to hash equal
+			const float key[8] = {vertex.position.x + 0.0f, vertex.position.y + 0.0f, vertex.position.z + 0.0f, vertex.normal.x + 0.0f,
+			                      vertex.normal.y + 0.0f,   vertex.normal.z + 0.0f,   vertex.texCoord.x + 0.0f, vertex.texCoord.y + 0.0f};
+			return HashBytes(key, sizeof(key));
+		}
+
+		std::vector<uint32_t> m_Slots;
+		size_t m_Mask;
+	};
+}    // namespace
+
+ObjImporter::ObjImporter(uint32_t threadCount): m_ThreadCount(threadCount) {
+	if(m_ThreadCount == 0) { m_ThreadCount = std::max(1u, std::thread::hardware_concurrency()); }
+}
+
+/**
+ * @brief Runs `function` on every chunk with up to m_ThreadCount threads and rethrows the first exception
+ */
+template <typename Function> void ObjImporter::ParallelFor(std::vector<Chunk>& chunks, Function function) {
+	std::atomic<size_t> next = 0;
+	auto work                = [&]() {
+		for(size_t c = next++; c < chunks.size(); c = next++) {
+			try {
+				function(chunks[c]);
+			} catch(...) { chunks[c].error = std::current_exception(); }
+		}
+	};
+
+	uint32_t threadCount = static_cast<uint32_t>(std::min<size_t>(m_ThreadCount, chunks.size()));
+	std::vector<std::thread> threads;
+	for(uint32_t i = 1; i < threadCount; i++) {
+		threads.emplace_back([&, i]() {
+			CpuProfiler::RegisterThread("Importer " + std::to_string(i));
+			work();
+		});
+	}
+	work();
+	for(auto& thread : threads) thread.join();
+
+	for(Chunk& chunk : chunks) {
+		if(chunk.error) std::rethrow_exception(chunk.error);
+	}
+}
+
+void ObjImporter::Load(const std::string& filepath, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices) {
+	MappedFile file;
+	if(!file.Open(filepath)) { throw std::runtime_error("failed to open model " + filepath + "!"); }
+
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+	const char* end  = data + file.GetSize();
+
+	// Line aligned chunks, one or a few per thread
+	size_t chunkSize = std::max(MIN_CHUNK_SIZE, file.GetSize() / (m_ThreadCount * 4) + 1);
+	std::vector<Chunk> chunks;
+	for(const char* begin = data; begin < end;) {
+		const char* chunkEnd = begin + std::min(chunkSize, static_cast<size_t>(end - begin));
+		if(chunkEnd < end) {
+			const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+			chunkEnd            = newline ? newline + 1 : end;
+		}
+		Chunk& chunk = chunks.emplace_back();
+		chunk.begin  = begin;
+		chunk.end    = chunkEnd;
+		begin = chunkEnd;
+	}
+
+	try {
+		// Indices are global, so every chunk has to know how many attributes came before it
+		ParallelFor(chunks, [this](Chunk& chunk) { Count(chunk); });
+
+		uint32_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+		for(Chunk& chunk : chunks) {
+			chunk.firstPosition = positionCount;
+			chunk.firstTexCoord = texCoordCount;
+			chunk.firstNormal   = normalCount;
+			positionCount += chunk.positionCount;
+			texCoordCount += chunk.texCoordCount;
+			normalCount += chunk.normalCount;
+		}
+		m_Positions.resize(positionCount);
+		m_TexCoords.resize(texCoordCount);
+		m_Normals.resize(normalCount);
+
+		ParallelFor(chunks, [this](Chunk& chunk) { Parse(chunk); });
+		ParallelFor(chunks, [this](Chunk& chunk) { Deduplicate(chunk); });
+	} catch(const std::exception& e) { throw std::runtime_error("failed to parse " + filepath + ": " + e.what() + "!"); }
+
+	// Merge the chunks, only their unique vertices have to go through the shared table
+	size_t uniqueCount = 0, indexCount = 0;
+	for(const Chunk& chunk : chunks) {
+		uniqueCount += chunk.vertices.size();
+		indexCount += chunk.indices.size();
+	}
+
+	vertices.clear();
+	vertices.reserve(uniqueCount);
+	VertexTable table(uniqueCount);
+	std::vector<std::vector<uint32_t>> remaps(chunks.size());
+	for(size_t c = 0; c < chunks.size(); c++) {
+		remaps[c].resize(chunks[c].vertices.size());
+		for(size_t i = 0; i < chunks[c].vertices.size(); i++) remaps[c][i] = table.Insert(chunks[c].vertices[i], vertices);
+	}
+
+	indices.resize(indexCount);
+	std::vector<size_t> firstIndex(chunks.size(), 0);
+	for(size_t c = 1; c < chunks.size(); c++) firstIndex[c] = firstIndex[c - 1] + chunks[c - 1].indices.size();
+
+	ParallelFor(chunks, [&](Chunk& chunk) {
+		size_t c                         = &chunk - chunks.data();
+		const std::vector<uint32_t>& map = remaps[c];
+		for(size_t i = 0; i < chunk.indices.size(); i++) indices[firstIndex[c] + i] = map[chunk.indices[i]];
+	});
+
+	m_Positions.clear();
+	m_TexCoords.clear();
+	m_Normals.clear();
+}
+
+void ObjImporter::Count(Chunk& chunk) {
+	for(const char* p = chunk.begin; p < chunk.end;) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+		if(!lineEnd) lineEnd = chunk.end;
+
+		switch(Classify(p, lineEnd)) {
+			case LINE_POSITION: chunk.positionCount++; break;
+			case LINE_TEXCOORD: chunk.texCoordCount++; break;
+			case LINE_NORMAL: chunk.normalCount++; break;
+			default: break;
+		}
+		p = lineEnd + 1;
+	}
+}
+
+void ObjImporter::Parse(Chunk& chunk) {
+	uint32_t positionCount = chunk.firstPosition, texCoordCount = chunk.firstTexCoord, normalCount = chunk.firstNormal;
+	std::vector<uint32_t> face;
+
+	for(const char* p = chunk.begin; p < chunk.end;) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+		if(!lineEnd) lineEnd = chunk.end;
+
+		switch(Classify(p, lineEnd)) {
+			case LINE_POSITION: {
+				glm::vec3& position = m_Positions[positionCount++];
+				for(int i = 0; i < 3; i++) p = ParseFloat(p, lineEnd, position[i]);
+				break;
+			}
+			case LINE_TEXCOORD: {
+				// The second (and third) coordinate are optional
+				glm::vec2 texCoord {0.0f};
+				p = ParseFloat(p, lineEnd, texCoord.x);
+				p = SkipBlanks(p, lineEnd);
+				if(p < lineEnd) ParseFloat(p, lineEnd, texCoord.y);
+				m_TexCoords[texCoordCount++] = {texCoord.x, 1.0f - texCoord.y};
+				break;
+			}
+			case LINE_NORMAL: {
+				glm::vec3& normal = m_Normals[normalCount++];
+				for(int i = 0; i < 3; i++) p = ParseFloat(p, lineEnd, normal[i]);
+				break;
+			}
+			case LINE_FACE: {
+				// Negative indices count back from the attributes declared so far
+				face.clear();
+				while((p = SkipBlanks(p, lineEnd)) < lineEnd) {
+					uint32_t corner[3] = {MISSING, MISSING, MISSING};
+					long long index;
+					p         = ParseInteger(p, lineEnd, index);
+					corner[0] = ResolveIndex(index, positionCount, static_cast<uint32_t>(m_Positions.size()));
+
+					// v, v/vt, v//vn or v/vt/vn
+					if(p < lineEnd && *p == '/') {
+						p++;
+						if(p < lineEnd && *p != '/') {
+							p         = ParseInteger(p, lineEnd, index);
+							corner[1] = ResolveIndex(index, texCoordCount, static_cast<uint32_t>(m_TexCoords.size()));
+						}
+						if(p < lineEnd && *p == '/') {
+							p         = ParseInteger(p + 1, lineEnd, index);
+							corner[2] = ResolveIndex(index, normalCount, static_cast<uint32_t>(m_Normals.size()));
+						}
+					}
+					face.insert(face.end(), corner, corner + 3);
+				}
+
+				// Triangulated later, when every position is known
+				if(face.size() < 9) throw std::runtime_error("face with less than three corners");
+				chunk.corners.insert(chunk.corners.end(), face.begin(), face.end());
+				chunk.faceSizes.push_back(static_cast<uint32_t>(face.size() / 3));
+				break;
+			}
+			default: break;
+		}
+		p = lineEnd + 1;
+	}
+}
+
+/**
+ * @brief Ear clipping triangulation of a polygon that may be concave, in the plane it mostly lies in
+ *
+ * @param triangles Receives three corner numbers (0 to cornerCount - 1) per triangle, in the winding of the polygon
+ */
+void ObjImporter::ClipEars(const uint32_t* face, uint32_t cornerCount, std::vector<uint32_t>& triangles) const {
+	triangles.clear();
+
+	// Newell's method, works for concave polygons too
+	glm::vec3 normal {0.0f};
+	for(uint32_t i = 0; i < cornerCount; i++) {
+		glm::vec3 a = m_Positions[face[i * 3]];
+		glm::vec3 b = m_Positions[face[((i + 1) % cornerCount) * 3]];
+		normal += glm::vec3((a.y - b.y) * (a.z + b.z), (a.z - b.z) * (a.x + b.x), (a.x - b.x) * (a.y + b.y));
+	}
+
+	// Drop the axis the normal points along the most
+	glm::vec3 absolute = glm::abs(normal);
+	int axis           = absolute.x > absolute.y ? (absolute.x > absolute.z ? 0 : 2) : (absolute.y > absolute.z ? 1 : 2);
+	int u = (axis + 1) % 3, v = (axis + 2) % 3;
+	float winding = normal[axis] < 0.0f ? -1.0f : 1.0f;
+
+	std::vector<glm::vec2> points(cornerCount);
+	for(uint32_t i = 0; i < cornerCount; i++) {
+		glm::vec3 position = m_Positions[face[i * 3]];
+		points[i]          = {position[u], position[v]};
+	}
+
+	auto cross = [&](uint32_t a, uint32_t b, uint32_t c) { return winding * ((points[b].x - points[a].x) * (points[c].y - points[a].y) - (points[b].y - points[a].y) * (points[c].x - points[a].x)); };
+
+	std::vector<uint32_t> remaining(cornerCount);
+	for(uint32_t i = 0; i < cornerCount; i++) remaining[i] = i;
+
+	while(remaining.size() > 3) {
+		size_t count = remaining.size();
+		bool clipped = false;
+		for(size_t i = 0; i < count && !clipped; i++) {
+			uint32_t a = remaining[(i + count - 1) % count], b = remaining[i], c = remaining[(i + 1) % count];
+			if(cross(a, b, c) <= 0.0f) continue;    // reflex corner
+
+			bool empty = true;
+			for(uint32_t other : remaining) {
+				if(other == a || other == b || other == c) continue;
+				if(cross(a, b, other) >= 0.0f && cross(b, c, other) >= 0.0f && cross(c, a, other) >= 0.0f) {
+					empty = false;
+					break;
+				}
+			}
+			if(!empty) continue;
+
+			triangles.insert(triangles.end(), {a, b, c});
+			remaining.erase(remaining.begin() + i);
+			clipped = true;
+		}
+
+		// Degenerate or self intersecting, fan whatever is left
+		if(!clipped) break;
+	}
+
+	for(size_t i = 2; i < remaining.size(); i++) triangles.insert(triangles.end(), {remaining[0], remaining[i - 1], remaining[i]});
+}
+
+/**
+ * @brief Triangulates the faces of the chunk and deduplicates their vertices
+ */
+void ObjImporter::Deduplicate(Chunk& chunk) {
+	size_t triangleCount = 0;
+	for(uint32_t faceSize : chunk.faceSizes) triangleCount += faceSize - 2;
+
+	VertexTable table(triangleCount * 3);
+	chunk.indices.reserve(triangleCount * 3);
+
+	auto addCorner = [&](const uint32_t* corner) {
+		Model::Vertex vertex {};
+		vertex.position = m_Positions[corner[0]];
+		if(corner[1] != MISSING) vertex.texCoord = m_TexCoords[corner[1]];
+		if(corner[2] != MISSING) vertex.normal = m_Normals[corner[2]];
+
+		chunk.indices.push_back(table.Insert(vertex, chunk.vertices));
+	};
+
+	std::vector<uint32_t> triangles;
+	const uint32_t* face = chunk.corners.data();
+	for(uint32_t faceSize : chunk.faceSizes) {
+		// Quads are split along their shorter diagonal, bigger polygons are ear clipped
+		uint32_t order[6] = {0, 1, 2, 0, 2, 3};
+		if(faceSize == 4) {
+			glm::vec3 diagonal02 = m_Positions[face[6]] - m_Positions[face[0]];
+			glm::vec3 diagonal13 = m_Positions[face[9]] - m_Positions[face[3]];
+			if(glm::dot(diagonal02, diagonal02) >= glm::dot(diagonal13, diagonal13)) {
+				const uint32_t other[6] = {0, 1, 3, 1, 2, 3};
+				std::copy(other, other + 6, order);
+			}
+			for(uint32_t corner : order) addCorner(face + corner * 3);
+		}
+		else if(faceSize == 3) {
+			for(uint32_t corner = 0; corner < 3; corner++) addCorner(face + corner * 3);
+		}
+		else {
+			ClipEars(face, faceSize, triangles);
+			for(uint32_t corner : triangles) addCorner(face + corner * 3);
+		}
+		face += faceSize * 3;
+	}
+
+	chunk.corners.clear();
+	chunk.corners.shrink_to_fit();
+	chunk.faceSizes.clear();
+	chunk.faceSizes.shrink_to_fit();
+}
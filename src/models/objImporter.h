@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../vulkan/model.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Multi threaded Wavefront OBJ importer.
+ *
+ * The file is mapped and split into line aligned chunks that are parsed in parallel. Vertices are
+ * deduplicated on their full position, normal and uv, first per chunk and then once more while the
+ * chunks are merged, with open addressing hash tables. Quads are split along their shorter diagonal
+ * like tinyobjloader does, bigger polygons are ear clipped. Materials and groups are ignored.
+ */
+class ObjImporter {
+public:
+	ObjImporter(uint32_t threadCount = 0);
+
+	void Load(const std::string& filepath, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+private:
+	struct Chunk {
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		// How many attributes of each kind are declared before this chunk
+		uint32_t firstPosition = 0, firstTexCoord = 0, firstNormal = 0;
+		uint32_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+
+		std::vector<uint32_t> corners;      // position, uv and normal index of every face corner
+		std::vector<uint32_t> faceSizes;    // corner count of every face
+
+		std::vector<Model::Vertex> vertices;    // unique within the chunk
+		std::vector<uint32_t> indices;          // into `vertices`, later into the merged vertices
+
+		std::exception_ptr error;
+	};
+
+	template <typename Function> void ParallelFor(std::vector<Chunk>& chunks, Function function);
+
+	void Count(Chunk& chunk);
+	void Parse(Chunk& chunk);
+	void Deduplicate(Chunk& chunk);
+	void ClipEars(const uint32_t* face, uint32_t cornerCount, std::vector<uint32_t>& triangles) const;
+
+	uint32_t m_ThreadCount;
+
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::vec2> m_TexCoords;
+	std::vector<glm::vec3> m_Normals;
+};
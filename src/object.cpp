@@ -2,33 +2,109 @@
 
 #include <memory>
 
-Object::Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& modelFilepath, const std::string& albedoMap, const std::string& normalMap, const std::string& metallicMap,
-               const std::string& roughnessMap)
-: m_Device(*objInfo.device), m_Transform(objTransform) {
-	m_Model = Model::CreateModelFromFile(*objInfo.device, modelFilepath);
+// Albedo, normal, metallic and roughness maps of objects that don't have their own
+const std::array<TextureSource, 4> Object::DEFAULT_MATERIAL = {"../../assets/textures/empty_roughness.jpg", "../../assets/textures/empty_normal.jpg",
+                                                               "../../assets/textures/empty_metallic.jpg", "../../assets/textures/empty_roughness.jpg"};
 
-	m_Albedo    = std::make_unique<Image>(m_Device, albedoMap);
-	m_Normal    = std::make_unique<Image>(m_Device, normalMap);
-	m_Metallic  = std::make_unique<Image>(m_Device, metallicMap);
-	m_Roughness = std::make_unique<Image>(m_Device, roughnessMap);
+Object::Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& modelFilepath, const TextureSource& albedoMap, const TextureSource& normalMap, const TextureSource& metallicMap,
+               const TextureSource& roughnessMap)
+: Object(objInfo, objTransform, modelFilepath, {albedoMap, normalMap, metallicMap, roughnessMap}) {}
 
+/**
+ * @brief Loads the mesh and the material textures from a .glb, slots without a texture use the empty maps
+ */
+Object::Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& gltfFilepath)
+: Object(objInfo, objTransform, gltfFilepath, GltfImporter::LoadMaterial(gltfFilepath, DEFAULT_MATERIAL)) {}
+
+Object::Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& modelFilepath, const std::array<TextureSource, 4>& material)
+: m_Device(*objInfo.device), m_Info(objInfo), m_Transform(objTransform) {
+	// Everything is loaded in the background, the object is drawn with the placeholders until then
+	m_Model = objInfo.streamer->LoadModel(modelFilepath);
+
+	m_Material                                                          = std::make_shared<Material>();
+	m_Material->textures[AssetStreamer::PLACEHOLDER_ALBEDO]             = objInfo.streamer->LoadImage(material[0], true);
+	m_Material->textures[AssetStreamer::PLACEHOLDER_NORMAL]             = objInfo.streamer->LoadImage(material[1]);
+	m_Material->textures[AssetStreamer::PLACEHOLDER_METALLIC_ROUGHNESS] = objInfo.streamer->LoadPackedImage(material[2], material[3]);
+
+	m_ID = NextID();
+}
+
+/**
+ * @brief Nothing is loaded again, large generated scenes are mostly instances of a handful of objects
+ */
+Object::Object(const Object& prototype, const Transform& objTransform)
+: m_Device(prototype.m_Device), m_Info(prototype.m_Info), m_Transform(objTransform), m_Model(prototype.m_Model), m_Material(prototype.m_Material) {
+	m_ID       = NextID();
+	m_Instance = true;
+}
+
+uint32_t Object::NextID() {
 	static uint32_t IDTotal = 0;
 
-	m_ID = IDTotal++;
+	return IDTotal++;
+}
+
+/**
+ * @brief Creates the material descriptor set once all textures are loaded.
+ * Must not be called while the render thread is recording, the set is swapped in place.
+ */
+bool Object::UpdateStreaming() {
+	if(m_Material->uniform) return true;
+
+	for(auto& texture : m_Material->textures) {
+		if(!texture->IsReady() && !texture->HasFailed()) return false;
+	}
 
+	// A texture that failed to load keeps its placeholder
 	std::vector<Binding> bindings;
-	bindings.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, objInfo.sampler->GetSampler(), m_Albedo->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
-	bindings.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, objInfo.sampler->GetSampler(), m_Normal->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
-	bindings.push_back(
-		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, objInfo.sampler->GetSampler(), m_Metallic->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
-	bindings.push_back(
-		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, objInfo.sampler->GetSampler(), m_Roughness->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
-	m_Uniform = std::make_unique<Uniform>(m_Device, bindings, *objInfo.descriptorPool);
+	for(uint32_t i = 0; i < m_Material->textures.size(); i++) {
+		Image* image = m_Material->textures[i]->IsReady() ? m_Material->textures[i]->Get() : &m_Info.streamer->GetPlaceholderTexture(static_cast<AssetStreamer::PlaceholderTexture>(i));
+		bindings.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, m_Info.sampler->GetSampler(), image->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+	}
+	m_Material->uniform = std::make_unique<Uniform>(m_Device, bindings, *m_Info.descriptorPool);
+	return true;
 }
 
-void Object::Draw(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet) {
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, firstSet, 1, &m_Uniform->GetDescriptorSet(), 0, nullptr);
+/**
+ * @brief Draws the LOD whose error is below `maxPixelError` pixels on screen
+ *
+ * @param lodScale Pixels covered by one unit at distance one, projection[1][1] * screen height / 2
+ * @return Number of triangles drawn
+ */
+uint32_t Object::Draw(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet, const glm::dvec3& cameraTranslation, float lodScale, float maxPixelError) {
+	uint32_t lod = SelectLod(cameraTranslation, lodScale, maxPixelError);
 
-	m_Model->Bind(commandBuffer);
-	m_Model->Draw(commandBuffer);
-}
\ No newline at end of file
+	Bind(layout, commandBuffer, firstSet);
+	GetModel()->Draw(commandBuffer, lod);
+	return GetModel()->GetLod(lod).indexCount / 3;
+}
+
+/**
+ * @brief Picks the LOD whose error is below `maxPixelError` pixels on screen
+ *
+ * @param lodScale Pixels covered by one unit at distance one, projection[1][1] * screen height / 2
+ */
+uint32_t Object::SelectLod(const glm::dvec3& cameraTranslation, float lodScale, float maxPixelError) {
+	// Error is measured at the closest point of the bounding sphere so the LOD never switches too early
+	float scale         = static_cast<float>(glm::max(m_Transform.scale.x, glm::max(m_Transform.scale.y, m_Transform.scale.z)));
+	float distance      = static_cast<float>(glm::length(m_Transform.translation - cameraTranslation)) - GetModel()->GetBoundingRadius() * scale;
+	float pixelsPerUnit = lodScale * scale / glm::max(distance, 0.1f);
+	return GetModel()->SelectLod(pixelsPerUnit, maxPixelError);
+}
+
+/**
+ * @brief Binds the material and the mesh, the draw itself is left to the caller
+ */
+void Object::Bind(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet) {
+	VkDescriptorSet descriptorSet = GetMaterialDescriptorSet();
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, firstSet, 1, &descriptorSet, 0, nullptr);
+
+	GetModel()->Bind(commandBuffer);
+}
+
+VkDescriptorSet Object::GetMaterialDescriptorSet() const { return m_Material->uniform ? m_Material->uniform->GetDescriptorSet() : m_Info.placeholderMaterial->GetDescriptorSet(); }
+
+float Object::GetBoundingRadius() {
+	float scale = static_cast<float>(glm::max(m_Transform.scale.x, glm::max(m_Transform.scale.y, m_Transform.scale.z)));
+	return GetModel()->GetBoundingRadius() * scale;
+}
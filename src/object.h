@@ -1,5 +1,6 @@
 #pragma once
 
+#include "vulkan/assetStreamer.h"
 #include "vulkan/descriptors.h"
 #include "vulkan/image.h"
 #include "vulkan/model.h"
@@ -16,6 +17,8 @@ struct ObjectInfo {
 	Device* device;
 	Sampler* sampler;
 	DescriptorPool* descriptorPool;
+	AssetStreamer* streamer;
+	Uniform* placeholderMaterial;    // drawn until every texture of the object is loaded
 };
 
 struct Transform {
@@ -39,32 +42,62 @@ struct Properties {};
 class Object {
 public:
 	Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& modelFilepath, 
-		const std::string& albedoMap, 
-		const std::string& normalMap = "../../assets/textures/empty_normal.jpg",
-		const std::string& metallicMap = "../../assets/textures/empty_metallic.jpg",
-		const std::string& roughnessMap = "../../assets/textures/empty_roughness.jpg"
+		const TextureSource& albedoMap, 
+		const TextureSource& normalMap = "../../assets/textures/empty_normal.jpg",
+		const TextureSource& metallicMap = "../../assets/textures/empty_metallic.jpg",
+		const TextureSource& roughnessMap = "../../assets/textures/empty_roughness.jpg"
 	);
+	Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& gltfFilepath);
+	// Another instance of `prototype`, it shares the model, the textures and the material descriptor set
+	Object(const Object& prototype, const Transform& objTransform);
 	~Object() = default;
 
+	static const std::array<TextureSource, 4> DEFAULT_MATERIAL;
+
 	Properties& GetObjectProperties() { return m_Properties; }
 
 	Transform& GetObjectTransform() { return m_Transform; }
 
 	uint32_t GetObjectID() { return m_ID; }
 
-	void Draw(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet);
+	uint32_t Draw(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet, const glm::dvec3& cameraTranslation, float lodScale, float maxPixelError);
+	uint32_t SelectLod(const glm::dvec3& cameraTranslation, float lodScale, float maxPixelError);
+	void Bind(VkPipelineLayout layout, VkCommandBuffer commandBuffer, int firstSet);
+
+	// The object's textures, or the placeholder material until all of them are loaded
+	VkDescriptorSet GetMaterialDescriptorSet() const;
+
+	// Radius of the bounding sphere around the object's translation
+	float GetBoundingRadius();
+
+	// Returns true once the material is final, instances share it with their prototype
+	bool UpdateStreaming();
+
+	inline bool IsInstance() const { return m_Instance; }
+
+	// The loaded model, or the placeholder while it is still streaming
+	inline Model* GetModel() { return m_Model->IsReady() ? m_Model->Get() : &m_Info.streamer->GetPlaceholderModel(); }
+
+	inline bool IsLoaded() const { return m_Model->IsReady() && m_Material->uniform != nullptr; }
 
 private:
 	Properties m_Properties;
 	Transform m_Transform;
 	uint32_t m_ID;
+	bool m_Instance = false;
 
 private:
+	Object(const ObjectInfo& objInfo, const Transform& objTransform, const std::string& modelFilepath, const std::array<TextureSource, 4>& material);
+	static uint32_t NextID();
+
+	// Shared by all instances of an object, whichever updates first creates the descriptor set
+	struct Material {
+		std::array<std::shared_ptr<Asset<Image>>, AssetStreamer::PLACEHOLDER_COUNT> textures;    // albedo, normal, metallic + roughness
+		std::unique_ptr<Uniform> uniform;
+	};
+
 	Device& m_Device;
-	std::unique_ptr<Model> m_Model;
-	std::unique_ptr<Uniform> m_Uniform;
-	std::unique_ptr<Image> m_Albedo;
-	std::unique_ptr<Image> m_Normal;
-	std::unique_ptr<Image> m_Metallic;
-	std::unique_ptr<Image> m_Roughness;
+	ObjectInfo m_Info;
+	std::shared_ptr<Asset<Model>> m_Model;
+	std::shared_ptr<Material> m_Material;
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+std::atomic<bool> CpuProfiler::enabled {true};
+std::mutex CpuProfiler::s_ThreadsMutex;
+std::vector<std::unique_ptr<CpuProfiler::ThreadBuffer>> CpuProfiler::s_Threads;
+thread_local CpuProfiler::ThreadBuffer* CpuProfiler::s_ThreadBuffer = nullptr;
+
+// steady_clock instead of rdtsc, the TSC rate would have to be calibrated and isn't invariant on every CPU. Reading it
+// is a vDSO call that takes about as long as rdtsc with the conversion.
+static const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+uint64_t CpuProfiler::Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count(); }
+
+CpuProfiler::Zone::Zone(const char* name): m_Name(name), m_Start(0) {
+	if(s_ThreadBuffer == nullptr || !enabled.load(std::memory_order_relaxed)) {
+		m_Name = nullptr;
+		return;
+	}
+
+	s_ThreadBuffer->depth++;
+	m_Start = Now();
+}
+
+CpuProfiler::Zone::~Zone() {
+	if(m_Name == nullptr) return;
+
+	uint64_t end         = Now();
+	ThreadBuffer& buffer = *s_ThreadBuffer;
+	buffer.depth--;
+
+	// The sequence is cleared before the fields change and set after, a reader that sees the same number on both
+	// sides of its copy got a whole event
+	uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	Slot& slot    = buffer.events[head & (EVENTS_PER_THREAD - 1)];
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(m_Name, std::memory_order_relaxed);
+	slot.start.store(m_Start, std::memory_order_relaxed);
+	slot.end.store(end, std::memory_order_relaxed);
+	slot.depth.store(buffer.depth, std::memory_order_relaxed);
+	slot.sequence.store(head + 1, std::memory_order_release);
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+CpuProfiler::ThreadExit::~ThreadExit() {
+	std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+	s_ThreadBuffer->inUse = false;
+}
+
+void CpuProfiler::RegisterThread(const std::string& name) {
+	if(s_ThreadBuffer != nullptr) return;
+
+	{
+		// Buffers are never freed, the events of a thread that exited can still be exported
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+		auto reusable = std::find_if(s_Threads.begin(), s_Threads.end(), [&](const std::unique_ptr<ThreadBuffer>& buffer) { return !buffer->inUse && buffer->name == name; });
+		if(reusable != s_Threads.end()) {
+			(*reusable)->inUse = true;
+			s_ThreadBuffer     = reusable->get();
+		}
+		else {
+			auto buffer    = std::make_unique<ThreadBuffer>();
+			buffer->name   = name;
+			buffer->id     = static_cast<uint32_t>(s_Threads.size());
+			buffer->events = std::make_unique<Slot[]>(EVENTS_PER_THREAD);
+			s_ThreadBuffer = buffer.get();
+			s_Threads.push_back(std::move(buffer));
+		}
+	}
+
+	static thread_local ThreadExit exit;
+	(void)exit;
+}
+
+/**
+ * @brief Copies the event with number `index` out of `slot`, false if the slot doesn't hold it (anymore)
+ */
+bool CpuProfiler::ReadSlot(const Slot& slot, uint64_t index, Event& event) {
+	uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+	event.name        = slot.name.load(std::memory_order_relaxed);
+	event.start       = slot.start.load(std::memory_order_relaxed);
+	event.end         = slot.end.load(std::memory_order_relaxed);
+	event.depth       = slot.depth.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return sequence == index + 1 && slot.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+std::vector<CpuProfiler::ThreadEvents> CpuProfiler::Snapshot(uint64_t since) {
+	std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+	std::vector<ThreadEvents> threads;
+	threads.reserve(s_Threads.size());
+	for(const std::unique_ptr<ThreadBuffer>& buffer : s_Threads) {
+		ThreadEvents& thread = threads.emplace_back();
+		thread.name          = buffer->name;
+		thread.id            = buffer->id;
+
+		// Events are written in the order they end, the ones before `since` are skipped without copying them. The owner
+		// keeps writing meanwhile, the oldest events may be overwritten and are left out.
+		uint64_t head  = buffer->head.load(std::memory_order_acquire);
+		uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+		uint64_t start = head;
+		Event event;
+		while(start > first && ReadSlot(buffer->events[(start - 1) & (EVENTS_PER_THREAD - 1)], start - 1, event) && event.end >= since) start--;
+
+		thread.events.reserve(head - start);
+		for(uint64_t i = start; i < head; i++) {
+			if(ReadSlot(buffer->events[i & (EVENTS_PER_THREAD - 1)], i, event)) thread.events.push_back(event);
+		}
+	}
+	return threads;
+}
+
+static void WriteJsonString(std::ofstream& file, const std::string& string) {
+	file << '"';
+	for(char c : string) {
+		if(c == '"' || c == '\\') file << '\\';
+		file << c;
+	}
+	file << '"';
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::string& filepath) {
+	std::ofstream file(filepath, std::ios::out | std::ios::trunc);
+	if(!file.is_open()) return false;
+
+	std::vector<ThreadEvents> threads = Snapshot();
+
+	// Complete events ("X") with microsecond timestamps, the thread names are metadata events
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for(const ThreadEvents& thread : threads) {
+		file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.id << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+		WriteJsonString(file, thread.name);
+		file << "}}";
+		first = false;
+
+		for(const Event& event : thread.events) {
+			file << ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.id << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << ",\"name\":";
+			WriteJsonString(file, event.name);
+			file << "}";
+		}
+	}
+	file << "\n]}\n";
+
+	return file.good();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing block, `name` has to be a string literal
+#define PROFILE_ZONE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+/**
+ * @brief Records nested zones of CPU time on every thread that registered itself.
+ *
+ * Each thread writes into its own ring of events, a zone end is a timestamp and a few atomic stores, no locks and no
+ * allocations. Every slot carries a sequence number like a seqlock, readers copy the rings and drop the events the owning
+ * thread overwrote while they copied, so recording never waits on the UI or the export. Threads that never called
+ * RegisterThread aren't recorded.
+ */
+class CpuProfiler {
+public:
+	static constexpr uint32_t EVENTS_PER_THREAD = 1 << 15;    // power of two, a few seconds of zones per thread
+
+	struct Event {
+		const char* name;
+		uint64_t start;    // nanoseconds since the profiler started
+		uint64_t end;
+		uint32_t depth;    // number of zones around this one
+	};
+
+	struct ThreadEvents {
+		std::string name;
+		uint32_t id;
+		std::vector<Event> events;    // ordered by end time
+	};
+
+	/**
+	 * @brief Begins a zone in its constructor and ends it in its destructor
+	 */
+	class Zone {
+	public:
+		Zone(const char* name);
+		~Zone();
+
+		Zone(const Zone&)            = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+	// Called once at the start of a thread, before its first zone. The ring of an exited thread with the same name is
+	// reused, so short lived worker threads don't add a ring each.
+	static void RegisterThread(const std::string& name);
+
+	static uint64_t Now();
+
+	// Copies the events that ended at or after `since` on every thread
+	static std::vector<ThreadEvents> Snapshot(uint64_t since = 0);
+
+	// Chrome trace_event JSON, opens in chrome://tracing or ui.perfetto.dev
+	static bool WriteChromeTrace(const std::string& filepath);
+
+	static std::atomic<bool> enabled;
+
+private:
+	// An Event whose fields are atomics, the owning thread writes them while readers copy
+	struct Slot {
+		std::atomic<uint64_t> sequence {0};    // index of the event + 1 once it is written, 0 while it is being written
+		std::atomic<const char*> name {nullptr};
+		std::atomic<uint64_t> start {0};
+		std::atomic<uint64_t> end {0};
+		std::atomic<uint32_t> depth {0};
+	};
+
+	struct ThreadBuffer {
+		std::string name;
+		uint32_t id;
+		std::unique_ptr<Slot[]> events;
+		std::atomic<uint64_t> head {0};    // events written so far, only the owning thread writes it
+		uint32_t depth = 0;
+		bool inUse     = true;    // guarded by s_ThreadsMutex
+	};
+
+	// Hands the thread's buffer back when the thread exits
+	struct ThreadExit {
+		~ThreadExit();
+	};
+
+	static bool ReadSlot(const Slot& slot, uint64_t index, Event& event);
+
+	static std::mutex s_ThreadsMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> s_Threads;
+	static thread_local ThreadBuffer* s_ThreadBuffer;
+};
@@ -1,10 +1,13 @@
 #include "renderer.h"
 
+#include "profiler.h"
 #include "vulkan/model.h"
 #include "imgui/backends/imgui_impl_glfw.h"
 #include "imgui/backends/imgui_impl_vulkan.h"
 #include "vulkan/pipeline.h"
+#include "vulkan/uniformRing.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <memory>
@@ -13,11 +16,20 @@
 #include <vulkan/vulkan_core.h>
 
 Renderer::Renderer(Window& window, Device& device, VkDescriptorPool pool): m_Window(window), m_Device(device), m_Pool(pool) {
+	m_Culler        = std::make_unique<OcclusionCuller>(m_Device);
+	m_LightClusters = std::make_unique<LightClusters>(m_Device);
+	m_Impostors     = std::make_unique<Impostors>(m_Device, m_LightClusters->GetDescriptorSetLayout());
+	m_PostProcess       = std::make_unique<PostProcess>(m_Device);
+	m_DynamicResolution = std::make_unique<DynamicResolution>(m_Device);
+	m_Profiler          = std::make_unique<GpuProfiler>(m_Device);
+	m_Ibl               = std::make_unique<ImageBasedLighting>(m_Device);
+
 	CreatePipelineLayouts();
 	RecreateSwapchain();
 	CreateCommandBuffers();
 
-    ImGuiInit();
+	// ImGui needs the GLFW window for its input
+	if(!m_Device.IsHeadless()) ImGuiInit();
 }
 
 Renderer::~Renderer() {
@@ -27,6 +39,8 @@ Renderer::~Renderer() {
 	vkDestroyPipelineLayout(m_Device.GetDevice(), m_StarsPipelineLayout, nullptr);
 	m_CommandBuffers.clear();
 
+	if(m_Device.IsHeadless()) return;
+
     ImGui_ImplVulkan_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -54,16 +68,17 @@ void Renderer::ImGuiInit()
 	info.DescriptorPool  = m_Pool;
 	info.Subpass         = 0;
 	info.MinImageCount   = 2;
-	info.ImageCount      = GetSwapchainImageCount();
+	// ImGui cycles through its vertex buffers with this count, it must not reuse one that a frame in flight still reads
+	info.ImageCount      = std::max<uint32_t>(GetSwapchainImageCount(), Swapchain::MAX_FRAMES_IN_FLIGHT);
 	info.CheckVkResultFn = CheckVkResult;
-	ImGui_ImplVulkan_Init(&info, GetGeometryRenderPass());
+	ImGui_ImplVulkan_Init(&info, GetUiRenderPass());
 
 	VkCommandBuffer cmdBuffer;
 	m_Device.BeginSingleTimeCommands(cmdBuffer);
 	ImGui_ImplVulkan_CreateFontsTexture(cmdBuffer);
 	m_Device.EndSingleTimeCommands(cmdBuffer);
 
-	vkDeviceWaitIdle(m_Device.GetDevice());
+	m_Device.WaitIdle();
 	ImGui_ImplVulkan_DestroyFontUploadObjects();
 }
 
@@ -73,18 +88,31 @@ void Renderer::RecreateSwapchain() {
 		extent = m_Window.GetExtent();
 		glfwWaitEvents();
 	}
-	vkDeviceWaitIdle(m_Device.GetDevice());
+	m_Device.WaitIdle();
 
-	if(m_Swapchain == nullptr) { m_Swapchain = std::make_unique<Swapchain>(m_Device, extent); }
+	if(m_Swapchain == nullptr) { m_Swapchain = std::make_unique<Swapchain>(m_Device, extent, m_PresentSettings); }
 	else {
 		std::shared_ptr<Swapchain> oldSwapchain = std::move(m_Swapchain);
-		m_Swapchain                             = std::make_unique<Swapchain>(m_Device, extent, oldSwapchain);
+		m_Swapchain                             = std::make_unique<Swapchain>(m_Device, extent, m_PresentSettings, oldSwapchain);
 		if(!oldSwapchain->CompareSwapFormats(*m_Swapchain.get())) { throw std::runtime_error("Swap chain image or depth formats have changed!"); }
 	}
 
+	// The device is idle, every frame in flight is free to be used next
+	m_CurrentFrameIndex %= m_Swapchain->GetFramesInFlight();
+
+	m_Culler->Resize(*m_Swapchain);
+	m_PostProcess->Resize(*m_Swapchain);
+
 	CreatePipelines();
 }
 
+void Renderer::SetPresentSettings(const PresentSettings& settings) {
+	m_PresentSettings        = settings;
+	m_PresentSettingsChanged = true;
+}
+
+void Renderer::WaitForNextFrame() { m_Swapchain->WaitForFrame(m_CurrentFrameIndex); }
+
 void Renderer::CreateCommandBuffers() {
 	m_CommandBuffers.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
 
@@ -102,9 +130,18 @@ void Renderer::FreeCommandBuffers() {
 }
 
 VkCommandBuffer Renderer::BeginFrame() {
+	PROFILE_ZONE("Begin frame");
+
 	ASSERT(!m_IsFrameStarted);    // Can't call BeginFrame while already in progress!
 
-	auto result = m_Swapchain->AcquireNextImage(&m_CurrentImageIndex);
+	if(m_PresentSettingsChanged) {
+		m_PresentSettingsChanged = false;
+		RecreateSwapchain();
+	}
+
+	uint64_t waitStart = CpuProfiler::Now();
+	auto result        = m_Swapchain->AcquireNextImage(m_CurrentFrameIndex, &m_CurrentImageIndex);
+	m_FrameWaitTime    = CpuProfiler::Now() - waitStart;
 	if(result == VK_ERROR_OUT_OF_DATE_KHR) {
 		RecreateSwapchain();
 		return nullptr;
@@ -121,23 +158,29 @@ VkCommandBuffer Renderer::BeginFrame() {
 }
 
 void Renderer::EndFrame() {
+	PROFILE_ZONE("Submit");
+
 	auto commandBuffer = GetCurrentCommandBuffer();
 	ASSERT(m_IsFrameStarted);    // Can't call EndFrame while frame is not in progress
 
 	if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) { throw std::runtime_error("failed to record command buffer!"); }
 
-	auto result = m_Swapchain->SubmitCommandBuffers(&commandBuffer, &m_CurrentImageIndex);
+	auto result = m_Swapchain->SubmitCommandBuffers(&commandBuffer, m_CurrentFrameIndex, &m_CurrentImageIndex);
+
+	m_IsFrameStarted    = false;
+	m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % m_Swapchain->GetFramesInFlight();
+
 	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_Window.WasWindowResized()) {
 		m_Window.ResetWindowResizedFlag();
 		RecreateSwapchain();
 	}
 	else if(result != VK_SUCCESS) { throw std::runtime_error("failed to present swap chain image!"); }
-
-	m_IsFrameStarted    = false;
-	m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % Swapchain::MAX_FRAMES_IN_FLIGHT;
 }
 
-void Renderer::BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& clearColor, VkFramebuffer framebuffer, const VkRenderPass& renderPass) {
+/**
+ * @brief Renders to the top left `extent` of the framebuffer, which can be smaller than the framebuffer itself
+ */
+void Renderer::BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& clearColor, VkFramebuffer framebuffer, const VkRenderPass& renderPass, VkExtent2D extent) {
 	ASSERT(m_IsFrameStarted);                              // Can't call BeginSwapchainRenderPass while frame is not in progress
 	ASSERT(commandBuffer == GetCurrentCommandBuffer());    // Can't Begin Render pass on command buffer from different frame
 
@@ -146,7 +189,7 @@ void Renderer::BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& c
 	renderPassInfo.renderPass        = renderPass;
 	renderPassInfo.framebuffer       = framebuffer;
 	renderPassInfo.renderArea.offset = {0, 0};
-	renderPassInfo.renderArea.extent = m_Swapchain->GetSwapchainExtent();
+	renderPassInfo.renderArea.extent = extent;
 	std::array<VkClearValue, 2> clearValues {};
 	clearValues[0].color           = {clearColor.r, clearColor.g, clearColor.b};
 	clearValues[1].depthStencil    = {1.0f, 0};
@@ -158,13 +201,13 @@ void Renderer::BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& c
 	VkViewport viewport {};
 	viewport.x        = 0.0f;
 	viewport.y        = 0.0f;
-	viewport.width    = static_cast<float>(m_Swapchain->GetSwapchainExtent().width);
-	viewport.height   = static_cast<float>(m_Swapchain->GetSwapchainExtent().height);
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 	VkRect2D scissor {
 		{0, 0},
-		m_Swapchain->GetSwapchainExtent()
+		extent
     };
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
@@ -177,66 +220,228 @@ void Renderer::EndRenderPass(VkCommandBuffer commandBuffer) {
 	vkCmdEndRenderPass(commandBuffer);
 }
 
-void Renderer::Render(FrameInfo frameInfo, std::function<void(VkCommandBuffer& commandBuffer)> renderImGui) {
+void Renderer::Render(FrameInfo& frameInfo, std::function<void(VkCommandBuffer& commandBuffer)> renderImGui) {
+	uint64_t start = CpuProfiler::Now();
+
+	// The skybox streams in after startup, its ambient lighting is computed (or loaded from the cache) once it arrived
+	// and replaces the black maps the earlier frames still sample, so only their fences are waited on instead of the device
+	if(!m_Ibl->IsReady() && frameInfo.skybox->IsCubemapReady()) {
+		m_Swapchain->WaitForFrames();
+		m_Ibl->Build(frameInfo.skybox->GetCubemap(), frameInfo.skybox->GetFilepaths());
+	}
+
 	if(auto commandBuffer = BeginFrame()) {
 		frameInfo.commandBuffer = commandBuffer;
 
+		// The fence of this frame was waited on, its last timings decide the resolution the geometry renders at
+		m_RenderExtent = m_DynamicResolution->Update(m_CurrentFrameIndex, m_Swapchain->GetSwapchainExtent());
+		m_DynamicResolution->BeginTiming(commandBuffer, m_CurrentFrameIndex);
+
+		// Results of the last frame that used this command buffer, it is finished by now
+		m_Profiler->BeginFrame(commandBuffer, m_CurrentFrameIndex, frameInfo.inputTime);
+
 		// SHADOW MAP PASS
 		BeginRenderPass(commandBuffer, {0.01f, 0.01f, 0.01f}, m_Swapchain->GetShadowMapFrameBuffer(m_CurrentFrameIndex),
-			m_Swapchain->GetShadowMapRenderPass());
-
+			m_Swapchain->GetShadowMapRenderPass(), m_Swapchain->GetSwapchainExtent());
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Shadow");
+		}
 		EndRenderPass(commandBuffer);
 		
 		// ------------------- GEOMETRY RENDER PASS -----------------
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Culling");
+
+			// Early pass draws what was visible last frame, its depth decides what else the late pass draws
+			CullGameObjects(frameInfo);
+
+			// Atlases requested last frame, their objects are drawn as meshes until they are baked
+			m_Impostors->Bake(commandBuffer);
+
+			m_LightClusters->Cull(commandBuffer, m_CurrentFrameIndex, frameInfo.lights, frameInfo.camera.GetView(), frameInfo.camera.GetProj(), frameInfo.camera.GetNear(),
+			                      frameInfo.camera.GetFar(), m_RenderExtent);
+		}
+
 		BeginRenderPass(commandBuffer, {0.01f, 0.01f, 0.01f}, m_Swapchain->GetGeometryFrameBuffer(m_CurrentFrameIndex), 
-			m_Swapchain->GetGeometryRenderPass());
+			m_Swapchain->GetGeometryRenderPass(), m_RenderExtent);
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Skybox");
+			RenderSkybox(frameInfo);
+		}
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "PBR");
+			RenderGameObjects(frameInfo, false);
+		}
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Stars");
+			RenderStars(frameInfo);
+		}
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Impostors");
+
+			// Not occlusion culled, they are too cheap for it. Their depth still occludes what the late pass would draw
+			m_Impostors->Draw(commandBuffer, frameInfo.uniformDescriptorSet, frameInfo.globalUboOffset, m_LightClusters->GetDescriptorSet());
+			m_DrawnTriangleCount += m_Impostors->GetImpostorCount() * 2;
+		}
+		EndRenderPass(commandBuffer);
 
-		RenderSkybox(frameInfo);
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Late culling");
+			m_Culler->CullLate(commandBuffer);
+		}
 
-		RenderGameObjects(frameInfo);
+		BeginRenderPass(commandBuffer, {0.01f, 0.01f, 0.01f}, m_Swapchain->GetGeometryFrameBuffer(m_CurrentFrameIndex), 
+			m_Swapchain->GetGeometryLateRenderPass(), m_RenderExtent);
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "PBR late");
+			RenderGameObjects(frameInfo, true);
+		}
+		EndRenderPass(commandBuffer);
 
-		renderImGui(commandBuffer);
+		// ------------------- POST PROCESSING -----------------
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "Post processing");
+			m_PostProcess->Record(commandBuffer, m_CurrentFrameIndex, m_CurrentImageIndex, m_RenderExtent, frameInfo.exposure, frameInfo.frameTime);
+		}
 
+		m_DynamicResolution->EndTiming(commandBuffer, m_CurrentFrameIndex);
+
+		BeginRenderPass(commandBuffer, {0.01f, 0.01f, 0.01f}, m_Swapchain->GetUiFrameBuffer(m_CurrentImageIndex), m_Swapchain->GetUiRenderPass(),
+		                m_Swapchain->GetSwapchainExtent());
+		{
+			GpuProfiler::Scope scope(*m_Profiler, commandBuffer, "ImGui");
+			renderImGui(commandBuffer);
+		}
 		EndRenderPass(commandBuffer);
+
+		m_Profiler->EndFrame(commandBuffer);
 		EndFrame();
+
+		m_CpuFrameTime = static_cast<float>(CpuProfiler::Now() - start - m_FrameWaitTime) * 1e-6f;
+	}
+}
+
+/**
+ * @brief Adds every game object to the occlusion culler with the LOD it is drawn at and records the early culling pass
+ */
+void Renderer::CullGameObjects(FrameInfo& frameInfo) {
+	PROFILE_ZONE("Cull objects");
+
+	float lodScale = frameInfo.camera.GetProj()[1][1] * m_RenderExtent.height * 0.5f;
+
+	// The culler reports the triangles of the last frame that finished with these buffers
+	m_Culler->BeginFrame(m_CurrentFrameIndex);
+	m_DrawnTriangleCount = m_Culler->GetDrawnTriangleCount();
+
+	m_Impostors->BeginFrame(m_CurrentFrameIndex);
+
+	m_CulledDraws.clear();
+	for(const auto& [id, object] : *frameInfo.gameObjects) {
+		Model* model = object->GetModel();
+		if(!model->HasIndexBuffer()) {
+			m_CulledDraws.push_back({object.get(), 0});
+			continue;
+		}
+
+		glm::vec3 center = object->GetObjectTransform().translation - frameInfo.camera.m_Translation;
+		if(AddImpostor(*object, center, lodScale, frameInfo.camera.m_Translation, false)) continue;
+
+		uint32_t lod  = object->SelectLod(frameInfo.camera.m_Translation, lodScale, m_LodPixelError);
+		uint32_t draw = m_Culler->AddObject(object->GetObjectID(), center, object->GetBoundingRadius(), model->GetLod(lod));
+		m_CulledDraws.push_back({object.get(), draw});
 	}
+
+	m_Culler->CullEarly(frameInfo.commandBuffer, frameInfo.camera.GetView(), frameInfo.camera.GetProj(), m_RenderExtent);
 }
 
-void Renderer::RenderGameObjects(FrameInfo& frameInfo) {
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PBRPipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+/**
+ * @brief Records an indirect draw per game object, the culling passes set which ones draw anything
+ */
+void Renderer::RenderGameObjects(FrameInfo& frameInfo, bool late) {
+	PROFILE_ZONE("Record objects");
+
+	float lodScale      = frameInfo.camera.GetProj()[1][1] * m_RenderExtent.height * 0.5f;
+	VkBuffer drawBuffer = late ? m_Culler->GetLateDrawBuffer() : m_Culler->GetEarlyDrawBuffer();
 
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PBRPipelineLayout, 1, 1, &frameInfo.lightsDescriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PBRPipelineLayout, 0, 1, &frameInfo.uniformDescriptorSet, 1, &frameInfo.globalUboOffset);
+
+	VkDescriptorSet lightsSet = m_LightClusters->GetDescriptorSet();
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PBRPipelineLayout, 1, 1, &lightsSet, 0, nullptr);
+
+	VkDescriptorSet iblSet = m_Ibl->GetDescriptorSet();
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PBRPipelineLayout, 3, 1, &iblSet, 0, nullptr);
 
 	m_PBRPipeline->Bind(frameInfo.commandBuffer);
-	for(std::pair<int, std::shared_ptr<Object>> obj : frameInfo.gameObjects) {
+	for(const CulledDraw& culledDraw : m_CulledDraws) {
+		Object* object = culledDraw.object;
+
+		// Models without indices can't be culled, they are always drawn in the early pass
+		bool indexed = object->GetModel()->HasIndexBuffer();
+		if(!indexed && late) continue;
+
+		// Vertex positions are quantized to the model bounds, the dequantization is folded into the model matrix
+		glm::mat4 transform = object->GetObjectTransform().mat4(frameInfo.camera.m_Translation);
 
 		PushConstantsPBR push {};
-		push.modelMatrix  = obj.second->GetObjectTransform().mat4(frameInfo.camera.m_Translation);
-		push.normalMatrix = glm::transpose(glm::inverse(glm::mat3(obj.second->GetObjectTransform().mat4(frameInfo.camera.m_Translation))));
+		push.modelMatrix  = transform * object->GetModel()->GetDequantization();
+		push.normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
 
 		vkCmdPushConstants(frameInfo.commandBuffer, m_PBRPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantsPBR), &push);
 
-		obj.second->Draw(m_PBRPipelineLayout, frameInfo.commandBuffer, 2);
+		if(!indexed) {
+			m_DrawnTriangleCount += object->Draw(m_PBRPipelineLayout, frameInfo.commandBuffer, 2, frameInfo.camera.m_Translation, lodScale, m_LodPixelError);
+			continue;
+		}
+
+		object->Bind(m_PBRPipelineLayout, frameInfo.commandBuffer, 2);
+		vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, drawBuffer, OcclusionCuller::GetDrawOffset(culledDraw.draw), 1, sizeof(VkDrawIndexedIndirectCommand));
 	}
+}
+
+void Renderer::RenderStars(FrameInfo& frameInfo) {
+	PROFILE_ZONE("Record stars");
+
+	float lodScale = frameInfo.camera.GetProj()[1][1] * m_RenderExtent.height * 0.5f;
 
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_StarsPipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_StarsPipelineLayout, 0, 1, &frameInfo.uniformDescriptorSet, 1, &frameInfo.globalUboOffset);
 
 	m_StarsPipeline->Bind(frameInfo.commandBuffer);
-	for(std::pair<int, std::shared_ptr<Object>> obj : frameInfo.stars) {
+	for(const auto& [id, object] : *frameInfo.stars) {
+		glm::vec3 center = object->GetObjectTransform().translation - frameInfo.camera.m_Translation;
+		if(AddImpostor(*object, center, lodScale, frameInfo.camera.m_Translation, true)) continue;
 
 		PushConstants push {};
-		push.modelMatrix  = obj.second->GetObjectTransform().mat4(frameInfo.camera.m_Translation);
-		
+		push.modelMatrix = object->GetObjectTransform().mat4(frameInfo.camera.m_Translation) * object->GetModel()->GetDequantization();
+
 		vkCmdPushConstants(frameInfo.commandBuffer, m_StarsPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &push);
 
-		obj.second->Draw(m_StarsPipelineLayout, frameInfo.commandBuffer, 1);
+		m_DrawnTriangleCount += object->Draw(m_StarsPipelineLayout, frameInfo.commandBuffer, 1, frameInfo.camera.m_Translation, lodScale, m_LodPixelError);
 	}
 }
 
+/**
+ * @brief Hands the object to the impostors if its bounding sphere is smaller than the pixel threshold on screen
+ * @return true if the impostor replaces the mesh this frame
+ */
+bool Renderer::AddImpostor(Object& object, const glm::vec3& center, float lodScale, const glm::dvec3& cameraTranslation, bool emissive) {
+	// Only baked once, the placeholders would stay in the atlas forever
+	if(!object.IsLoaded() || !object.GetModel()->HasIndexBuffer()) return false;
+
+	float radius   = object.GetBoundingRadius();
+	float distance = glm::length(center);
+	if(distance <= radius || 2.0f * radius * lodScale / distance >= m_ImpostorPixelSize) return false;
+
+	// The atlas is rendered in model space, the impostor needs the rotation without the scale
+	glm::mat3 transform = object.GetObjectTransform().mat4(cameraTranslation);
+	glm::quat rotation  = glm::quat_cast(glm::mat3(glm::normalize(transform[0]), glm::normalize(transform[1]), glm::normalize(transform[2])));
+
+	return m_Impostors->Add(object.GetModel(), object.GetMaterialDescriptorSet(), center, radius, rotation, emissive);
+}
+
 void Renderer::RenderSkybox(FrameInfo& frameInfo) {
 	m_SkyboxPipeline->Bind(frameInfo.commandBuffer);
 
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_SkyboxPipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_SkyboxPipelineLayout, 0, 1, &frameInfo.uniformDescriptorSet, 1, &frameInfo.globalUboOffset);
 
 	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_SkyboxPipelineLayout, 1, 1, &frameInfo.skyboxDescriptorSet, 0, nullptr);
 
@@ -246,7 +451,7 @@ void Renderer::RenderSkybox(FrameInfo& frameInfo) {
 	transform              = glm::scale(transform, scale);
 
 	PushConstants push {};
-	push.modelMatrix = transform;
+	push.modelMatrix = glm::mat4(transform) * frameInfo.skybox->GetSkyboxModel()->GetDequantization();
 
 	vkCmdPushConstants(frameInfo.commandBuffer, m_SkyboxPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &push);
 
@@ -259,15 +464,13 @@ void Renderer::CreatePipelineLayouts() {
 	// Stars Pipline layout
 	//
 	{
-		auto globalLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
-		globalLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
-		auto globalLayout = globalLayoutBuilder.Build();
+		// Global ubo lives in the per frame uniform ring
+		auto globalLayout = UniformRing::CreateDescriptorSetLayout(m_Device);
 
 		auto texturesLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
 		texturesLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		texturesLayoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		texturesLayoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
-		texturesLayoutBuilder.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		auto textureLayout = texturesLayoutBuilder.Build();
 
 		VkPushConstantRange pushConstantRange {};
@@ -283,27 +486,28 @@ void Renderer::CreatePipelineLayouts() {
 	// PBR Pipline layout
 	//
 	{
-		auto globalLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
-		globalLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
-		auto globalLayout = globalLayoutBuilder.Build();
+		// Global ubo lives in the per frame uniform ring
+		auto globalLayout = UniformRing::CreateDescriptorSetLayout(m_Device);
 
 		auto texturesLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
 		texturesLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		texturesLayoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		texturesLayoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
-		texturesLayoutBuilder.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
 		auto textureLayout = texturesLayoutBuilder.Build();
 
-		auto lightsLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
-		lightsLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
-		auto lightsLayout = lightsLayoutBuilder.Build();
+		// Light lists of the clusters, written by the light assignment pass every frame
+		auto lightsLayout = m_LightClusters->GetDescriptorSetLayout();
+
+		// Ambient light from the skybox
+		auto iblLayout = m_Ibl->GetDescriptorSetLayout();
 
 		VkPushConstantRange pushConstantRange {};
 		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		pushConstantRange.offset     = 0;
 		pushConstantRange.size       = sizeof(PushConstantsPBR);
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {globalLayout->GetDescriptorSetLayout(), lightsLayout->GetDescriptorSetLayout(), textureLayout->GetDescriptorSetLayout()};
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {globalLayout->GetDescriptorSetLayout(), lightsLayout->GetDescriptorSetLayout(), textureLayout->GetDescriptorSetLayout(),
+		                                                         iblLayout->GetDescriptorSetLayout()};
 		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_PBRPipelineLayout, &pushConstantRange);
 	}
 
@@ -311,9 +515,8 @@ void Renderer::CreatePipelineLayouts() {
 	// Skybox Pipeline layout
 	//
 	{
-		auto globalLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
-		globalLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
-		auto globalLayout = globalLayoutBuilder.Build();
+		// Global ubo lives in the per frame uniform ring
+		auto globalLayout = UniformRing::CreateDescriptorSetLayout(m_Device);
 
 		auto skyboxLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
 		skyboxLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -342,8 +545,8 @@ void Renderer::CreatePipelines() {
 		pipelineConfig.renderPass     = m_Swapchain->GetGeometryRenderPass();
 		pipelineConfig.pipelineLayout = m_StarsPipelineLayout;
 		m_StarsPipeline             = std::make_unique<Pipeline>(m_Device);
-		m_StarsPipeline->CreatePipeline("../../shaders/spv/star.vert.spv", "../../shaders/spv/star.frag.spv", pipelineConfig, Model::Vertex::GetBindingDescriptions(),
-		                                  Model::Vertex::GetAttributeDescriptions());
+		m_StarsPipeline->CreatePipeline(SHADER_DIRECTORY "star.vert.spv", SHADER_DIRECTORY "star.frag.spv", pipelineConfig, Model::PackedVertex::GetBindingDescriptions(),
+		                                  Model::PackedVertex::GetAttributeDescriptions());
 	}
 	
 	//
@@ -357,10 +560,15 @@ void Renderer::CreatePipelines() {
 		pipelineConfig.renderPass     = m_Swapchain->GetGeometryRenderPass();
 		pipelineConfig.pipelineLayout = m_PBRPipelineLayout;
 		m_PBRPipeline             = std::make_unique<Pipeline>(m_Device);
-		m_PBRPipeline->CreatePipeline("../../shaders/spv/PBR.vert.spv", "../../shaders/spv/PBR.frag.spv", pipelineConfig, Model::Vertex::GetBindingDescriptions(),
-		                                  Model::Vertex::GetAttributeDescriptions());
+		m_PBRPipeline->CreatePipeline(SHADER_DIRECTORY "PBR.vert.spv", SHADER_DIRECTORY "PBR.frag.spv", pipelineConfig, Model::PackedVertex::GetBindingDescriptions(),
+		                                  Model::PackedVertex::GetAttributeDescriptions());
 	}
 
+	//
+	// Impostor Pipeline
+	//
+	m_Impostors->CreateDrawPipeline(m_Swapchain->GetGeometryRenderPass());
+
 	//
 	// Skybox Pipeline
 	//
@@ -372,7 +580,7 @@ void Renderer::CreatePipelines() {
 		pipelineConfig.renderPass = m_Swapchain->GetGeometryRenderPass();
 		pipelineConfig.pipelineLayout = m_SkyboxPipelineLayout;
 		m_SkyboxPipeline              = std::make_unique<Pipeline>(m_Device);
-		m_SkyboxPipeline->CreatePipeline("../../shaders/spv/skybox.vert.spv", "../../shaders/spv/skybox.frag.spv", pipelineConfig, Model::Vertex::GetBindingDescriptions(),
-		                                 Model::Vertex::GetAttributeDescriptions());
+		m_SkyboxPipeline->CreatePipeline(SHADER_DIRECTORY "skybox.vert.spv", SHADER_DIRECTORY "skybox.frag.spv", pipelineConfig, Model::PackedVertex::GetBindingDescriptions(),
+		                                 Model::PackedVertex::GetAttributeDescriptions());
 	}
 }
\ No newline at end of file
@@ -5,7 +5,14 @@
 #include "object.h"
 #include "utilities.h"
 #include "vulkan/device.h"
+#include "vulkan/dynamicResolution.h"
+#include "vulkan/gpuProfiler.h"
+#include "vulkan/imageBasedLighting.h"
+#include "vulkan/impostors.h"
+#include "vulkan/lightClusters.h"
+#include "vulkan/occlusionCuller.h"
 #include "vulkan/pipeline.h"
+#include "vulkan/postProcess.h"
 #include "vulkan/skybox.h"
 #include "vulkan/swapchain.h"
 #include "vulkan/window.h"
@@ -37,13 +44,56 @@ public:
 
 	inline VkRenderPass GetGeometryRenderPass() { return m_Swapchain->GetGeometryRenderPass(); }
 
+	inline VkRenderPass GetUiRenderPass() { return m_Swapchain->GetUiRenderPass(); }
+
 	inline float GetAspectRatio() { return m_Swapchain->GetExtentAspectRatio(); }
 
 	inline bool IsFrameInProgress() const { return m_IsFrameStarted; }
 
+	// Max on screen error of a mesh LOD in pixels, higher switches to coarser LODs earlier
+	inline float& GetLodPixelError() { return m_LodPixelError; }
+
+	inline uint32_t GetDrawnTriangleCount() const { return m_DrawnTriangleCount; }
+
+	// Milliseconds the last Render took on the CPU, without waiting for its frame in flight to be free
+	inline float GetCpuFrameTime() const { return m_CpuFrameTime; }
+
+	// Objects whose bounding sphere covers fewer pixels than this are drawn as impostors, 0 disables them
+	inline float& GetImpostorPixelSize() { return m_ImpostorPixelSize; }
+
+	inline const Impostors& GetImpostors() const { return *m_Impostors; }
+
+	inline const OcclusionCuller& GetOcclusionCuller() const { return *m_Culler; }
+
+	inline const LightClusters& GetLightClusters() const { return *m_LightClusters; }
+
+	inline float& GetBloomStrength() { return m_PostProcess->GetBloomStrength(); }
+
+	inline bool& GetAutoExposureEnabled() { return m_PostProcess->GetAutoExposureEnabled(); }
+
+	inline float& GetExposureAdaptationSpeed() { return m_PostProcess->GetAutoExposure().GetAdaptationSpeed(); }
+
+	inline DynamicResolution& GetDynamicResolution() { return *m_DynamicResolution; }
+
+	inline GpuProfiler& GetGpuProfiler() { return *m_Profiler; }
+
+	inline const PresentSettings& GetPresentSettings() const { return m_PresentSettings; }
+
+	// Applied before the next frame, the swapchain is recreated with them
+	void SetPresentSettings(const PresentSettings& settings);
+
+	inline VkPresentModeKHR GetPresentMode() const { return m_Swapchain->GetPresentMode(); }
+
+	// Blocks until the GPU finished the frame that the next Render reuses, so it doesn't have to wait anymore. Must not
+	// be called while the render thread is inside Render.
+	void WaitForNextFrame();
+
+	// The extent the geometry is rendered at this frame, the tonemapping upscales it to the swapchain extent
+	inline VkExtent2D GetRenderExtent() const { return m_RenderExtent; }
+
 	VkCommandBuffer GetCurrentCommandBuffer() const {
 		ASSERT(m_IsFrameStarted);    // Cannot get command buffer when frame is not in progress
-		return m_CommandBuffers[m_CurrentImageIndex];
+		return m_CommandBuffers[m_CurrentFrameIndex];
 	}
 
 	int GetFrameIndex() const {
@@ -54,12 +104,14 @@ public:
 
 	VkCommandBuffer BeginFrame();
 	void EndFrame();
-	void BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& clearColor, VkFramebuffer framebuffer, const VkRenderPass& renderPass);
+	void BeginRenderPass(VkCommandBuffer commandBuffer, const glm::vec3& clearColor, VkFramebuffer framebuffer, const VkRenderPass& renderPass, VkExtent2D extent);
 	void EndRenderPass(VkCommandBuffer commandBuffer);
-	void RenderGameObjects(FrameInfo& frameInfo);
+	void CullGameObjects(FrameInfo& frameInfo);
+	void RenderGameObjects(FrameInfo& frameInfo, bool late);
+	void RenderStars(FrameInfo& frameInfo);
 	void RenderSkybox(FrameInfo& frameInfo);
 
-	void Render(FrameInfo frameInfo, std::function<void(VkCommandBuffer& commandBuffer)> renderImGui);
+	void Render(FrameInfo& frameInfo, std::function<void(VkCommandBuffer& commandBuffer)> renderImGui);
 
 private:
 	void CreateCommandBuffers();
@@ -68,6 +120,7 @@ private:
     void ImGuiInit();
 
 	void CreatePipelines();
+	bool AddImpostor(Object& object, const glm::vec3& center, float lodScale, const glm::dvec3& cameraTranslation, bool emissive);
 
 	void CreatePipelineLayouts();
 
@@ -77,6 +130,25 @@ private:
 	std::unique_ptr<Swapchain> m_Swapchain;
 	std::vector<VkCommandBuffer> m_CommandBuffers;
 
+	PresentSettings m_PresentSettings;
+	bool m_PresentSettingsChanged = false;
+
+	struct CulledDraw {
+		Object* object;
+		uint32_t draw;    // index into the culler's draw buffers, only valid for indexed models
+	};
+
+	std::unique_ptr<OcclusionCuller> m_Culler;
+	std::vector<CulledDraw> m_CulledDraws;
+
+	std::unique_ptr<LightClusters> m_LightClusters;
+	std::unique_ptr<Impostors> m_Impostors;
+	std::unique_ptr<PostProcess> m_PostProcess;
+	std::unique_ptr<DynamicResolution> m_DynamicResolution;
+	std::unique_ptr<GpuProfiler> m_Profiler;
+	std::unique_ptr<ImageBasedLighting> m_Ibl;
+	VkExtent2D m_RenderExtent {};
+
 	std::unique_ptr<Pipeline> m_StarsPipeline;
 	VkPipelineLayout m_StarsPipelineLayout;
 
@@ -89,4 +161,11 @@ private:
 	uint32_t m_CurrentImageIndex = 0;
 	int m_CurrentFrameIndex      = 0;
 	bool m_IsFrameStarted        = false;
+
+	float m_LodPixelError         = 1.0f;
+	float m_ImpostorPixelSize     = 24.0f;
+	uint32_t m_DrawnTriangleCount = 0;
+
+	uint64_t m_FrameWaitTime = 0;    // nanoseconds
+	float m_CpuFrameTime     = 0.0f;
 };
\ No newline at end of file
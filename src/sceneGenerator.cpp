@@ -0,0 +1,125 @@
+#include "sceneGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+static constexpr double SPACING           = 4.0;     // average distance between objects when the radius is picked automatically
+static constexpr double MIN_RADIUS        = 20.0;
+static constexpr uint32_t DEFAULT_CLUSTERS = 16;
+static constexpr double CLUSTER_SIZE      = 0.08;    // of the world radius
+static constexpr double RING_WIDTH        = 0.2;
+static constexpr double RING_THICKNESS    = 0.02;
+
+SceneGenerator::SceneGenerator(const SceneSettings& settings): m_Settings(settings), m_Random(settings.seed) {
+	m_Radius = m_Settings.radius > 0.0 ? m_Settings.radius : std::max(MIN_RADIUS, SPACING * std::cbrt(static_cast<double>(m_Settings.GetTotalCount())));
+}
+
+bool SceneGenerator::ParseDistribution(const std::string& name, SceneDistribution& distribution) {
+	if(name == "uniform") distribution = SceneDistribution::Uniform;
+	else if(name == "clustered") distribution = SceneDistribution::Clustered;
+	else if(name == "ring") distribution = SceneDistribution::Ring;
+	else return false;
+	return true;
+}
+
+void SceneGenerator::Generate(const ObjectInfo& objInfo, Map& gameObjects, Map& stars, std::vector<SceneLight>& lights) {
+	// Star systems are spread over the whole world with every distribution, clustered objects gather around them
+	std::shared_ptr<Object> starPrototype;
+	for(uint32_t i = 0; i < m_Settings.starSystems; i++) {
+		glm::dvec3 position = RandomInSphere(m_Radius);
+		m_Clusters.push_back(position);
+
+		Transform transform = RandomTransform(position, 2.0, 6.0);
+		transform.scale     = glm::dvec3(transform.scale.x);
+
+		auto star = starPrototype ? std::make_shared<Object>(*starPrototype, transform) : std::make_shared<Object>(objInfo, transform, "../../assets/models/sphere.obj", "../../assets/textures/empty_roughness.jpg");
+		if(!starPrototype) starPrototype = star;
+		stars.emplace(star->GetObjectID(), star);
+
+		SceneLight light {};
+		light.position        = position;
+		light.light.radius    = 200.0f;
+		light.light.color     = RandomColor();
+		light.light.intensity = 2000.0f;
+		lights.push_back(light);
+	}
+
+	for(uint32_t i = 0; m_Clusters.empty() && i < DEFAULT_CLUSTERS; i++) m_Clusters.push_back(RandomInSphere(m_Radius));
+
+	std::shared_ptr<Object> shipPrototype;
+	for(uint32_t i = 0; i < m_Settings.ships; i++) {
+		Transform transform = RandomTransform(RandomPosition(), 1.0, 1.0);
+
+		auto ship = shipPrototype ? std::make_shared<Object>(*shipPrototype, transform)
+		                          : std::make_shared<Object>(objInfo, transform, "../../assets/models/spaceship.obj", "../../assets/textures/spaceship_albedo.png",
+		                                                     "../../assets/textures/spaceship_normal.png", "../../assets/textures/spaceship_metalic.png",
+		                                                     "../../assets/textures/spaceship_roughness.png");
+		if(!shipPrototype) shipPrototype = ship;
+		gameObjects.emplace(ship->GetObjectID(), ship);
+	}
+
+	// Squashed spheres with the empty material
+	std::shared_ptr<Object> asteroidPrototype;
+	for(uint32_t i = 0; i < m_Settings.asteroids; i++) {
+		Transform transform = RandomTransform(RandomPosition(), 0.3, 3.0);
+		transform.scale *= glm::dvec3(0.7 + 0.6 * Random(), 0.7 + 0.6 * Random(), 0.7 + 0.6 * Random());
+
+		auto asteroid = asteroidPrototype ? std::make_shared<Object>(*asteroidPrototype, transform) : std::make_shared<Object>(objInfo, transform, "../../assets/models/sphere.obj", Object::DEFAULT_MATERIAL[0]);
+		if(!asteroidPrototype) asteroidPrototype = asteroid;
+		gameObjects.emplace(asteroid->GetObjectID(), asteroid);
+	}
+
+	for(uint32_t i = 0; i < m_Settings.lights; i++) {
+		SceneLight light {};
+		light.position        = RandomPosition();
+		light.light.radius    = 20.0f + 30.0f * static_cast<float>(Random());
+		light.light.color     = RandomColor();
+		light.light.intensity = 20.0f;
+		lights.push_back(light);
+	}
+}
+
+/**
+ * @brief The top 53 bits of the generator, the same on every platform
+ */
+double SceneGenerator::Random() { return static_cast<double>(m_Random() >> 11) * 0x1.0p-53; }
+
+glm::dvec3 SceneGenerator::RandomInSphere(double radius) {
+	glm::dvec3 position;
+	do {
+		position = {Random() * 2.0 - 1.0, Random() * 2.0 - 1.0, Random() * 2.0 - 1.0};
+	} while(glm::dot(position, position) > 1.0);
+	return position * radius;
+}
+
+glm::dvec3 SceneGenerator::RandomPosition() {
+	switch(m_Settings.distribution) {
+		case SceneDistribution::Clustered: {
+			// Sum of uniforms, close enough to a normal distribution around the center
+			const glm::dvec3& center = m_Clusters[static_cast<size_t>(Random() * m_Clusters.size())];
+			glm::dvec3 offset {};
+			for(int i = 0; i < 4; i++) offset += glm::dvec3(Random(), Random(), Random());
+			return center + (offset - 2.0) * (m_Radius * CLUSTER_SIZE);
+		}
+		case SceneDistribution::Ring: {
+			// Flat ring around the origin in the xz plane
+			double angle    = Random() * 2.0 * glm::pi<double>();
+			double distance = m_Radius * (1.0 - RING_WIDTH * Random());
+			double height   = m_Radius * RING_THICKNESS * (Random() * 2.0 - 1.0);
+			return {distance * std::cos(angle), height, distance * std::sin(angle)};
+		}
+		case SceneDistribution::Uniform:
+		default: return RandomInSphere(m_Radius);
+	}
+}
+
+glm::dvec3 SceneGenerator::RandomColor() { return glm::dvec3(0.6 + 0.4 * Random(), 0.6 + 0.4 * Random(), 0.6 + 0.4 * Random()); }
+
+Transform SceneGenerator::RandomTransform(const glm::dvec3& position, double minScale, double maxScale) {
+	Transform transform {};
+	transform.translation = position;
+	transform.rotation    = glm::dvec3(Random(), Random(), Random()) * 360.0;
+	transform.scale       = glm::dvec3(minScale + (maxScale - minScale) * Random());
+	return transform;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "frameInfo.h"
+#include "object.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class SceneDistribution { Uniform, Clustered, Ring };
+
+struct SceneSettings {
+	uint32_t ships                 = 0;
+	uint32_t asteroids             = 0;
+	uint32_t lights                = 0;
+	uint32_t starSystems           = 0;    // an emissive star with a light in its center each
+	uint64_t seed                  = 1;
+	SceneDistribution distribution = SceneDistribution::Uniform;
+	double radius                  = 0.0;    // of the generated world, 0 grows it with the object count at a constant density
+
+	inline uint32_t GetTotalCount() const { return ships + asteroids + lights + starSystems; }
+};
+
+// PointLight positions are relative to the camera, these are in world space and converted every frame
+struct SceneLight {
+	glm::dvec3 position;
+	PointLight light;
+};
+
+/**
+ * @brief Generates benchmark worlds of ships, asteroids, lights and star systems.
+ *
+ * The same settings always give the same sequence of random draws: only the raw output of std::mt19937_64 is used,
+ * which the standard fixes, not the distributions of <random> whose results differ between standard libraries. The
+ * positions go through std::cos, std::sin and std::cbrt, which may round differently between math libraries, so the
+ * worlds of two platforms can differ in the last bits. Every kind of object is an instance of one prototype, so a
+ * million objects still load three models and create three materials.
+ */
+class SceneGenerator {
+public:
+	SceneGenerator(const SceneSettings& settings);
+
+	// Appends the generated objects and lights
+	void Generate(const ObjectInfo& objInfo, Map& gameObjects, Map& stars, std::vector<SceneLight>& lights);
+
+	// Radius of the generated world, the objects are placed around the origin
+	inline double GetRadius() const { return m_Radius; }
+
+	// "uniform", "clustered" or "ring"
+	static bool ParseDistribution(const std::string& name, SceneDistribution& distribution);
+
+private:
+	double Random();    // [0, 1)
+	glm::dvec3 RandomInSphere(double radius);
+	glm::dvec3 RandomPosition();
+	glm::dvec3 RandomColor();
+	Transform RandomTransform(const glm::dvec3& position, double minScale, double maxScale);
+
+	SceneSettings m_Settings;
+	std::mt19937_64 m_Random;
+	double m_Radius;
+
+	std::vector<glm::dvec3> m_Clusters;    // the star systems, or random centers without any
+};
@@ -0,0 +1,85 @@
+#include "iblFile.h"
+
+#include "../utilities.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+static constexpr const char* IBL_CACHE_DIRECTORY = "../../assets/cache/";
+
+/**
+ * @brief Maps the cached lighting, returns false if there is none or it was computed from other faces or with other sizes
+ */
+bool IblFile::Open(const std::string& filepath, const IblFileHeader& expected) {
+	if(!m_File.Open(filepath)) return false;
+
+	const uint8_t* bytes = m_File.GetData();
+	const uint64_t size  = m_File.GetSize();
+
+	IblFileHeader header;
+	if(size < sizeof(header)) return false;
+	std::memcpy(&header, bytes, sizeof(header));
+
+	bool matches = header.magic == MAGIC && header.version == VERSION && header.sourceHash == expected.sourceHash && header.format == expected.format
+	               && header.prefilteredSize == expected.prefilteredSize && header.prefilteredLevels == expected.prefilteredLevels && header.brdfLutSize == expected.brdfLutSize
+	               && header.dataSize == expected.dataSize;
+
+	// A truncated file (crash while writing) must not be read past its end
+	if(!matches || header.dataOffset % ALIGNMENT != 0 || header.dataOffset > size || header.dataSize > size - header.dataOffset) {
+		m_File.Close();
+		return false;
+	}
+
+	m_Data = bytes + header.dataOffset;
+	return true;
+}
+
+/**
+ * @brief Writes under a temporary name and renames, a later run either sees no file or the complete one
+ */
+bool IblFile::Write(const std::string& filepath, IblFileHeader header, const void* data) {
+	header.magic      = MAGIC;
+	header.version    = VERSION;
+	header.dataOffset = (sizeof(header) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(filepath).parent_path(), error);
+
+	std::ostringstream temporaryPath;
+	temporaryPath << filepath << "." << std::this_thread::get_id() << ".tmp";
+
+	{
+		std::ofstream file(temporaryPath.str(), std::ios::binary | std::ios::trunc);
+		if(!file) return false;
+
+		static const char zeros[ALIGNMENT] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(zeros, static_cast<std::streamsize>(header.dataOffset - sizeof(header)));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(header.dataSize));
+
+		if(!file) {
+			file.close();
+			std::filesystem::remove(temporaryPath.str(), error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath.str(), filepath, error);
+	if(error) {
+		std::filesystem::remove(temporaryPath.str(), error);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Named after the skybox folder, with its full path hashed in like the mesh cache
+ */
+std::string IblFile::GetCachePath(const std::string& skyboxDirectory) {
+	std::ostringstream path;
+	path << IBL_CACHE_DIRECTORY << std::filesystem::path(skyboxDirectory).filename().string() << "-" << std::hex << HashBytes(skyboxDirectory.data(), skyboxDirectory.size()) << ".ibl";
+	return path.str();
+}
\ No newline at end of file
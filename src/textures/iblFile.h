@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../mappedFile.h"
+
+#include <string>
+
+/**
+ * @brief Cached image based lighting of a skybox, a header followed by the irradiance coefficients, the prefiltered
+ * cubemap and the BRDF lookup table in the layout ImageBasedLighting reads them back in. The data is handed to the
+ * upload queue as it is.
+ */
+struct IblFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;    // KtxFile::HashSources of the skybox faces
+
+	uint32_t format;    // VkFormat of the prefiltered cubemap and the BRDF lookup table
+	uint32_t prefilteredSize;
+	uint32_t prefilteredLevels;
+	uint32_t brdfLutSize;
+	uint64_t dataOffset;
+	uint64_t dataSize;
+};
+
+class IblFile {
+public:
+	static constexpr uint32_t MAGIC     = 0x204c4249;    // "IBL "
+	static constexpr uint32_t VERSION   = 1;
+	static constexpr uint64_t ALIGNMENT = 64;
+
+	// Everything in `expected` but the magic, the version and the data offset has to match the file
+	bool Open(const std::string& filepath, const IblFileHeader& expected);
+
+	static bool Write(const std::string& filepath, IblFileHeader header, const void* data);
+
+	static std::string GetCachePath(const std::string& skyboxDirectory);
+
+	// Points into the mapping, only valid while the IblFile is open
+	inline const uint8_t* GetData() const { return m_Data; }
+
+private:
+	MappedFile m_File;
+	const uint8_t* m_Data = nullptr;
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "ktxFile.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+static constexpr uint8_t IDENTIFIER[12]       = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};    // «KTX 20»\r\n\x1A\n
+static constexpr const char SOURCE_HASH_KEY[] = "SpaceSim.sourceHash";
+static constexpr const char* BAKED_DIRECTORY  = "baked";
+static constexpr uint32_t MAX_LEVELS          = 16;
+
+struct KtxHeader {
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+
+struct KtxLevelIndex {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+static inline uint64_t GetLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level) {
+	uint64_t blocksX = (std::max(width >> level, 1u) + 3) / 4;
+	uint64_t blocksY = (std::max(height >> level, 1u) + 3) / 4;
+	return blocksX * blocksY * KtxFile::GetBlockSize(format);
+}
+
+uint32_t KtxFile::GetBlockSize(VkFormat format) {
+	switch(format) {
+		case VK_FORMAT_BC4_UNORM_BLOCK: return 8;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK: return 16;
+		default: return 0;
+	}
+}
+
+/**
+ * @brief Maps a baked texture, returns false if there is none, it is not a texture we can load or it was baked
+ * from different source images
+ */
+bool KtxFile::Open(const std::string& filepath, uint64_t sourceHash) {
+	m_Levels.clear();
+	if(!m_File.Open(filepath)) return false;
+
+	const uint8_t* bytes = m_File.GetData();
+	const uint64_t size  = m_File.GetSize();
+
+	KtxHeader header;
+	if(size < sizeof(header)) return false;
+	std::memcpy(&header, bytes, sizeof(header));
+
+	m_Format = static_cast<VkFormat>(header.vkFormat);
+	m_Width  = header.pixelWidth;
+	m_Height = header.pixelHeight;
+
+	bool valid = std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) == 0 && GetBlockSize(m_Format) != 0 && header.supercompressionScheme == 0 && m_Width > 0 && m_Height > 0
+	          && header.pixelDepth == 0 && header.layerCount <= 1 && header.faceCount == 1 && header.levelCount <= MAX_LEVELS;
+
+	// A level count of 0 asks the loader to generate the mips, there is only the base level in the file then
+	uint32_t levelCount = std::max(header.levelCount, 1u);
+	if(valid && (m_Width >> (levelCount - 1)) == 0 && (m_Height >> (levelCount - 1)) == 0) valid = false;
+
+	// The hash is stored as a key/value pair, a file without it wasn't baked by us
+	bool hashMatches = false;
+	if(valid && header.kvdByteOffset <= size && header.kvdByteLength <= size - header.kvdByteOffset) {
+		uint64_t position = header.kvdByteOffset;
+		uint64_t end      = position + header.kvdByteLength;
+		while(position + 4 <= end) {
+			uint32_t length;
+			std::memcpy(&length, bytes + position, 4);
+			position += 4;
+			if(length > end - position) break;
+
+			if(length == sizeof(SOURCE_HASH_KEY) + 8 && std::memcmp(bytes + position, SOURCE_HASH_KEY, sizeof(SOURCE_HASH_KEY)) == 0) {
+				uint64_t hash;
+				std::memcpy(&hash, bytes + position + sizeof(SOURCE_HASH_KEY), 8);
+				hashMatches = hash == sourceHash;
+			}
+			position = AlignUp(position + length, 4);
+		}
+	}
+
+	if(!valid || !hashMatches || size < sizeof(header) + uint64_t(levelCount) * sizeof(KtxLevelIndex)) {
+		m_File.Close();
+		return false;
+	}
+
+	// A truncated file (crash while baking) must not be read past its end
+	for(uint32_t level = 0; level < levelCount; level++) {
+		KtxLevelIndex index;
+		std::memcpy(&index, bytes + sizeof(header) + level * sizeof(KtxLevelIndex), sizeof(index));
+		if(index.byteOffset % GetBlockSize(m_Format) != 0 || index.byteOffset > size || index.byteLength > size - index.byteOffset
+		   || index.byteLength != GetLevelSize(m_Format, m_Width, m_Height, level)) {
+			m_File.Close();
+			m_Levels.clear();
+			return false;
+		}
+		m_Levels.push_back({bytes + index.byteOffset, index.byteLength});
+	}
+	return true;
+}
+
+/**
+ * @brief Writes already encoded mip levels, largest first. Like the mesh cache the file is written under a
+ * temporary name and renamed, so a running game either sees the old file or the complete new one.
+ */
+bool KtxFile::Write(const std::string& filepath, uint64_t sourceHash, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels) {
+	const uint32_t blockSize = GetBlockSize(format);
+	if(blockSize == 0 || levels.empty() || levels.size() > MAX_LEVELS) return false;
+	for(uint32_t level = 0; level < levels.size(); level++) {
+		if(levels[level].size() != GetLevelSize(format, width, height, level)) return false;
+	}
+
+	// Data format descriptor, one basic block describing the compressed block
+	uint8_t colorModel       = 0;
+	const uint32_t blockBits = blockSize * 8;
+	std::vector<std::array<uint32_t, 4>> samples;
+	switch(format) {
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			colorModel = 131;    // KHR_DF_MODEL_BC4
+			samples.push_back({(blockBits - 1) << 16, 0, 0, UINT32_MAX});
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			colorModel = 132;    // KHR_DF_MODEL_BC5, red and green are two BC4 blocks
+			samples.push_back({63u << 16, 0, 0, UINT32_MAX});
+			samples.push_back({64u | (63u << 16) | (1u << 24), 0, 0, UINT32_MAX});
+			break;
+		default:
+			colorModel = 134;    // KHR_DF_MODEL_BC7
+			samples.push_back({(blockBits - 1) << 16, 0, 0, UINT32_MAX});
+			break;
+	}
+	const uint32_t transferFunction = format == VK_FORMAT_BC7_SRGB_BLOCK ? 2 : 1;    // KHR_DF_TRANSFER_SRGB / LINEAR
+	const uint32_t descriptorSize   = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+	std::vector<uint32_t> dfd = {4 + descriptorSize, 0, 2u | (descriptorSize << 16), colorModel | (1u << 8) | (transferFunction << 16), 3u | (3u << 8), blockSize, 0};
+	for(const auto& sample : samples) dfd.insert(dfd.end(), sample.begin(), sample.end());
+
+	std::vector<uint8_t> kvd(4 + sizeof(SOURCE_HASH_KEY) + 8);
+	uint32_t entryLength = sizeof(SOURCE_HASH_KEY) + 8;
+	std::memcpy(kvd.data(), &entryLength, 4);
+	std::memcpy(kvd.data() + 4, SOURCE_HASH_KEY, sizeof(SOURCE_HASH_KEY));
+	std::memcpy(kvd.data() + 4 + sizeof(SOURCE_HASH_KEY), &sourceHash, 8);
+	kvd.resize(AlignUp(kvd.size(), 4));
+
+	KtxHeader header {};
+	std::memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+	header.vkFormat      = format;
+	header.typeSize      = 1;
+	header.pixelWidth    = width;
+	header.pixelHeight   = height;
+	header.faceCount     = 1;
+	header.levelCount    = static_cast<uint32_t>(levels.size());
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levels.size() * sizeof(KtxLevelIndex));
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+	header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+	header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+	// The spec wants the smallest level first, so a streaming reader can show something early
+	std::vector<KtxLevelIndex> levelIndex(levels.size());
+	uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+	for(uint32_t level = static_cast<uint32_t>(levels.size()); level-- > 0;) {
+		offset                                   = AlignUp(offset, blockSize);
+		levelIndex[level].byteOffset             = offset;
+		levelIndex[level].byteLength             = levels[level].size();
+		levelIndex[level].uncompressedByteLength = levels[level].size();
+		offset += levels[level].size();
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(filepath).parent_path(), error);
+
+	std::ostringstream temporaryPath;
+	temporaryPath << filepath << "." << std::this_thread::get_id() << ".tmp";
+
+	{
+		std::ofstream file(temporaryPath.str(), std::ios::binary | std::ios::trunc);
+		if(!file) return false;
+
+		auto writeAt = [&](uint64_t offset, const void* blob, uint64_t blobSize) {
+			static const char zeros[16] = {};
+			uint64_t position           = static_cast<uint64_t>(file.tellp());
+			file.write(zeros, static_cast<std::streamsize>(offset - position));
+			file.write(static_cast<const char*>(blob), static_cast<std::streamsize>(blobSize));
+		};
+		writeAt(0, &header, sizeof(header));
+		writeAt(sizeof(header), levelIndex.data(), levelIndex.size() * sizeof(KtxLevelIndex));
+		writeAt(header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+		writeAt(header.kvdByteOffset, kvd.data(), header.kvdByteLength);
+		for(uint32_t level = static_cast<uint32_t>(levels.size()); level-- > 0;) { writeAt(levelIndex[level].byteOffset, levels[level].data(), levels[level].size()); }
+
+		if(!file) {
+			file.close();
+			std::filesystem::remove(temporaryPath.str(), error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath.str(), filepath, error);
+	if(error) {
+		std::filesystem::remove(temporaryPath.str(), error);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Where the baked version of one or more packed source images lives, a "baked" folder next to the first one
+ */
+std::string KtxFile::GetBakedPath(const std::vector<std::string>& sourceFilepaths) {
+	std::filesystem::path first = sourceFilepaths.front();
+
+	std::string name = first.stem().string();
+	for(size_t i = 1; i < sourceFilepaths.size(); i++) name += "+" + std::filesystem::path(sourceFilepaths[i]).stem().string();
+	return (first.parent_path() / BAKED_DIRECTORY / (name + ".ktx2")).string();
+}
+
+/**
+ * @brief Hash of the contents of all source images, 0 if one of them can't be read
+ */
+uint64_t KtxFile::HashSources(const std::vector<std::string>& sourceFilepaths) {
+	std::vector<uint64_t> hashes;
+	for(const std::string& filepath : sourceFilepaths) {
+		MappedFile file;
+		if(!file.Open(filepath)) return 0;
+		hashes.push_back(HashBytes(file.GetData(), file.GetSize()));
+	}
+	return HashBytes(hashes.data(), hashes.size() * sizeof(uint64_t));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../mappedFile.h"
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @brief KTX 2.0 texture container (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html), limited to
+ * single layer 2D textures without supercompression. The mip levels are stored in the format the GPU samples,
+ * so a loaded file is handed to the upload queue without any decoding.
+ *
+ * Baked textures store the hash of the images they were made from under the "SpaceSim.sourceHash" key, a
+ * file whose sources changed since it was baked is not opened.
+ */
+class KtxFile {
+public:
+	struct Level {
+		const uint8_t* data;
+		uint64_t size;
+	};
+
+	bool Open(const std::string& filepath, uint64_t sourceHash);
+
+	static bool Write(const std::string& filepath, uint64_t sourceHash, VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels);
+
+	static std::string GetBakedPath(const std::vector<std::string>& sourceFilepaths);
+
+	static uint64_t HashSources(const std::vector<std::string>& sourceFilepaths);
+
+	// Bytes of one 4x4 block, 0 for formats this container doesn't handle
+	static uint32_t GetBlockSize(VkFormat format);
+
+	inline VkFormat GetFormat() const { return m_Format; }
+
+	inline uint32_t GetWidth() const { return m_Width; }
+
+	inline uint32_t GetHeight() const { return m_Height; }
+
+	inline uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+
+	// Points into the mapping, only valid while the KtxFile is open
+	inline const Level& GetLevel(uint32_t level) const { return m_Levels[level]; }
+
+private:
+	MappedFile m_File;
+	VkFormat m_Format = VK_FORMAT_UNDEFINED;
+	uint32_t m_Width  = 0;
+	uint32_t m_Height = 0;
+	std::vector<Level> m_Levels;
+};
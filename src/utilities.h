@@ -3,6 +3,8 @@
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <string>
@@ -12,6 +14,28 @@ template <typename T, typename... Rest> void HashCombine(std::size_t& seed, cons
 	(HashCombine(seed, rest), ...);
 };
 
+/**
+ * @brief 64 bit hash of a block of memory, eight bytes per step so hashing big files keeps up with the disk
+ */
+inline uint64_t HashBytes(const void* data, size_t size) {
+	const uint64_t prime = 0x9e3779b97f4a7c15ull;
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash        = 0xcbf29ce484222325ull ^ (size * prime);
+
+	for(; size >= 8; bytes += 8, size -= 8) {
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 29;
+	}
+
+	uint64_t tail = 0;
+	std::memcpy(&tail, bytes, size);
+	hash = (hash ^ tail) * prime;
+	hash ^= hash >> 32;
+	return hash;
+}
+
 #ifndef NDEBUG
 	#if defined(_WIN32)
 #	define ASSERT(condition)                                                                                                                   \
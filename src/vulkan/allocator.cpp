@@ -0,0 +1,586 @@
+#include "allocator.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// TLSF
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Tlsf::Tlsf(VkDeviceSize size): m_Size(size) {
+	for(auto& fl : m_FreeHeads) fl.fill(INVALID_NODE);
+
+	m_FirstNode       = NewNode();
+	Node& node        = m_Nodes[m_FirstNode];
+	node.offset       = 0;
+	node.size         = size;
+	node.prevPhysical = INVALID_NODE;
+	node.nextPhysical = INVALID_NODE;
+	InsertFree(m_FirstNode);
+}
+
+/**
+ * @brief Maps a size to its free list bucket.
+ * The first level is the index of the highest set bit, the second level the next SL_LOG2 bits below it.
+ */
+void Tlsf::Mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl) {
+	if(size < SL_COUNT) {
+		fl = 0;
+		sl = static_cast<uint32_t>(size);
+		return;
+	}
+	uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+	fl           = msb - SL_LOG2 + 1;
+	sl           = static_cast<uint32_t>(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+}
+
+/**
+ * @brief Returns a free node that is guaranteed to be at least `size` big.
+ * The size is rounded up to the next bucket first so that any node in the found list fits
+ * (good fit instead of best fit, but without walking the list).
+ */
+uint32_t Tlsf::FindFree(VkDeviceSize size) {
+	if(size >= SL_COUNT) size += (1ull << (std::bit_width(size) - 1 - SL_LOG2)) - 1;
+
+	uint32_t fl, sl;
+	Mapping(size, fl, sl);
+	if(fl >= FL_COUNT) return INVALID_NODE;
+
+	uint32_t slMap = m_SlBitmap[fl] & (~0u << sl);
+	if(slMap == 0) {
+		uint64_t flMap = m_FlBitmap & (~0ull << (fl + 1));
+		if(flMap == 0) return INVALID_NODE;
+
+		fl    = static_cast<uint32_t>(std::countr_zero(flMap));
+		slMap = m_SlBitmap[fl];
+	}
+	sl = static_cast<uint32_t>(std::countr_zero(slMap));
+	return m_FreeHeads[fl][sl];
+}
+
+void Tlsf::InsertFree(uint32_t index) {
+	uint32_t fl, sl;
+	Mapping(m_Nodes[index].size, fl, sl);
+
+	Node& node    = m_Nodes[index];
+	node.free     = true;
+	node.prevFree = INVALID_NODE;
+	node.nextFree = m_FreeHeads[fl][sl];
+	if(node.nextFree != INVALID_NODE) m_Nodes[node.nextFree].prevFree = index;
+
+	m_FreeHeads[fl][sl] = index;
+	m_SlBitmap[fl] |= 1u << sl;
+	m_FlBitmap |= 1ull << fl;
+}
+
+void Tlsf::RemoveFree(uint32_t index) {
+	uint32_t fl, sl;
+	Mapping(m_Nodes[index].size, fl, sl);
+
+	Node& node = m_Nodes[index];
+	node.free  = false;
+	if(node.prevFree != INVALID_NODE) m_Nodes[node.prevFree].nextFree = node.nextFree;
+	if(node.nextFree != INVALID_NODE) m_Nodes[node.nextFree].prevFree = node.prevFree;
+
+	if(m_FreeHeads[fl][sl] == index) {
+		m_FreeHeads[fl][sl] = node.nextFree;
+		if(node.nextFree == INVALID_NODE) {
+			m_SlBitmap[fl] &= ~(1u << sl);
+			if(m_SlBitmap[fl] == 0) m_FlBitmap &= ~(1ull << fl);
+		}
+	}
+}
+
+uint32_t Tlsf::NewNode() {
+	if(!m_UnusedNodes.empty()) {
+		uint32_t index = m_UnusedNodes.back();
+		m_UnusedNodes.pop_back();
+		return index;
+	}
+	m_Nodes.push_back({});
+	return static_cast<uint32_t>(m_Nodes.size() - 1);
+}
+
+void Tlsf::ReleaseNode(uint32_t index) { m_UnusedNodes.push_back(index); }
+
+uint32_t Tlsf::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+	alignment = std::max(alignment, MIN_ALIGNMENT);
+	size      = AlignUp(size, MIN_ALIGNMENT);
+
+	// Ask for enough room to be able to align the start inside the free range
+	uint32_t index = FindFree(size + alignment - MIN_ALIGNMENT);
+	if(index == INVALID_NODE) return INVALID_NODE;
+	RemoveFree(index);
+
+	VkDeviceSize alignedOffset = AlignUp(m_Nodes[index].offset, alignment);
+	VkDeviceSize padding       = alignedOffset - m_Nodes[index].offset;
+
+	// Give the alignment padding back as its own free range
+	if(padding > 0) {
+		uint32_t front         = NewNode();
+		Node& node             = m_Nodes[index];
+		Node& frontNode        = m_Nodes[front];
+		frontNode.offset       = node.offset;
+		frontNode.size         = padding;
+		frontNode.prevPhysical = node.prevPhysical;
+		frontNode.nextPhysical = index;
+		if(node.prevPhysical != INVALID_NODE) m_Nodes[node.prevPhysical].nextPhysical = front;
+		else m_FirstNode = front;
+
+		node.prevPhysical = front;
+		node.offset       = alignedOffset;
+		node.size -= padding;
+		InsertFree(front);
+	}
+
+	// Split off the tail
+	if(m_Nodes[index].size > size) {
+		uint32_t back         = NewNode();
+		Node& node            = m_Nodes[index];
+		Node& backNode        = m_Nodes[back];
+		backNode.offset       = node.offset + size;
+		backNode.size         = node.size - size;
+		backNode.prevPhysical = index;
+		backNode.nextPhysical = node.nextPhysical;
+		if(node.nextPhysical != INVALID_NODE) m_Nodes[node.nextPhysical].prevPhysical = back;
+
+		node.nextPhysical = back;
+		node.size         = size;
+		InsertFree(back);
+	}
+
+	m_Used += m_Nodes[index].size;
+	m_AllocationCount++;
+	offset = m_Nodes[index].offset;
+	return index;
+}
+
+void Tlsf::Free(uint32_t index) {
+	ASSERT(index < m_Nodes.size() && !m_Nodes[index].free);    // Double free or foreign node
+
+	m_Used -= m_Nodes[index].size;
+	m_AllocationCount--;
+
+	// Merge with the previous physical neighbour
+	uint32_t prev = m_Nodes[index].prevPhysical;
+	if(prev != INVALID_NODE && m_Nodes[prev].free) {
+		RemoveFree(prev);
+		m_Nodes[prev].size += m_Nodes[index].size;
+		m_Nodes[prev].nextPhysical = m_Nodes[index].nextPhysical;
+		if(m_Nodes[index].nextPhysical != INVALID_NODE) m_Nodes[m_Nodes[index].nextPhysical].prevPhysical = prev;
+		ReleaseNode(index);
+		index = prev;
+	}
+
+	// Merge with the next physical neighbour
+	uint32_t next = m_Nodes[index].nextPhysical;
+	if(next != INVALID_NODE && m_Nodes[next].free) {
+		RemoveFree(next);
+		m_Nodes[index].size += m_Nodes[next].size;
+		m_Nodes[index].nextPhysical = m_Nodes[next].nextPhysical;
+		if(m_Nodes[next].nextPhysical != INVALID_NODE) m_Nodes[m_Nodes[next].nextPhysical].prevPhysical = index;
+		ReleaseNode(next);
+	}
+
+	InsertFree(index);
+}
+
+void Tlsf::GetUsedRanges(std::vector<std::pair<VkDeviceSize, VkDeviceSize>>& ranges) const {
+	for(uint32_t i = m_FirstNode; i != INVALID_NODE; i = m_Nodes[i].nextPhysical) {
+		if(!m_Nodes[i].free) ranges.push_back({m_Nodes[i].offset, m_Nodes[i].size});
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocator
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Allocator::Allocator(VkPhysicalDevice physicalDevice, VkDevice device): m_PhysicalDevice(physicalDevice), m_Device(device) {
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+	m_NonCoherentAtomSize      = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+	m_MaxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+	m_Pools.resize(m_MemoryProperties.memoryTypeCount * 2);
+}
+
+Allocator::~Allocator() {
+	for(auto& pool : m_Pools) {
+		for(auto& block : pool.blocks) { vkFreeMemory(m_Device, block->memory, nullptr); }
+	}
+	for(auto& allocation : m_Dedicated) { vkFreeMemory(m_Device, allocation.memory, nullptr); }
+}
+
+/**
+ * @brief Allocates memory for the buffer and binds it.
+ * Uses vkGetBufferMemoryRequirements2 so the driver can tell us when it would rather have a dedicated allocation.
+ */
+Allocation Allocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+	VkMemoryDedicatedRequirements dedicatedRequirements {};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+	VkMemoryRequirements2 requirements {};
+	requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	requirements.pNext = &dedicatedRequirements;
+
+	VkBufferMemoryRequirementsInfo2 info {};
+	info.sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+	info.buffer = buffer;
+	vkGetBufferMemoryRequirements2(m_Device, &info, &requirements);
+
+	bool dedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation;
+
+	Allocation allocation;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		allocation = Allocate(requirements.memoryRequirements, properties, dedicated, VK_NULL_HANDLE, buffer);
+	}
+
+	if(vkBindBufferMemory(m_Device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) { throw std::runtime_error("failed to bind buffer memory!"); }
+	return allocation;
+}
+
+/**
+ * @brief Allocates memory for an optimally tiled image and binds it.
+ */
+Allocation Allocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties) {
+	VkMemoryDedicatedRequirements dedicatedRequirements {};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+	VkMemoryRequirements2 requirements {};
+	requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	requirements.pNext = &dedicatedRequirements;
+
+	VkImageMemoryRequirementsInfo2 info {};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+	info.image = image;
+	vkGetImageMemoryRequirements2(m_Device, &info, &requirements);
+
+	bool dedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation;
+
+	Allocation allocation;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		allocation = Allocate(requirements.memoryRequirements, properties, dedicated, image, VK_NULL_HANDLE);
+	}
+
+	if(vkBindImageMemory(m_Device, image, allocation.memory, allocation.offset) != VK_SUCCESS) { throw std::runtime_error("failed to bind image memory!"); }
+	return allocation;
+}
+
+Allocation Allocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool preferDedicated, VkImage image, VkBuffer buffer) {
+	uint32_t memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+	bool optimal             = image != VK_NULL_HANDLE;
+
+	// Anything bigger than half a block would waste most of a fresh block, give it its own memory
+	if(preferDedicated || requirements.size > GetBlockSize(memoryTypeIndex) / 2) { return AllocateDedicated(requirements.size, memoryTypeIndex, image, buffer); }
+
+	MemoryPool& pool = GetPool(memoryTypeIndex, optimal);
+	Allocation allocation;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+
+	// Small requests share power of two slots inside a slab
+	VkDeviceSize largestClass = MIN_SIZE_CLASS << (SIZE_CLASS_COUNT - 1);
+	if(requirements.size <= largestClass && requirements.alignment <= largestClass) {
+		VkDeviceSize classSize = std::bit_ceil(std::max({requirements.size, requirements.alignment, MIN_SIZE_CLASS}));
+		uint32_t sizeClass     = static_cast<uint32_t>(std::bit_width(classSize) - std::bit_width(MIN_SIZE_CLASS));
+		if(AllocateFromSlab(pool, sizeClass, memoryTypeIndex, optimal, allocation)) return allocation;
+	}
+
+	if(AllocateFromPool(pool, requirements.size, requirements.alignment, allocation)) return allocation;
+
+	CreateBlock(pool, memoryTypeIndex, optimal);
+	if(AllocateFromPool(pool, requirements.size, requirements.alignment, allocation)) return allocation;
+
+	throw std::runtime_error("failed to sub-allocate device memory!");
+}
+
+Allocation Allocator::AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, VkImage image, VkBuffer buffer) {
+	VkMemoryDedicatedAllocateInfo dedicatedInfo {};
+	dedicatedInfo.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+	dedicatedInfo.image  = image;
+	dedicatedInfo.buffer = buffer;
+
+	Allocation allocation;
+	allocation.memory          = AllocateDeviceMemory(size, memoryTypeIndex, &dedicatedInfo, &allocation.mapped);
+	allocation.offset          = 0;
+	allocation.size            = size;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.dedicated       = true;
+
+	m_Dedicated.push_back(allocation);
+	return allocation;
+}
+
+bool Allocator::AllocateFromPool(MemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) {
+	// Newest blocks first, older ones are usually the most fragmented
+	for(auto it = pool.blocks.rbegin(); it != pool.blocks.rend(); ++it) {
+		MemoryBlock* block = it->get();
+		VkDeviceSize offset;
+		uint32_t node = block->tlsf.Allocate(size, alignment, offset);
+		if(node == Tlsf::INVALID_NODE) continue;
+
+		allocation.memory          = block->memory;
+		allocation.offset          = offset;
+		allocation.size            = size;
+		allocation.mapped          = block->mapped ? static_cast<char*>(block->mapped) + offset : nullptr;
+		allocation.memoryTypeIndex = block->memoryTypeIndex;
+		allocation.block           = block;
+		allocation.slab            = nullptr;
+		allocation.node            = node;
+		return true;
+	}
+	return false;
+}
+
+bool Allocator::AllocateFromSlab(MemoryPool& pool, uint32_t sizeClass, uint32_t memoryTypeIndex, bool optimal, Allocation& allocation) {
+	VkDeviceSize classSize = MIN_SIZE_CLASS << sizeClass;
+	auto& slabs            = pool.slabs[sizeClass];
+
+	Slab* slab = nullptr;
+	for(auto it = slabs.rbegin(); it != slabs.rend(); ++it) {
+		if(!(*it)->freeSlots.empty()) {
+			slab = it->get();
+			break;
+		}
+	}
+
+	if(slab == nullptr) {
+		Allocation slabAllocation;
+		if(!AllocateFromPool(pool, SLAB_SIZE, classSize, slabAllocation)) {
+			CreateBlock(pool, memoryTypeIndex, optimal);
+			if(!AllocateFromPool(pool, SLAB_SIZE, classSize, slabAllocation)) return false;
+		}
+
+		auto newSlab       = std::make_unique<Slab>();
+		newSlab->block     = slabAllocation.block;
+		newSlab->node      = slabAllocation.node;
+		newSlab->offset    = slabAllocation.offset;
+		newSlab->sizeClass = sizeClass;
+		newSlab->slotCount = static_cast<uint32_t>(SLAB_SIZE / classSize);
+		newSlab->freeSlots.reserve(newSlab->slotCount);
+		// Reversed so slots are handed out front to back
+		for(uint32_t i = newSlab->slotCount; i > 0; i--) newSlab->freeSlots.push_back(i - 1);
+
+		slab = newSlab.get();
+		slabs.push_back(std::move(newSlab));
+	}
+
+	uint32_t slot = slab->freeSlots.back();
+	slab->freeSlots.pop_back();
+
+	allocation.memory          = slab->block->memory;
+	allocation.offset          = slab->offset + slot * classSize;
+	allocation.size            = classSize;
+	allocation.mapped          = slab->block->mapped ? static_cast<char*>(slab->block->mapped) + allocation.offset : nullptr;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.block           = slab->block;
+	allocation.slab            = slab;
+	allocation.node            = slot;
+	return true;
+}
+
+MemoryBlock* Allocator::CreateBlock(MemoryPool& pool, uint32_t memoryTypeIndex, bool optimal) {
+	VkDeviceSize size     = GetBlockSize(memoryTypeIndex);
+	void* mapped          = nullptr;
+	VkDeviceMemory memory = AllocateDeviceMemory(size, memoryTypeIndex, nullptr, &mapped);
+
+	pool.blocks.push_back(std::make_unique<MemoryBlock>(memory, size, memoryTypeIndex, optimal, mapped));
+	return pool.blocks.back().get();
+}
+
+VkDeviceMemory Allocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, void** mapped) {
+	VkMemoryAllocateInfo allocInfo {};
+	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.pNext           = pNext;
+	allocInfo.allocationSize  = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if(vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS) { throw std::runtime_error("failed to allocate device memory!"); }
+	m_DeviceMemoryCount++;
+
+	// Host visible memory stays mapped for its whole lifetime, mapping is not free and we map often
+	*mapped = nullptr;
+	if(m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if(vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) { throw std::runtime_error("failed to map device memory!"); }
+	}
+	return memory;
+}
+
+void Allocator::Free(Allocation& allocation) {
+	if(allocation.memory == VK_NULL_HANDLE) return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if(allocation.dedicated) {
+		auto it = std::find_if(m_Dedicated.begin(), m_Dedicated.end(), [&](const Allocation& a) { return a.memory == allocation.memory; });
+		if(it != m_Dedicated.end()) m_Dedicated.erase(it);
+		vkFreeMemory(m_Device, allocation.memory, nullptr);
+		m_DeviceMemoryCount--;
+	}
+	else {
+		MemoryBlock* block = allocation.block;
+		MemoryPool& pool   = GetPool(block->memoryTypeIndex, block->optimal);
+
+		if(allocation.slab) {
+			Slab* slab = allocation.slab;
+			slab->freeSlots.push_back(allocation.node);
+
+			// Hand fully empty slabs back to the block so other size classes can use the space
+			if(slab->freeSlots.size() == slab->slotCount) {
+				block->tlsf.Free(slab->node);
+				auto& slabs = pool.slabs[slab->sizeClass];
+				slabs.erase(std::find_if(slabs.begin(), slabs.end(), [&](const std::unique_ptr<Slab>& s) { return s.get() == slab; }));
+				ReleaseEmptyBlock(pool, block);
+			}
+		}
+		else {
+			block->tlsf.Free(allocation.node);
+			ReleaseEmptyBlock(pool, block);
+		}
+	}
+
+	allocation = {};
+}
+
+/**
+ * @brief Frees a block once nothing lives in it anymore.
+ * The last block of a pool is kept around so a create/destroy pattern doesn't hammer vkAllocateMemory.
+ */
+void Allocator::ReleaseEmptyBlock(MemoryPool& pool, MemoryBlock* block) {
+	if(!block->tlsf.IsEmpty() || pool.blocks.size() <= 1) return;
+
+	vkFreeMemory(m_Device, block->memory, nullptr);
+	m_DeviceMemoryCount--;
+	pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const std::unique_ptr<MemoryBlock>& b) { return b.get() == block; }));
+}
+
+/**
+ * @brief Builds the flush/invalidate range for an allocation.
+ * Ranges inside a shared block have to be expanded to nonCoherentAtomSize, VK_WHOLE_SIZE would
+ * otherwise touch every allocation after ours.
+ */
+VkMappedMemoryRange Allocator::GetMappedRange(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+	VkDeviceSize memorySize = allocation.dedicated ? allocation.size : allocation.block->tlsf.GetSize();
+	VkDeviceSize begin      = allocation.offset + offset;
+	VkDeviceSize end        = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+	begin = begin / m_NonCoherentAtomSize * m_NonCoherentAtomSize;
+	end   = AlignUp(end, m_NonCoherentAtomSize);
+
+	VkMappedMemoryRange range {};
+	range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.memory;
+	range.offset = begin;
+	range.size   = end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+	return range;
+}
+
+VkResult Allocator::Flush(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+	// Coherent memory never needs flushing
+	if(m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return VK_SUCCESS;
+
+	VkMappedMemoryRange range = GetMappedRange(allocation, size, offset);
+	return vkFlushMappedMemoryRanges(m_Device, 1, &range);
+}
+
+VkResult Allocator::Invalidate(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+	if(m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return VK_SUCCESS;
+
+	VkMappedMemoryRange range = GetMappedRange(allocation, size, offset);
+	return vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+}
+
+uint32_t Allocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+	for(uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++) {
+		if((typeFilter & (1 << i)) && ((m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)) { return i; }
+	}
+
+	throw std::runtime_error("failed to find suitable memory type!");
+}
+
+/**
+ * @brief Blocks are 64 MiB, small heaps (e.g. the 256 MiB host visible VRAM window) use an eighth of the heap
+ */
+VkDeviceSize Allocator::GetBlockSize(uint32_t memoryTypeIndex) {
+	VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+	if(heapSize <= 1024ull * 1024 * 1024) { return AlignUp(heapSize / 8, 1024 * 1024); }
+	return DEFAULT_BLOCK_SIZE;
+}
+
+AllocatorStats Allocator::GetStats() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	AllocatorStats stats;
+	stats.deviceMemoryCount        = m_DeviceMemoryCount;
+	stats.maxMemoryAllocationCount = m_MaxMemoryAllocationCount;
+	stats.heaps.resize(m_MemoryProperties.memoryHeapCount);
+	for(uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++) {
+		stats.heaps[i].heapSize    = m_MemoryProperties.memoryHeaps[i].size;
+		stats.heaps[i].deviceLocal = m_MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	}
+
+	for(uint32_t i = 0; i < m_Pools.size(); i++) {
+		HeapStats& heap = stats.heaps[m_MemoryProperties.memoryTypes[i / 2].heapIndex];
+		for(auto& block : m_Pools[i].blocks) {
+			heap.reservedBytes += block->tlsf.GetSize();
+			heap.usedBytes += block->tlsf.GetUsed();
+			heap.allocationCount += block->tlsf.GetAllocationCount();
+			heap.blockCount++;
+		}
+		// A slab is a single Tlsf allocation, only count the slots that are actually in use
+		for(auto& slabs : m_Pools[i].slabs) {
+			for(auto& slab : slabs) {
+				uint32_t usedSlots = slab->slotCount - static_cast<uint32_t>(slab->freeSlots.size());
+				heap.usedBytes -= static_cast<VkDeviceSize>(slab->freeSlots.size()) * (MIN_SIZE_CLASS << slab->sizeClass);
+				heap.allocationCount += usedSlots - 1;    // the slab itself was counted by the Tlsf
+				stats.slabCount++;
+			}
+		}
+	}
+
+	for(auto& allocation : m_Dedicated) {
+		HeapStats& heap = stats.heaps[m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex];
+		heap.reservedBytes += allocation.size;
+		heap.usedBytes += allocation.size;
+		heap.dedicatedBytes += allocation.size;
+		heap.dedicatedCount++;
+		heap.allocationCount++;
+	}
+	return stats;
+}
+
+std::vector<MemoryBlockInfo> Allocator::GetBlockInfo() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<MemoryBlockInfo> infos;
+	for(auto& pool : m_Pools) {
+		for(auto& block : pool.blocks) {
+			MemoryBlockInfo info {};
+			info.memoryTypeIndex = block->memoryTypeIndex;
+			info.heapIndex       = m_MemoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex;
+			info.size            = block->tlsf.GetSize();
+			info.dedicated       = false;
+			block->tlsf.GetUsedRanges(info.usedRanges);
+			infos.push_back(std::move(info));
+		}
+	}
+	for(auto& allocation : m_Dedicated) {
+		MemoryBlockInfo info {};
+		info.memoryTypeIndex = allocation.memoryTypeIndex;
+		info.heapIndex       = m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex;
+		info.size            = allocation.size;
+		info.dedicated       = true;
+		info.usedRanges.push_back({0, allocation.size});
+		infos.push_back(std::move(info));
+	}
+	return infos;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class MemoryBlock;
+struct Slab;
+
+/**
+ * @brief A sub-range of a VkDeviceMemory object handed out by the Allocator.
+ *
+ * Resources must be bound at `offset` inside `memory`. For host visible memory the whole
+ * block stays persistently mapped and `mapped` already points at the start of this range.
+ */
+struct Allocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset   = 0;
+	VkDeviceSize size     = 0;
+	void* mapped          = nullptr;
+
+	uint32_t memoryTypeIndex = 0;
+	bool dedicated           = false;
+
+	// Bookkeeping used by Allocator::Free
+	MemoryBlock* block = nullptr;
+	Slab* slab         = nullptr;
+	uint32_t node      = 0;
+};
+
+struct HeapStats {
+	VkDeviceSize heapSize       = 0;
+	bool deviceLocal            = false;
+	VkDeviceSize reservedBytes  = 0;    // bytes held in VkDeviceMemory objects (blocks + dedicated)
+	VkDeviceSize usedBytes      = 0;    // bytes handed out to resources
+	VkDeviceSize dedicatedBytes = 0;
+	uint32_t blockCount         = 0;
+	uint32_t dedicatedCount     = 0;
+	uint32_t allocationCount    = 0;
+};
+
+struct AllocatorStats {
+	std::vector<HeapStats> heaps;
+	uint32_t deviceMemoryCount        = 0;    // live vkAllocateMemory objects
+	uint32_t maxMemoryAllocationCount = 0;
+	uint32_t slabCount                = 0;
+};
+
+struct MemoryBlockInfo {
+	uint32_t memoryTypeIndex;
+	uint32_t heapIndex;
+	VkDeviceSize size;
+	bool dedicated;
+	std::vector<std::pair<VkDeviceSize, VkDeviceSize>> usedRanges;    // offset, size
+};
+
+/**
+ * @brief TLSF (two level segregated fit) free list over a single range of memory.
+ *
+ * Free ranges are bucketed by the position of their highest bit (first level) and 16 linear
+ * subdivisions inside that power of two (second level). Two bitmaps make both allocation and
+ * free O(1), and neighbouring free ranges are merged immediately on free.
+ */
+class Tlsf {
+public:
+	static constexpr uint32_t INVALID_NODE = ~0u;
+
+	Tlsf(VkDeviceSize size);
+
+	uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	void Free(uint32_t node);
+
+	inline VkDeviceSize GetSize() const { return m_Size; }
+
+	inline VkDeviceSize GetUsed() const { return m_Used; }
+
+	inline uint32_t GetAllocationCount() const { return m_AllocationCount; }
+
+	inline bool IsEmpty() const { return m_AllocationCount == 0; }
+
+	void GetUsedRanges(std::vector<std::pair<VkDeviceSize, VkDeviceSize>>& ranges) const;
+
+private:
+	static constexpr uint32_t SL_LOG2  = 4;
+	static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+	static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+	// Every offset and size is kept at this granularity so we never create unusable slivers
+	static constexpr VkDeviceSize MIN_ALIGNMENT = 16;
+
+	struct Node {
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		uint32_t prevPhysical;
+		uint32_t nextPhysical;
+		uint32_t prevFree;
+		uint32_t nextFree;
+		bool free;
+	};
+
+	static void Mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+	uint32_t FindFree(VkDeviceSize size);
+	void InsertFree(uint32_t node);
+	void RemoveFree(uint32_t node);
+	uint32_t NewNode();
+	void ReleaseNode(uint32_t node);
+
+	VkDeviceSize m_Size;
+	VkDeviceSize m_Used        = 0;
+	uint32_t m_AllocationCount = 0;
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_UnusedNodes;
+	uint32_t m_FirstNode = INVALID_NODE;
+
+	uint64_t m_FlBitmap = 0;
+	std::array<uint32_t, FL_COUNT> m_SlBitmap {};
+	std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> m_FreeHeads;
+};
+
+/**
+ * @brief One VkDeviceMemory block that is carved up with a Tlsf free list
+ */
+class MemoryBlock {
+public:
+	MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, bool optimal, void* mapped)
+	: memory(memory), memoryTypeIndex(memoryTypeIndex), optimal(optimal), mapped(mapped), tlsf(size) {}
+
+	VkDeviceMemory memory;
+	uint32_t memoryTypeIndex;
+	bool optimal;
+	void* mapped;
+	Tlsf tlsf;
+};
+
+/**
+ * @brief A run of equally sized slots used for small allocations (uniform buffers, small meshes).
+ * The slab itself is a single Tlsf allocation inside a MemoryBlock.
+ */
+struct Slab {
+	MemoryBlock* block;
+	uint32_t node;
+	VkDeviceSize offset;
+	uint32_t sizeClass;
+	uint32_t slotCount;
+	std::vector<uint32_t> freeSlots;
+};
+
+/**
+ * @brief Block based GPU memory sub-allocator.
+ *
+ * Instead of one vkAllocateMemory per resource (which quickly hits maxMemoryAllocationCount and
+ * wastes alignment padding) memory is reserved in large blocks per memory type and resources are
+ * placed inside them:
+ *   - small requests are rounded up to a power of two size class and served from slabs,
+ *   - medium requests are placed in the block with a TLSF free list,
+ *   - big requests and images the driver would like to own alone get a dedicated allocation.
+ *
+ * Linear resources (buffers) and optimally tiled images live in separate pools so we never have
+ * to care about bufferImageGranularity. Host visible blocks are persistently mapped.
+ */
+class Allocator {
+public:
+	Allocator(VkPhysicalDevice physicalDevice, VkDevice device);
+	~Allocator();
+
+	Allocator(const Allocator&)            = delete;
+	Allocator& operator=(const Allocator&) = delete;
+
+	Allocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+	Allocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties);
+	void Free(Allocation& allocation);
+
+	VkResult Flush(const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	VkResult Invalidate(const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+	AllocatorStats GetStats();
+	std::vector<MemoryBlockInfo> GetBlockInfo();
+
+	inline const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_MemoryProperties; }
+
+private:
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+	static constexpr VkDeviceSize SLAB_SIZE          = 256ull * 1024;
+	static constexpr VkDeviceSize MIN_SIZE_CLASS     = 256;
+	static constexpr uint32_t SIZE_CLASS_COUNT       = 8;    // 256 B ... 32 KiB
+
+	struct MemoryPool {
+		std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		std::array<std::vector<std::unique_ptr<Slab>>, SIZE_CLASS_COUNT> slabs;
+	};
+
+	Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool preferDedicated, VkImage image, VkBuffer buffer);
+	Allocation AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, VkImage image, VkBuffer buffer);
+	bool AllocateFromPool(MemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation);
+	bool AllocateFromSlab(MemoryPool& pool, uint32_t sizeClass, uint32_t memoryTypeIndex, bool optimal, Allocation& allocation);
+	MemoryBlock* CreateBlock(MemoryPool& pool, uint32_t memoryTypeIndex, bool optimal);
+	void ReleaseEmptyBlock(MemoryPool& pool, MemoryBlock* block);
+	VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, const void* pNext, void** mapped);
+
+	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+	VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex);
+	VkMappedMemoryRange GetMappedRange(const Allocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+	inline MemoryPool& GetPool(uint32_t memoryTypeIndex, bool optimal) { return m_Pools[memoryTypeIndex * 2 + (optimal ? 1 : 0)]; }
+
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+	VkDeviceSize m_NonCoherentAtomSize;
+	uint32_t m_MaxMemoryAllocationCount;
+
+	std::vector<MemoryPool> m_Pools;
+	std::vector<Allocation> m_Dedicated;
+	uint32_t m_DeviceMemoryCount = 0;
+
+	std::mutex m_Mutex;
+};
@@ -0,0 +1,283 @@
+#include "assetStreamer.h"
+
+#include "../profiler.h"
+#include "../textures/ktxFile.h"
+#include "../utilities.h"
+#include "uploadQueue.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+AssetStreamer::AssetStreamer(Device& device, uint32_t workerCount): m_Device(device) {
+	CreatePlaceholders();
+
+	// The game and render thread already keep two cores busy
+	if(workerCount == 0) { workerCount = std::clamp(std::thread::hardware_concurrency(), 3u, 6u) - 2; }
+	for(uint32_t i = 0; i < workerCount; i++) {
+		m_Workers.emplace_back([this, i]() {
+			CpuProfiler::RegisterThread("Streamer " + std::to_string(i));
+			WorkerLoop();
+		});
+	}
+}
+
+AssetStreamer::~AssetStreamer() {
+	{
+		// Whatever did not start loading yet is dropped, the ones in progress are finished
+		std::lock_guard<std::mutex> lock(m_JobMutex);
+		m_Stop = true;
+		m_Jobs.clear();
+	}
+	m_JobCondition.notify_all();
+	for(auto& worker : m_Workers) { worker.join(); }
+
+	m_Device.GetUploadQueue().WaitIdle();
+	m_Recorded.clear();
+	m_InFlight.clear();
+}
+
+/**
+ * @brief Starts loading an OBJ model (or its baked .mesh) in the background
+ */
+std::shared_ptr<Asset<Model>> AssetStreamer::LoadModel(const std::string& filepath) {
+	auto asset    = std::make_shared<Asset<Model>>();
+	asset->m_Path = filepath;
+
+	Enqueue(asset, [this, asset]() {
+		PROFILE_ZONE("Load model");
+		asset->m_Resource = Model::CreateModelFromFile(m_Device, asset->m_Path);
+	});
+	return asset;
+}
+
+/**
+ * @brief Starts loading a texture in the background, either an image file or one embedded in a .glb.
+ * Image files are replaced by their baked .ktx2 if it is up to date.
+ */
+std::shared_ptr<Asset<Image>> AssetStreamer::LoadImage(const TextureSource& source, bool srgb) {
+	auto asset    = std::make_shared<Asset<Image>>();
+	asset->m_Path = source.embeddedImage >= 0 ? source.filepath + "#" + std::to_string(source.embeddedImage) : source.filepath;
+
+	Enqueue(asset, [this, asset, source, srgb]() {
+		PROFILE_ZONE("Load texture");
+		if(source.embeddedImage < 0 && source.channel < 0) {
+			asset->m_Resource = LoadBakedImage({source.filepath});
+			if(!asset->m_Resource) asset->m_Resource = std::make_unique<Image>(m_Device, source.filepath, srgb);
+			return;
+		}
+
+		uint32_t width, height;
+		std::vector<uint8_t> pixels = GltfImporter::DecodeImage(source, width, height);
+		asset->m_Resource           = std::make_unique<Image>(m_Device, pixels.data(), width, height, srgb);
+	});
+	return asset;
+}
+
+/**
+ * @brief Starts loading two single channel images packed into the red and green channel of one texture
+ */
+std::shared_ptr<Asset<Image>> AssetStreamer::LoadPackedImage(const TextureSource& red, const TextureSource& green) {
+	auto asset    = std::make_shared<Asset<Image>>();
+	asset->m_Path = red.filepath + "+" + green.filepath;
+
+	Enqueue(asset, [this, asset, red, green]() {
+		PROFILE_ZONE("Load packed texture");
+		if(red.embeddedImage < 0 && green.embeddedImage < 0) {
+			asset->m_Resource = LoadBakedImage({red.filepath, green.filepath});
+			if(asset->m_Resource) return;
+		}
+
+		uint32_t redWidth, redHeight, greenWidth, greenHeight;
+		std::vector<uint8_t> redPixels   = GltfImporter::DecodeImage(red, redWidth, redHeight);
+		std::vector<uint8_t> greenPixels = GltfImporter::DecodeImage(green, greenWidth, greenHeight);
+
+		// A 1x1 image (the empty maps) is stretched over the other one
+		bool redIsConstant   = redWidth == 1 && redHeight == 1;
+		bool greenIsConstant = greenWidth == 1 && greenHeight == 1;
+		if(!redIsConstant && !greenIsConstant && (redWidth != greenWidth || redHeight != greenHeight)) {
+			throw std::runtime_error("failed to pack " + asset->m_Path + ", the images have different sizes!");
+		}
+
+		uint32_t width  = redIsConstant ? greenWidth : redWidth;
+		uint32_t height = redIsConstant ? greenHeight : redHeight;
+		std::vector<uint8_t> pixels(size_t(width) * height * 4);
+		for(size_t i = 0; i < size_t(width) * height; i++) {
+			pixels[i * 4 + 0] = redPixels[redIsConstant ? 0 : i * 4];
+			pixels[i * 4 + 1] = greenPixels[greenIsConstant ? 0 : i * 4];
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+		asset->m_Resource = std::make_unique<Image>(m_Device, pixels.data(), width, height);
+	});
+	return asset;
+}
+
+/**
+ * @brief Loads the texture TextureBaker made from `sourceFilepaths`, nullptr if there is none, it is out of date
+ * or the device can't sample its format
+ */
+std::unique_ptr<Image> AssetStreamer::LoadBakedImage(const std::vector<std::string>& sourceFilepaths) {
+	KtxFile file;
+	if(!file.Open(KtxFile::GetBakedPath(sourceFilepaths), KtxFile::HashSources(sourceFilepaths))) return nullptr;
+	if(!Image::IsFormatSupported(m_Device, file.GetFormat())) return nullptr;
+
+	return std::make_unique<Image>(m_Device, file);
+}
+
+/**
+ * @brief Starts loading the 6 faces of a cubemap in the background
+ */
+std::shared_ptr<Asset<Cubemap>> AssetStreamer::LoadCubemap(const std::array<std::string, 6>& filepaths) {
+	auto asset    = std::make_shared<Asset<Cubemap>>();
+	asset->m_Path = std::filesystem::path(filepaths[0]).parent_path().string();
+
+	Enqueue(asset, [this, asset, filepaths]() {
+		PROFILE_ZONE("Load cubemap");
+		auto cubemap = std::make_unique<Cubemap>(m_Device);
+		cubemap->CreateImageFromTexture(filepaths);
+		asset->m_Resource = std::move(cubemap);
+	});
+	return asset;
+}
+
+/**
+ * @brief Submits the uploads the workers recorded since the last call and marks finished assets as ready.
+ * Should be called once per frame.
+ */
+void AssetStreamer::Update() {
+	std::vector<std::shared_ptr<AssetBase>> recorded;
+	{
+		std::lock_guard<std::mutex> lock(m_JobMutex);
+		recorded.swap(m_Recorded);
+	}
+
+	UploadQueue& uploadQueue = m_Device.GetUploadQueue();
+
+	// Every asset that got here has its copies recorded already, so one submit covers all of them
+	if(!recorded.empty()) {
+		uint64_t value = uploadQueue.Submit();
+		for(auto& asset : recorded) {
+			asset->m_UploadValue = value;
+			m_InFlight.push_back(std::move(asset));
+		}
+	}
+
+	for(size_t i = 0; i < m_InFlight.size();) {
+		if(uploadQueue.IsComplete(m_InFlight[i]->m_UploadValue)) {
+			m_InFlight[i]->m_Ready.store(true, std::memory_order_release);
+			m_PendingCount.fetch_sub(1, std::memory_order_relaxed);
+			m_InFlight[i] = std::move(m_InFlight.back());
+			m_InFlight.pop_back();
+		}
+		else { i++; }
+	}
+}
+
+/**
+ * @brief Blocks until everything that was requested so far is loaded (or failed)
+ */
+void AssetStreamer::WaitIdle() {
+	{
+		std::unique_lock<std::mutex> lock(m_JobMutex);
+		m_IdleCondition.wait(lock, [&]() { return m_Jobs.empty() && m_BusyWorkers == 0; });
+	}
+
+	Update();
+	m_Device.GetUploadQueue().WaitIdle();
+	Update();
+}
+
+void AssetStreamer::Enqueue(const std::shared_ptr<AssetBase>& asset, std::function<void()> job) {
+	m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(m_JobMutex);
+	m_Jobs.push_back([this, asset, job = std::move(job)]() {
+		try {
+			job();
+		} catch(const std::exception& e) {
+			// Users keep drawing the placeholder
+			std::cerr << "failed to stream " << asset->m_Path << ": " << e.what() << std::endl;
+			asset->m_Failed.store(true, std::memory_order_release);
+			m_PendingCount.fetch_sub(1, std::memory_order_relaxed);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_JobMutex);
+		m_Recorded.push_back(asset);
+	});
+	m_JobCondition.notify_one();
+}
+
+void AssetStreamer::WorkerLoop() {
+	while(true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_JobMutex);
+			m_JobCondition.wait(lock, [&]() { return m_Stop || !m_Jobs.empty(); });
+			if(m_Stop) return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+			m_BusyWorkers++;
+		}
+
+		{
+			PROFILE_ZONE("Asset job");
+			job();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_JobMutex);
+			m_BusyWorkers--;
+		}
+		m_IdleCondition.notify_all();
+	}
+}
+
+/**
+ * @brief Creates the resources that are drawn while the real ones are still loading:
+ * a unit cube and a flat grey, non metallic, fully rough 1x1 material.
+ * These are tiny so we simply wait for them here.
+ */
+void AssetStreamer::CreatePlaceholders() {
+	Model::Builder cube {};
+	for(int axis = 0; axis < 3; axis++) {
+		for(float sign : {1.0f, -1.0f}) {
+			glm::vec3 normal {0.0f};
+			normal[axis] = sign;
+			// u x v = normal so every face is counter clockwise seen from outside, like the OBJ files
+			glm::vec3 u {0.0f};
+			u[(axis + 1) % 3] = 1.0f;
+			glm::vec3 v = glm::cross(normal, u);
+
+			uint32_t base = static_cast<uint32_t>(cube.vertices.size());
+			const glm::vec2 corners[4] {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+			for(const glm::vec2& corner : corners) {
+				Model::Vertex vertex {};
+				vertex.position = (normal + u * corner.x + v * corner.y) * 0.5f;
+				vertex.normal   = normal;
+				vertex.texCoord = corner * 0.5f + 0.5f;
+				cube.vertices.push_back(vertex);
+			}
+			for(uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u}) { cube.indices.push_back(base + index); }
+		}
+	}
+	cube.GenerateTangents();
+	m_PlaceholderModel = std::make_unique<Model>(m_Device, cube);
+
+	const uint8_t albedo[4]            = {128, 128, 128, 255};
+	const uint8_t normal[4]            = {128, 128, 255, 255};
+	const uint8_t metallicRoughness[4] = {0, 255, 0, 255};
+
+	m_PlaceholderTextures[PLACEHOLDER_ALBEDO]             = std::make_unique<Image>(m_Device, albedo, 1, 1, true);
+	m_PlaceholderTextures[PLACEHOLDER_NORMAL]             = std::make_unique<Image>(m_Device, normal, 1, 1);
+	m_PlaceholderTextures[PLACEHOLDER_METALLIC_ROUGHNESS] = std::make_unique<Image>(m_Device, metallicRoughness, 1, 1);
+
+	const uint8_t black[4] = {0, 0, 0, 255};
+	m_PlaceholderCubemap   = std::make_unique<Cubemap>(m_Device);
+	m_PlaceholderCubemap->CreateImageFromPixels({black, black, black, black, black, black}, 1, 1);
+
+	m_Device.GetUploadQueue().WaitIdle();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../models/gltfImporter.h"
+#include "cubemap.h"
+#include "device.h"
+#include "image.h"
+#include "model.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AssetStreamer;
+
+/**
+ * @brief Loading state shared between the streamer and the users of an asset
+ */
+class AssetBase {
+public:
+	virtual ~AssetBase() = default;
+
+	inline bool IsReady() const { return m_Ready.load(std::memory_order_acquire); }
+
+	inline bool HasFailed() const { return m_Failed.load(std::memory_order_acquire); }
+
+	inline const std::string& GetPath() const { return m_Path; }
+
+private:
+	friend class AssetStreamer;
+
+	std::string m_Path;
+	uint64_t m_UploadValue = 0;    // upload queue timeline value the data is resident at
+	std::atomic<bool> m_Ready {false};
+	std::atomic<bool> m_Failed {false};
+};
+
+/**
+ * @brief Handle to a resource that is loaded in the background. Get() returns nullptr until the data is on the GPU.
+ */
+template <typename T> class Asset : public AssetBase {
+public:
+	inline T* Get() { return IsReady() ? m_Resource.get() : nullptr; }
+
+private:
+	friend class AssetStreamer;
+
+	std::unique_ptr<T> m_Resource;
+};
+
+/**
+ * @brief Loads models, textures and cubemaps on worker threads.
+ *
+ * A worker decodes the file (OBJ / glTF / PNG / JPG, or the baked .mesh / .ktx2), creates the GPU resource and records its upload
+ * into the device UploadQueue. Update() is called once per frame from the game thread: it submits
+ * whatever the workers recorded since the last frame as one batch and flips assets to ready once
+ * their batch completed on the GPU. Until then users draw with the shared placeholders.
+ */
+class AssetStreamer {
+public:
+	// Metallic is stored in the red and roughness in the green channel of one texture
+	enum PlaceholderTexture { PLACEHOLDER_ALBEDO = 0, PLACEHOLDER_NORMAL, PLACEHOLDER_METALLIC_ROUGHNESS, PLACEHOLDER_COUNT };
+
+	AssetStreamer(Device& device, uint32_t workerCount = 0);
+	~AssetStreamer();
+
+	AssetStreamer(const AssetStreamer&)            = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+	std::shared_ptr<Asset<Model>> LoadModel(const std::string& filepath);
+	std::shared_ptr<Asset<Image>> LoadImage(const TextureSource& source, bool srgb = false);
+	std::shared_ptr<Asset<Image>> LoadPackedImage(const TextureSource& red, const TextureSource& green);
+	std::shared_ptr<Asset<Cubemap>> LoadCubemap(const std::array<std::string, 6>& filepaths);
+
+	void Update();
+	void WaitIdle();
+
+	inline Model& GetPlaceholderModel() { return *m_PlaceholderModel; }
+
+	inline Image& GetPlaceholderTexture(PlaceholderTexture texture) { return *m_PlaceholderTextures[texture]; }
+
+	inline Cubemap& GetPlaceholderCubemap() { return *m_PlaceholderCubemap; }
+
+	inline uint32_t GetPendingCount() const { return m_PendingCount.load(std::memory_order_relaxed); }
+
+private:
+	void Enqueue(const std::shared_ptr<AssetBase>& asset, std::function<void()> job);
+	void WorkerLoop();
+	void CreatePlaceholders();
+	std::unique_ptr<Image> LoadBakedImage(const std::vector<std::string>& sourceFilepaths);
+
+	Device& m_Device;
+
+	std::unique_ptr<Model> m_PlaceholderModel;
+	std::array<std::unique_ptr<Image>, PLACEHOLDER_COUNT> m_PlaceholderTextures;
+	std::unique_ptr<Cubemap> m_PlaceholderCubemap;
+
+	std::vector<std::thread> m_Workers;
+	std::deque<std::function<void()>> m_Jobs;
+	std::mutex m_JobMutex;
+	std::condition_variable m_JobCondition;
+	bool m_Stop = false;
+
+	// Assets whose uploads were recorded but not yet submitted, guarded by m_JobMutex
+	std::vector<std::shared_ptr<AssetBase>> m_Recorded;
+	// Submitted assets waiting for their batch, only touched by Update()
+	std::vector<std::shared_ptr<AssetBase>> m_InFlight;
+	std::atomic<uint32_t> m_PendingCount {0};
+	uint32_t m_BusyWorkers = 0;
+	std::condition_variable m_IdleCondition;
+};
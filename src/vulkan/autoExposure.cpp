@@ -0,0 +1,128 @@
+#include "autoExposure.h"
+
+#include <stdexcept>
+
+static constexpr uint32_t HISTOGRAM_GROUP_SIZE = 16;
+
+// Luminance from 2^-10 to 2^4 is binned, everything darker lands in the first bin which the average ignores
+static constexpr float MIN_LOG_LUMINANCE   = -10.0f;
+static constexpr float LOG_LUMINANCE_RANGE = 14.0f;
+
+AutoExposure::AutoExposure(Device& device): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device)
+	             .SetMaxSets(Swapchain::MAX_FRAMES_IN_FLIGHT)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT * 2)
+	             .Build();
+
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_NEAREST;
+	samplerInfo.minFilter    = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = 0.0f;
+	if(vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS) { throw std::runtime_error("failed to create auto exposure sampler!"); }
+
+	CreateBuffers();
+	CreatePipelines();
+}
+
+AutoExposure::~AutoExposure() {
+	vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr);
+}
+
+void AutoExposure::CreateBuffers() {
+	m_HistogramBuffer = std::make_unique<Buffer>(m_Device, sizeof(uint32_t), HISTOGRAM_BINS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	m_ExposureBuffer  = std::make_unique<Buffer>(m_Device, sizeof(float), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void AutoExposure::CreatePipelines() {
+	auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+	layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	layoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	m_SetLayout = layoutBuilder.Build();
+
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset     = 0;
+	pushConstantRange.size       = sizeof(PushConstants);
+
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_SetLayout->GetDescriptorSetLayout()};
+	Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_PipelineLayout, &pushConstantRange);
+
+	m_HistogramPipeline = std::make_unique<Pipeline>(m_Device);
+	m_HistogramPipeline->CreateComputePipeline(SHADER_DIRECTORY "luminanceHistogram.comp.spv", m_PipelineLayout);
+
+	m_AveragePipeline = std::make_unique<Pipeline>(m_Device);
+	m_AveragePipeline->CreateComputePipeline(SHADER_DIRECTORY "luminanceAverage.comp.spv", m_PipelineLayout);
+}
+
+/**
+ * @brief Only called right after the swapchain was recreated, so the GPU is idle
+ */
+void AutoExposure::Resize(Swapchain& swapchain) {
+	m_Pool->ResetPool();
+
+	VkDescriptorBufferInfo histogramInfo = m_HistogramBuffer->DescriptorInfo();
+	VkDescriptorBufferInfo exposureInfo  = m_ExposureBuffer->DescriptorInfo();
+	for(uint32_t frame = 0; frame < Swapchain::MAX_FRAMES_IN_FLIGHT; frame++) {
+		VkDescriptorImageInfo hdrInfo {m_Sampler, swapchain.GetHdrImage(frame)->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+		DescriptorWriter writer(*m_SetLayout, *m_Pool);
+		writer.WriteImage(0, &hdrInfo);
+		writer.WriteBuffer(1, &histogramInfo);
+		writer.WriteBuffer(2, &exposureInfo);
+		if(!writer.Build(m_Sets[frame])) { throw std::runtime_error("failed to allocate auto exposure descriptor set!"); }
+	}
+}
+
+void AutoExposure::Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D renderExtent, float deltaTime) {
+	VkMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+	if(!m_BuffersCleared) {
+		// An exposure of zero makes the first average jump straight to its target instead of adapting to it
+		vkCmdFillBuffer(commandBuffer, m_HistogramBuffer->GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_ExposureBuffer->GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+		m_BuffersCleared = true;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	} else {
+		// The last frame's average pass cleared the histogram and the tonemapping read the exposure
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	PushConstants push {};
+	push.minLogLuminance   = MIN_LOG_LUMINANCE;
+	push.logLuminanceRange = LOG_LUMINANCE_RANGE;
+	push.deltaTime         = deltaTime;
+	push.adaptationSpeed   = m_AdaptationSpeed;
+	push.width             = renderExtent.width;
+	push.height            = renderExtent.height;
+
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_Sets[frameIndex], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+
+	m_HistogramPipeline->Bind(commandBuffer);
+	vkCmdDispatch(commandBuffer, (renderExtent.width + HISTOGRAM_GROUP_SIZE - 1) / HISTOGRAM_GROUP_SIZE, (renderExtent.height + HISTOGRAM_GROUP_SIZE - 1) / HISTOGRAM_GROUP_SIZE, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// A single work group, one invocation per bin
+	m_AveragePipeline->Bind(commandBuffer);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
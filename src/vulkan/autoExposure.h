@@ -0,0 +1,70 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <array>
+#include <memory>
+
+/**
+ * @brief Adapts the exposure to the average luminance of the HDR image, entirely on the GPU.
+ *
+ * A compute pass bins the log luminance of every pixel into a 256 bin histogram, a second one reduces the histogram to
+ * the average luminance and moves the exposure towards the one that maps it to middle grey. The exposure stays in a
+ * device local buffer the tonemapping reads, so nothing is ever read back and the frame never waits on the GPU.
+ */
+class AutoExposure {
+public:
+	AutoExposure(Device& device);
+	~AutoExposure();
+
+	AutoExposure(const AutoExposure&)            = delete;
+	AutoExposure& operator=(const AutoExposure&) = delete;
+
+	// Points the histogram at the HDR images of a new swapchain
+	void Resize(Swapchain& swapchain);
+
+	// Has to be recorded after the geometry passes, the exposure is ready for any compute pass recorded after it
+	void Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D renderExtent, float deltaTime);
+
+	// A single float, the exposure the tonemapping should use
+	inline VkDescriptorBufferInfo GetExposureBufferInfo() { return m_ExposureBuffer->DescriptorInfo(); }
+
+	// How fast the exposure follows the scene, in 1 / seconds
+	inline float& GetAdaptationSpeed() { return m_AdaptationSpeed; }
+
+private:
+	static constexpr uint32_t HISTOGRAM_BINS = 256;
+
+	struct PushConstants {
+		float minLogLuminance;
+		float logLuminanceRange;
+		float deltaTime;
+		float adaptationSpeed;
+		uint32_t width;    // the rendered part of the HDR image
+		uint32_t height;
+	};
+
+	void CreateBuffers();
+	void CreatePipelines();
+
+	Device& m_Device;
+
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_SetLayout;
+	VkPipelineLayout m_PipelineLayout;
+	std::unique_ptr<Pipeline> m_HistogramPipeline;
+	std::unique_ptr<Pipeline> m_AveragePipeline;
+	VkSampler m_Sampler;
+
+	std::unique_ptr<Buffer> m_HistogramBuffer;
+	std::unique_ptr<Buffer> m_ExposureBuffer;
+	bool m_BuffersCleared = false;    // afterwards the average pass clears the histogram for the next frame
+
+	std::array<VkDescriptorSet, Swapchain::MAX_FRAMES_IN_FLIGHT> m_Sets {};    // one per HDR image
+
+	float m_AdaptationSpeed = 1.5f;
+};
@@ -62,36 +62,34 @@ Buffer::Buffer(Device& device, VkDeviceSize instanceSize, uint32_t instanceCount
 : m_Device(device), m_InstanceSize(instanceSize), m_InstanceCount(instanceCount), m_UsageFlags(usageFlags), m_MemoryPropertyFlags(memoryPropertyFlags) {
 	m_AlignmentSize = GetAlignment(instanceSize, minOffsetAlignment);
 	m_BufferSize    = m_AlignmentSize * m_InstanceCount;
-	m_Device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Memory);
+	m_Device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Allocation);
 }
 
 Buffer::~Buffer() {
 	Unmap();
 	vkDestroyBuffer(m_Device.GetDevice(), m_Buffer, nullptr);
-	vkFreeMemory(m_Device.GetDevice(), m_Memory, nullptr);
+	m_Device.GetAllocator().Free(m_Allocation);
 }
 
 /**
- * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
+ * Map this buffer from `offset` on. If successful, mapped points to that byte of the buffer.
+ * Host visible blocks are persistently mapped by the allocator, so this only hands out a pointer
+ * into that mapping and never calls vkMapMemory, there is no range to pick.
  *
- * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
- * buffer range.
  * @param offset (Optional) Byte offset from beginning
  */
-VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset) {
-	ASSERT(m_Buffer && m_Memory);    // Called map on buffer before create
-	return vkMapMemory(m_Device.GetDevice(), m_Memory, offset, size, 0, &m_Mapped);
+VkResult Buffer::Map(VkDeviceSize offset) {
+	ASSERT(m_Buffer && m_Allocation.memory);    // Called map on buffer before create
+	if(m_Allocation.mapped == nullptr) return VK_ERROR_MEMORY_MAP_FAILED;
+
+	m_Mapped = static_cast<char*>(m_Allocation.mapped) + offset;
+	return VK_SUCCESS;
 }
 
 /**
- * Unmap a mapped memory range
+ * Unmap a mapped memory range. The underlying block stays mapped until the allocator frees it.
  */
-void Buffer::Unmap() {
-	if(m_Mapped) {
-		vkUnmapMemory(m_Device.GetDevice(), m_Memory);
-		m_Mapped = nullptr;
-	}
-}
+void Buffer::Unmap() { m_Mapped = nullptr; }
 
 /**
  * Copies the specified data to the mapped buffer. Default value writes whole buffer range
@@ -128,14 +126,7 @@ void Buffer::WriteToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset) {
  *
  * @return VkResult of the flush call
  */
-VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory              = m_Memory;
-	mappedRange.offset              = offset;
-	mappedRange.size                = size;
-	return vkFlushMappedMemoryRanges(m_Device.GetDevice(), 1, &mappedRange);
-}
+VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) { return m_Device.GetAllocator().Flush(m_Allocation, size, offset); }
 
 /**
  * @brief a memory range of the buffer to make it visible to the host
@@ -148,14 +139,7 @@ VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) {
  *
  * @return VkResult of the invalidate call
  */
-VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset) {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory              = m_Memory;
-	mappedRange.offset              = offset;
-	mappedRange.size                = size;
-	return vkInvalidateMappedMemoryRanges(m_Device.GetDevice(), 1, &mappedRange);
-}
+VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset) { return m_Device.GetAllocator().Invalidate(m_Allocation, size, offset); }
 
 /**
  * Create a buffer info descriptor
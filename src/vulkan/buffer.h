@@ -10,7 +10,7 @@ public:
 	Buffer(const Buffer&)            = delete;
 	Buffer& operator=(const Buffer&) = delete;
 
-	VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	VkResult Map(VkDeviceSize offset = 0);
 	void Unmap();
 
 	void WriteToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -38,9 +38,9 @@ private:
 	static VkDeviceSize GetAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
 
 	Device& m_Device;
-	void* m_Mapped          = nullptr;
-	VkBuffer m_Buffer       = VK_NULL_HANDLE;
-	VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+	void* m_Mapped    = nullptr;
+	VkBuffer m_Buffer = VK_NULL_HANDLE;
+	Allocation m_Allocation;
 
 	VkDeviceSize m_BufferSize;
 	uint32_t m_InstanceCount;
@@ -1,6 +1,9 @@
 #include "cubemap.h"
 
+#include "../mappedFile.h"
+#include "buffer.h"
 #include "image.h"
+#include "uploadQueue.h"
 #include "stbimage/stb_image.h"
 
 #include <memory>
@@ -10,7 +13,7 @@ Cubemap::Cubemap(Device& device): m_Device(device), m_CubeMapSampler(device) {}
 
 Cubemap::~Cubemap() {
 	vkDestroyImage(m_Device.GetDevice(), m_CubeMapImage, nullptr);
-	vkFreeMemory(m_Device.GetDevice(), m_CubeMapImageMemory, nullptr);
+	m_Device.GetAllocator().Free(m_CubeMapAllocation);
 	vkDestroyImageView(m_Device.GetDevice(), m_CubeMapImageView, nullptr);
 }
 
@@ -40,73 +43,50 @@ void Cubemap::CreateImage(uint32_t width, uint32_t height) {
 void Cubemap::CreateImageFromTexture(const std::array<std::string, 6>& filepaths) {
 	std::array<stbi_uc*, 6> pixels;
 
-	for(int i = 0; i < 6; i++) { pixels[i] = stbi_load(filepaths[i].c_str(), &m_Width, &m_Height, &m_TextureChannles, STBI_rgb_alpha); }
-	CreateImage(m_Width, m_Height);
+	for(int i = 0; i < 6; i++) {
+		MappedFile file;
+		if(file.Open(filepaths[i])) pixels[i] = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &m_Width, &m_Height, &m_TextureChannles, STBI_rgb_alpha);
+		else pixels[i] = nullptr;
+		if(!pixels[i]) { throw std::runtime_error("failed to load cubemap face! " + filepaths[i]); }
+	}
 
-	VkDeviceSize allSize   = m_Width * m_Height * 4 * 6;
-	VkDeviceSize imageSize = m_Width * m_Height * 4;
-
-	VkMemoryAllocateInfo memAllocInfo {};
-	memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	VkMemoryRequirements memReqs;
-
-	VkBufferCreateInfo bufferCreateInfo {};
-	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferCreateInfo.size  = allSize;
-	// This buffer is used as a transfer source for the buffer copy
-	bufferCreateInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	vkCreateBuffer(m_Device.GetDevice(), &bufferCreateInfo, nullptr, &m_StagingBuffer);
-
-	vkGetBufferMemoryRequirements(m_Device.GetDevice(), m_StagingBuffer, &memReqs);
-	memAllocInfo.allocationSize = memReqs.size;
-	// Get memory type index for a host visible buffer
-	memAllocInfo.memoryTypeIndex = m_Device.FindMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	vkAllocateMemory(m_Device.GetDevice(), &memAllocInfo, nullptr, &m_StagingMemory);
-	vkBindBufferMemory(m_Device.GetDevice(), m_StagingBuffer, m_StagingMemory, 0);
-
-	// Copy texture data into staging buffer
-	uint8_t* data;
-	vkMapMemory(m_Device.GetDevice(), m_StagingMemory, 0, memReqs.size, 0, (void**) &data);
-	for(int i = 0; i < 6; i++) { memcpy((char*) data + (imageSize * i), pixels[i], static_cast<size_t>(imageSize)); }
-	vkUnmapMemory(m_Device.GetDevice(), m_StagingMemory);
-
-	vkGetImageMemoryRequirements(m_Device.GetDevice(), m_CubeMapImage, &memReqs);
-	memAllocInfo.allocationSize  = memReqs.size;
-	memAllocInfo.memoryTypeIndex = m_Device.FindMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	vkAllocateMemory(m_Device.GetDevice(), &memAllocInfo, nullptr, &m_CubeMapImageMemory);
-	vkBindImageMemory(m_Device.GetDevice(), m_CubeMapImage, m_CubeMapImageMemory, 0);
-
-	VkImageSubresourceRange subresourceRange = {};
-	subresourceRange.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel            = 0;
-	subresourceRange.levelCount              = 1;
-	subresourceRange.baseArrayLayer          = 0;
-	subresourceRange.layerCount              = 6;
+	CreateImageFromPixels({pixels[0], pixels[1], pixels[2], pixels[3], pixels[4], pixels[5]}, m_Width, m_Height);
 
-	Image::TransitionImageLayout(m_Device, m_CubeMapImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
-
-	VkCommandBuffer commandBuffer;
-	m_Device.BeginSingleTimeCommands(commandBuffer);
-
-	VkBufferImageCopy region {};
-	region.bufferOffset                    = 0;
-	region.bufferRowLength                 = 0;
-	region.bufferImageHeight               = 0;
-	region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel       = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount     = 6;
-	region.imageOffset                     = {0, 0, 0};
-	region.imageExtent                     = {(uint32_t) m_Width, (uint32_t) m_Height, 1};
+	for(int i = 0; i < 6; i++) { stbi_image_free(pixels[i]); }
+}
 
-	vkCmdCopyBufferToImage(commandBuffer, m_StagingBuffer, m_CubeMapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+/**
+ * @brief Creates the cubemap from 6 already decoded R8G8B8A8 faces of equal size
+ */
+void Cubemap::CreateImageFromPixels(const std::array<const void*, 6>& faces, uint32_t width, uint32_t height) {
+	CreateImage(width, height);
 
-	m_Device.EndSingleTimeCommands(commandBuffer);
+	VkDeviceSize imageSize = m_Width * m_Height * 4;
 
-	Image::TransitionImageLayout(m_Device, m_CubeMapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+	m_CubeMapAllocation = m_Device.GetAllocator().AllocateImage(m_CubeMapImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// Every face is its own array layer, so each one is uploaded separately straight from the decoded pixels
+	for(uint32_t i = 0; i < 6; i++) {
+		VkBufferImageCopy region {};
+		region.bufferOffset                    = 0;
+		region.bufferRowLength                 = 0;
+		region.bufferImageHeight               = 0;
+		region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel       = 0;
+		region.imageSubresource.baseArrayLayer = i;
+		region.imageSubresource.layerCount     = 1;
+		region.imageOffset                     = {0, 0, 0};
+		region.imageExtent                     = {(uint32_t) m_Width, (uint32_t) m_Height, 1};
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel            = 0;
+		subresourceRange.levelCount              = 1;
+		subresourceRange.baseArrayLayer          = i;
+		subresourceRange.layerCount              = 1;
+
+		m_Device.GetUploadQueue().UploadImage(m_CubeMapImage, faces[i], imageSize, {region}, subresourceRange);
+	}
 
 	// Create image view
 	VkImageViewCreateInfo view {};
@@ -121,9 +101,4 @@ void Cubemap::CreateImageFromTexture(const std::array<std::string, 6>& filepaths
 	view.subresourceRange.levelCount = 1;
 	view.image                       = m_CubeMapImage;
 	vkCreateImageView(m_Device.GetDevice(), &view, nullptr, &m_CubeMapImageView);
-
-	vkFreeMemory(m_Device.GetDevice(), m_StagingMemory, nullptr);
-	vkDestroyBuffer(m_Device.GetDevice(), m_StagingBuffer, nullptr);
-
-	for(int i = 0; i < 6; i++) { stbi_image_free(pixels[i]); }
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ public:
 
 	void CreateImage(uint32_t width, uint32_t height);
 	void CreateImageFromTexture(const std::array<std::string, 6>& filepaths);
+	void CreateImageFromPixels(const std::array<const void*, 6>& faces, uint32_t width, uint32_t height);
 
 	inline VkSampler GetCubeMapImageSampler() { return m_CubeMapSampler.GetSampler(); }
 
@@ -20,6 +21,9 @@ public:
 
 	inline VkImageView GetCubeMapImageView() { return m_CubeMapImageView; }
 
+	// Of every face, the faces are square
+	inline int32_t GetWidth() const { return m_Width; }
+
 private:
 	Device& m_Device;
 
@@ -27,11 +31,7 @@ private:
 
 	VkImage m_CubeMapImage;
 	VkImageView m_CubeMapImageView;
-	VkDeviceMemory m_CubeMapImageMemory;
+	Allocation m_CubeMapAllocation;
 
 	Sampler m_CubeMapSampler;
-
-	// Create a host-visible staging buffer that contains the raw image data
-	VkBuffer m_StagingBuffer;
-	VkDeviceMemory m_StagingMemory;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "device.h"
 
 #include "GLFW/glfw3.h"
+#include "uploadQueue.h"
 
 #include <cstring>
 #include <iostream>
@@ -53,14 +54,18 @@ Device::Device(Window& window): m_Window {window} {
 	PickPhysicalDevice();
 	CreateLogicalDevice();
 	CreateCommandPool();
+	m_Allocator   = std::make_unique<Allocator>(m_PhysicalDevice, m_Device);
+	m_UploadQueue = std::make_unique<UploadQueue>(*this);
 }
 
 Device::~Device() {
+	m_UploadQueue.reset();
+	m_Allocator.reset();
 	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
 	vkDestroyDevice(m_Device, nullptr);
 	if(m_EnableValidationLayers) { DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, nullptr); }
 
-	vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+	if(!IsHeadless()) vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
 	vkDestroyInstance(m_Instance, nullptr);
 }
 
@@ -86,10 +91,13 @@ bool Device::CheckValidationLayerSupport() {
 }
 
 std::vector<const char*> Device::GetRequiredGlfwExtensions() {
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	// Headless there are no surface extensions to ask GLFW for, it isn't initialized
+	std::vector<const char*> extensions;
+	if(!IsHeadless()) {
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if(m_EnableValidationLayers) { extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME); }
 
@@ -187,21 +195,36 @@ QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device) {
 
 	int i = 0;
 	for(const auto& queueFamily : queueFamilies) {
-		if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+		if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamilyHasValue) {
 			indices.graphicsFamily         = i;
 			indices.graphicsFamilyHasValue = true;
 		}
+		// Headless nothing is presented, the graphics queue stands in for the present queue
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface, &presentSupport);
-		if(presentSupport) {
+		if(IsHeadless()) presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+		else vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface, &presentSupport);
+		if(presentSupport && !indices.presentFamilyHasValue) {
 			indices.presentFamily         = i;
 			indices.presentFamilyHasValue = true;
 		}
-		if(indices.IsComplete()) { break; }
+		/*
+            A family that can only do transfers maps to the copy engines of the GPU. Uploads submitted
+            there run in parallel to rendering instead of being serialized with it on the graphics queue.
+        */
+		if((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && !indices.transferFamilyHasValue) {
+			indices.transferFamily         = i;
+			indices.transferFamilyHasValue = true;
+		}
 
 		i++;
 	}
 
+	// No dedicated transfer family, every graphics queue supports transfers as well
+	if(!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+		indices.transferFamily         = indices.graphicsFamily;
+		indices.transferFamilyHasValue = true;
+	}
+
 	return indices;
 }
 
@@ -210,13 +233,33 @@ bool Device::IsDeviceSuitable(VkPhysicalDevice device) {
 
 	bool extensionSupported = CheckDeviceExtensionSupport(device);
 
-	bool swapChainAdequate = false;
-	if(extensionSupported) {
+	bool swapChainAdequate = IsHeadless();
+	if(extensionSupported && !IsHeadless()) {
 		SwapchainSupportDetails swapChainSupport = QuerySwapchainSupport(device);
 		swapChainAdequate                        = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	return indices.IsComplete() && extensionSupported && swapChainAdequate;
+	// Upload completion is tracked with timeline semaphores (core in 1.2, but still an optional feature)
+	VkPhysicalDeviceVulkan12Features features12 {};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+	VkPhysicalDeviceFeatures2 features {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features12;
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	// The luminance histogram merges the atomics of a subgroup that hit the same bin
+	VkPhysicalDeviceSubgroupProperties subgroupProperties {};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &subgroupProperties;
+	vkGetPhysicalDeviceProperties2(device, &properties);
+
+	VkSubgroupFeatureFlags subgroupOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+	bool subgroupsAdequate                    = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) && (subgroupProperties.supportedOperations & subgroupOperations) == subgroupOperations;
+
+	// The tonemapping writes the swapchain images, whose format has no matching storage image qualifier
+	return indices.IsComplete() && extensionSupported && swapChainAdequate && subgroupsAdequate && features12.timelineSemaphore && features.features.shaderStorageImageWriteWithoutFormat;
 }
 
 void Device::PickPhysicalDevice() {
@@ -244,7 +287,7 @@ void Device::CreateLogicalDevice() {
 	QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
 	float queuePriority = 1.0f;
 	for(uint32_t queueFamily : uniqueQueueFamilies) {
@@ -256,16 +299,48 @@ void Device::CreateLogicalDevice() {
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	// Baked textures are block compressed, without BC support the source images are loaded instead
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.samplerAnisotropy        = VK_TRUE;
+	deviceFeatures.textureCompressionBC     = supportedFeatures.textureCompressionBC;
+
+	// Only for the GPU profiler, it falls back to timestamps without it
+	deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+
+	deviceFeatures.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+	m_EnabledFeatures                                   = deviceFeatures;
+
+	VkPhysicalDeviceVulkan12Features features12 = {};
+	features12.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+	features12.timelineSemaphore                = VK_TRUE;
+
+	// The GPU profiler uses calibrated timestamps to place GPU work on the CPU timeline
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+	if(!IsHeadless()) m_EnabledExtensions = m_DeviceExtensions;
+	for(const char* optional : m_OptionalDeviceExtensions) {
+		for(const auto& extension : availableExtensions) {
+			if(std::strcmp(extension.extensionName, optional) == 0) {
+				m_EnabledExtensions.push_back(optional);
+				break;
+			}
+		}
+	}
 
 	VkDeviceCreateInfo createInfo      = {};
 	createInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext                   = &features12;
 	createInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos       = queueCreateInfos.data();
 	createInfo.pEnabledFeatures        = &deviceFeatures;
-	createInfo.enabledExtensionCount   = (uint32_t) m_DeviceExtensions.size();
-	createInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
+	createInfo.enabledExtensionCount   = (uint32_t) m_EnabledExtensions.size();
+	createInfo.ppEnabledExtensionNames = m_EnabledExtensions.data();
 
 	if(m_EnableValidationLayers) {
 		createInfo.enabledLayerCount   = static_cast<uint32_t>(m_ValidationLayers.size());
@@ -277,9 +352,23 @@ void Device::CreateLogicalDevice() {
 
 	vkGetDeviceQueue(m_Device, indices.graphicsFamily, 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_Device, indices.graphicsFamily, 0, &m_PresentQueue);
+	vkGetDeviceQueue(m_Device, indices.transferFamily, 0, &m_TransferQueue);
+}
+
+void Device::CreateSurface() {
+	if(IsHeadless()) {
+		m_Surface = VK_NULL_HANDLE;
+		return;
+	}
+	m_Window.CreateWindowSurface(m_Instance, &m_Surface);
 }
 
-void Device::CreateSurface() { m_Window.CreateWindowSurface(m_Instance, &m_Surface); }
+bool Device::IsExtensionEnabled(const char* name) const {
+	for(const char* extension : m_EnabledExtensions) {
+		if(std::strcmp(extension, name) == 0) return true;
+	}
+	return false;
+}
 
 bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
 	uint32_t extensionCount;
@@ -288,6 +377,9 @@ bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
 	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
+	// The swapchain extension is the only required one, headless it isn't needed
+	if(IsHeadless()) return true;
+
 	std::set<std::string> requiredExtensions(m_DeviceExtensions.begin(), m_DeviceExtensions.end());
 
 	for(const auto& extension : availableExtensions) { requiredExtensions.erase(extension.extensionName); }
@@ -368,7 +460,7 @@ uint32_t Device::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
 	throw std::runtime_error("failed to find suitable memory type!");
 }
 
-void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation) {
 	VkBufferCreateInfo bufferInfo {};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size  = size;
@@ -392,20 +484,11 @@ void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
         our own application requirements to find the right type of memory to use.
     */
 
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo {};
-	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize  = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-	if(vkAllocateMemory(m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) { throw std::runtime_error("failed to allocate vertex buffer memory!"); }
-
 	/*
-        If memory allocation was successful, then we can now associate this memory with the buffer using vkBindBufferMemory
+        Memory is not allocated per buffer anymore. The allocator hands out a range inside one of its
+        blocks (or a dedicated allocation for big buffers) and binds the buffer at that offset.
     */
-	vkBindBufferMemory(m_Device, buffer, bufferMemory, 0);
+	allocation = m_Allocator->AllocateBuffer(buffer, properties);
 }
 
 void Device::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -437,6 +520,14 @@ void Device::BeginSingleTimeCommands(VkCommandBuffer& buffer) {
 	vkBeginCommandBuffer(buffer, &beginInfo);
 }
 
+/**
+ * @brief vkDeviceWaitIdle waits on every queue, so it needs the same external synchronization as a submit to each of them
+ */
+void Device::WaitIdle() {
+	std::scoped_lock lock(m_GraphicsQueueMutex, m_TransferQueueMutex);
+	vkDeviceWaitIdle(m_Device);
+}
+
 void Device::EndSingleTimeCommands(VkCommandBuffer commandBuffer) {
 	vkEndCommandBuffer(commandBuffer);
 
@@ -445,6 +536,7 @@ void Device::EndSingleTimeCommands(VkCommandBuffer commandBuffer) {
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers    = &commandBuffer;
 
+	std::lock_guard<std::mutex> lock(m_GraphicsQueueMutex);
 	vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
 	vkQueueWaitIdle(m_GraphicsQueue);
 
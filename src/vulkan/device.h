@@ -1,10 +1,15 @@
 #pragma once
 
+#include "allocator.h"
 #include "window.h"
 
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+class UploadQueue;
+
 struct SwapchainSupportDetails {
 	VkSurfaceCapabilitiesKHR capabilities;      // min/max number of images
 	std::vector<VkSurfaceFormatKHR> formats;    // pixel format, color space
@@ -14,8 +19,10 @@ struct SwapchainSupportDetails {
 struct QueueFamilyIndices {
 	uint32_t graphicsFamily;
 	uint32_t presentFamily;
+	uint32_t transferFamily;    // dedicated DMA family if there is one, graphics family otherwise
 	bool graphicsFamilyHasValue = false;
 	bool presentFamilyHasValue  = false;
+	bool transferFamilyHasValue = false;
 
 	bool IsComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
@@ -40,6 +47,9 @@ public:
 
 	inline VkSurfaceKHR GetSurface() { return m_Surface; }
 
+	// No surface and no present queue, nothing is shown on screen
+	inline bool IsHeadless() const { return m_Window.IsHeadless(); }
+
 	inline QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(m_PhysicalDevice); }
 
 	inline VkCommandPool GetCommandPool() { return m_CommandPool; }
@@ -48,12 +58,32 @@ public:
 
 	inline VkQueue GetPresentQueue() { return m_PresentQueue; }
 
+	inline VkQueue GetTransferQueue() { return m_TransferQueue; }
+
+	// Queues are externally synchronized, everything that submits to the graphics queue takes this lock
+	inline std::mutex& GetGraphicsQueueMutex() { return m_GraphicsQueueMutex; }
+
+	// Same for a dedicated transfer queue, with a single family the graphics lock covers it
+	inline std::mutex& GetTransferQueueMutex() { return m_TransferQueueMutex; }
+
 	inline VkPhysicalDeviceProperties GetDeviceProperties() { return m_Properties; }
 
+	// The optional features are only enabled when the physical device has them
+	inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_EnabledFeatures; }
+
+	// Whether one of the optional extensions was enabled, the required ones always are
+	bool IsExtensionEnabled(const char* name) const;
+
+	inline Allocator& GetAllocator() { return *m_Allocator; }
+
+	inline UploadQueue& GetUploadQueue() { return *m_UploadQueue; }
+
 	VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation);
 	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
+	void WaitIdle();
+
 	void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 	void BeginSingleTimeCommands(VkCommandBuffer& buffer);
 	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -77,6 +107,7 @@ private:
 	SwapchainSupportDetails QuerySwapchainSupport(VkPhysicalDevice device);
 
 	VkPhysicalDeviceProperties m_Properties;
+	VkPhysicalDeviceFeatures m_EnabledFeatures {};
 	VkInstance m_Instance;
 	VkDebugUtilsMessengerEXT m_DebugMessenger;
 	VkPhysicalDevice m_PhysicalDevice;
@@ -86,11 +117,20 @@ private:
 
 	VkQueue m_GraphicsQueue;
 	VkQueue m_PresentQueue;
+	VkQueue m_TransferQueue;
+	std::mutex m_GraphicsQueueMutex;
+	std::mutex m_TransferQueueMutex;
 
 	VkCommandPool m_CommandPool;
 
+	std::unique_ptr<Allocator> m_Allocator;
+	std::unique_ptr<UploadQueue> m_UploadQueue;
+
 	const std::vector<const char*> m_ValidationLayers = {"VK_LAYER_KHRONOS_validation"};
 	const std::vector<const char*> m_DeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+	// Enabled when the physical device has them
+	const std::vector<const char*> m_OptionalDeviceExtensions = {VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME};
+	std::vector<const char*> m_EnabledExtensions;
 
 #ifdef NDEBUG
 	const bool m_EnableValidationLayers = false;
@@ -0,0 +1,80 @@
+#include "dynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// The GPU time is aimed a bit below the budget, so a single slower frame doesn't miss it right away
+static constexpr float BUDGET_HEADROOM = 0.9f;
+// Dropping resolution has to be quick to save frames, raising it again can take its time
+static constexpr float DECREASE_RATE = 0.2f;
+static constexpr float INCREASE_RATE = 0.05f;
+// The render extent only changes in steps of this, so the scale settling doesn't shift the pixel grid every frame
+static constexpr float SCALE_STEP = 0.025f;
+
+DynamicResolution::DynamicResolution(Device& device): m_Device(device) {
+	VkPhysicalDeviceProperties properties = m_Device.GetDeviceProperties();
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+	uint32_t validBits = queueFamilies[m_Device.FindPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+
+	// Without timestamps there is nothing to base the scale on, everything renders at full resolution then
+	m_Supported = properties.limits.timestampComputeAndGraphics && validBits > 0;
+	if(!m_Supported) return;
+
+	m_TimestampPeriod = properties.limits.timestampPeriod;
+	m_TimestampMask   = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo queryPoolInfo {};
+	queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = Swapchain::MAX_FRAMES_IN_FLIGHT * 2;
+	if(vkCreateQueryPool(m_Device.GetDevice(), &queryPoolInfo, nullptr, &m_QueryPool) != VK_SUCCESS) { throw std::runtime_error("failed to create timestamp query pool!"); }
+}
+
+DynamicResolution::~DynamicResolution() {
+	if(m_QueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(m_Device.GetDevice(), m_QueryPool, nullptr);
+}
+
+VkExtent2D DynamicResolution::Update(uint32_t frameIndex, VkExtent2D fullExtent) {
+	if(m_Supported && m_QueriesWritten[frameIndex]) {
+		// The frame's fence was waited on, so the results are there. The availability is checked anyway instead of waiting.
+		std::array<uint64_t, 4> results {};
+		VkResult result = vkGetQueryPoolResults(m_Device.GetDevice(), m_QueryPool, frameIndex * 2, 2, sizeof(results), results.data(), sizeof(uint64_t) * 2,
+		                                        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if((result == VK_SUCCESS || result == VK_NOT_READY) && results[1] != 0 && results[3] != 0) {
+			uint64_t ticks = (results[2] - results[0]) & m_TimestampMask;
+			float time     = static_cast<float>(ticks) * m_TimestampPeriod * 1e-6f;
+			m_GpuTime      = m_GpuTime == 0.0f ? time : m_GpuTime + (time - m_GpuTime) * 0.1f;
+		}
+	}
+
+	if(m_Enabled && m_Supported && m_GpuTime > 0.0f) {
+		// The GPU time is mostly spent per pixel, which grows with the square of the scale
+		float target = std::clamp(m_Scale * std::sqrt(m_FrameBudget * BUDGET_HEADROOM / m_GpuTime), m_MinScale, 1.0f);
+		m_Scale += (target - m_Scale) * (target < m_Scale ? DECREASE_RATE : INCREASE_RATE);
+	} else if(!m_Enabled) {
+		m_Scale = 1.0f;
+	}
+
+	float scale = std::clamp(std::round(m_Scale / SCALE_STEP) * SCALE_STEP, m_MinScale, 1.0f);
+	return {std::max(static_cast<uint32_t>(fullExtent.width * scale), 1u), std::max(static_cast<uint32_t>(fullExtent.height * scale), 1u)};
+}
+
+void DynamicResolution::BeginTiming(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+	if(!m_Supported) return;
+
+	vkCmdResetQueryPool(commandBuffer, m_QueryPool, frameIndex * 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, frameIndex * 2);
+}
+
+void DynamicResolution::EndTiming(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+	if(!m_Supported) return;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, frameIndex * 2 + 1);
+	m_QueriesWritten[frameIndex] = true;
+}
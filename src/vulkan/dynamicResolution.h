@@ -0,0 +1,52 @@
+#pragma once
+
+#include "device.h"
+#include "swapchain.h"
+
+#include <array>
+
+/**
+ * @brief Picks the resolution the geometry is rendered at from the measured GPU time of the frame.
+ *
+ * The frame is timed with a pair of timestamp queries per frame in flight. Their results are read once the frame's fence
+ * was waited on, so the readback never stalls. The pixel count is assumed to scale the GPU time linearly, the scale
+ * moves towards the one that would have hit the frame budget and is damped so it doesn't oscillate. The render targets
+ * are never reallocated, the geometry is drawn into the top left of them and the tonemapping upscales it.
+ */
+class DynamicResolution {
+public:
+	DynamicResolution(Device& device);
+	~DynamicResolution();
+
+	DynamicResolution(const DynamicResolution&)            = delete;
+	DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+	// Reads the timings of the last frame that used these queries and returns the extent this frame renders at.
+	// Has to be called after the frame's fence was waited on.
+	VkExtent2D Update(uint32_t frameIndex, VkExtent2D fullExtent);
+
+	void BeginTiming(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	void EndTiming(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+	inline bool& GetEnabled() { return m_Enabled; }
+	inline float& GetFrameBudget() { return m_FrameBudget; }
+	inline float& GetMinScale() { return m_MinScale; }
+	inline float GetScale() const { return m_Scale; }
+	inline float GetGpuTime() const { return m_GpuTime; }
+	inline bool IsSupported() const { return m_Supported; }
+
+private:
+	Device& m_Device;
+
+	VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+	std::array<bool, Swapchain::MAX_FRAMES_IN_FLIGHT> m_QueriesWritten {};
+	bool m_Supported         = false;
+	float m_TimestampPeriod  = 1.0f;    // nanoseconds per tick
+	uint64_t m_TimestampMask = ~0ull;
+
+	bool m_Enabled      = true;
+	float m_FrameBudget = 16.6f;    // milliseconds of GPU time
+	float m_MinScale    = 0.5f;
+	float m_Scale       = 1.0f;
+	float m_GpuTime     = 0.0f;    // milliseconds, smoothed
+};
@@ -0,0 +1,216 @@
+#include "gpuProfiler.h"
+#include "../profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Order of the results follows the bit order of the flags
+static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                                                     VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+                                                                     VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+static constexpr uint32_t STATISTIC_COUNT = 3;
+
+// After the begin and end timestamps of every scope
+static constexpr uint32_t FRAME_END_QUERY = GpuProfiler::MAX_SCOPES * 2;
+
+GpuProfiler::GpuProfiler(Device& device): m_Device(device) {
+	VkPhysicalDeviceProperties properties = m_Device.GetDeviceProperties();
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_Device.GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+	uint32_t validBits = queueFamilies[m_Device.FindPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+
+	m_Supported = properties.limits.timestampComputeAndGraphics && validBits > 0;
+	if(!m_Supported) return;
+
+	m_TimestampPeriod     = properties.limits.timestampPeriod;
+	m_TimestampMask       = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	m_StatisticsSupported = m_Device.GetEnabledFeatures().pipelineStatisticsQuery;
+
+	// Only the device clock is sampled, it is compared against the CPU clock read right after
+	if(m_Device.IsExtensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+		auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT) vkGetInstanceProcAddr(m_Device.GetInstance(), "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+
+		uint32_t domainCount = 0;
+		if(getTimeDomains != nullptr) getTimeDomains(m_Device.GetPhysicalDevice(), &domainCount, nullptr);
+		std::vector<VkTimeDomainEXT> domains(domainCount);
+		if(domainCount > 0) getTimeDomains(m_Device.GetPhysicalDevice(), &domainCount, domains.data());
+
+		if(std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end()) {
+			m_GetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT) vkGetDeviceProcAddr(m_Device.GetDevice(), "vkGetCalibratedTimestampsEXT");
+		}
+	}
+
+	for(Frame& frame : m_Frames) {
+		VkQueryPoolCreateInfo queryPoolInfo {};
+		queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = FRAME_END_QUERY + 1;
+		if(vkCreateQueryPool(m_Device.GetDevice(), &queryPoolInfo, nullptr, &frame.timestamps) != VK_SUCCESS) { throw std::runtime_error("failed to create profiler query pool!"); }
+
+		if(!m_StatisticsSupported) continue;
+
+		queryPoolInfo.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolInfo.queryCount         = MAX_SCOPES;
+		queryPoolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+		if(vkCreateQueryPool(m_Device.GetDevice(), &queryPoolInfo, nullptr, &frame.statistics) != VK_SUCCESS) { throw std::runtime_error("failed to create profiler query pool!"); }
+	}
+}
+
+GpuProfiler::~GpuProfiler() {
+	for(Frame& frame : m_Frames) {
+		if(frame.timestamps != VK_NULL_HANDLE) vkDestroyQueryPool(m_Device.GetDevice(), frame.timestamps, nullptr);
+		if(frame.statistics != VK_NULL_HANDLE) vkDestroyQueryPool(m_Device.GetDevice(), frame.statistics, nullptr);
+	}
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t inputTime) {
+	m_CurrentFrame = &m_Frames[frameIndex];
+	if(!m_Supported) return;
+
+	if(m_CurrentFrame->scopeCount > 0) ReadResults(*m_CurrentFrame);
+	if(m_CurrentFrame->ended) ReadLatency(*m_CurrentFrame);
+	m_CurrentFrame->scopeCount = 0;
+	m_CurrentFrame->inputTime  = inputTime;
+	m_CurrentFrame->ended      = false;
+
+	vkCmdResetQueryPool(commandBuffer, m_CurrentFrame->timestamps, 0, FRAME_END_QUERY + 1);
+	if(m_StatisticsSupported) vkCmdResetQueryPool(commandBuffer, m_CurrentFrame->statistics, 0, MAX_SCOPES);
+}
+
+void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name) {
+	// Scopes past the limit aren't measured
+	if(!m_Supported || m_CurrentFrame->scopeCount == MAX_SCOPES) return;
+
+	uint32_t scope               = m_CurrentFrame->scopeCount;
+	m_CurrentFrame->names[scope] = name;
+	m_ScopeActive                = true;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_CurrentFrame->timestamps, scope * 2);
+	if(m_StatisticsSupported) vkCmdBeginQuery(commandBuffer, m_CurrentFrame->statistics, scope, 0);
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer) {
+	if(!m_ScopeActive) return;
+
+	uint32_t scope = m_CurrentFrame->scopeCount++;
+	m_ScopeActive  = false;
+
+	if(m_StatisticsSupported) vkCmdEndQuery(commandBuffer, m_CurrentFrame->statistics, scope);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_CurrentFrame->timestamps, scope * 2 + 1);
+}
+
+void GpuProfiler::EndFrame(VkCommandBuffer commandBuffer) {
+	if(!m_Supported) return;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_CurrentFrame->timestamps, FRAME_END_QUERY);
+	m_CurrentFrame->ended = true;
+}
+
+/**
+ * @brief The frame's fence was waited on, so the results are there. The availability is checked anyway instead of waiting.
+ */
+void GpuProfiler::ReadResults(Frame& frame) {
+	// Each query is followed by its availability
+	std::vector<uint64_t> timestamps(frame.scopeCount * 2 * 2);
+	VkResult result = vkGetQueryPoolResults(m_Device.GetDevice(), frame.timestamps, 0, frame.scopeCount * 2, timestamps.size() * sizeof(uint64_t), timestamps.data(),
+	                                        sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if(result != VK_SUCCESS && result != VK_NOT_READY) return;
+
+	std::vector<uint64_t> statistics(frame.scopeCount * (STATISTIC_COUNT + 1));
+	if(m_StatisticsSupported) {
+		result = vkGetQueryPoolResults(m_Device.GetDevice(), frame.statistics, 0, frame.scopeCount, statistics.size() * sizeof(uint64_t), statistics.data(),
+		                               sizeof(uint64_t) * (STATISTIC_COUNT + 1), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if(result != VK_SUCCESS && result != VK_NOT_READY) statistics.assign(statistics.size(), 0);
+	}
+
+	float frameTime = 0.0f;
+	for(uint32_t scope = 0; scope < frame.scopeCount; scope++) {
+		const uint64_t* begin = &timestamps[scope * 4];
+		const uint64_t* end   = &timestamps[scope * 4 + 2];
+		if(begin[1] == 0 || end[1] == 0) continue;
+
+		ScopeStats& stats = FindScope(frame.names[scope]);
+		stats.time        = static_cast<float>((end[0] - begin[0]) & m_TimestampMask) * m_TimestampPeriod * 1e-6f;
+		frameTime += stats.time;
+
+		const uint64_t* counts = &statistics[scope * (STATISTIC_COUNT + 1)];
+		if(counts[STATISTIC_COUNT] != 0) {
+			stats.vertexInvocations   = counts[0];
+			stats.fragmentInvocations = counts[1];
+			stats.computeInvocations  = counts[2];
+		}
+
+		stats.history[stats.historyOffset] = stats.time;
+		stats.historyOffset                = (stats.historyOffset + 1) % HISTORY_SIZE;
+
+		if(m_Capture.is_open()) {
+			m_Capture << m_CapturedFrames << ',' << stats.name << ',' << stats.time << ',' << stats.vertexInvocations << ',' << stats.fragmentInvocations << ','
+			          << stats.computeInvocations << '\n';
+		}
+	}
+	m_CapturedFrames++;
+
+	m_FrameTime = frameTime;
+	m_FrameCount++;
+}
+
+/**
+ * @brief The GPU timestamp is only comparable to the CPU clock through a calibrated timestamp. Without one the frame is
+ * known to be done by the time it is read back, which is at least a frame later than it really finished.
+ */
+void GpuProfiler::ReadLatency(Frame& frame) {
+	if(frame.inputTime == 0) return;
+
+	uint64_t end[2] = {};
+	VkResult result = vkGetQueryPoolResults(m_Device.GetDevice(), frame.timestamps, FRAME_END_QUERY, 1, sizeof(end), end, sizeof(end), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if((result != VK_SUCCESS && result != VK_NOT_READY) || end[1] == 0) return;
+
+	uint64_t finished = CpuProfiler::Now();
+	if(m_GetCalibratedTimestamps != nullptr) {
+		VkCalibratedTimestampInfoEXT info {};
+		info.sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		info.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+
+		uint64_t deviceNow = 0;
+		uint64_t deviation = 0;
+		if(m_GetCalibratedTimestamps(m_Device.GetDevice(), 1, &info, &deviceNow, &deviation) != VK_SUCCESS) return;
+		uint64_t now = CpuProfiler::Now();
+
+		uint64_t ago = static_cast<uint64_t>(static_cast<double>((deviceNow - end[0]) & m_TimestampMask) * m_TimestampPeriod);
+		finished     = now - std::min(ago, now);
+	}
+	if(finished <= frame.inputTime) return;
+
+	m_Latency                                = static_cast<float>(finished - frame.inputTime) * 1e-6f;
+	m_LatencyHistory[m_LatencyHistoryOffset] = m_Latency;
+	m_LatencyHistoryOffset                   = (m_LatencyHistoryOffset + 1) % HISTORY_SIZE;
+}
+
+GpuProfiler::ScopeStats& GpuProfiler::FindScope(const char* name) {
+	for(ScopeStats& stats : m_Scopes) {
+		if(std::strcmp(stats.name, name) == 0) return stats;
+	}
+
+	ScopeStats& stats = m_Scopes.emplace_back();
+	stats.name        = name;
+	return stats;
+}
+
+bool GpuProfiler::StartCapture(const std::string& filepath) {
+	StopCapture();
+
+	m_Capture.open(filepath, std::ios::out | std::ios::trunc);
+	if(!m_Capture.is_open()) return false;
+
+	m_Capture << "frame,pass,gpu_ms,vertex_invocations,fragment_invocations,compute_invocations\n";
+	m_CapturedFrames = 0;
+	return true;
+}
+
+void GpuProfiler::StopCapture() {
+	if(m_Capture.is_open()) m_Capture.close();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "device.h"
+#include "swapchain.h"
+
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Measures the GPU time and the shader invocations of the passes of a frame.
+ *
+ * Every frame in flight has its own timestamp and pipeline statistics query pools. They are read back when the frame
+ * starts again, after its fence was waited on, so the readback never stalls and the numbers are as many frames old as
+ * there are frames in flight. Scopes can't be nested, Vulkan only allows a single active pipeline statistics query per
+ * command buffer.
+ *
+ * The last timestamp of a frame also gives the input latency, from the moment the game thread sampled the input to the
+ * GPU finishing the frame. With VK_EXT_calibrated_timestamps the GPU time is moved onto the CPU clock, without it the
+ * latency is measured up to the readback and only an upper bound. Scanout isn't included either way.
+ */
+class GpuProfiler {
+public:
+	static constexpr uint32_t MAX_SCOPES   = 32;
+	static constexpr uint32_t HISTORY_SIZE = 240;    // frames kept for the graphs
+
+	struct ScopeStats {
+		const char* name             = nullptr;
+		float time                   = 0.0f;    // milliseconds
+		uint64_t vertexInvocations   = 0;
+		uint64_t fragmentInvocations = 0;
+		uint64_t computeInvocations  = 0;
+		std::array<float, HISTORY_SIZE> history {};
+		uint32_t historyOffset = 0;    // oldest value, where the next one is written
+	};
+
+	/**
+	 * @brief Begins a scope in its constructor and ends it in its destructor
+	 */
+	class Scope {
+	public:
+		Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name): m_Profiler(profiler), m_CommandBuffer(commandBuffer) { m_Profiler.BeginScope(m_CommandBuffer, name); }
+
+		~Scope() { m_Profiler.EndScope(m_CommandBuffer); }
+
+		Scope(const Scope&)            = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		GpuProfiler& m_Profiler;
+		VkCommandBuffer m_CommandBuffer;
+	};
+
+	GpuProfiler(Device& device);
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&)            = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// Reads the results of the last frame that used these queries and resets them. Has to be called after the frame's
+	// fence was waited on, outside of any render pass. `inputTime` is the CpuProfiler::Now() the frame's input was
+	// sampled at, 0 if it wasn't.
+	void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t inputTime);
+
+	// After the last command of the frame
+	void EndFrame(VkCommandBuffer commandBuffer);
+
+	// `name` has to outlive the profiler, scopes are told apart by it
+	void BeginScope(VkCommandBuffer commandBuffer, const char* name);
+	void EndScope(VkCommandBuffer commandBuffer);
+
+	// Appends a row per scope and frame to a CSV file until the capture is stopped
+	bool StartCapture(const std::string& filepath);
+	void StopCapture();
+
+	inline bool IsCapturing() const { return m_Capture.is_open(); }
+
+	// In the order the scopes were first recorded
+	inline const std::vector<ScopeStats>& GetScopes() const { return m_Scopes; }
+
+	inline bool IsSupported() const { return m_Supported; }
+
+	inline bool HasPipelineStatistics() const { return m_StatisticsSupported; }
+
+	// Sum of the scopes of the last frame that was read back, in milliseconds
+	inline float GetFrameTime() const { return m_FrameTime; }
+
+	// Frames read back so far, tells when GetFrameTime has a new value
+	inline uint64_t GetFrameCount() const { return m_FrameCount; }
+
+	// Milliseconds from sampling the input to the GPU finishing the frame
+	inline float GetInputLatency() const { return m_Latency; }
+
+	inline const std::array<float, HISTORY_SIZE>& GetInputLatencyHistory() const { return m_LatencyHistory; }
+
+	inline uint32_t GetInputLatencyHistoryOffset() const { return m_LatencyHistoryOffset; }
+
+	// False when the latency is only an upper bound
+	inline bool IsInputLatencyCalibrated() const { return m_GetCalibratedTimestamps != nullptr; }
+
+private:
+	struct Frame {
+		VkQueryPool timestamps = VK_NULL_HANDLE;
+		VkQueryPool statistics = VK_NULL_HANDLE;
+		std::array<const char*, MAX_SCOPES> names {};
+		uint32_t scopeCount = 0;
+		uint64_t inputTime  = 0;
+		bool ended          = false;
+	};
+
+	void ReadResults(Frame& frame);
+	void ReadLatency(Frame& frame);
+	ScopeStats& FindScope(const char* name);
+
+	Device& m_Device;
+
+	std::array<Frame, Swapchain::MAX_FRAMES_IN_FLIGHT> m_Frames;
+	Frame* m_CurrentFrame = nullptr;
+	bool m_ScopeActive    = false;
+
+	bool m_Supported           = false;
+	bool m_StatisticsSupported = false;
+	float m_TimestampPeriod    = 1.0f;    // nanoseconds per tick
+	uint64_t m_TimestampMask   = ~0ull;
+
+	std::vector<ScopeStats> m_Scopes;
+	float m_FrameTime     = 0.0f;
+	uint64_t m_FrameCount = 0;
+
+	PFN_vkGetCalibratedTimestampsEXT m_GetCalibratedTimestamps = nullptr;
+	float m_Latency                                            = 0.0f;
+	std::array<float, HISTORY_SIZE> m_LatencyHistory {};
+	uint32_t m_LatencyHistoryOffset = 0;
+
+	std::ofstream m_Capture;
+	uint64_t m_CapturedFrames = 0;
+};
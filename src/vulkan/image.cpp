@@ -1,35 +1,26 @@
 #include "image.h"
 
+#include "../textures/ktxFile.h"
+#include "uploadQueue.h"
+
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stbimage/stb_image.h>
 
-Image::Image(Device& device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlagBits aspect)
+Image::Image(Device& device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlagBits aspect,
+             uint32_t mipLevels)
 	: m_Device(device) 
 {
 	m_Size.width = width;
 	m_Size.height = height;
+	m_MipLevels = mipLevels;
 	CreateImage(width, height, format, tiling, usage);
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(m_Device.GetDevice(), m_Image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo {};
-	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize  = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_Device.FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-	if(vkAllocateMemory(m_Device.GetDevice(), &allocInfo, nullptr, &m_ImageMemory) != VK_SUCCESS) 
-	{ 
-		throw std::runtime_error("failed to allocate image memory!"); 
-	}
-
-	if(vkBindImageMemory(m_Device.GetDevice(), m_Image, m_ImageMemory, 0) != VK_SUCCESS) 
-	{ 
-		throw std::runtime_error("failed to bind image memory!"); 
-	}
+	m_Allocation = m_Device.GetAllocator().AllocateImage(m_Image, properties);
 
 	CreateImageView(format, aspect);
 }
@@ -42,7 +33,7 @@ void Image::CreateImageView(VkFormat format, VkImageAspectFlagBits aspect) {
 	viewInfo.format                          = format;
 	viewInfo.subresourceRange.aspectMask     = aspect;
 	viewInfo.subresourceRange.baseMipLevel   = 0;
-	viewInfo.subresourceRange.levelCount     = 1;
+	viewInfo.subresourceRange.levelCount     = m_MipLevels;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
 	viewInfo.subresourceRange.layerCount     = 1;
 	if(vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &m_ImageView) != VK_SUCCESS) { throw std::runtime_error("failed to create texture image view!"); }
@@ -55,7 +46,7 @@ void Image::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImag
 	imageInfo.extent.width  = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth  = 1;
-	imageInfo.mipLevels     = 1;
+	imageInfo.mipLevels     = m_MipLevels;
 	imageInfo.arrayLayers   = 1;
 	imageInfo.format        = format;
 	imageInfo.tiling        = tiling;
@@ -67,46 +58,105 @@ void Image::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImag
 	if(vkCreateImage(m_Device.GetDevice(), &imageInfo, nullptr, &m_Image) != VK_SUCCESS) { throw std::runtime_error("failed to create image!"); }
 }
 
-Image::Image(Device& device, const std::string& filepath): m_Device(device) {
+Image::Image(Device& device, const std::string& filepath, bool srgb): m_Device(device) {
+	MappedFile file;
+	if(!file.Open(filepath)) { throw std::runtime_error(std::string("failed to load texture image! " + filepath)); }
+
 	int texChannels;
-	stbi_uc* pixels        = stbi_load(filepath.c_str(), &m_Size.width, &m_Size.height, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = m_Size.width * m_Size.height * 4;
+	stbi_uc* pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &m_Size.width, &m_Size.height, &texChannels, STBI_rgb_alpha);
 
 	if(!pixels) { throw std::runtime_error(std::string("failed to load texture image! " + filepath)); }
 
-	auto buffer = std::make_unique<Buffer>(m_Device, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	buffer->Map(imageSize);
-	buffer->WriteToBuffer((void*) pixels, static_cast<size_t>(imageSize));
-	buffer->Unmap();
+	CreateFromPixels(pixels, srgb);
 
 	stbi_image_free(pixels);
+}
+
+/**
+ * @brief Creates a sampled R8G8B8A8 texture from already decoded pixels (4 bytes per pixel)
+ */
+Image::Image(Device& device, const void* pixels, uint32_t width, uint32_t height, bool srgb): m_Device(device) {
+	m_Size.width  = width;
+	m_Size.height = height;
+	CreateFromPixels(pixels, srgb);
+}
 
-	CreateImage(m_Size.width, m_Size.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+/**
+ * @brief Creates a sampled texture from a baked KTX2 file, all mip levels are uploaded in one copy straight from the mapping
+ */
+Image::Image(Device& device, const KtxFile& file): m_Device(device) {
+	m_Size.width  = file.GetWidth();
+	m_Size.height = file.GetHeight();
+	m_MipLevels   = file.GetLevelCount();
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(m_Device.GetDevice(), m_Image, &memRequirements);
+	CreateImage(m_Size.width, m_Size.height, file.GetFormat(), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
-	VkMemoryAllocateInfo allocInfo {};
-	allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize  = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_Device.FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	m_Allocation = m_Device.GetAllocator().AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// The levels are stored back to back (smallest first), so one staging copy covers all of them
+	const uint8_t* begin = file.GetLevel(0).data;
+	const uint8_t* end   = file.GetLevel(0).data + file.GetLevel(0).size;
+	for(uint32_t level = 1; level < m_MipLevels; level++) {
+		begin = std::min(begin, file.GetLevel(level).data);
+		end   = std::max(end, file.GetLevel(level).data + file.GetLevel(level).size);
+	}
+
+	std::vector<VkBufferImageCopy> regions(m_MipLevels);
+	for(uint32_t level = 0; level < m_MipLevels; level++) {
+		regions[level].bufferOffset                    = file.GetLevel(level).data - begin;
+		regions[level].imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[level].imageSubresource.mipLevel       = level;
+		regions[level].imageSubresource.baseArrayLayer = 0;
+		regions[level].imageSubresource.layerCount     = 1;
+		regions[level].imageExtent                     = {std::max(file.GetWidth() >> level, 1u), std::max(file.GetHeight() >> level, 1u), 1};
+	}
 
-	if(vkAllocateMemory(m_Device.GetDevice(), &allocInfo, nullptr, &m_ImageMemory) != VK_SUCCESS) { throw std::runtime_error("failed to allocate image memory!"); }
+	VkImageSubresourceRange subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_MipLevels, 0, 1};
+	m_Device.GetUploadQueue().UploadImage(m_Image, begin, end - begin, regions, subresourceRange);
 
-	if(vkBindImageMemory(m_Device.GetDevice(), m_Image, m_ImageMemory, 0) != VK_SUCCESS) { throw std::runtime_error("failed to bind image memory!"); }
+	CreateImageView(file.GetFormat(), VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+/**
+ * @brief Whether textures of `format` can be sampled with linear filtering, block compressed formats are optional
+ */
+bool Image::IsFormatSupported(Device& device, VkFormat format) {
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(device.GetPhysicalDevice(), format, &properties);
+
+	VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	return (properties.optimalTilingFeatures & required) == required;
+}
+
+void Image::CreateFromPixels(const void* pixels, bool srgb) {
+	VkDeviceSize imageSize = m_Size.width * m_Size.height * 4;
+	VkFormat format        = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+	// Full chain down to 1x1, blitted from level 0 on the GPU (linear blits are mandatory for both formats)
+	m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_Size.width, m_Size.height)))) + 1;
+
+	CreateImage(m_Size.width, m_Size.height, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	m_Allocation = m_Device.GetAllocator().AllocateImage(m_Image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// The pixels are copied into the staging ring right away, the layout transitions, the copy and the mip blits run with the next upload batch
+	VkBufferImageCopy region {};
+	region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel       = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount     = 1;
+	region.imageExtent                     = {static_cast<uint32_t>(m_Size.width), static_cast<uint32_t>(m_Size.height), 1};
 
-	Image::TransitionImageLayout(m_Device, m_Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	CopyBufferToImage(buffer->GetBuffer(), static_cast<uint32_t>(m_Size.width), static_cast<uint32_t>(m_Size.height));
-	Image::TransitionImageLayout(m_Device, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkImageSubresourceRange subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_MipLevels, 0, 1};
+	m_Device.GetUploadQueue().UploadImage(m_Image, pixels, imageSize, {region}, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_MipLevels > 1);
 
-	CreateImageView(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+	CreateImageView(format, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
 Image::~Image() {
-	vkDeviceWaitIdle(m_Device.GetDevice());
 	vkDestroyImage(m_Device.GetDevice(), m_Image, nullptr);
 	vkDestroyImageView(m_Device.GetDevice(), m_ImageView, nullptr);
-	vkFreeMemory(m_Device.GetDevice(), m_ImageMemory, nullptr);
+	m_Device.GetAllocator().Free(m_Allocation);
 }
 
 void Image::TransitionImageLayout(Device& device, const VkImage& image, const VkImageLayout& oldLayout, const VkImageLayout& newLayout, const VkImageSubresourceRange& subresourceRange) {
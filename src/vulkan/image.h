@@ -6,6 +6,8 @@
 #include <memory>
 #include <vulkan/vulkan_core.h>
 
+class KtxFile;
+
 struct Size {
 	int width;
 	int height;
@@ -13,29 +15,39 @@ struct Size {
 
 class Image {
 public:
-	Image(Device& device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlagBits aspect);
-	Image(Device& device, const std::string& filepath);
+	Image(Device& device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlagBits aspect,
+	      uint32_t mipLevels = 1);
+	Image(Device& device, const std::string& filepath, bool srgb = false);
+	Image(Device& device, const void* pixels, uint32_t width, uint32_t height, bool srgb = false);
+	Image(Device& device, const KtxFile& file);
+	// Like Buffer it does not wait for the GPU, the owner destroys it once no frame in flight uses it
 	~Image();
 	static void TransitionImageLayout(Device& device, const VkImage& image, const VkImageLayout& oldLayout, const VkImageLayout& newLayout, const VkImageSubresourceRange& subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
 	void CopyBufferToImage(VkBuffer buffer, uint32_t width, uint32_t height);
 
+	static bool IsFormatSupported(Device& device, VkFormat format);
+
 	inline VkImage GetImage() { return m_Image; }
 
 	inline VkImageView GetImageView() { return m_ImageView; }
 
-	inline VkDeviceMemory GetImageMemory() { return m_ImageMemory; }
+	inline const Allocation& GetAllocation() { return m_Allocation; }
+
+	inline uint32_t GetMipLevels() const { return m_MipLevels; }
 
 private:
+	void CreateFromPixels(const void* pixels, bool srgb);
 	void CreateImageView(VkFormat format, VkImageAspectFlagBits aspect);
 	void CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
 	Device& m_Device;
 
 	VkImage m_Image;
 	VkImageView m_ImageView;
-	VkDeviceMemory m_ImageMemory;
+	Allocation m_Allocation;
 
 	VkBuffer m_Buffer;
 	VkDeviceMemory m_BufferMemory;
 
 	Size m_Size;
+	uint32_t m_MipLevels = 1;
 };
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "imageBasedLighting.h"
+
+#include "../profiler.h"
+#include "../textures/iblFile.h"
+#include "../textures/ktxFile.h"
+#include "uploadQueue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+static constexpr uint32_t GROUP_SIZE        = 8;
+static constexpr uint32_t ENVIRONMENT_SIZE  = 512;     // the skybox is box filtered down to this before integrating
+static constexpr uint32_t IRRADIANCE_SIZE   = 32;      // texels per face the spherical harmonics are projected from
+static constexpr uint32_t PREFILTER_SAMPLES = 512;
+static constexpr uint32_t BRDF_SAMPLES      = 1024;
+static constexpr VkDeviceSize TEXEL_SIZE    = 8;       // bytes per texel of FORMAT, VK_FORMAT_R16G16B16A16_SFLOAT
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+ImageBasedLighting::ImageBasedLighting(Device& device): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device)
+	             .SetMaxSets(1)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)
+	             .Build();
+
+	// Environment copy, one set per prefiltered level and one for the irradiance and the BRDF
+	uint32_t computeSets = PREFILTERED_LEVELS + 2;
+	m_ComputePool        = DescriptorPool::Builder(m_Device)
+	                    .SetMaxSets(computeSets)
+	                    .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, computeSets)
+	                    .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, computeSets)
+	                    .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, computeSets)
+	                    .Build();
+
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_LINEAR;
+	samplerInfo.minFilter    = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+	if(vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS) { throw std::runtime_error("failed to create image based lighting sampler!"); }
+
+	CreateResources();
+	CreatePipelines();
+	Clear();
+}
+
+ImageBasedLighting::~ImageBasedLighting() {
+	vkDestroyImageView(m_Device.GetDevice(), m_PrefilteredView, nullptr);
+	vkDestroyImage(m_Device.GetDevice(), m_Prefiltered, nullptr);
+	m_Device.GetAllocator().Free(m_PrefilteredAllocation);
+	vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_ComputePipelineLayout, nullptr);
+}
+
+void ImageBasedLighting::CreateResources() {
+	VkBufferUsageFlags transfer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	m_Irradiance = std::make_unique<Buffer>(m_Device, sizeof(float) * 4, IRRADIANCE_COEFFICIENTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | transfer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	m_Prefiltered     = CreateCube(PREFILTERED_SIZE, PREFILTERED_LEVELS, m_PrefilteredAllocation);
+	m_PrefilteredView = CreateView(m_Prefiltered, VK_IMAGE_VIEW_TYPE_CUBE, 0, PREFILTERED_LEVELS, 6);
+
+	// RGBA instead of RG, storage support for two channel formats is optional
+	m_BrdfLut = std::make_unique<Image>(m_Device, BRDF_LUT_SIZE, BRDF_LUT_SIZE, FORMAT, VK_IMAGE_TILING_OPTIMAL,
+	                                    VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	layoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	m_SetLayout = layoutBuilder.Build();
+
+	VkDescriptorBufferInfo irradianceInfo = m_Irradiance->DescriptorInfo();
+	VkDescriptorImageInfo prefilteredInfo {m_Sampler, m_PrefilteredView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	VkDescriptorImageInfo brdfLutInfo {m_Sampler, m_BrdfLut->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+	DescriptorWriter writer(*m_SetLayout, *m_Pool);
+	writer.WriteBuffer(0, &irradianceInfo);
+	writer.WriteImage(1, &prefilteredInfo);
+	writer.WriteImage(2, &brdfLutInfo);
+	if(!writer.Build(m_Set)) { throw std::runtime_error("failed to allocate image based lighting descriptor set!"); }
+}
+
+void ImageBasedLighting::CreatePipelines() {
+	auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+	layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+	layoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	m_ComputeSetLayout = layoutBuilder.Build();
+
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset     = 0;
+	pushConstantRange.size       = sizeof(PushConstants);
+
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_ComputeSetLayout->GetDescriptorSetLayout()};
+	Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_ComputePipelineLayout, &pushConstantRange);
+
+	m_EnvironmentPipeline = std::make_unique<Pipeline>(m_Device);
+	m_EnvironmentPipeline->CreateComputePipeline(SHADER_DIRECTORY "iblEnvironment.comp.spv", m_ComputePipelineLayout);
+
+	m_IrradiancePipeline = std::make_unique<Pipeline>(m_Device);
+	m_IrradiancePipeline->CreateComputePipeline(SHADER_DIRECTORY "iblIrradiance.comp.spv", m_ComputePipelineLayout);
+
+	m_PrefilterPipeline = std::make_unique<Pipeline>(m_Device);
+	m_PrefilterPipeline->CreateComputePipeline(SHADER_DIRECTORY "iblPrefilter.comp.spv", m_ComputePipelineLayout);
+
+	m_BrdfPipeline = std::make_unique<Pipeline>(m_Device);
+	m_BrdfPipeline->CreateComputePipeline(SHADER_DIRECTORY "iblBrdf.comp.spv", m_ComputePipelineLayout);
+}
+
+VkImage ImageBasedLighting::CreateCube(uint32_t size, uint32_t levels, Allocation& allocation) {
+	VkImageCreateInfo imageInfo {};
+	imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.flags         = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+	imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+	imageInfo.format        = FORMAT;
+	imageInfo.extent        = {size, size, 1};
+	imageInfo.mipLevels     = levels;
+	imageInfo.arrayLayers   = 6;
+	imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage         = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkImage image;
+	if(vkCreateImage(m_Device.GetDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) { throw std::runtime_error("failed to create image based lighting cubemap!"); }
+	allocation = m_Device.GetAllocator().AllocateImage(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	return image;
+}
+
+VkImageView ImageBasedLighting::CreateView(VkImage image, VkImageViewType type, uint32_t baseLevel, uint32_t levelCount, uint32_t layerCount, VkFormat format) {
+	VkImageViewCreateInfo viewInfo {};
+	viewInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image            = image;
+	viewInfo.viewType         = type;
+	viewInfo.format           = format;
+	viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, layerCount};
+
+	VkImageView view;
+	if(vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &view) != VK_SUCCESS) { throw std::runtime_error("failed to create image based lighting view!"); }
+	return view;
+}
+
+/**
+ * @brief Black maps and zero coefficients, so the descriptor set can be bound before the skybox arrived
+ */
+void ImageBasedLighting::Clear() {
+	VkCommandBuffer commandBuffer;
+	m_Device.BeginSingleTimeCommands(commandBuffer);
+
+	std::array<VkImageMemoryBarrier, 2> barriers {};
+	for(VkImageMemoryBarrier& barrier : barriers) {
+		barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	}
+	barriers[0].image            = m_Prefiltered;
+	barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, PREFILTERED_LEVELS, 0, 6};
+	barriers[1].image            = m_BrdfLut->GetImage();
+	barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers.data());
+
+	VkClearColorValue black {};
+	for(const VkImageMemoryBarrier& barrier : barriers) vkCmdClearColorImage(commandBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &barrier.subresourceRange);
+	vkCmdFillBuffer(commandBuffer, m_Irradiance->GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+	for(VkImageMemoryBarrier& barrier : barriers) {
+		barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	}
+	VkMemoryBarrier memoryBarrier {};
+	memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 2, barriers.data());
+
+	m_Device.EndSingleTimeCommands(commandBuffer);
+}
+
+/**
+ * @brief Irradiance, then every prefiltered level with its faces next to each other, then the BRDF lookup table
+ */
+ImageBasedLighting::Layout ImageBasedLighting::GetLayout() {
+	Layout layout {};
+	layout.irradianceOffset  = 0;
+	layout.prefilteredOffset = AlignUp(IRRADIANCE_COEFFICIENTS * sizeof(float) * 4, IblFile::ALIGNMENT);
+
+	for(uint32_t level = 0; level < PREFILTERED_LEVELS; level++) {
+		uint32_t size = PREFILTERED_SIZE >> level;
+
+		VkBufferImageCopy region {};
+		region.bufferOffset     = layout.prefilteredBytes;
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 6};
+		region.imageExtent      = {size, size, 1};
+		layout.prefilteredRegions.push_back(region);
+
+		layout.prefilteredBytes += VkDeviceSize(size) * size * 6 * TEXEL_SIZE;
+	}
+
+	layout.brdfLutOffset = AlignUp(layout.prefilteredOffset + layout.prefilteredBytes, IblFile::ALIGNMENT);
+	layout.brdfLutBytes  = VkDeviceSize(BRDF_LUT_SIZE) * BRDF_LUT_SIZE * TEXEL_SIZE;
+	layout.size          = layout.brdfLutOffset + layout.brdfLutBytes;
+	return layout;
+}
+
+void ImageBasedLighting::Build(Cubemap& skybox, const std::array<std::string, 6>& skyboxFilepaths) {
+	PROFILE_ZONE("Image based lighting");
+
+	Layout layout = GetLayout();
+
+	IblFileHeader header {};
+	header.sourceHash        = KtxFile::HashSources({skyboxFilepaths.begin(), skyboxFilepaths.end()});
+	header.format            = FORMAT;
+	header.prefilteredSize   = PREFILTERED_SIZE;
+	header.prefilteredLevels = PREFILTERED_LEVELS;
+	header.brdfLutSize       = BRDF_LUT_SIZE;
+	header.dataSize          = layout.size;
+
+	std::string cachePath = IblFile::GetCachePath(std::filesystem::path(skyboxFilepaths[0]).parent_path().string());
+
+	IblFile file;
+	if(header.sourceHash != 0 && file.Open(cachePath, header)) {
+		Upload(file.GetData(), layout);
+		m_Ready = true;
+		return;
+	}
+
+	Buffer readback(m_Device, layout.size, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	readback.Map();
+	Compute(skybox, readback, layout);
+
+	if(header.sourceHash != 0 && !IblFile::Write(cachePath, header, readback.GetMappedMemory())) { std::cerr << "failed to write image based lighting cache " << cachePath << std::endl; }
+	m_Ready = true;
+}
+
+void ImageBasedLighting::Upload(const uint8_t* data, const Layout& layout) {
+	UploadQueue& uploadQueue = m_Device.GetUploadQueue();
+	uploadQueue.UploadBuffer(m_Irradiance->GetBuffer(), data + layout.irradianceOffset, IRRADIANCE_COEFFICIENTS * sizeof(float) * 4);
+	uploadQueue.UploadImage(m_Prefiltered, data + layout.prefilteredOffset, layout.prefilteredBytes, layout.prefilteredRegions, {VK_IMAGE_ASPECT_COLOR_BIT, 0, PREFILTERED_LEVELS, 0, 6});
+
+	VkBufferImageCopy region {};
+	region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.imageExtent      = {BRDF_LUT_SIZE, BRDF_LUT_SIZE, 1};
+	uploadQueue.UploadImage(m_BrdfLut->GetImage(), data + layout.brdfLutOffset, layout.brdfLutBytes, {region}, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
+
+	uploadQueue.Wait(uploadQueue.Submit());
+}
+
+/**
+ * @brief Runs every pass in one submission and reads the results back into `readback` for the cache
+ */
+void ImageBasedLighting::Compute(Cubemap& skybox, Buffer& readback, const Layout& layout) {
+	// The skybox is box filtered into a linear HDR environment with a full mip chain, the passes below sample lower
+	// levels where their samples cover more texels so the stars don't alias
+	uint32_t sourceSize       = static_cast<uint32_t>(skybox.GetWidth());
+	uint32_t scale            = std::max(sourceSize / ENVIRONMENT_SIZE, 1u);
+	uint32_t environmentSize  = sourceSize / scale;
+	uint32_t environmentLevel = static_cast<uint32_t>(std::floor(std::log2(environmentSize))) + 1;
+
+	Allocation environmentAllocation;
+	VkImage environment         = CreateCube(environmentSize, environmentLevel, environmentAllocation);
+	VkImageView environmentView = CreateView(environment, VK_IMAGE_VIEW_TYPE_CUBE, 0, environmentLevel, 6);
+	VkImageView environmentBase = CreateView(environment, VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 1, 6);
+	VkImageView sourceView      = CreateView(skybox.GetCubeMapImage(), VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 1, 6, VK_FORMAT_R8G8B8A8_UNORM);
+
+	std::vector<VkImageView> levelViews;
+	for(uint32_t level = 0; level < PREFILTERED_LEVELS; level++) levelViews.push_back(CreateView(m_Prefiltered, VK_IMAGE_VIEW_TYPE_2D_ARRAY, level, 1, 6));
+
+	VkDescriptorBufferInfo irradianceInfo = m_Irradiance->DescriptorInfo();
+	auto writeSet                         = [&](VkImageView source, VkImageView destination) {
+		VkDescriptorImageInfo sourceInfo {m_Sampler, source, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+		VkDescriptorImageInfo destinationInfo {VK_NULL_HANDLE, destination, VK_IMAGE_LAYOUT_GENERAL};
+
+		VkDescriptorSet set;
+		DescriptorWriter writer(*m_ComputeSetLayout, *m_ComputePool);
+		writer.WriteImage(0, &sourceInfo);
+		writer.WriteImage(1, &destinationInfo);
+		writer.WriteBuffer(2, &irradianceInfo);
+		if(!writer.Build(set)) { throw std::runtime_error("failed to allocate image based lighting descriptor set!"); }
+		return set;
+	};
+
+	m_ComputePool->ResetPool();
+	VkDescriptorSet environmentSet = writeSet(sourceView, environmentBase);
+	VkDescriptorSet brdfSet        = writeSet(environmentView, m_BrdfLut->GetImageView());    // also the irradiance, which only reads the environment
+	std::vector<VkDescriptorSet> prefilterSets;
+	for(VkImageView view : levelViews) prefilterSets.push_back(writeSet(environmentView, view));
+
+	auto imageBarrier = [](VkImage image, uint32_t baseLevel, uint32_t levelCount, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess,
+	                       VkAccessFlags dstAccess) {
+		VkImageMemoryBarrier barrier {};
+		barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout           = oldLayout;
+		barrier.newLayout           = newLayout;
+		barrier.srcAccessMask       = srcAccess;
+		barrier.dstAccessMask       = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image               = image;
+		barrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, layerCount};
+		return barrier;
+	};
+
+	VkCommandBuffer commandBuffer;
+	m_Device.BeginSingleTimeCommands(commandBuffer);
+
+	auto record = [&](Pipeline& pipeline, VkDescriptorSet set, const PushConstants& push, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+		pipeline.Bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_ComputePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+		vkCmdDispatch(commandBuffer, groupsX, groupsY, groupsZ);
+	};
+	auto groups = [](uint32_t size) { return (size + GROUP_SIZE - 1) / GROUP_SIZE; };
+
+	//
+	// Environment
+	//
+	{
+		VkImageMemoryBarrier barrier = imageBarrier(environment, 0, environmentLevel, 6, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		PushConstants push {};
+		push.size  = environmentSize;
+		push.count = scale;
+		record(*m_EnvironmentPipeline, environmentSet, push, groups(environmentSize), groups(environmentSize), 6);
+
+		// Mip chain, every level is blitted from the one above it
+		std::array<VkImageMemoryBarrier, 2> barriers {};
+		barriers[0] = imageBarrier(environment, 0, 1, 6, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		barriers[1] = imageBarrier(environment, 1, environmentLevel - 1, 6, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, environmentLevel > 1 ? 2 : 1, barriers.data());
+
+		for(uint32_t level = 1; level < environmentLevel; level++) {
+			int32_t sourceExtent      = static_cast<int32_t>(std::max(environmentSize >> (level - 1), 1u));
+			int32_t destinationExtent = static_cast<int32_t>(std::max(environmentSize >> level, 1u));
+
+			VkImageBlit blit {};
+			blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 6};
+			blit.srcOffsets[1]  = {sourceExtent, sourceExtent, 1};
+			blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 6};
+			blit.dstOffsets[1]  = {destinationExtent, destinationExtent, 1};
+			vkCmdBlitImage(commandBuffer, environment, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, environment, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+			barrier = imageBarrier(environment, level, 1, 6, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		barriers[0] = imageBarrier(environment, 0, environmentLevel, 6, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT,
+		                           VK_ACCESS_SHADER_READ_BIT);
+		barriers[1] = imageBarrier(m_Prefiltered, 0, PREFILTERED_LEVELS, 6, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+		VkImageMemoryBarrier lutBarrier = imageBarrier(m_BrdfLut->GetImage(), 0, 1, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+		std::array<VkImageMemoryBarrier, 3> computeBarriers {barriers[0], barriers[1], lutBarrier};
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 3, computeBarriers.data());
+	}
+
+	//
+	// Irradiance, prefiltered levels and BRDF lookup table, independent of each other
+	//
+	{
+		PushConstants push {};
+		push.size = IRRADIANCE_SIZE;
+		record(*m_IrradiancePipeline, brdfSet, push, 1, 1, 1);
+
+		for(uint32_t level = 0; level < PREFILTERED_LEVELS; level++) {
+			uint32_t size  = PREFILTERED_SIZE >> level;
+			push.roughness = static_cast<float>(level) / (PREFILTERED_LEVELS - 1);
+			push.size      = size;
+			push.count     = PREFILTER_SAMPLES;
+			record(*m_PrefilterPipeline, prefilterSets[level], push, groups(size), groups(size), 6);
+		}
+
+		push.size  = BRDF_LUT_SIZE;
+		push.count = BRDF_SAMPLES;
+		record(*m_BrdfPipeline, brdfSet, push, groups(BRDF_LUT_SIZE), groups(BRDF_LUT_SIZE), 1);
+	}
+
+	//
+	// Readback for the cache
+	//
+	{
+		std::array<VkImageMemoryBarrier, 2> barriers {};
+		barriers[0] = imageBarrier(m_Prefiltered, 0, PREFILTERED_LEVELS, 6, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		barriers[1] = imageBarrier(m_BrdfLut->GetImage(), 0, 1, 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+		VkMemoryBarrier memoryBarrier {};
+		memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 2, barriers.data());
+
+		VkBufferCopy irradianceCopy {0, layout.irradianceOffset, IRRADIANCE_COEFFICIENTS * sizeof(float) * 4};
+		vkCmdCopyBuffer(commandBuffer, m_Irradiance->GetBuffer(), readback.GetBuffer(), 1, &irradianceCopy);
+
+		std::vector<VkBufferImageCopy> regions = layout.prefilteredRegions;
+		for(VkBufferImageCopy& region : regions) region.bufferOffset += layout.prefilteredOffset;
+		vkCmdCopyImageToBuffer(commandBuffer, m_Prefiltered, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetBuffer(), static_cast<uint32_t>(regions.size()), regions.data());
+
+		VkBufferImageCopy lutRegion {};
+		lutRegion.bufferOffset     = layout.brdfLutOffset;
+		lutRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+		lutRegion.imageExtent      = {BRDF_LUT_SIZE, BRDF_LUT_SIZE, 1};
+		vkCmdCopyImageToBuffer(commandBuffer, m_BrdfLut->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetBuffer(), 1, &lutRegion);
+
+		for(VkImageMemoryBarrier& barrier : barriers) {
+			barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		}
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+		                     &memoryBarrier, 0, nullptr, 2, barriers.data());
+	}
+
+	// Waits for the queue to be idle
+	m_Device.EndSingleTimeCommands(commandBuffer);
+
+	for(VkImageView view : levelViews) vkDestroyImageView(m_Device.GetDevice(), view, nullptr);
+	vkDestroyImageView(m_Device.GetDevice(), sourceView, nullptr);
+	vkDestroyImageView(m_Device.GetDevice(), environmentBase, nullptr);
+	vkDestroyImageView(m_Device.GetDevice(), environmentView, nullptr);
+	vkDestroyImage(m_Device.GetDevice(), environment, nullptr);
+	m_Device.GetAllocator().Free(environmentAllocation);
+	m_ComputePool->ResetPool();
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "buffer.h"
+#include "cubemap.h"
+#include "descriptors.h"
+#include "device.h"
+#include "image.h"
+#include "pipeline.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Ambient lighting from the skybox, split into a diffuse and a specular part.
+ *
+ * The diffuse irradiance is projected onto 9 spherical harmonics coefficients, already convolved with the cosine lobe.
+ * The specular part is a cubemap whose mips are prefiltered with the GGX distribution for increasing roughness, combined
+ * with a lookup table of the BRDF's scale and bias to F0 (split sum approximation). All of it is computed once on the
+ * GPU when the skybox arrived and cached in assets/cache keyed by the hash of the skybox faces, so later runs only
+ * upload the cached results and never run the convolution.
+ *
+ * Until then the descriptor set points at black maps and zero coefficients, there is no ambient light.
+ */
+class ImageBasedLighting {
+public:
+	static constexpr uint32_t IRRADIANCE_COEFFICIENTS = 9;
+	static constexpr uint32_t PREFILTERED_SIZE        = 128;
+	static constexpr uint32_t PREFILTERED_LEVELS      = 6;    // roughness 0 to 1, the last level is 4x4
+	static constexpr uint32_t BRDF_LUT_SIZE           = 256;
+	static constexpr VkFormat FORMAT                  = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	ImageBasedLighting(Device& device);
+	~ImageBasedLighting();
+
+	ImageBasedLighting(const ImageBasedLighting&)            = delete;
+	ImageBasedLighting& operator=(const ImageBasedLighting&) = delete;
+
+	// Loads the maps of `skybox` from the cache or computes and caches them. It overwrites the maps the frames in flight
+	// sample, so it has to be called between frames on the thread that submits them, after their fences were waited on.
+	void Build(Cubemap& skybox, const std::array<std::string, 6>& skyboxFilepaths);
+
+	inline bool IsReady() const { return m_Ready; }
+
+	// Irradiance coefficients, the prefiltered cubemap and the BRDF lookup table for the fragment shader
+	inline std::shared_ptr<DescriptorSetLayout> GetDescriptorSetLayout() const { return m_SetLayout; }
+
+	inline VkDescriptorSet GetDescriptorSet() const { return m_Set; }
+
+private:
+	// Matches the layout of the cache file, the readback buffer is written straight into it
+	struct Layout {
+		VkDeviceSize irradianceOffset;
+		VkDeviceSize prefilteredOffset;
+		VkDeviceSize prefilteredBytes;
+		VkDeviceSize brdfLutOffset;
+		VkDeviceSize brdfLutBytes;
+		VkDeviceSize size;
+		std::vector<VkBufferImageCopy> prefilteredRegions;    // offsets relative to the prefiltered part
+	};
+
+	struct PushConstants {
+		float roughness;
+		uint32_t size;     // of the destination
+		uint32_t count;    // samples, or source texels per environment texel for the copy
+		uint32_t padding;
+	};
+
+	static Layout GetLayout();
+
+	void CreateResources();
+	void CreatePipelines();
+	void Clear();
+	void Upload(const uint8_t* data, const Layout& layout);
+	void Compute(Cubemap& skybox, Buffer& readback, const Layout& layout);
+
+	VkImage CreateCube(uint32_t size, uint32_t levels, Allocation& allocation);
+	VkImageView CreateView(VkImage image, VkImageViewType type, uint32_t baseLevel, uint32_t levelCount, uint32_t layerCount, VkFormat format = FORMAT);
+
+	Device& m_Device;
+
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_SetLayout;
+	VkDescriptorSet m_Set;
+	VkSampler m_Sampler;
+
+	std::unique_ptr<DescriptorPool> m_ComputePool;
+	std::shared_ptr<DescriptorSetLayout> m_ComputeSetLayout;
+	VkPipelineLayout m_ComputePipelineLayout;
+	std::unique_ptr<Pipeline> m_EnvironmentPipeline;
+	std::unique_ptr<Pipeline> m_IrradiancePipeline;
+	std::unique_ptr<Pipeline> m_PrefilterPipeline;
+	std::unique_ptr<Pipeline> m_BrdfPipeline;
+
+	std::unique_ptr<Buffer> m_Irradiance;
+	VkImage m_Prefiltered;
+	Allocation m_PrefilteredAllocation;
+	VkImageView m_PrefilteredView;
+	std::unique_ptr<Image> m_BrdfLut;
+
+	bool m_Ready = false;
+};
@@ -0,0 +1,440 @@
+#include "impostors.h"
+
+#include "model.h"
+#include "uniformRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static constexpr uint32_t MAX_ATLASES         = 64;
+static constexpr uint32_t MIN_INSTANCES       = 256;
+static constexpr VkFormat ALBEDO_FORMAT       = VK_FORMAT_R8G8B8A8_SRGB;
+static constexpr VkFormat NORMAL_FORMAT       = VK_FORMAT_R8G8B8A8_UNORM;
+static constexpr uint32_t BAKES_PER_FRAME     = 1;    // an atlas is 64 draws of the full mesh
+
+//
+// Frame directions, impostor.vert picks the frames the same way
+//
+static glm::vec3 OctDecode(glm::vec2 e) {
+	glm::vec3 v = {e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y)};
+	if(v.z < 0.0f) {
+		glm::vec2 flipped = (1.0f - glm::abs(glm::vec2(v.y, v.x))) * glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+		v.x               = flipped.x;
+		v.y               = flipped.y;
+	}
+	return glm::normalize(v);
+}
+
+// Right and up of the frame that looks at the model from `forward`
+static void FrameBasis(const glm::vec3& forward, glm::vec3& right, glm::vec3& up) {
+	glm::vec3 reference = std::abs(forward.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	right               = glm::normalize(glm::cross(reference, forward));
+	up                  = glm::cross(forward, right);
+}
+
+Impostors::Impostors(Device& device, const std::shared_ptr<DescriptorSetLayout>& lightsLayout): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device).SetMaxSets(MAX_ATLASES).AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_ATLASES * 2).Build();
+
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_LINEAR;
+	samplerInfo.minFilter    = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = static_cast<float>(ATLAS_MIP_COUNT);
+	if(vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS) { throw std::runtime_error("failed to create impostor sampler!"); }
+
+	m_DepthFormat = m_Device.FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+	m_BakeDepth   = std::make_unique<Image>(m_Device, GRID_SIZE * FRAME_SIZE, GRID_SIZE * FRAME_SIZE, m_DepthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+	                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	CreateRenderPass();
+	CreatePipelineLayouts(lightsLayout);
+	CreateBakePipeline();
+}
+
+Impostors::~Impostors() {
+	for(auto& [key, atlas] : m_Atlases) {
+		vkDestroyFramebuffer(m_Device.GetDevice(), atlas->framebuffer, nullptr);
+		vkDestroyImageView(m_Device.GetDevice(), atlas->albedoTarget, nullptr);
+		vkDestroyImageView(m_Device.GetDevice(), atlas->normalTarget, nullptr);
+	}
+	vkDestroyRenderPass(m_Device.GetDevice(), m_BakeRenderPass, nullptr);
+	vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_DrawPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_BakePipelineLayout, nullptr);
+}
+
+void Impostors::CreateRenderPass() {
+	std::array<VkAttachmentDescription, 3> attachments {};
+	for(uint32_t i = 0; i < 2; i++) {
+		attachments[i].format         = i == 0 ? ALBEDO_FORMAT : NORMAL_FORMAT;
+		attachments[i].samples        = VK_SAMPLE_COUNT_1_BIT;
+		attachments[i].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[i].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[i].finalLayout    = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;    // the mips are blitted from it
+	}
+
+	attachments[2].format         = m_DepthFormat;
+	attachments[2].samples        = VK_SAMPLE_COUNT_1_BIT;
+	attachments[2].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[2].storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[2].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[2].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[2].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[2].finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	std::array<VkAttachmentReference, 2> colorReferences = {
+		VkAttachmentReference {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+		VkAttachmentReference {1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}
+    };
+	VkAttachmentReference depthReference {2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+	VkSubpassDescription subpass {};
+	subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount    = static_cast<uint32_t>(colorReferences.size());
+	subpass.pColorAttachments       = colorReferences.data();
+	subpass.pDepthStencilAttachment = &depthReference;
+
+	// The depth image is shared by every bake, the previous one has to be done with it
+	std::array<VkSubpassDependency, 2> dependencies {};
+	dependencies[0].srcSubpass    = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass    = 0;
+	dependencies[0].srcStageMask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstStageMask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	// The mip chain is blitted right after
+	dependencies[1].srcSubpass    = 0;
+	dependencies[1].dstSubpass    = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo {};
+	renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments    = attachments.data();
+	renderPassInfo.subpassCount    = 1;
+	renderPassInfo.pSubpasses      = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies   = dependencies.data();
+	if(vkCreateRenderPass(m_Device.GetDevice(), &renderPassInfo, nullptr, &m_BakeRenderPass) != VK_SUCCESS) { throw std::runtime_error("failed to create impostor render pass!"); }
+}
+
+void Impostors::CreatePipelineLayouts(const std::shared_ptr<DescriptorSetLayout>& lightsLayout) {
+	auto materialLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	materialLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	materialLayoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	materialLayoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	m_MaterialSetLayout = materialLayoutBuilder.Build();
+
+	auto atlasLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	atlasLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	atlasLayoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+	m_AtlasSetLayout = atlasLayoutBuilder.Build();
+
+	//
+	// Baking
+	//
+	{
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(BakePushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_MaterialSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_BakePipelineLayout, &pushConstantRange);
+	}
+
+	//
+	// Drawing
+	//
+	{
+		// Global ubo lives in the per frame uniform ring
+		auto globalLayout = UniformRing::CreateDescriptorSetLayout(m_Device);
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(DrawPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {globalLayout->GetDescriptorSetLayout(), lightsLayout->GetDescriptorSetLayout(), m_AtlasSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_DrawPipelineLayout, &pushConstantRange);
+	}
+}
+
+void Impostors::CreateBakePipeline() {
+	PipelineConfigInfo pipelineConfig {};
+	Pipeline::CreatePipelineConfigInfo(pipelineConfig, FRAME_SIZE, FRAME_SIZE, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_CULL_MODE_NONE, true, false);
+
+	// Albedo and normal are written as is
+	std::array<VkPipelineColorBlendAttachmentState, 2> blendAttachments = {pipelineConfig.colorBlendAttachment, pipelineConfig.colorBlendAttachment};
+	pipelineConfig.colorBlendInfo.attachmentCount                       = static_cast<uint32_t>(blendAttachments.size());
+	pipelineConfig.colorBlendInfo.pAttachments                          = blendAttachments.data();
+	pipelineConfig.renderPass                                           = m_BakeRenderPass;
+	pipelineConfig.pipelineLayout                                       = m_BakePipelineLayout;
+
+	m_BakePipeline = std::make_unique<Pipeline>(m_Device);
+	m_BakePipeline->CreatePipeline(SHADER_DIRECTORY "impostorBake.vert.spv", SHADER_DIRECTORY "impostorBake.frag.spv", pipelineConfig, Model::PackedVertex::GetBindingDescriptions(),
+	                               Model::PackedVertex::GetAttributeDescriptions());
+}
+
+void Impostors::CreateDrawPipeline(VkRenderPass geometryRenderPass) {
+	PipelineConfigInfo pipelineConfig {};
+	Pipeline::CreatePipelineConfigInfo(pipelineConfig, FRAME_SIZE, FRAME_SIZE, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_CULL_MODE_NONE, true, false);
+	pipelineConfig.renderPass     = geometryRenderPass;
+	pipelineConfig.pipelineLayout = m_DrawPipelineLayout;
+
+	// The quad corners come from the vertex index, only the instances are read from a buffer
+	VkVertexInputBindingDescription binding {};
+	binding.binding   = 0;
+	binding.stride    = sizeof(Instance);
+	binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	std::vector<VkVertexInputAttributeDescription> attributes = {
+		{0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Instance, centerRadius)},
+		{1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Instance, rotation)    }
+    };
+
+	m_DrawPipeline = std::make_unique<Pipeline>(m_Device);
+	m_DrawPipeline->CreatePipeline(SHADER_DIRECTORY "impostor.vert.spv", SHADER_DIRECTORY "impostor.frag.spv", pipelineConfig, {binding}, attributes);
+}
+
+void Impostors::BeginFrame(uint32_t frameIndex) {
+	m_FrameIndex                          = frameIndex;
+	m_Frames[m_FrameIndex].instanceCount = 0;
+	for(auto& [key, atlas] : m_Atlases) {
+		for(auto& instances : atlas->instances) instances.clear();
+	}
+}
+
+bool Impostors::Add(Model* model, VkDescriptorSet materialSet, const glm::vec3& center, float radius, const glm::quat& rotation, bool emissive) {
+	auto it = m_Atlases.find({model, materialSet});
+	if(it == m_Atlases.end()) {
+		if(m_Atlases.size() >= MAX_ATLASES) return false;
+
+		auto atlas         = std::make_unique<Atlas>();
+		atlas->model       = model;
+		atlas->materialSet = materialSet;
+		CreateAtlas(*atlas);
+		m_BakeQueue.push_back(atlas.get());
+		m_Atlases.emplace(AtlasKey {model, materialSet}, std::move(atlas));
+		return false;
+	}
+
+	Atlas& atlas = *it->second;
+	if(!atlas.baked) return false;
+
+	atlas.instances[emissive ? 1 : 0].push_back({glm::vec4(center, radius), glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w)});
+	m_Frames[m_FrameIndex].instanceCount++;
+	return true;
+}
+
+void Impostors::CreateAtlas(Atlas& atlas) {
+	uint32_t size          = GRID_SIZE * FRAME_SIZE;
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	atlas.albedo = std::make_unique<Image>(m_Device, size, size, ALBEDO_FORMAT, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, ATLAS_MIP_COUNT);
+	atlas.normal = std::make_unique<Image>(m_Device, size, size, NORMAL_FORMAT, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, ATLAS_MIP_COUNT);
+
+	// Framebuffer attachments can only have a single mip
+	auto createTargetView = [&](Image& image, VkFormat format, VkImageView& view) {
+		VkImageViewCreateInfo viewInfo {};
+		viewInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image            = image.GetImage();
+		viewInfo.viewType         = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format           = format;
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+		if(vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &view) != VK_SUCCESS) { throw std::runtime_error("failed to create impostor atlas view!"); }
+	};
+	createTargetView(*atlas.albedo, ALBEDO_FORMAT, atlas.albedoTarget);
+	createTargetView(*atlas.normal, NORMAL_FORMAT, atlas.normalTarget);
+
+	std::array<VkImageView, 3> attachments = {atlas.albedoTarget, atlas.normalTarget, m_BakeDepth->GetImageView()};
+
+	VkFramebufferCreateInfo framebufferInfo {};
+	framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass      = m_BakeRenderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments    = attachments.data();
+	framebufferInfo.width           = size;
+	framebufferInfo.height          = size;
+	framebufferInfo.layers          = 1;
+	if(vkCreateFramebuffer(m_Device.GetDevice(), &framebufferInfo, nullptr, &atlas.framebuffer) != VK_SUCCESS) { throw std::runtime_error("failed to create impostor framebuffer!"); }
+
+	VkDescriptorImageInfo albedoInfo {m_Sampler, atlas.albedo->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	VkDescriptorImageInfo normalInfo {m_Sampler, atlas.normal->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+	DescriptorWriter writer(*m_AtlasSetLayout, *m_Pool);
+	writer.WriteImage(0, &albedoInfo);
+	writer.WriteImage(1, &normalInfo);
+	if(!writer.Build(atlas.set)) { throw std::runtime_error("failed to allocate impostor descriptor set!"); }
+}
+
+void Impostors::Bake(VkCommandBuffer commandBuffer) {
+	for(uint32_t i = 0; i < BAKES_PER_FRAME && !m_BakeQueue.empty(); i++) {
+		Atlas* atlas = m_BakeQueue.front();
+		m_BakeQueue.pop_front();
+
+		BakeAtlas(commandBuffer, *atlas);
+		GenerateMips(commandBuffer, *atlas);
+		atlas->baked = true;
+	}
+}
+
+/**
+ * @brief Renders the model into every frame of the atlas with an orthographic projection that fits its bounding sphere
+ */
+void Impostors::BakeAtlas(VkCommandBuffer commandBuffer, Atlas& atlas) {
+	uint32_t size = GRID_SIZE * FRAME_SIZE;
+
+	// Alpha 0 marks the texels the model doesn't cover
+	std::array<VkClearValue, 3> clearValues {};
+	clearValues[0].color        = {0.0f, 0.0f, 0.0f, 0.0f};
+	clearValues[1].color        = {0.5f, 0.5f, 1.0f, 0.0f};
+	clearValues[2].depthStencil = {1.0f, 0};
+
+	VkRenderPassBeginInfo renderPassInfo {};
+	renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass        = m_BakeRenderPass;
+	renderPassInfo.framebuffer       = atlas.framebuffer;
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = {size, size};
+	renderPassInfo.clearValueCount   = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues      = clearValues.data();
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	m_BakePipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_BakePipelineLayout, 0, 1, &atlas.materialSet, 0, nullptr);
+	atlas.model->Bind(commandBuffer);
+
+	BakePushConstants push {};
+	push.dequantization = atlas.model->GetDequantization();
+	float radius        = std::max(atlas.model->GetBoundingRadius(), 0.0001f);
+
+	for(uint32_t y = 0; y < GRID_SIZE; y++) {
+		for(uint32_t x = 0; x < GRID_SIZE; x++) {
+			glm::vec2 encoded = (glm::vec2(x, y) + 0.5f) / static_cast<float>(GRID_SIZE) * 2.0f - 1.0f;
+			glm::vec3 forward = OctDecode(encoded);
+			glm::vec3 right, up;
+			FrameBasis(forward, right, up);
+
+			push.right   = glm::vec4(right, radius);
+			push.up      = glm::vec4(up, 0.0f);
+			push.forward = glm::vec4(forward, 0.0f);
+
+			VkViewport viewport {};
+			viewport.x        = static_cast<float>(x * FRAME_SIZE);
+			viewport.y        = static_cast<float>(y * FRAME_SIZE);
+			viewport.width    = static_cast<float>(FRAME_SIZE);
+			viewport.height   = static_cast<float>(FRAME_SIZE);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+			VkRect2D scissor {
+				{static_cast<int32_t>(x * FRAME_SIZE), static_cast<int32_t>(y * FRAME_SIZE)},
+				{FRAME_SIZE, FRAME_SIZE}
+            };
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+			vkCmdPushConstants(commandBuffer, m_BakePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(BakePushConstants), &push);
+			atlas.model->Draw(commandBuffer, 0);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+/**
+ * @brief Every frame is a power of two, so each mip halves the frames without mixing neighbouring ones
+ */
+void Impostors::GenerateMips(VkCommandBuffer commandBuffer, Atlas& atlas) {
+	for(Image* image : {atlas.albedo.get(), atlas.normal.get()}) {
+		VkImageMemoryBarrier barrier {};
+		barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image               = image->GetImage();
+
+		int32_t size = static_cast<int32_t>(GRID_SIZE * FRAME_SIZE);
+		for(uint32_t level = 1; level < ATLAS_MIP_COUNT; level++) {
+			barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+			barrier.srcAccessMask    = 0;
+			barrier.dstAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkImageBlit blit {};
+			blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+			blit.srcOffsets[1]  = {size, size, 1};
+			blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+			blit.dstOffsets[1]  = {size / 2, size / 2, 1};
+			vkCmdBlitImage(commandBuffer, image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+			// The level just written is the source of the next one
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			size /= 2;
+		}
+
+		barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, ATLAS_MIP_COUNT, 0, 1};
+		barrier.srcAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout        = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
+
+void Impostors::Draw(VkCommandBuffer commandBuffer, VkDescriptorSet globalSet, uint32_t globalUboOffset, VkDescriptorSet lightsSet) {
+	Frame& frame = m_Frames[m_FrameIndex];
+	if(frame.instanceCount == 0) return;
+
+	// The GPU is done with this frame's buffer, it can be replaced
+	if(frame.instanceCount > frame.capacity) {
+		frame.capacity  = std::max(frame.instanceCount * 2, MIN_INSTANCES);
+		frame.instances = std::make_unique<Buffer>(m_Device, sizeof(Instance), frame.capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		frame.instances->Map();
+	}
+
+	m_DrawPipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipelineLayout, 0, 1, &globalSet, 1, &globalUboOffset);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipelineLayout, 1, 1, &lightsSet, 0, nullptr);
+
+	VkBuffer instanceBuffer = frame.instances->GetBuffer();
+	VkDeviceSize offset     = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instanceBuffer, &offset);
+
+	Instance* instances    = static_cast<Instance*>(frame.instances->GetMappedMemory());
+	uint32_t firstInstance = 0;
+	for(auto& [key, atlas] : m_Atlases) {
+		for(uint32_t emissive = 0; emissive < 2; emissive++) {
+			const std::vector<Instance>& atlasInstances = atlas->instances[emissive];
+			if(atlasInstances.empty()) continue;
+
+			std::copy(atlasInstances.begin(), atlasInstances.end(), instances + firstInstance);
+
+			DrawPushConstants push {};
+			push.gridSize = GRID_SIZE;
+			push.emissive = emissive;
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DrawPipelineLayout, 2, 1, &atlas->set, 0, nullptr);
+			vkCmdPushConstants(commandBuffer, m_DrawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DrawPushConstants), &push);
+			vkCmdDraw(commandBuffer, 6, static_cast<uint32_t>(atlasInstances.size()), 0, firstInstance);
+			firstInstance += static_cast<uint32_t>(atlasInstances.size());
+		}
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "image.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <array>
+#include <deque>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Model;
+
+/**
+ * @brief Draws objects that only cover a few pixels as camera facing quads instead of their meshes.
+ *
+ * Every model and material pair is rendered once, on first use, from 8x8 directions spread over the sphere with an
+ * octahedral mapping into an atlas of albedo and normal frames. An impostor picks the frame closest to the direction it
+ * is seen from and is lit like the meshes, with the normals stored in the atlas. All impostors of an atlas are a single
+ * instanced draw of a quad, so thousands of them cost about as much as particles.
+ */
+class Impostors {
+public:
+	Impostors(Device& device, const std::shared_ptr<DescriptorSetLayout>& lightsLayout);
+	~Impostors();
+
+	Impostors(const Impostors&)            = delete;
+	Impostors& operator=(const Impostors&) = delete;
+
+	// Has to be called again whenever the geometry render pass is recreated, the atlases are kept
+	void CreateDrawPipeline(VkRenderPass geometryRenderPass);
+
+	// Starts filling the instances of `frameIndex`, the GPU has to be done with the frame that used them last
+	void BeginFrame(uint32_t frameIndex);
+
+	/**
+	 * @param materialSet The object's material set, impostors of the same model with another material get their own atlas
+	 * @param center Center of the bounding sphere relative to the camera
+	 * @param rotation Rotation of the object, the atlas frames are rendered in model space
+	 * @param emissive Drawn with the albedo as is, for stars
+	 * @return false while the atlas isn't baked yet, the object has to be drawn as a mesh until then
+	 */
+	bool Add(Model* model, VkDescriptorSet materialSet, const glm::vec3& center, float radius, const glm::quat& rotation, bool emissive);
+
+	// Renders atlases that were requested by Add, has to be recorded outside of any render pass
+	void Bake(VkCommandBuffer commandBuffer);
+
+	// Has to be recorded inside a geometry pass, binds its own pipeline
+	void Draw(VkCommandBuffer commandBuffer, VkDescriptorSet globalSet, uint32_t globalUboOffset, VkDescriptorSet lightsSet);
+
+	inline uint32_t GetImpostorCount() const { return m_Frames[m_FrameIndex].instanceCount; }
+
+	inline uint32_t GetAtlasCount() const { return static_cast<uint32_t>(m_Atlases.size()); }
+
+private:
+	static constexpr uint32_t GRID_SIZE       = 8;     // frames per side of the atlas
+	static constexpr uint32_t FRAME_SIZE      = 64;    // pixels per side of a frame
+	static constexpr uint32_t ATLAS_MIP_COUNT = 4;     // the last mip still has 8x8 pixels per frame
+
+	using AtlasKey = std::pair<Model*, VkDescriptorSet>;
+
+	struct Instance {
+		glm::vec4 centerRadius;    // camera relative
+		glm::vec4 rotation;        // quaternion as xyzw, independent of how glm stores it
+	};
+
+	struct DrawPushConstants {
+		uint32_t gridSize;
+		uint32_t emissive;
+	};
+
+	struct BakePushConstants {
+		glm::mat4 dequantization;
+		glm::vec4 right;      // basis of the frame in model space, w is the model's bounding radius
+		glm::vec4 up;
+		glm::vec4 forward;    // towards the viewer
+	};
+
+	struct Atlas {
+		Model* model;
+		VkDescriptorSet materialSet;
+		std::unique_ptr<Image> albedo;
+		std::unique_ptr<Image> normal;
+		VkImageView albedoTarget  = VK_NULL_HANDLE;    // mip 0 only, the views of the images cover the whole chain
+		VkImageView normalTarget  = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkDescriptorSet set       = VK_NULL_HANDLE;
+		bool baked                = false;
+
+		// Instances of the frame being filled, sorted by emissive or not
+		std::array<std::vector<Instance>, 2> instances;
+	};
+
+	struct Frame {
+		std::unique_ptr<Buffer> instances;
+		uint32_t capacity      = 0;
+		uint32_t instanceCount = 0;
+	};
+
+	void CreateRenderPass();
+	void CreatePipelineLayouts(const std::shared_ptr<DescriptorSetLayout>& lightsLayout);
+	void CreateBakePipeline();
+	void CreateAtlas(Atlas& atlas);
+	void BakeAtlas(VkCommandBuffer commandBuffer, Atlas& atlas);
+	void GenerateMips(VkCommandBuffer commandBuffer, Atlas& atlas);
+
+	Device& m_Device;
+
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_AtlasSetLayout;
+	std::shared_ptr<DescriptorSetLayout> m_MaterialSetLayout;
+	VkPipelineLayout m_DrawPipelineLayout;
+	VkPipelineLayout m_BakePipelineLayout;
+	std::unique_ptr<Pipeline> m_DrawPipeline;
+	std::unique_ptr<Pipeline> m_BakePipeline;
+	VkRenderPass m_BakeRenderPass;
+	VkSampler m_Sampler;
+
+	VkFormat m_DepthFormat;
+	std::unique_ptr<Image> m_BakeDepth;    // shared by every bake, they are recorded one after another
+
+	std::map<AtlasKey, std::unique_ptr<Atlas>> m_Atlases;
+	std::deque<Atlas*> m_BakeQueue;
+
+	std::array<Frame, Swapchain::MAX_FRAMES_IN_FLIGHT> m_Frames;
+	uint32_t m_FrameIndex = 0;
+};
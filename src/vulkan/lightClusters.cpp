@@ -0,0 +1,113 @@
+#include "lightClusters.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr uint32_t INITIAL_CAPACITY = 1024;
+static constexpr uint32_t GROUP_SIZE       = 64;
+
+LightClusters::LightClusters(Device& device): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device)
+	             .SetMaxSets(Swapchain::MAX_FRAMES_IN_FLIGHT)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT * 3)
+	             .Build();
+
+	auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+	layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+	layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+	layoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+	layoutBuilder.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+	m_SetLayout = layoutBuilder.Build();
+
+	CreatePipeline();
+
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	for(auto& frame : m_Frames) {
+		frame.info = std::make_unique<Buffer>(m_Device, sizeof(ClusterInfo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible);
+		frame.info->Map();
+
+		// The light lists are only touched by the GPU, every frame gets its own so the next frame's assignment doesn't have to
+		// wait for the previous frame's shading
+		frame.lightGrid    = std::make_unique<Buffer>(m_Device, sizeof(uint32_t), CLUSTER_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		frame.lightIndices = std::make_unique<Buffer>(m_Device, sizeof(uint32_t), CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		GrowLights(frame, INITIAL_CAPACITY);
+	}
+}
+
+LightClusters::~LightClusters() { vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr); }
+
+void LightClusters::CreatePipeline() {
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_SetLayout->GetDescriptorSetLayout()};
+	Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_PipelineLayout, nullptr);
+
+	m_Pipeline = std::make_unique<Pipeline>(m_Device);
+	m_Pipeline->CreateComputePipeline(SHADER_DIRECTORY "lightCulling.comp.spv", m_PipelineLayout);
+}
+
+/**
+ * @brief Replaces the frame's light buffer with a larger one, the GPU is done with the frame
+ */
+void LightClusters::GrowLights(Frame& frame, uint32_t capacity) {
+	frame.lights = std::make_unique<Buffer>(m_Device, sizeof(PointLight), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	frame.lights->Map();
+	frame.capacity = capacity;
+
+	WriteSet(frame);
+}
+
+void LightClusters::WriteSet(Frame& frame) {
+	VkDescriptorBufferInfo info         = frame.info->DescriptorInfo();
+	VkDescriptorBufferInfo lights       = frame.lights->DescriptorInfo();
+	VkDescriptorBufferInfo lightGrid    = frame.lightGrid->DescriptorInfo();
+	VkDescriptorBufferInfo lightIndices = frame.lightIndices->DescriptorInfo();
+
+	DescriptorWriter writer(*m_SetLayout, *m_Pool);
+	writer.WriteBuffer(0, &info);
+	writer.WriteBuffer(1, &lights);
+	writer.WriteBuffer(2, &lightGrid);
+	writer.WriteBuffer(3, &lightIndices);
+
+	if(frame.set == VK_NULL_HANDLE) {
+		if(!writer.Build(frame.set)) { throw std::runtime_error("failed to allocate light cluster descriptor set!"); }
+	}
+	else writer.Overwrite(frame.set);
+}
+
+void LightClusters::Cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, float near, float far,
+                         VkExtent2D extent) {
+	m_FrameIndex = frameIndex;
+	Frame& frame = m_Frames[m_FrameIndex];
+
+	uint32_t lightCount = static_cast<uint32_t>(lights.size());
+	if(lightCount > frame.capacity) {
+		uint32_t capacity = frame.capacity;
+		while(capacity < lightCount) capacity *= 2;
+		GrowLights(frame, capacity);
+	}
+	if(lightCount > 0) std::memcpy(frame.lights->GetMappedMemory(), lights.data(), lightCount * sizeof(PointLight));
+	frame.lightCount = lightCount;
+
+	// slice = log(depth) * scale + bias puts near at slice 0 and far at slice GRID_Z
+	float sliceScale = GRID_Z / std::log(far / near);
+
+	ClusterInfo info {};
+	info.view       = view;
+	info.projection = {projection[0][0], projection[1][1], near, far};
+	info.slicing    = {sliceScale, -std::log(near) * sliceScale, static_cast<float>(extent.width), static_cast<float>(extent.height)};
+	info.grid       = {GRID_X, GRID_Y, GRID_Z, lightCount};
+	std::memcpy(frame.info->GetMappedMemory(), &info, sizeof(ClusterInfo));
+
+	// The frame that used these lists last has finished, only the reads of this frame's shading have to wait
+	m_Pipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &frame.set, 0, nullptr);
+	vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+	VkMemoryBarrier barrier {};
+	barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
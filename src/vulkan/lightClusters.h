@@ -0,0 +1,91 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+struct PointLight {
+	glm::vec3 position;    // relative to the camera
+	float radius;          // the light fades out to zero at this distance
+	glm::vec3 color;
+	float intensity;
+};
+
+/**
+ * @brief Clustered light assignment for forward shading.
+ *
+ * The view frustum is split into a grid of froxels, screen space tiles that are sliced exponentially in depth.
+ * Every frame a compute pass tests the lights of the frame against every froxel and writes a list of light
+ * indices per froxel, the fragment shader only loops over the lights of the froxel it falls into.
+ * The descriptor set holds everything the fragment shader needs, PBR.frag binds it as set 1.
+ */
+class LightClusters {
+public:
+	static constexpr uint32_t GRID_X                 = 16;
+	static constexpr uint32_t GRID_Y                 = 9;
+	static constexpr uint32_t GRID_Z                 = 24;
+	static constexpr uint32_t CLUSTER_COUNT          = GRID_X * GRID_Y * GRID_Z;
+	static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+	LightClusters(Device& device);
+	~LightClusters();
+
+	LightClusters(const LightClusters&)            = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	/**
+	 * @brief Uploads the lights of the frame and records the light assignment, has to be outside of a render pass.
+	 * The GPU has to be done with the frame that used `frameIndex` last.
+	 *
+	 * @param view Only rotates, the lights are already relative to the camera
+	 */
+	void Cull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, float near, float far,
+	          VkExtent2D extent);
+
+	inline VkDescriptorSet GetDescriptorSet() const { return m_Frames[m_FrameIndex].set; }
+
+	inline std::shared_ptr<DescriptorSetLayout> GetDescriptorSetLayout() const { return m_SetLayout; }
+
+	inline uint32_t GetLightCount() const { return m_Frames[m_FrameIndex].lightCount; }
+
+private:
+	// Matches ClusterInfo in lightCulling.comp and PBR.frag
+	struct ClusterInfo {
+		glm::mat4 view;
+		glm::vec4 projection;    // P00, P11, near, far
+		glm::vec4 slicing;       // depth slice scale and bias, screen width and height
+		glm::uvec4 grid;         // x, y, z, light count
+	};
+
+	struct Frame {
+		std::unique_ptr<Buffer> info;
+		std::unique_ptr<Buffer> lights;
+		std::unique_ptr<Buffer> lightGrid;       // light count per cluster
+		std::unique_ptr<Buffer> lightIndices;    // MAX_LIGHTS_PER_CLUSTER indices per cluster
+		uint32_t capacity   = 0;
+		uint32_t lightCount = 0;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+	};
+
+	void CreatePipeline();
+	void GrowLights(Frame& frame, uint32_t capacity);
+	void WriteSet(Frame& frame);
+
+	Device& m_Device;
+
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_SetLayout;
+	VkPipelineLayout m_PipelineLayout;
+	std::unique_ptr<Pipeline> m_Pipeline;
+
+	std::array<Frame, Swapchain::MAX_FRAMES_IN_FLIGHT> m_Frames;
+	uint32_t m_FrameIndex = 0;
+};
@@ -1,104 +1,82 @@
 #include "model.h"
 
+#include "../mappedFile.h"
+#include "../models/gltfImporter.h"
+#include "../models/meshFile.h"
+#include "../models/meshSimplifier.h"
+#include "../models/objImporter.h"
 #include "../utilities.h"
+#include "uploadQueue.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cctype>
+#include <cmath>
 #include <cstring>
-#include <unordered_map>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tinyobjloader/tiny_obj_loader.h"
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <iostream>
 
-namespace std {
-	template <> struct hash<Model::Vertex> {
-		size_t operator()(Model::Vertex const& vertex) const {
-			size_t seed = 0;
-			HashCombine(seed, vertex.position);
-			return seed;
-		}
-	};
-}    // namespace std
-
 Model::Model(Device& device, const Model::Builder& builder): m_Device(device) {
-	CreateVertexBuffer(builder.vertices);
-	CreateIndexBuffer(builder.indices);
+	std::vector<PackedVertex> packedVertices;
+	Create(PackMesh(builder, packedVertices));
 }
 
+Model::Model(Device& device, const MeshData& data): m_Device(device) { Create(data); }
+
 Model::~Model() {}
 
-void Model::CreateVertexBuffer(const std::vector<Vertex>& vertices) {
-	m_VertexCount           = static_cast<uint32_t>(vertices.size());
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * m_VertexCount;
-	uint32_t vertexSize     = sizeof(vertices[0]);
+void Model::Create(const MeshData& data) {
+	CreateVertexBuffer(data.vertices, data.vertexCount);
+	CreateIndexBuffer(data.indices, data.indexCount);
 
-	/*
-        We need to be able to write our vertex data to memory.
-        This property is indicated with VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT with VK_MEMORY_PROPERTY_HOST_COHERENT_BIT property.
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT is Used to get memory heap that is host coherent. 
-        We use this to copy the data into the buffer memory immediately.
-    */
-	Buffer stagingBuffer(m_Device, vertexSize, m_VertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	m_Lods.assign(data.lods, data.lods + data.lodCount);
+	if(m_Lods.empty()) { m_Lods.push_back({0, m_IndexCount, 0.0f}); }
 
-	/*
-        When buffer is created It is time to copy the vertex data to the buffer. 
-        This is done by mapping the buffer memory into CPU accessible memory with vkMapMemory.
-    */
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*) vertices.data());
+	m_Dequantization = data.dequantization;
+	m_BoundingRadius = data.boundingRadius;
+}
+
+void Model::CreateVertexBuffer(const PackedVertex* vertices, uint32_t vertexCount) {
+	m_VertexCount           = vertexCount;
+	VkDeviceSize bufferSize = sizeof(PackedVertex) * m_VertexCount;
+	uint32_t vertexSize     = sizeof(PackedVertex);
 
 	/*
-        The vertexBuffer is now allocated from a memory type that is device 
+        The vertexBuffer is allocated from a memory type that is device 
         local, which generally means that we're not able to use vkMapMemory. 
-        However, we can copy data from the stagingBuffer to the vertexBuffer. 
-        We have to indicate that we intend to do that by specifying the transfer 
-        source flag(VK_BUFFER_USAGE_TRANSFER_SRC_BIT) for the stagingBuffer 
-        and the transfer destination flag(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-        for the vertexBuffer, along with the vertex buffer usage flag.
+        The data is instead copied into the upload queue's staging ring and the 
+        copy is recorded into its current batch, so we need the transfer 
+        destination flag(VK_BUFFER_USAGE_TRANSFER_DST_BIT) along with the 
+        vertex buffer usage flag. Nothing waits here, the batch is submitted 
+        together with every other upload and the graphics queue only starts 
+        using the buffer after the copy finished.
     */
-
 	m_VertexBuffer = std::make_unique<Buffer>(m_Device, vertexSize, m_VertexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-	m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_VertexBuffer->GetBuffer(), bufferSize);
+	m_Device.GetUploadQueue().UploadBuffer(m_VertexBuffer->GetBuffer(), vertices, bufferSize);
 }
 
-void Model::CreateIndexBuffer(const std::vector<uint32_t>& indices) {
-	m_IndexCount     = static_cast<uint32_t>(indices.size());
+void Model::CreateIndexBuffer(const uint32_t* indices, uint32_t indexCount) {
+	m_IndexCount     = indexCount;
 	m_HasIndexBuffer = m_IndexCount > 0;
 	if(!m_HasIndexBuffer) { return; }
 
-	VkDeviceSize bufferSize = sizeof(indices[0]) * m_IndexCount;
-	uint32_t indexSize      = sizeof(indices[0]);
+	VkDeviceSize bufferSize = sizeof(uint32_t) * m_IndexCount;
+	uint32_t indexSize      = sizeof(uint32_t);
 
 	/*
-        We need to be able to write our index data to memory.
-        This property is indicated with VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT with VK_MEMORY_PROPERTY_HOST_COHERENT_BIT property.
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT is Used to get memory heap that is host coherent. 
-        We use this to copy the data into the buffer memory immediately.
-    */
-	Buffer stagingBuffer(m_Device, indexSize, m_IndexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	/*
-        When buffer is created It is time to copy the index data to the buffer. 
-        This is done by mapping the buffer memory into CPU accessible memory with vkMapMemory.
-    */
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*) indices.data());
-
-	/*
-        The IndexBuffer is now allocated from a memory type that is device 
-        local, which generally means that we're not able to use vkMapMemory. 
-        However, we can copy data from the stagingBuffer to the IndexBuffer. 
-        We have to indicate that we intend to do that by specifying the transfer 
-        source flag(VK_BUFFER_USAGE_TRANSFER_SRC_BIT) for the stagingBuffer 
-        and the transfer destination flag(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-        for the IndexBuffer, along with the IndexBuffer usage flag.
+        Same as the vertex buffer, the IndexBuffer is device local and is filled 
+        through the upload queue, so it needs the transfer destination 
+        flag(VK_BUFFER_USAGE_TRANSFER_DST_BIT) along with the IndexBuffer usage flag.
     */
 	m_IndexBuffer = std::make_unique<Buffer>(m_Device, indexSize, m_IndexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-	m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_IndexBuffer->GetBuffer(), bufferSize);
+	m_Device.GetUploadQueue().UploadBuffer(m_IndexBuffer->GetBuffer(), indices, bufferSize);
 }
 
 /**
@@ -112,92 +90,275 @@ void Model::Bind(VkCommandBuffer commandBuffer) {
 	if(m_HasIndexBuffer) { vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32); }
 }
 
-void Model::Draw(VkCommandBuffer commandBuffer) {
-	if(m_HasIndexBuffer) { vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, 0, 0, 0); }
+void Model::Draw(VkCommandBuffer commandBuffer, uint32_t lod) {
+	if(m_HasIndexBuffer) { vkCmdDrawIndexed(commandBuffer, m_Lods[lod].indexCount, 1, m_Lods[lod].firstIndex, 0, 0); }
 	else { vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0); }
 }
 
 /**
- * @brief Specifies how many vertex buffers we wish to bind to our pipeline. In this case there is only one with all data packed inside it
-*/
-std::vector<VkVertexInputBindingDescription> Model::Vertex::GetBindingDescriptions() {
-	std::vector<VkVertexInputBindingDescription> bindingDescription(1);
-	bindingDescription[0].binding   = 0;
-	bindingDescription[0].stride    = sizeof(Vertex);
-	bindingDescription[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-	return bindingDescription;
+ * @brief Picks the coarsest LOD whose error stays below `maxPixelError` on screen
+ *
+ * @param pixelsPerUnit How many pixels one model space unit covers at the model's distance
+ */
+uint32_t Model::SelectLod(float pixelsPerUnit, float maxPixelError) const {
+	uint32_t lod = 0;
+	while(lod + 1 < m_Lods.size() && m_Lods[lod + 1].error * pixelsPerUnit <= maxPixelError) lod++;
+	return lod;
 }
 
 /**
- * @brief Specifies layout of data inside vertex buffer
-*/
-std::vector<VkVertexInputAttributeDescription> Model::Vertex::GetAttributeDescriptions() {
-	std::vector<VkVertexInputAttributeDescription> attributeDescriptions {};
-	attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-	attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
-	attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord)});
+ * @brief Loads the baked version of the model if it is up to date with the source file, otherwise imports and bakes it.
+ * The baked vertices and indices are copied from the mapping straight into the staging ring.
+ */
+std::unique_ptr<Model> Model::CreateModelFromFile(Device& device, const std::string& modelFilepath) {
+	MappedFile source;
+	if(!source.Open(modelFilepath)) { throw std::runtime_error("failed to open model " + modelFilepath + "!"); }
+	uint64_t sourceHash = HashBytes(source.GetData(), source.GetSize());
+	source.Close();
 
-	return attributeDescriptions;
-}
+	std::string cachePath = MeshFile::GetCachePath(modelFilepath);
+
+	MeshFile meshFile;
+	if(meshFile.Open(cachePath, sourceHash)) { return std::make_unique<Model>(device, meshFile.GetData()); }
 
-std::unique_ptr<Model> Model::CreateModelFromFile(Device& device, const std::string& modelFilepath) {
 	Builder builder {};
 	builder.LoadModel(modelFilepath);
 
-	return std::make_unique<Model>(device, builder);
+	std::vector<PackedVertex> packedVertices;
+	MeshData data = PackMesh(builder, packedVertices);
+	if(!MeshFile::Write(cachePath, sourceHash, data)) { std::cerr << "failed to write mesh cache " << cachePath << std::endl; }
+
+	return std::make_unique<Model>(device, data);
+}
+
+/**
+ * @brief Packs the vertices of `builder` into `packedVertices` and returns a MeshData that points into both
+ */
+Model::MeshData Model::PackMesh(const Builder& builder, std::vector<PackedVertex>& packedVertices) {
+	MeshData data {};
+	packedVertices = PackVertices(builder.vertices, data.dequantization);
+
+	data.vertices    = packedVertices.data();
+	data.vertexCount = static_cast<uint32_t>(packedVertices.size());
+	data.indices     = builder.indices.data();
+	data.indexCount  = static_cast<uint32_t>(builder.indices.size());
+	data.lods        = builder.lods.data();
+	data.lodCount    = static_cast<uint32_t>(builder.lods.size());
+
+	for(const Vertex& vertex : builder.vertices) { data.boundingRadius = std::max(data.boundingRadius, glm::length(vertex.position)); }
+	return data;
 }
 
 void Model::Builder::LoadModel(const std::string& modelFilepath) {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
-	std::string mtlPath = modelFilepath;
-	size_t lastSlashPos = mtlPath.find_last_of('/');
-	if(lastSlashPos != std::string::npos) {
-		// Erase everything after the last '/'
-		mtlPath.erase(lastSlashPos);
+	std::string extension = std::filesystem::path(modelFilepath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if(extension == ".glb") {
+		GltfImporter importer {};
+		importer.Load(modelFilepath, vertices, indices);
+	}
+	else {
+		ObjImporter importer {};
+		importer.Load(modelFilepath, vertices, indices);
 	}
-	if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelFilepath.c_str(), mtlPath.c_str())) { throw std::runtime_error(warn + err); }
-	std::cout << warn << std::endl;
-
-	vertices.clear();
-	indices.clear();
-
-	std::unordered_map<Vertex, uint32_t> uniqueVertices {};
-	for(const auto& shape : shapes) {
-		for(const auto& index : shape.mesh.indices) {
-			Vertex vertex {};
-
-			if(index.vertex_index >= 0) {
-				vertex.position = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2],
-				};
-			}
-
-			if(index.texcoord_index >= 0) { vertex.texCoord = {attrib.texcoords[2 * index.texcoord_index + 0], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1]}; }
-
-			if(index.normal_index >= 0) {
-				vertex.normal = {
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2],
-				};
-			}
-
-			// Check if vertex is in hashmap already, if yes just add it do indices. We're saving a lot of memory this way
-			if(uniqueVertices.count(vertex) == 0) {
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
-			indices.push_back(uniqueVertices[vertex]);
+
+	GenerateTangents();
+	GenerateLods();
+	OptimizeIndices();
+
+	if(!s_PrintImportReports) return;
+
+	std::ostringstream message;
+	message << std::fixed << std::setprecision(3) << modelFilepath << ": " << report.vertexCount << " vertices, " << report.triangleCount << " triangles, " << report.lodCount << " LODs, ACMR "
+	        << report.before.acmr << " -> " << report.after.acmr << ", ATVR " << report.before.atvr << " -> " << report.after.atvr;
+	std::cout << message.str() << std::endl;
+}
+
+/**
+ * @brief Computes a per vertex tangent from the uv layout of the triangles around it.
+ * Vertices on a uv mirror seam are already split by the importer, so every vertex ends up with one handedness.
+ */
+void Model::Builder::GenerateTangents() {
+	std::vector<glm::vec3> tangents(vertices.size(), glm::vec3 {0.0f});
+	std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3 {0.0f});
+
+	for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const Vertex& v0 = vertices[indices[i + 0]];
+		const Vertex& v1 = vertices[indices[i + 1]];
+		const Vertex& v2 = vertices[indices[i + 2]];
+
+		glm::vec3 edge1 = v1.position - v0.position;
+		glm::vec3 edge2 = v2.position - v0.position;
+		glm::vec2 duv1  = v1.texCoord - v0.texCoord;
+		glm::vec2 duv2  = v2.texCoord - v0.texCoord;
+
+		float determinant = duv1.x * duv2.y - duv2.x * duv1.y;
+		if(std::abs(determinant) < 1e-12f) continue;
+
+		// Not normalized, so bigger triangles weigh more
+		float r             = 1.0f / determinant;
+		glm::vec3 tangent   = (edge1 * duv2.y - edge2 * duv1.y) * r;
+		glm::vec3 bitangent = (edge2 * duv1.x - edge1 * duv2.x) * r;
+		for(int corner = 0; corner < 3; corner++) {
+			tangents[indices[i + corner]] += tangent;
+			bitangents[indices[i + corner]] += bitangent;
 		}
 	}
+
+	for(size_t i = 0; i < vertices.size(); i++) {
+		glm::vec3 normal = vertices[i].normal;
+
+		// Gram-Schmidt, the tangent has to be perpendicular to the normal
+		glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+		if(glm::dot(tangent, tangent) < 1e-12f) {
+			// No usable uvs around this vertex, any perpendicular direction will do
+			glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3 {1.0f, 0.0f, 0.0f} : glm::vec3 {0.0f, 1.0f, 0.0f};
+			tangent        = glm::cross(normal, axis);
+			if(glm::dot(tangent, tangent) < 1e-12f) tangent = {1.0f, 0.0f, 0.0f};
+		}
+		tangent = glm::normalize(tangent);
+
+		float handedness    = glm::dot(glm::cross(normal, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+		vertices[i].tangent = glm::vec4(tangent, handedness);
+	}
+}
+
+/**
+ * @brief Builds a chain of simplified versions of the mesh, each with about half the triangles of the previous one.
+ * The LODs are appended to `indices` and all of them use the same vertices.
+ */
+void Model::Builder::GenerateLods() {
+	lods.clear();
+	if(indices.empty()) return;
+
+	lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+
+	std::vector<glm::vec3> positions(vertices.size());
+	for(size_t i = 0; i < vertices.size(); i++) positions[i] = vertices[i].position;
+	MeshSimplifier simplifier(positions);
+
+	std::vector<uint32_t> previous = indices;
+	float error                    = 0.0f;
+	while(lods.size() < MAX_LOD_COUNT) {
+		size_t target = previous.size() / 6 * 3;
+		if(target < 12 * 3) break;
+
+		float lodError;
+		std::vector<uint32_t> lod = simplifier.Simplify(previous, target, FLT_MAX, lodError);
+
+		// Stuck on borders or flips, more LODs would look the same
+		if(lod.empty() || lod.size() > previous.size() * 85 / 100) break;
+
+		// Every LOD is simplified from the previous one so the errors add up
+		error += lodError;
+		lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.size()), error});
+		indices.insert(indices.end(), lod.begin(), lod.end());
+		previous = std::move(lod);
+	}
+}
+
+/**
+ * @brief Reorders the triangles of every LOD for the post transform cache and overdraw, then the vertices for fetch locality.
+ * Fills the vertex cache part of `report`.
+ */
+void Model::Builder::OptimizeIndices() {
+	std::vector<Lod> ranges = lods;
+	if(ranges.empty()) { ranges.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f}); }
+
+	auto lodIndices = [&](const Lod& lod) { return std::vector<uint32_t>(indices.begin() + lod.firstIndex, indices.begin() + lod.firstIndex + lod.indexCount); };
+
+	report.vertexCount   = static_cast<uint32_t>(vertices.size());
+	report.triangleCount = ranges[0].indexCount / 3;
+	report.lodCount      = static_cast<uint32_t>(ranges.size());
+	report.before        = MeshOptimizer::AnalyzeVertexCache(lodIndices(ranges[0]), vertices.size());
+	if(indices.empty()) {
+		report.after = report.before;
+		return;
+	}
+
+	std::vector<glm::vec3> positions(vertices.size());
+	for(size_t i = 0; i < vertices.size(); i++) positions[i] = vertices[i].position;
+
+	for(const Lod& lod : ranges) {
+		std::vector<uint32_t> optimized = MeshOptimizer::OptimizeOverdraw(lodIndices(lod), positions);
+		std::copy(optimized.begin(), optimized.end(), indices.begin() + lod.firstIndex);
+	}
+
+	// The full resolution LOD comes first, so the vertex buffer ends up in its order
+	std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(indices, vertices.size());
+	std::vector<Vertex> reordered(vertices.size());
+	size_t usedCount = 0;
+	for(size_t i = 0; i < vertices.size(); i++) {
+		if(remap[i] == ~0u) continue;
+		reordered[remap[i]] = vertices[i];
+		usedCount++;
+	}
+	reordered.resize(usedCount);
+	vertices = std::move(reordered);
+
+	report.vertexCount = static_cast<uint32_t>(vertices.size());
+	report.after       = MeshOptimizer::AnalyzeVertexCache(lodIndices(ranges[0]), vertices.size());
 }
 
 void Model::UpdateVertexBuffer(VkCommandBuffer cmd, Buffer* buffer, const std::vector<Vertex>& vertices) {
-	vkCmdUpdateBuffer(cmd, buffer->GetBuffer(), 0, sizeof(vertices[0]) * vertices.size(), vertices.data());
-}
\ No newline at end of file
+	std::vector<PackedVertex> packed = PackVertices(vertices, m_Dequantization);
+	vkCmdUpdateBuffer(cmd, buffer->GetBuffer(), 0, sizeof(packed[0]) * packed.size(), packed.data());
+}
+
+namespace {
+	// Octahedral mapping of a unit vector onto the [-1, 1] square
+	glm::vec2 OctEncode(glm::vec3 v) {
+		v /= std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		glm::vec2 result {v.x, v.y};
+		if(v.z < 0.0f) {
+			result.x = (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+			result.y = (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return result;
+	}
+
+	int8_t PackSnorm8(float value) { return static_cast<int8_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 127.0f)); }
+}    // namespace
+
+/**
+ * @brief Quantizes vertices to the 16 byte GPU format
+ *
+ * @param dequantization Receives the matrix that maps the quantized positions back to model space
+ */
+std::vector<Model::PackedVertex> Model::PackVertices(const std::vector<Vertex>& vertices, glm::mat4& dequantization) {
+	glm::vec3 min {FLT_MAX};
+	glm::vec3 max {-FLT_MAX};
+	for(const Vertex& vertex : vertices) {
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+	if(vertices.empty()) { min = max = glm::vec3 {0.0f}; }
+
+	glm::vec3 extent = max - min;
+	for(int axis = 0; axis < 3; axis++) {
+		if(extent[axis] <= 0.0f) extent[axis] = 1.0f;
+	}
+
+	std::vector<PackedVertex> packed(vertices.size());
+	for(size_t i = 0; i < vertices.size(); i++) {
+		const Vertex& vertex = vertices[i];
+		PackedVertex& out    = packed[i];
+
+		glm::vec3 position = (vertex.position - min) / extent;
+		for(int axis = 0; axis < 3; axis++) { out.position[axis] = static_cast<uint16_t>(std::round(std::clamp(position[axis], 0.0f, 1.0f) * 65535.0f)); }
+		out.position[3] = vertex.tangent.w < 0.0f ? 0 : 65535;
+
+		glm::vec3 tangent    = glm::vec3(vertex.tangent);
+		glm::vec2 normal     = glm::dot(vertex.normal, vertex.normal) > 0.0f ? OctEncode(vertex.normal) : glm::vec2 {0.0f};
+		glm::vec2 tangentOct = glm::dot(tangent, tangent) > 0.0f ? OctEncode(tangent) : glm::vec2 {0.0f};
+		out.normalTangent[0] = PackSnorm8(normal.x);
+		out.normalTangent[1] = PackSnorm8(normal.y);
+		out.normalTangent[2] = PackSnorm8(tangentOct.x);
+		out.normalTangent[3] = PackSnorm8(tangentOct.y);
+
+		out.texCoord = glm::packHalf2x16(vertex.texCoord);
+	}
+
+	dequantization = glm::scale(glm::translate(glm::mat4 {1.0f}, min), extent);
+	return packed;
+}
@@ -2,35 +2,113 @@
 
 #include "../vulkan/buffer.h"
 #include "../vulkan/device.h"
+#include "../models/meshOptimizer.h"
 #include "../vulkan/image.h"
+#include "vertexLayout.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 class Model {
 public:
+	/**
+	 * @brief Full precision vertex used while importing and processing meshes
+	 */
 	struct Vertex {
 		glm::vec3 position;
 		glm::vec3 normal;
 		glm::vec2 texCoord;
+		glm::vec4 tangent;    // w is the handedness of the bitangent
 
-		static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
-		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		using Layout = VertexLayout<VertexAttribute<glm::vec3, VK_FORMAT_R32G32B32_SFLOAT>, VertexAttribute<glm::vec3, VK_FORMAT_R32G32B32_SFLOAT>,
+		                            VertexAttribute<glm::vec2, VK_FORMAT_R32G32_SFLOAT>, VertexAttribute<glm::vec4, VK_FORMAT_R32G32B32A32_SFLOAT>>;
+
+		static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions() { return Layout::GetBindingDescriptions(); }
+
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() { return Layout::GetAttributeDescriptions(); }
 
 		bool operator==(const Vertex& other) const { return position == other.position && normal == other.normal && texCoord == other.texCoord; }
 	};
 
+	/**
+	 * @brief 16 byte vertex the GPU draws with, half of the 32 bytes position, normal and uv took as floats.
+	 *
+	 * position     16 bit unorm inside the mesh bounds (see GetDequantization), w holds the tangent handedness (0 = -1, 1 = +1)
+	 * normalTangent octahedral encoded normal (xy) and tangent (zw) as 8 bit snorm
+	 * texCoord     two half floats
+	 */
+	struct PackedVertex {
+		uint16_t position[4];
+		int8_t normalTangent[4];
+		uint32_t texCoord;
+
+		using Layout = VertexLayout<VertexAttribute<uint16_t[4], VK_FORMAT_R16G16B16A16_UNORM>, VertexAttribute<int8_t[4], VK_FORMAT_R8G8B8A8_SNORM>,
+		                            VertexAttribute<uint32_t, VK_FORMAT_R16G16_SFLOAT>>;
+
+		static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions() { return Layout::GetBindingDescriptions(); }
+
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() { return Layout::GetAttributeDescriptions(); }
+	};
+
+	/**
+	 * @brief Range of the shared index buffer that draws one level of detail.
+	 * `error` is how far (in model space) the surface deviates from the full resolution mesh.
+	 */
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
+	static constexpr uint32_t MAX_LOD_COUNT = 8;
+
+	// Print the ImportReport of every model that is imported instead of loaded from its cache, set by --verbose
+	static inline bool s_PrintImportReports = false;
+
+	/**
+	 * @brief What the import did to the mesh, vertex cache statistics are for the full resolution LOD
+	 */
+	struct ImportReport {
+		uint32_t vertexCount   = 0;
+		uint32_t triangleCount = 0;
+		uint32_t lodCount      = 0;
+		VertexCacheStats before {};
+		VertexCacheStats after {};
+	};
+
 	struct Builder {
 		std::vector<Vertex> vertices {};
 		std::vector<uint32_t> indices;
+		std::vector<Lod> lods;    // indices holds every LOD back to back, empty means a single LOD
+		ImportReport report {};
 
 		void LoadModel(const std::string& modelFilepath);
+		void GenerateTangents();
+		void GenerateLods();
+		void OptimizeIndices();
+	};
+
+	/**
+	 * @brief Everything the GPU copy of a mesh is made from. Doesn't own the data, it either points into a
+	 * Builder and its packed vertices or straight into a mapped .mesh file.
+	 */
+	struct MeshData {
+		const PackedVertex* vertices = nullptr;
+		uint32_t vertexCount         = 0;
+		const uint32_t* indices      = nullptr;
+		uint32_t indexCount          = 0;
+		const Lod* lods              = nullptr;
+		uint32_t lodCount            = 0;
+		glm::mat4 dequantization {1.0f};
+		float boundingRadius = 0.0f;
 	};
 
 	Model(Device& device, const Model::Builder& builder);
+	Model(Device& device, const MeshData& data);
 	~Model();
 
 	Model(const Model&)            = delete;
@@ -39,15 +117,32 @@ public:
 	static std::unique_ptr<Model> CreateModelFromFile(Device& device, const std::string& modelFilepath);
 
 	void Bind(VkCommandBuffer commandBuffer);
-	void Draw(VkCommandBuffer commandBuffer);
+	void Draw(VkCommandBuffer commandBuffer, uint32_t lod = 0);
+
+	uint32_t SelectLod(float pixelsPerUnit, float maxPixelError = 1.0f) const;
+
+	inline uint32_t GetLodCount() const { return static_cast<uint32_t>(m_Lods.size()); }
+
+	inline const Lod& GetLod(uint32_t lod) const { return m_Lods[lod]; }
+
+	inline float GetBoundingRadius() const { return m_BoundingRadius; }
+
+	inline bool HasIndexBuffer() const { return m_HasIndexBuffer; }
+
+	// Maps the quantized [0, 1] positions back to model space, has to be applied after the model matrix
+	inline const glm::mat4& GetDequantization() const { return m_Dequantization; }
 
 	void UpdateVertexBuffer(VkCommandBuffer cmd, Buffer* buffer, const std::vector<Vertex>& vertices);
 
+	static std::vector<PackedVertex> PackVertices(const std::vector<Vertex>& vertices, glm::mat4& dequantization);
+	static MeshData PackMesh(const Builder& builder, std::vector<PackedVertex>& packedVertices);
+
 	inline Buffer* GetVertexBuffer() { return m_VertexBuffer.get(); }
 
 private:
-	void CreateVertexBuffer(const std::vector<Vertex>& vertices);
-	void CreateIndexBuffer(const std::vector<uint32_t>& indices);
+	void Create(const MeshData& data);
+	void CreateVertexBuffer(const PackedVertex* vertices, uint32_t vertexCount);
+	void CreateIndexBuffer(const uint32_t* indices, uint32_t indexCount);
 
 	Device& m_Device;
 
@@ -57,4 +152,11 @@ private:
 	bool m_HasIndexBuffer = false;
 	std::unique_ptr<Buffer> m_IndexBuffer;
 	uint32_t m_IndexCount;
-};
\ No newline at end of file
+
+	std::vector<Lod> m_Lods;
+	float m_BoundingRadius = 0.0f;    // around the model space origin
+	glm::mat4 m_Dequantization {1.0f};
+};
+
+static_assert(sizeof(Model::Vertex) == Model::Vertex::Layout::STRIDE, "Vertex members don't match its layout");
+static_assert(sizeof(Model::PackedVertex) == Model::PackedVertex::Layout::STRIDE, "PackedVertex members don't match its layout");
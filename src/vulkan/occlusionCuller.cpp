@@ -0,0 +1,426 @@
+#include "occlusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr uint32_t INITIAL_CAPACITY   = 256;
+static constexpr uint32_t CULL_GROUP_SIZE    = 64;
+static constexpr uint32_t PYRAMID_GROUP_SIZE = 8;
+static constexpr uint32_t MAX_PYRAMID_LEVELS = 16;
+
+OcclusionCuller::OcclusionCuller(Device& device): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device)
+	             .SetMaxSets(Swapchain::MAX_FRAMES_IN_FLIGHT * 2 + MAX_PYRAMID_LEVELS)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT * 5)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Swapchain::MAX_FRAMES_IN_FLIGHT * 2 + MAX_PYRAMID_LEVELS)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, Swapchain::MAX_FRAMES_IN_FLIGHT + MAX_PYRAMID_LEVELS)
+	             .Build();
+
+	CreateSampler();
+	CreatePipelines();
+
+	for(auto& frame : m_Frames) GrowFrame(frame, INITIAL_CAPACITY);
+	GrowVisibility(INITIAL_CAPACITY);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+	DestroyPyramid();
+	vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_CullPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_PyramidPipelineLayout, nullptr);
+}
+
+void OcclusionCuller::CreateSampler() {
+	// Everything is read with texelFetch, the descriptors just need a sampler
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_NEAREST;
+	samplerInfo.minFilter    = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+	if(vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS) { throw std::runtime_error("failed to create depth pyramid sampler!"); }
+}
+
+void OcclusionCuller::CreatePipelines() {
+	//
+	// Culling
+	//
+	{
+		auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+		for(uint32_t binding = 0; binding < 5; binding++) layoutBuilder.AddBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+		layoutBuilder.AddBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_CullSetLayout = layoutBuilder.Build();
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(CullPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_CullSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_CullPipelineLayout, &pushConstantRange);
+
+		m_CullPipeline = std::make_unique<Pipeline>(m_Device);
+		m_CullPipeline->CreateComputePipeline(SHADER_DIRECTORY "cull.comp.spv", m_CullPipelineLayout);
+	}
+
+	//
+	// Depth pyramid
+	//
+	{
+		auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+		layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_PyramidSetLayout = layoutBuilder.Build();
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(PyramidPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_PyramidSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_PyramidPipelineLayout, &pushConstantRange);
+
+		m_PyramidPipeline = std::make_unique<Pipeline>(m_Device);
+		m_PyramidPipeline->CreateComputePipeline(SHADER_DIRECTORY "depthPyramid.comp.spv", m_PyramidPipelineLayout);
+	}
+}
+
+/**
+ * @brief Recreates the pyramid for the extent and depth images of `swapchain`. Only called right after the swapchain
+ * was recreated, so the GPU is idle. The pyramid starts at half the depth resolution and goes down to 1x1.
+ */
+void OcclusionCuller::Resize(Swapchain& swapchain) {
+	DestroyPyramid();
+
+	m_DepthExtent        = swapchain.GetSwapchainExtent();
+	VkFormat depthFormat = swapchain.GetDepthFormat();
+	m_DepthAspect        = VK_IMAGE_ASPECT_DEPTH_BIT;
+	if(depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) m_DepthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+	uint32_t width      = std::max(m_DepthExtent.width / 2, 1u);
+	uint32_t height     = std::max(m_DepthExtent.height / 2, 1u);
+	uint32_t levelCount = std::min(static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1, MAX_PYRAMID_LEVELS);
+
+	m_Pyramid = std::make_unique<Image>(m_Device, width, height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+
+	m_PyramidLevelViews.resize(levelCount);
+	for(uint32_t level = 0; level < levelCount; level++) {
+		VkImageViewCreateInfo viewInfo {};
+		viewInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image            = m_Pyramid->GetImage();
+		viewInfo.viewType         = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format           = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+		if(vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &m_PyramidLevelViews[level]) != VK_SUCCESS) { throw std::runtime_error("failed to create depth pyramid view!"); }
+	}
+
+	for(uint32_t i = 0; i < m_Frames.size(); i++) m_Frames[i].depthImage = swapchain.GetDepthImage(i);
+
+	CreateDescriptorSets();
+
+	m_RenderExtent = m_DepthExtent;
+
+	// The visibility of the old depth images says nothing about the new ones
+	m_ClearVisibility = true;
+}
+
+void OcclusionCuller::DestroyPyramid() {
+	for(VkImageView view : m_PyramidLevelViews) vkDestroyImageView(m_Device.GetDevice(), view, nullptr);
+	m_PyramidLevelViews.clear();
+	m_PyramidLevelSets.clear();
+	m_Pyramid.reset();
+}
+
+void OcclusionCuller::CreateDescriptorSets() {
+	m_Pool->ResetPool();
+
+	m_PyramidLevelSets.assign(m_PyramidLevelViews.size(), VK_NULL_HANDLE);
+	for(uint32_t level = 1; level < m_PyramidLevelViews.size(); level++) {
+		VkDescriptorImageInfo source {m_Sampler, m_PyramidLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+		VkDescriptorImageInfo destination {VK_NULL_HANDLE, m_PyramidLevelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+
+		DescriptorWriter writer(*m_PyramidSetLayout, *m_Pool);
+		writer.WriteImage(0, &source);
+		writer.WriteImage(1, &destination);
+		if(!writer.Build(m_PyramidLevelSets[level])) { throw std::runtime_error("failed to allocate depth pyramid descriptor set!"); }
+	}
+
+	for(auto& frame : m_Frames) {
+		VkDescriptorImageInfo source {m_Sampler, frame.depthImage->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+		VkDescriptorImageInfo destination {VK_NULL_HANDLE, m_PyramidLevelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+
+		DescriptorWriter writer(*m_PyramidSetLayout, *m_Pool);
+		writer.WriteImage(0, &source);
+		writer.WriteImage(1, &destination);
+		if(!writer.Build(frame.pyramidSet)) { throw std::runtime_error("failed to allocate depth pyramid descriptor set!"); }
+
+		frame.cullSet = VK_NULL_HANDLE;
+		WriteCullSet(frame);
+	}
+}
+
+/**
+ * @brief Points the frame's culling set at its current buffers, allocates the set if it has none yet
+ */
+void OcclusionCuller::WriteCullSet(Frame& frame) {
+	frame.visibility = m_Visibility;
+
+	// Without a pyramid there is nothing to bind yet, the set is written once the swapchain exists
+	if(!m_Pyramid) return;
+
+	VkDescriptorBufferInfo objects    = frame.objects->DescriptorInfo();
+	VkDescriptorBufferInfo earlyDraws = frame.earlyDraws->DescriptorInfo();
+	VkDescriptorBufferInfo lateDraws  = frame.lateDraws->DescriptorInfo();
+	VkDescriptorBufferInfo visibility = frame.visibility->DescriptorInfo();
+	VkDescriptorBufferInfo stats      = frame.stats->DescriptorInfo();
+	VkDescriptorImageInfo pyramid {m_Sampler, m_Pyramid->GetImageView(), VK_IMAGE_LAYOUT_GENERAL};
+
+	DescriptorWriter writer(*m_CullSetLayout, *m_Pool);
+	writer.WriteBuffer(0, &objects);
+	writer.WriteBuffer(1, &earlyDraws);
+	writer.WriteBuffer(2, &lateDraws);
+	writer.WriteBuffer(3, &visibility);
+	writer.WriteBuffer(4, &stats);
+	writer.WriteImage(5, &pyramid);
+
+	if(frame.cullSet == VK_NULL_HANDLE) {
+		if(!writer.Build(frame.cullSet)) { throw std::runtime_error("failed to allocate culling descriptor set!"); }
+	}
+	else writer.Overwrite(frame.cullSet);
+}
+
+/**
+ * @brief Replaces the frame's buffers with larger ones, keeping the objects added so far. Only the current frame grows,
+ * the GPU is done with its buffers.
+ */
+void OcclusionCuller::GrowFrame(Frame& frame, uint32_t capacity) {
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	auto objects    = std::make_unique<Buffer>(m_Device, sizeof(CullObject), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	auto earlyDraws = std::make_unique<Buffer>(m_Device, sizeof(VkDrawIndexedIndirectCommand), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible);
+	auto lateDraws  = std::make_unique<Buffer>(m_Device, sizeof(VkDrawIndexedIndirectCommand), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, hostVisible);
+	objects->Map();
+	earlyDraws->Map();
+	lateDraws->Map();
+
+	if(frame.objects) {
+		std::memcpy(objects->GetMappedMemory(), frame.objects->GetMappedMemory(), frame.objectCount * sizeof(CullObject));
+		std::memcpy(earlyDraws->GetMappedMemory(), frame.earlyDraws->GetMappedMemory(), frame.objectCount * sizeof(VkDrawIndexedIndirectCommand));
+		std::memcpy(lateDraws->GetMappedMemory(), frame.lateDraws->GetMappedMemory(), frame.objectCount * sizeof(VkDrawIndexedIndirectCommand));
+	}
+	else {
+		frame.stats = std::make_unique<Buffer>(m_Device, sizeof(Stats), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		frame.stats->Map();
+		std::memset(frame.stats->GetMappedMemory(), 0, sizeof(Stats));
+	}
+
+	frame.objects    = std::move(objects);
+	frame.earlyDraws = std::move(earlyDraws);
+	frame.lateDraws  = std::move(lateDraws);
+	frame.capacity   = capacity;
+
+	if(frame.cullSet != VK_NULL_HANDLE) WriteCullSet(frame);
+}
+
+/**
+ * @brief The visibility buffer is shared by all frames. It only grows when objects are created, and without waiting for
+ * the GPU: the frames in flight keep the old buffer alive and their sets are only rewritten in their next BeginFrame,
+ * after their fence was waited on.
+ */
+void OcclusionCuller::GrowVisibility(uint32_t capacity) {
+	m_Visibility         = std::make_shared<Buffer>(m_Device, sizeof(uint32_t), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	m_VisibilityCapacity = capacity;
+	m_ClearVisibility    = true;
+
+	WriteCullSet(m_Frames[m_FrameIndex]);
+}
+
+/**
+ * @brief Reads the results of the last frame that used these buffers, the frame's fence was waited on
+ */
+void OcclusionCuller::BeginFrame(uint32_t frameIndex) {
+	m_FrameIndex = frameIndex;
+	Frame& frame = m_Frames[m_FrameIndex];
+
+	// The visibility buffer grew while this frame was in flight
+	if(frame.visibility != m_Visibility) WriteCullSet(frame);
+
+	Stats stats;
+	std::memcpy(&stats, frame.stats->GetMappedMemory(), sizeof(Stats));
+	m_LastObjectCount    = frame.objectCount;
+	m_LastDrawnObjects   = stats.drawnObjects;
+	m_LastDrawnTriangles = stats.drawnTriangles;
+
+	std::memset(frame.stats->GetMappedMemory(), 0, sizeof(Stats));
+	frame.objectCount = 0;
+}
+
+uint32_t OcclusionCuller::AddObject(uint32_t visibilityIndex, const glm::vec3& center, float radius, const Model::Lod& lod) {
+	Frame& frame = m_Frames[m_FrameIndex];
+	if(frame.objectCount == frame.capacity) GrowFrame(frame, frame.capacity * 2);
+	if(visibilityIndex >= m_VisibilityCapacity) GrowVisibility(std::max(m_VisibilityCapacity * 2, visibilityIndex + 1));
+
+	uint32_t draw = frame.objectCount++;
+
+	CullObject object {};
+	object.sphere          = glm::vec4(center, radius);
+	object.visibilityIndex = visibilityIndex;
+	static_cast<CullObject*>(frame.objects->GetMappedMemory())[draw] = object;
+
+	// The instance counts are filled in by the culling passes
+	VkDrawIndexedIndirectCommand command {};
+	command.indexCount    = lod.indexCount;
+	command.instanceCount = 0;
+	command.firstIndex    = lod.firstIndex;
+	command.vertexOffset  = 0;
+	command.firstInstance = 0;
+	static_cast<VkDrawIndexedIndirectCommand*>(frame.earlyDraws->GetMappedMemory())[draw] = command;
+	static_cast<VkDrawIndexedIndirectCommand*>(frame.lateDraws->GetMappedMemory())[draw]  = command;
+
+	return draw;
+}
+
+void OcclusionCuller::Dispatch(VkCommandBuffer commandBuffer, bool late) {
+	Frame& frame = m_Frames[m_FrameIndex];
+
+	m_Push.objectCount = frame.objectCount;
+	m_Push.late        = late ? 1 : 0;
+
+	m_CullPipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_CullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &m_Push);
+	vkCmdDispatch(commandBuffer, (frame.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+/**
+ * @brief Sets the instance count of every object that was visible last frame and is in the frustum
+ */
+void OcclusionCuller::CullEarly(VkCommandBuffer commandBuffer, const glm::mat4& view, const glm::mat4& projection, VkExtent2D renderExtent) {
+	// Planes of a symmetric frustum in view space, only the right and bottom ones are needed since the test mirrors x and y
+	glm::vec2 right  = glm::normalize(glm::vec2(projection[0][0], 1.0f));
+	glm::vec2 bottom = glm::normalize(glm::vec2(projection[1][1], 1.0f));
+	m_Push.view      = view;
+	m_Push.frustum   = glm::vec4(right, bottom);
+	m_Push.P00       = projection[0][0];
+	m_Push.P11       = projection[1][1];
+	m_Push.P22       = projection[2][2];
+	m_Push.P32       = projection[3][2];
+	m_Push.depthSize = {static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height)};
+	m_RenderExtent   = renderExtent;
+
+	// The late pass of the previous frame wrote the visibility
+	VkMemoryBarrier barrier {};
+	barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	if(m_ClearVisibility) {
+		vkCmdFillBuffer(commandBuffer, m_Visibility->GetBuffer(), 0, VK_WHOLE_SIZE, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		m_ClearVisibility = false;
+	}
+
+	Dispatch(commandBuffer, false);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+	                     nullptr);
+}
+
+/**
+ * @brief Reduces the depth buffer of the early pass into the pyramid, the depth buffer is left readable by shaders
+ */
+void OcclusionCuller::BuildDepthPyramid(VkCommandBuffer commandBuffer) {
+	Frame& frame = m_Frames[m_FrameIndex];
+
+	std::array<VkImageMemoryBarrier, 2> barriers {};
+	barriers[0].sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[0].srcAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	barriers[0].dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+	barriers[0].oldLayout           = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	barriers[0].newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].image               = frame.depthImage->GetImage();
+	barriers[0].subresourceRange    = {m_DepthAspect, 0, 1, 0, 1};
+
+	// Last frame's pyramid is not needed anymore, the previous culling pass only has to be done reading it
+	barriers[1].sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[1].srcAccessMask       = 0;
+	barriers[1].dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+	barriers[1].oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+	barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].image               = m_Pyramid->GetImage();
+	barriers[1].subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_Pyramid->GetMipLevels(), 0, 1};
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	m_PyramidPipeline->Bind(commandBuffer);
+
+	// Only the part of the pyramid that covers the rendered part of the depth image is built
+	PyramidPushConstants push {};
+	push.sourceSize      = glm::ivec2(m_RenderExtent.width, m_RenderExtent.height);
+	push.destinationSize = glm::max(push.sourceSize / 2, glm::ivec2(1));
+	for(uint32_t level = 0; level < m_PyramidLevelViews.size(); level++) {
+		VkDescriptorSet set = level == 0 ? frame.pyramidSet : m_PyramidLevelSets[level];
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PyramidPipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_PyramidPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidPushConstants), &push);
+		vkCmdDispatch(commandBuffer, (push.destinationSize.x + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+		              (push.destinationSize.y + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+
+		// The next level reads this one, and the culling reads all of them
+		VkMemoryBarrier barrier {};
+		barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		push.sourceSize      = push.destinationSize;
+		push.destinationSize = glm::max(push.sourceSize / 2, glm::ivec2(1));
+	}
+}
+
+/**
+ * @brief Builds the pyramid from the early pass, tests every object against it and sets the instance count of the ones that
+ * weren't drawn early but are visible. The depth buffer is handed back to the late pass as an attachment.
+ */
+void OcclusionCuller::CullLate(VkCommandBuffer commandBuffer) {
+	BuildDepthPyramid(commandBuffer);
+
+	Dispatch(commandBuffer, true);
+
+	// The late pass loads the color and depth the early pass left behind
+	VkMemoryBarrier barrier {};
+	barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkImageMemoryBarrier depthBarrier {};
+	depthBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	depthBarrier.srcAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+	depthBarrier.dstAccessMask       = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depthBarrier.oldLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	depthBarrier.newLayout           = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.image               = m_Frames[m_FrameIndex].depthImage->GetImage();
+	depthBarrier.subresourceRange    = {m_DepthAspect, 0, 1, 0, 1};
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+	                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0,
+	                     1, &barrier, 0, nullptr, 1, &depthBarrier);
+}
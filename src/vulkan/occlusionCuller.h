@@ -0,0 +1,149 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+#include "image.h"
+#include "model.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Two pass occlusion culling on the GPU against a hierarchical depth pyramid.
+ *
+ * Every frame the objects are added with their bounding sphere and the LOD to draw, each one gets an indexed
+ * indirect draw whose instance count is set by a compute shader:
+ *  - the early pass draws the objects that were visible last frame (and are in the frustum),
+ *  - the depth pyramid is built from the depth buffer of the early pass,
+ *  - the late pass tests every object against the pyramid, draws the ones that became visible since and stores the
+ *    result for the early pass of the next frame.
+ * Objects behind others are rejected before they are rasterized or shaded, while objects that just came out from
+ * behind something are still drawn in the frame they appear.
+ */
+class OcclusionCuller {
+public:
+	OcclusionCuller(Device& device);
+	~OcclusionCuller();
+
+	OcclusionCuller(const OcclusionCuller&)            = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	// Recreates the depth pyramid for the depth images of a new swapchain
+	void Resize(Swapchain& swapchain);
+
+	// Starts filling the buffers of `frameIndex`, the GPU has to be done with the frame that used them last
+	void BeginFrame(uint32_t frameIndex);
+
+	/**
+	 * @param visibilityIndex Stable index of the object across frames, its visibility is remembered under it
+	 * @param center Center of the bounding sphere relative to the camera
+	 * @return Index of the object's draw in the early and late draw buffers
+	 */
+	uint32_t AddObject(uint32_t visibilityIndex, const glm::vec3& center, float radius, const Model::Lod& lod);
+
+	// `view` only rotates, the object centers are already relative to the camera. `renderExtent` is the part of the depth
+	// images the geometry passes render to this frame.
+	void CullEarly(VkCommandBuffer commandBuffer, const glm::mat4& view, const glm::mat4& projection, VkExtent2D renderExtent);
+	// Has to be recorded after the early pass, outside of any render pass
+	void CullLate(VkCommandBuffer commandBuffer);
+
+	inline VkBuffer GetEarlyDrawBuffer() const { return m_Frames[m_FrameIndex].earlyDraws->GetBuffer(); }
+
+	inline VkBuffer GetLateDrawBuffer() const { return m_Frames[m_FrameIndex].lateDraws->GetBuffer(); }
+
+	static constexpr VkDeviceSize GetDrawOffset(uint32_t draw) { return draw * sizeof(VkDrawIndexedIndirectCommand); }
+
+	// Results of the last frame that finished on the GPU
+	inline uint32_t GetObjectCount() const { return m_LastObjectCount; }
+
+	inline uint32_t GetDrawnObjectCount() const { return m_LastDrawnObjects; }
+
+	inline uint32_t GetDrawnTriangleCount() const { return m_LastDrawnTriangles; }
+
+private:
+	struct CullObject {
+		glm::vec4 sphere;
+		uint32_t visibilityIndex;
+		uint32_t padding[3];
+	};
+
+	struct Stats {
+		uint32_t drawnObjects;
+		uint32_t drawnTriangles;
+	};
+
+	struct CullPushConstants {
+		glm::mat4 view;
+		glm::vec4 frustum;
+		float P00, P11, P22, P32;
+		uint32_t objectCount;
+		uint32_t late;
+		glm::vec2 depthSize;
+	};
+
+	struct PyramidPushConstants {
+		glm::ivec2 sourceSize;    // only the top left of the images is used when rendering below full resolution
+		glm::ivec2 destinationSize;
+	};
+
+	struct Frame {
+		std::unique_ptr<Buffer> objects;
+		std::unique_ptr<Buffer> earlyDraws;
+		std::unique_ptr<Buffer> lateDraws;
+		std::unique_ptr<Buffer> stats;
+		uint32_t capacity    = 0;
+		uint32_t objectCount = 0;
+
+		VkDescriptorSet cullSet    = VK_NULL_HANDLE;
+		VkDescriptorSet pyramidSet = VK_NULL_HANDLE;    // reads this frame's depth image into level 0
+		std::shared_ptr<Image> depthImage;
+		std::shared_ptr<Buffer> visibility;    // the one cullSet points at, an older one stays alive until the frame is done with it
+	};
+
+	void CreatePipelines();
+	void CreateSampler();
+	void CreateDescriptorSets();
+	void WriteCullSet(Frame& frame);
+	void GrowFrame(Frame& frame, uint32_t capacity);
+	void GrowVisibility(uint32_t capacity);
+	void BuildDepthPyramid(VkCommandBuffer commandBuffer);
+	void DestroyPyramid();
+	void Dispatch(VkCommandBuffer commandBuffer, bool late);
+
+	Device& m_Device;
+
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_CullSetLayout;
+	std::shared_ptr<DescriptorSetLayout> m_PyramidSetLayout;
+	VkPipelineLayout m_CullPipelineLayout;
+	VkPipelineLayout m_PyramidPipelineLayout;
+	std::unique_ptr<Pipeline> m_CullPipeline;
+	std::unique_ptr<Pipeline> m_PyramidPipeline;
+	VkSampler m_Sampler;
+
+	std::array<Frame, Swapchain::MAX_FRAMES_IN_FLIGHT> m_Frames;
+	uint32_t m_FrameIndex = 0;
+
+	// One flag per visibility index, written by the late pass and read by the next early pass
+	std::shared_ptr<Buffer> m_Visibility;
+	uint32_t m_VisibilityCapacity = 0;
+	bool m_ClearVisibility        = false;
+
+	std::unique_ptr<Image> m_Pyramid;
+	std::vector<VkImageView> m_PyramidLevelViews;
+	std::vector<VkDescriptorSet> m_PyramidLevelSets;    // level n - 1 into level n, level 0 comes from the frame's set
+	VkExtent2D m_DepthExtent {};
+	VkExtent2D m_RenderExtent {};
+	VkImageAspectFlags m_DepthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+	CullPushConstants m_Push {};
+
+	uint32_t m_LastObjectCount    = 0;
+	uint32_t m_LastDrawnObjects   = 0;
+	uint32_t m_LastDrawnTriangles = 0;
+};
@@ -1,9 +1,10 @@
 #include "pipeline.h"
 
+#include "../mappedFile.h"
 #include "../utilities.h"
 
+#include <array>
 #include <cassert>
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 
@@ -12,16 +13,12 @@ Pipeline::Pipeline(Device& device): m_Device(device) {}
 Pipeline::~Pipeline() { vkDestroyPipeline(m_Device.GetDevice(), m_Pipeline, nullptr); }
 
 std::vector<char> Pipeline::ReadFile(const std::string& filepath) {
-	std::ifstream file(filepath, std::ios::ate | std::ios::binary);    // ate goes to the end of the file so reading filesize is easier and binary avoids text transformation
-	if(!file.is_open()) { throw std::runtime_error("failed to open file: " + filepath); }
+	// Goes through MappedFile so shaders are read from the asset pack when one is mounted
+	MappedFile file;
+	if(!file.Open(filepath)) { throw std::runtime_error("failed to open file: " + filepath); }
 
-	size_t fileSize = (size_t) (file.tellg());    // tellg gets current position in file
-	std::vector<char> buffer(fileSize);
-	file.seekg(0);    // return to the begining of the file
-	file.read(buffer.data(), fileSize);
-
-	file.close();
-	return buffer;
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+	return std::vector<char>(data, data + file.GetSize());
 }
 
 void Pipeline::CreateShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule) {
@@ -34,7 +31,7 @@ void Pipeline::CreateShaderModule(const std::vector<char>& code, VkShaderModule*
 	if(vkCreateShaderModule(m_Device.GetDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) { throw std::runtime_error("failed to create shader module"); }
 }
 
-void Pipeline::Bind(VkCommandBuffer commandBuffer) { vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline); }
+void Pipeline::Bind(VkCommandBuffer commandBuffer) { vkCmdBindPipeline(commandBuffer, m_BindPoint, m_Pipeline); }
 
 PipelineConfigInfo Pipeline::CreatePipelineConfigInfo(PipelineConfigInfo& configInfo, uint32_t width, uint32_t height, VkPrimitiveTopology topology, VkCullModeFlags cullMode, bool depthTestEnable, bool blendingEnable) {
 	configInfo.inputAssemblyInfo.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -159,6 +156,13 @@ void Pipeline::CreatePipeline(const std::string& vertexPath, const std::string&
 	viewportInfo.scissorCount  = 1;
 	viewportInfo.pScissors     = &configInfo.scissor;
 
+	// The geometry is rendered at a resolution that changes from frame to frame, the render passes set both
+	std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
+	dynamicStateInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicStateInfo.pDynamicStates    = dynamicStates.data();
+
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineInfo.stageCount                   = 2;
@@ -169,7 +173,7 @@ void Pipeline::CreatePipeline(const std::string& vertexPath, const std::string&
 	pipelineInfo.pRasterizationState          = &configInfo.rasterizationInfo;
 	pipelineInfo.pMultisampleState            = &configInfo.multisampleInfo;
 	pipelineInfo.pColorBlendState             = &configInfo.colorBlendInfo;
-	pipelineInfo.pDynamicState                = nullptr;
+	pipelineInfo.pDynamicState                = &dynamicStateInfo;
 	pipelineInfo.pDepthStencilState           = &configInfo.depthStencilInfo;
 
 	pipelineInfo.layout     = configInfo.pipelineLayout;
@@ -184,6 +188,26 @@ void Pipeline::CreatePipeline(const std::string& vertexPath, const std::string&
 	vkDestroyShaderModule(m_Device.GetDevice(), fragmentShaderModule, nullptr);
 }
 
+void Pipeline::CreateComputePipeline(const std::string& computePath, VkPipelineLayout pipelineLayout) {
+	auto computeCode = ReadFile(computePath);
+
+	VkShaderModule computeShaderModule;
+	CreateShaderModule(computeCode, &computeShaderModule);
+
+	VkComputePipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeShaderModule;
+	pipelineInfo.stage.pName  = "main";
+	pipelineInfo.layout       = pipelineLayout;
+
+	if(vkCreateComputePipelines(m_Device.GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline) != VK_SUCCESS) { throw std::runtime_error("failed to create compute pipeline!"); }
+	vkDestroyShaderModule(m_Device.GetDevice(), computeShaderModule, nullptr);
+
+	m_BindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+}
+
 void Pipeline::CreatePipelineLayout(Device& device, std::vector<VkDescriptorSetLayout>& descriptorSetsLayouts, VkPipelineLayout& pipelineLayout, VkPushConstantRange* pushConstants) {
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
 	pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
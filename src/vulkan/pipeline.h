@@ -5,6 +5,11 @@
 #include <string>
 #include <vector>
 
+// Where the compiled shaders are, the build points it at its output when it compiles them itself
+#ifndef SHADER_DIRECTORY
+#	define SHADER_DIRECTORY "../../shaders/spv/"
+#endif
+
 struct PipelineConfigInfo {
 	VkViewport viewport;
 	VkRect2D scissor;
@@ -33,6 +38,7 @@ public:
 	void CreatePipeline(const std::string& vertexPath, const std::string& fragmentPath, const PipelineConfigInfo& configInfo,
 	                    std::vector<VkVertexInputBindingDescription> bindingDesc     = std::vector<VkVertexInputBindingDescription>(),
 	                    std::vector<VkVertexInputAttributeDescription> attributeDesc = std::vector<VkVertexInputAttributeDescription>());
+	void CreateComputePipeline(const std::string& computePath, VkPipelineLayout pipelineLayout);
 	static void CreatePipelineLayout(Device& device, std::vector<VkDescriptorSetLayout>& descriptorSetsLayouts, VkPipelineLayout& pipelineLayout, VkPushConstantRange* pushConstants);
 
 private:
@@ -42,4 +48,5 @@ private:
 
 	Device& m_Device;
 	VkPipeline m_Pipeline;
+	VkPipelineBindPoint m_BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 };
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "postProcess.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static constexpr uint32_t GROUP_SIZE         = 8;
+static constexpr uint32_t MAX_BLOOM_LEVELS   = 6;
+static constexpr uint32_t MAX_SWAPCHAIN_SETS = 8;
+static constexpr VkFormat BLOOM_FORMAT       = VK_FORMAT_R16G16B16A16_SFLOAT;
+static constexpr uint32_t MAX_SETS           = Swapchain::MAX_FRAMES_IN_FLIGHT * 2 + MAX_BLOOM_LEVELS * 2 + MAX_SWAPCHAIN_SETS;
+
+static constexpr float BLOOM_THRESHOLD = 1.0f;
+static constexpr float BLOOM_KNEE      = 0.5f;
+
+PostProcess::PostProcess(Device& device): m_Device(device) {
+	m_Pool = DescriptorPool::Builder(m_Device)
+	             .SetMaxSets(MAX_SETS)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_SETS * 2)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_SETS)
+	             .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+	             .Build();
+
+	m_AutoExposure = std::make_unique<AutoExposure>(m_Device);
+
+	CreateSampler();
+	CreatePipelines();
+}
+
+PostProcess::~PostProcess() {
+	DestroyBloom();
+	vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_BloomPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(m_Device.GetDevice(), m_TonemapPipelineLayout, nullptr);
+}
+
+void PostProcess::CreateSampler() {
+	// The bloom filters rely on bilinear taps between texels
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter    = VK_FILTER_LINEAR;
+	samplerInfo.minFilter    = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod       = 0.0f;
+	if(vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS) { throw std::runtime_error("failed to create post process sampler!"); }
+}
+
+void PostProcess::CreatePipelines() {
+	//
+	// Bloom
+	//
+	{
+		auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+		layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_BloomSetLayout = layoutBuilder.Build();
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(BloomPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_BloomSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_BloomPipelineLayout, &pushConstantRange);
+
+		m_DownsamplePipeline = std::make_unique<Pipeline>(m_Device);
+		m_DownsamplePipeline->CreateComputePipeline(SHADER_DIRECTORY "bloomDownsample.comp.spv", m_BloomPipelineLayout);
+
+		m_UpsamplePipeline = std::make_unique<Pipeline>(m_Device);
+		m_UpsamplePipeline->CreateComputePipeline(SHADER_DIRECTORY "bloomUpsample.comp.spv", m_BloomPipelineLayout);
+	}
+
+	//
+	// Tonemapping
+	//
+	{
+		auto layoutBuilder = DescriptorSetLayout::Builder(m_Device);
+		layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		layoutBuilder.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		layoutBuilder.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_TonemapSetLayout = layoutBuilder.Build();
+
+		auto outputLayoutBuilder = DescriptorSetLayout::Builder(m_Device);
+		outputLayoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+		m_OutputSetLayout = outputLayoutBuilder.Build();
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset     = 0;
+		pushConstantRange.size       = sizeof(TonemapPushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts {m_TonemapSetLayout->GetDescriptorSetLayout(), m_OutputSetLayout->GetDescriptorSetLayout()};
+		Pipeline::CreatePipelineLayout(m_Device, descriptorSetLayouts, m_TonemapPipelineLayout, &pushConstantRange);
+
+		m_TonemapPipeline = std::make_unique<Pipeline>(m_Device);
+		m_TonemapPipeline->CreateComputePipeline(SHADER_DIRECTORY "tonemap.comp.spv", m_TonemapPipelineLayout);
+	}
+}
+
+/**
+ * @brief Only called right after the swapchain was recreated, so the GPU is idle
+ */
+void PostProcess::Resize(Swapchain& swapchain) {
+	DestroyBloom();
+	m_AutoExposure->Resize(swapchain);
+
+	m_Extent = swapchain.GetSwapchainExtent();
+	m_OutputImages.resize(swapchain.GetImageCount());
+	for(uint32_t i = 0; i < m_OutputImages.size(); i++) m_OutputImages[i] = swapchain.GetPresentableImage(i);
+	if(m_OutputImages.size() > MAX_SWAPCHAIN_SETS) { throw std::runtime_error("too many swap chain images for the post processing!"); }
+
+	// Bloom starts at half resolution, the chain stops before the levels get smaller than a few texels
+	VkExtent2D extent   = {std::max(m_Extent.width / 2, 1u), std::max(m_Extent.height / 2, 1u)};
+	uint32_t levelCount = 1;
+	while(levelCount < MAX_BLOOM_LEVELS && std::min(extent.width, extent.height) >> levelCount >= 4) levelCount++;
+
+	m_Bloom = std::make_unique<Image>(m_Device, extent.width, extent.height, BLOOM_FORMAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+
+	m_BloomLevelViews.resize(levelCount);
+	m_BloomLevelExtents.resize(levelCount);
+	for(uint32_t level = 0; level < levelCount; level++) {
+		m_BloomLevelExtents[level] = {std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u)};
+
+		VkImageViewCreateInfo viewInfo {};
+		viewInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image            = m_Bloom->GetImage();
+		viewInfo.viewType         = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format           = BLOOM_FORMAT;
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+		if(vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &m_BloomLevelViews[level]) != VK_SUCCESS) { throw std::runtime_error("failed to create bloom view!"); }
+	}
+
+	CreateDescriptorSets(swapchain);
+}
+
+void PostProcess::DestroyBloom() {
+	for(VkImageView view : m_BloomLevelViews) vkDestroyImageView(m_Device.GetDevice(), view, nullptr);
+	m_BloomLevelViews.clear();
+	m_BloomLevelExtents.clear();
+	m_Bloom.reset();
+}
+
+void PostProcess::CreateDescriptorSets(Swapchain& swapchain) {
+	m_Pool->ResetPool();
+
+	auto writeBloomSet = [&](VkImageView source, VkImageLayout sourceLayout, VkImageView destination, VkDescriptorSet& set) {
+		VkDescriptorImageInfo sourceInfo {m_Sampler, source, sourceLayout};
+		VkDescriptorImageInfo destinationInfo {VK_NULL_HANDLE, destination, VK_IMAGE_LAYOUT_GENERAL};
+
+		DescriptorWriter writer(*m_BloomSetLayout, *m_Pool);
+		writer.WriteImage(0, &sourceInfo);
+		writer.WriteImage(1, &destinationInfo);
+		if(!writer.Build(set)) { throw std::runtime_error("failed to allocate bloom descriptor set!"); }
+	};
+
+	uint32_t levelCount = static_cast<uint32_t>(m_BloomLevelViews.size());
+	m_DownsampleSets.assign(levelCount, VK_NULL_HANDLE);
+	m_UpsampleSets.assign(levelCount, VK_NULL_HANDLE);
+	for(uint32_t level = 1; level < levelCount; level++) {
+		writeBloomSet(m_BloomLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, m_BloomLevelViews[level], m_DownsampleSets[level]);
+		writeBloomSet(m_BloomLevelViews[level], VK_IMAGE_LAYOUT_GENERAL, m_BloomLevelViews[level - 1], m_UpsampleSets[level - 1]);
+	}
+
+	VkDescriptorBufferInfo exposureInfo = m_AutoExposure->GetExposureBufferInfo();
+	for(uint32_t frame = 0; frame < Swapchain::MAX_FRAMES_IN_FLIGHT; frame++) {
+		VkImageView hdr = swapchain.GetHdrImage(frame)->GetImageView();
+		writeBloomSet(hdr, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_BloomLevelViews[0], m_HdrDownsampleSets[frame]);
+
+		VkDescriptorImageInfo hdrInfo {m_Sampler, hdr, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+		VkDescriptorImageInfo bloomInfo {m_Sampler, m_BloomLevelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+
+		DescriptorWriter writer(*m_TonemapSetLayout, *m_Pool);
+		writer.WriteImage(0, &hdrInfo);
+		writer.WriteImage(1, &bloomInfo);
+		writer.WriteBuffer(2, &exposureInfo);
+		if(!writer.Build(m_TonemapSets[frame])) { throw std::runtime_error("failed to allocate tonemap descriptor set!"); }
+	}
+
+	m_OutputSets.assign(m_OutputImages.size(), VK_NULL_HANDLE);
+	for(uint32_t image = 0; image < m_OutputImages.size(); image++) {
+		VkDescriptorImageInfo outputInfo {VK_NULL_HANDLE, swapchain.GetPresentableImageView(image), VK_IMAGE_LAYOUT_GENERAL};
+
+		DescriptorWriter writer(*m_OutputSetLayout, *m_Pool);
+		writer.WriteImage(0, &outputInfo);
+		if(!writer.Build(m_OutputSets[image])) { throw std::runtime_error("failed to allocate tonemap descriptor set!"); }
+	}
+}
+
+void PostProcess::Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex, VkExtent2D renderExtent, float exposure, float deltaTime) {
+	uint32_t levelCount   = static_cast<uint32_t>(m_BloomLevelViews.size());
+	glm::vec2 renderScale = {static_cast<float>(renderExtent.width) / m_Extent.width, static_cast<float>(renderExtent.height) / m_Extent.height};
+
+	// Keeps adapting while turned off, so turning it back on doesn't start from a stale exposure
+	m_AutoExposure->Record(commandBuffer, frameIndex, renderExtent, deltaTime);
+
+	// Compute writes have to be visible to the next pass, which reads them through a sampler
+	VkMemoryBarrier barrier {};
+	barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	// Last frame's bloom is not needed anymore, its tonemapping only has to be done reading it
+	VkImageMemoryBarrier bloomBarrier {};
+	bloomBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	bloomBarrier.srcAccessMask       = 0;
+	bloomBarrier.dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+	bloomBarrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+	bloomBarrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+	bloomBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bloomBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bloomBarrier.image               = m_Bloom->GetImage();
+	bloomBarrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &bloomBarrier);
+
+	//
+	// Bloom downsample
+	//
+	BloomPushConstants push {};
+	push.threshold = BLOOM_THRESHOLD;
+	push.knee      = BLOOM_KNEE;
+
+	m_DownsamplePipeline->Bind(commandBuffer);
+	for(uint32_t level = 0; level < levelCount; level++) {
+		VkDescriptorSet set = level == 0 ? m_HdrDownsampleSets[frameIndex] : m_DownsampleSets[level];
+		push.prefilter      = level == 0 ? 1 : 0;
+		push.sourceScale    = level == 0 ? renderScale : glm::vec2(1.0f);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_BloomPipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_BloomPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BloomPushConstants), &push);
+		vkCmdDispatch(commandBuffer, (m_BloomLevelExtents[level].width + GROUP_SIZE - 1) / GROUP_SIZE, (m_BloomLevelExtents[level].height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	//
+	// Bloom upsample, every level adds the blurred level below it
+	//
+	m_UpsamplePipeline->Bind(commandBuffer);
+	for(int level = static_cast<int>(levelCount) - 2; level >= 0; level--) {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_BloomPipelineLayout, 0, 1, &m_UpsampleSets[level], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_BloomPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BloomPushConstants), &push);
+		vkCmdDispatch(commandBuffer, (m_BloomLevelExtents[level].width + GROUP_SIZE - 1) / GROUP_SIZE, (m_BloomLevelExtents[level].height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	//
+	// Tonemapping
+	//
+	// The swapchain image is only acquired once the color output stage is reached, that's where the submit waits for it
+	VkImageMemoryBarrier outputBarrier {};
+	outputBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	outputBarrier.srcAccessMask       = 0;
+	outputBarrier.dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+	outputBarrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+	outputBarrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+	outputBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarrier.image               = m_OutputImages[imageIndex];
+	outputBarrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &outputBarrier);
+
+	// Every bloom level adds about as much light as the first one
+	TonemapPushConstants tonemapPush {};
+	tonemapPush.exposure        = exposure;
+	tonemapPush.bloomStrength   = m_BloomStrength / static_cast<float>(levelCount);
+	tonemapPush.useAutoExposure = m_AutoExposureEnabled ? 1 : 0;
+	tonemapPush.renderScale     = renderScale;
+
+	std::array<VkDescriptorSet, 2> sets = {m_TonemapSets[frameIndex], m_OutputSets[imageIndex]};
+	m_TonemapPipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_TonemapPipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_TonemapPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(TonemapPushConstants), &tonemapPush);
+	vkCmdDispatch(commandBuffer, (m_Extent.width + GROUP_SIZE - 1) / GROUP_SIZE, (m_Extent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+}
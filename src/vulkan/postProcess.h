@@ -0,0 +1,99 @@
+#pragma once
+
+#include "autoExposure.h"
+#include "descriptors.h"
+#include "device.h"
+#include "image.h"
+#include "pipeline.h"
+#include "swapchain.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Compute post processing from the HDR geometry target to the swapchain image.
+ *
+ * Bloom runs at half resolution and below: the bright parts of the HDR image are downsampled through a mip chain with
+ * a 13 tap filter, then every level is blurred back up into the one above it with a tent filter that reads a tile of
+ * the smaller level from shared memory. The tonemapping adds the bloom, applies the exposure and writes the result
+ * straight into the swapchain image, by default with the exposure the AutoExposure adapted to the HDR image. When the
+ * geometry was rendered below the swapchain resolution it is upscaled on the way with a sharp bicubic filter whose
+ * overshoot is clamped to the neighbouring texels, so edges don't ring.
+ */
+class PostProcess {
+public:
+	PostProcess(Device& device);
+	~PostProcess();
+
+	PostProcess(const PostProcess&)            = delete;
+	PostProcess& operator=(const PostProcess&) = delete;
+
+	// Recreates the bloom chain for the HDR and swapchain images of a new swapchain
+	void Resize(Swapchain& swapchain);
+
+	// Has to be recorded after the geometry passes and before the UI pass, outside of any render pass. `renderExtent` is
+	// the top left part of the HDR image the geometry was rendered to. The exposure is only used when the auto exposure is
+	// turned off.
+	void Record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex, VkExtent2D renderExtent, float exposure, float deltaTime);
+
+	// How much of the bloom is added to the image
+	inline float& GetBloomStrength() { return m_BloomStrength; }
+
+	inline bool& GetAutoExposureEnabled() { return m_AutoExposureEnabled; }
+
+	inline AutoExposure& GetAutoExposure() { return *m_AutoExposure; }
+
+private:
+	struct BloomPushConstants {
+		float threshold;
+		float knee;
+		uint32_t prefilter;    // only the first downsample removes everything below the threshold
+		uint32_t padding;
+		glm::vec2 sourceScale;    // the rendered part of the HDR image in uv, 1 for the bloom levels
+	};
+
+	struct TonemapPushConstants {
+		float exposure;
+		float bloomStrength;
+		uint32_t useAutoExposure;
+		uint32_t padding;
+		glm::vec2 renderScale;    // the rendered part of the HDR image in uv
+	};
+
+	void CreateSampler();
+	void CreatePipelines();
+	void CreateDescriptorSets(Swapchain& swapchain);
+	void DestroyBloom();
+
+	Device& m_Device;
+
+	std::unique_ptr<AutoExposure> m_AutoExposure;
+	std::unique_ptr<DescriptorPool> m_Pool;
+	std::shared_ptr<DescriptorSetLayout> m_BloomSetLayout;
+	std::shared_ptr<DescriptorSetLayout> m_TonemapSetLayout;
+	std::shared_ptr<DescriptorSetLayout> m_OutputSetLayout;
+	VkPipelineLayout m_BloomPipelineLayout;
+	VkPipelineLayout m_TonemapPipelineLayout;
+	std::unique_ptr<Pipeline> m_DownsamplePipeline;
+	std::unique_ptr<Pipeline> m_UpsamplePipeline;
+	std::unique_ptr<Pipeline> m_TonemapPipeline;
+	VkSampler m_Sampler;
+
+	VkExtent2D m_Extent {};
+	std::vector<VkImage> m_OutputImages;
+
+	std::unique_ptr<Image> m_Bloom;
+	std::vector<VkImageView> m_BloomLevelViews;
+	std::vector<VkExtent2D> m_BloomLevelExtents;
+	std::vector<VkDescriptorSet> m_DownsampleSets;    // level n - 1 into level n, level 0 is read from the frame's HDR image
+	std::vector<VkDescriptorSet> m_UpsampleSets;      // level n + 1 into level n
+
+	std::array<VkDescriptorSet, Swapchain::MAX_FRAMES_IN_FLIGHT> m_HdrDownsampleSets {};
+	std::array<VkDescriptorSet, Swapchain::MAX_FRAMES_IN_FLIGHT> m_TonemapSets {};
+	std::vector<VkDescriptorSet> m_OutputSets;    // one per swapchain image
+
+	float m_BloomStrength      = 0.5f;
+	bool m_AutoExposureEnabled = true;
+};
@@ -15,7 +15,7 @@ Sampler::Sampler(Device& device): m_Device(device)
 	samplerInfo.mipLodBias              = 0.0f;
 	samplerInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
 	samplerInfo.minLod                  = 0.0f;
-	samplerInfo.maxLod                  = 0.0f;
+	samplerInfo.maxLod                  = VK_LOD_CLAMP_NONE;    // the image views limit it to the levels each texture has
 	samplerInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 	samplerInfo.maxAnisotropy           = m_Device.GetDeviceProperties().limits.maxSamplerAnisotropy;
 	samplerInfo.anisotropyEnable        = VK_TRUE;
@@ -6,8 +6,8 @@
 #include <algorithm>
 #include <array>
 
-Skybox::Skybox(Device& device, const std::string& folderPath): m_Device(device) {
-	m_SkyboxModel = Model::CreateModelFromFile(m_Device, "../../assets/models/cube.obj");
+Skybox::Skybox(Device& device, AssetStreamer& streamer, const std::string& folderPath): m_Device(device), m_Streamer(streamer) {
+	m_SkyboxModel = m_Streamer.LoadModel("../../assets/models/cube.obj");
 
 	std::array<std::string, 6> filepaths;
 	int fileCount = 0;
@@ -20,5 +20,6 @@ Skybox::Skybox(Device& device, const std::string& folderPath): m_Device(device)
 	ASSERT(fileCount == 6);
 	std::sort(filepaths.begin(), filepaths.end());
 
-	m_Cubemap.CreateImageFromTexture(filepaths);
+	m_Filepaths = filepaths;
+	m_Cubemap   = m_Streamer.LoadCubemap(filepaths);
 }
\ No newline at end of file
@@ -1,24 +1,35 @@
 #pragma once
 
 #include "../vulkan/model.h"
+#include "assetStreamer.h"
 #include "cubemap.h"
 #include "device.h"
 
+#include <array>
 #include <memory>
+#include <string>
 
 class Skybox {
 public:
-	Skybox(Device& device, const std::string& folderPath);
+	Skybox(Device& device, AssetStreamer& streamer, const std::string& folderPath);
 	~Skybox() = default;
 
-	inline Cubemap& GetCubemap() { return m_Cubemap; }
+	// Both return the streamer placeholders until the real ones are loaded
+	inline Cubemap& GetCubemap() { return m_Cubemap->IsReady() ? *m_Cubemap->Get() : m_Streamer.GetPlaceholderCubemap(); }
 
-	inline Model* GetSkyboxModel() { return m_SkyboxModel.get(); }
+	inline Model* GetSkyboxModel() { return m_SkyboxModel->IsReady() ? m_SkyboxModel->Get() : &m_Streamer.GetPlaceholderModel(); }
+
+	inline bool IsCubemapReady() const { return m_Cubemap->IsReady(); }
+
+	// The faces in the order they are uploaded
+	inline const std::array<std::string, 6>& GetFilepaths() const { return m_Filepaths; }
 
 private:
 	Device& m_Device;
-	std::unique_ptr<Model> m_SkyboxModel;
+	AssetStreamer& m_Streamer;
+	std::shared_ptr<Asset<Model>> m_SkyboxModel;
 	glm::mat4 m_ModelTransform;
 
-	Cubemap m_Cubemap {m_Device};
+	std::array<std::string, 6> m_Filepaths;
+	std::shared_ptr<Asset<Cubemap>> m_Cubemap;
 };
\ No newline at end of file
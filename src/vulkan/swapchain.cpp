@@ -10,20 +10,23 @@
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
 
-Swapchain::Swapchain(Device& deviceRef, VkExtent2D windowExtent): m_Device(deviceRef), m_WindowExtent(windowExtent) {
+Swapchain::Swapchain(Device& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings): m_Device(deviceRef), m_WindowExtent(windowExtent), m_Settings(settings) {
 	CreateSwapchain();
 	CreateImageViews();
 	CreateRenderPass();
 	CreateDepthResources();
+	CreateHdrResources();
 	CreateFramebuffers();
 	CreateSyncObjects();
 }
 
-Swapchain::Swapchain(Device& deviceRef, VkExtent2D windowExtent, std::shared_ptr<Swapchain> previousSwapchain): m_Device(deviceRef), m_WindowExtent(windowExtent), m_OldSwapchain(previousSwapchain) {
+Swapchain::Swapchain(Device& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings, std::shared_ptr<Swapchain> previousSwapchain):
+	m_OldSwapchain(previousSwapchain), m_Device(deviceRef), m_WindowExtent(windowExtent), m_Settings(settings) {
 	CreateSwapchain();
 	CreateImageViews();
 	CreateRenderPass();
 	CreateDepthResources();
+	CreateHdrResources();
 	CreateFramebuffers();
 	CreateSyncObjects();
 
@@ -40,8 +43,11 @@ Swapchain::~Swapchain() {
 	}
 
 	for(auto framebuffer : m_SwapchainFramebuffers) { vkDestroyFramebuffer(m_Device.GetDevice(), framebuffer, nullptr); }
+	for(auto framebuffer : m_UiFramebuffers) { vkDestroyFramebuffer(m_Device.GetDevice(), framebuffer, nullptr); }
 
 	vkDestroyRenderPass(m_Device.GetDevice(), m_GeometryRenderPass, nullptr);
+	vkDestroyRenderPass(m_Device.GetDevice(), m_GeometryLateRenderPass, nullptr);
+	vkDestroyRenderPass(m_Device.GetDevice(), m_UiRenderPass, nullptr);
 	vkDestroyRenderPass(m_Device.GetDevice(), m_ShadowMapRenderPass, nullptr);
 
 	// cleanup synchronization objects
@@ -65,29 +71,15 @@ VkSurfaceFormatKHR Swapchain::ChooseSwapSurfaceFormat(const std::vector<VkSurfac
 
 /**
  * @brief Chooses how to present images to Screen
- * @brief Mailbox - Most efficent one, address the screen tearing issue in immediate mode. (not supported by Linux)
+ * @brief Mailbox - Replaces the queued image with the newest one, no tearing and no waiting for v-sync. (not supported by every Linux driver)
  * @brief Immediate - Presents images on screen as fast as possible. Possible screen tearing.
- * @brief V-Sync (FIFO) - Synchronizes presenting images with monitor refresh rate.
+ * @brief V-Sync (FIFO) - Synchronizes presenting images with monitor refresh rate. Always supported.
+ * @brief FIFO relaxed - V-Sync, but a late image is presented right away and may tear.
 */
-VkPresentModeKHR Swapchain::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-	// for (const auto &availablePresentMode : availablePresentModes)
-	// {
-	//     if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-	//     {
-	//         std::cout << "Present mode: Mailbox" << std::endl;
-	//         return availablePresentMode;
-	//     }
-	// }
-	// for (const auto &availablePresentMode : availablePresentModes)
-	// {
-	//    if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-	//    {
-	//        std::cout << "Present mode: Immediate" << std::endl;
-	//        return availablePresentMode;
-	//    }
-	// }
-
-	std::cout << "Present mode: V-Sync" << std::endl;
+VkPresentModeKHR Swapchain::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, VkPresentModeKHR requested) {
+	if(std::find(availablePresentModes.begin(), availablePresentModes.end(), requested) != availablePresentModes.end()) { return requested; }
+
+	std::cout << "Present mode " << requested << " not supported, falling back to V-Sync" << std::endl;
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -103,15 +95,25 @@ VkExtent2D Swapchain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilit
 }
 
 void Swapchain::CreateSwapchain() {
+	if(m_Device.IsHeadless()) {
+		CreateOffscreenImages();
+		return;
+	}
+
 	SwapchainSupportDetails swapChainSupport = m_Device.GetSwapchainSupport();
 
 	VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-	VkPresentModeKHR presentMode     = ChooseSwapPresentMode(swapChainSupport.presentModes);
+	VkPresentModeKHR presentMode     = ChooseSwapPresentMode(swapChainSupport.presentModes, m_Settings.presentMode);
 	VkExtent2D extent                = ChooseSwapExtent(swapChainSupport.capabilities);
 
-	uint32_t imageCount = MAX_FRAMES_IN_FLIGHT;
+	m_Settings.framesInFlight = std::clamp<uint32_t>(m_Settings.framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
+	m_PresentMode             = presentMode;
+
+	uint32_t imageCount = std::max(m_Settings.imageCount, swapChainSupport.capabilities.minImageCount);
 	if(swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) { imageCount = swapChainSupport.capabilities.maxImageCount; }
 
+	if(!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT)) { throw std::runtime_error("swap chain images can't be used as storage images!"); }
+
 	VkSwapchainCreateInfoKHR createInfo {};
 	createInfo.sType   = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 	createInfo.surface = m_Device.GetSurface();
@@ -121,7 +123,7 @@ void Swapchain::CreateSwapchain() {
 	createInfo.imageColorSpace  = surfaceFormat.colorSpace;
 	createInfo.imageExtent      = extent;
 	createInfo.imageArrayLayers = 1;
-	createInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	createInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;    // the tonemapping writes the images from a compute shader
 
 	QueueFamilyIndices indices    = m_Device.FindPhysicalQueueFamilies();
 	uint32_t queueFamilyIndices[] = {indices.graphicsFamily, indices.presentFamily};
@@ -156,6 +158,27 @@ void Swapchain::CreateSwapchain() {
 	m_SwapchainExtent      = extent;
 }
 
+/**
+ * @brief Headless the frames are rendered into plain images, one per frame in flight so that frame's fence guards it
+ */
+void Swapchain::CreateOffscreenImages() {
+	m_Settings.framesInFlight = std::clamp<uint32_t>(m_Settings.framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
+	m_PresentMode             = VK_PRESENT_MODE_FIFO_KHR;
+
+	m_SwapchainImageFormat = m_Device.FindSupportedFormat({VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM}, VK_IMAGE_TILING_OPTIMAL,
+	                                                      VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+	m_SwapchainExtent      = m_WindowExtent;
+
+	m_OffscreenImages.resize(m_Settings.framesInFlight);
+	m_PresentableImages.resize(m_Settings.framesInFlight);
+	for(uint32_t i = 0; i < m_Settings.framesInFlight; i++) {
+		m_OffscreenImages[i]   = std::make_shared<Image>(m_Device, m_SwapchainExtent.width, m_SwapchainExtent.height, m_SwapchainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+		                                                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		                                                 VK_IMAGE_ASPECT_COLOR_BIT);
+		m_PresentableImages[i] = m_OffscreenImages[i]->GetImage();
+	}
+}
+
 void Swapchain::CreateImageViews() {
 	m_PresentableImageViews.resize(m_PresentableImages.size());
 
@@ -178,15 +201,17 @@ void Swapchain::CreateImageViews() {
 void Swapchain::CreateRenderPass() {
 	// Geometry Pass
 	{
+		m_HdrFormat = FindHdrFormat();
+
 		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format                  = GetSwapchainImageFormat();
+		colorAttachment.format                  = m_HdrFormat;
 		colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
 		colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;    // the late pass continues drawing
 
 		VkAttachmentReference colorAttachmentRef = {};
 		colorAttachmentRef.attachment            = 0;
@@ -196,7 +221,7 @@ void Swapchain::CreateRenderPass() {
 		depthAttachment.format         = FindDepthFormat();
 		depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
 		depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;    // read by the depth pyramid
 		depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depthAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -234,6 +259,74 @@ void Swapchain::CreateRenderPass() {
 		{ 
 			throw std::runtime_error("failed to create render pass!"); 
 		}
+
+		// Late geometry pass, draws the objects the occlusion culling found after the early pass
+		colorAttachment.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.finalLayout   = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;    // read by the post processing
+		depthAttachment.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.storeOp       = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachments                   = {colorAttachment, depthAttachment};
+
+		// The compute passes after it read the color
+		VkSubpassDependency postDependency = {};
+		postDependency.srcSubpass          = 0;
+		postDependency.dstSubpass          = VK_SUBPASS_EXTERNAL;
+		postDependency.srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		postDependency.srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		postDependency.dstStageMask        = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		postDependency.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+		renderPassInfo.dependencyCount     = 1;
+		renderPassInfo.pDependencies       = &postDependency;
+
+		if(vkCreateRenderPass(m_Device.GetDevice(), &renderPassInfo, nullptr, &m_GeometryLateRenderPass) != VK_SUCCESS) 
+		{ 
+			throw std::runtime_error("failed to create render pass!"); 
+		}
+	}
+	// UI pass
+	{
+		VkAttachmentDescription colorAttachment = {};
+		colorAttachment.format                  = GetSwapchainImageFormat();
+		colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_LOAD;
+		colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_GENERAL;    // written by the tonemapping
+		colorAttachment.finalLayout             = m_Device.IsHeadless() ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;    // the present layout needs the swapchain extension
+
+		VkAttachmentReference colorAttachmentRef = {};
+		colorAttachmentRef.attachment            = 0;
+		colorAttachmentRef.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments    = &colorAttachmentRef;
+
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass          = 0;
+		dependency.srcStageMask        = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependency.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+		dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount        = 1;
+		renderPassInfo.pAttachments           = &colorAttachment;
+		renderPassInfo.subpassCount           = 1;
+		renderPassInfo.pSubpasses             = &subpass;
+		renderPassInfo.dependencyCount        = 1;
+		renderPassInfo.pDependencies          = &dependency;
+
+		if(vkCreateRenderPass(m_Device.GetDevice(), &renderPassInfo, nullptr, &m_UiRenderPass) != VK_SUCCESS) 
+		{ 
+			throw std::runtime_error("failed to create render pass!"); 
+		}
 	}
 	// Shadow map pass
 	{
@@ -295,11 +388,19 @@ VkFormat Swapchain::FindDepthFormat() {
 	return m_Device.FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
 }
 
+/**
+ * @brief Packed 32 bit float format when it can be blended into, half floats take twice the bandwidth
+ */
+VkFormat Swapchain::FindHdrFormat() {
+	return m_Device.FindSupportedFormat({VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_R16G16B16A16_SFLOAT}, VK_IMAGE_TILING_OPTIMAL,
+	                                    VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
 void Swapchain::CreateFramebuffers() {
-	// Geometry pass
-	m_SwapchainFramebuffers.resize(GetImageCount());
-	for(size_t i = 0; i < GetImageCount(); i++) {
-		std::array<VkImageView, 2> attachments = {m_PresentableImageViews[i], m_PresentableDepthImages[i]->GetImageView()};
+	// Geometry pass, one per frame in flight like the HDR and depth images
+	m_SwapchainFramebuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		std::array<VkImageView, 2> attachments = {m_HdrImages[i]->GetImageView(), m_PresentableDepthImages[i]->GetImageView()};
 
 		VkFramebufferCreateInfo framebufferInfo = {};
 		framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -313,8 +414,23 @@ void Swapchain::CreateFramebuffers() {
 		if(vkCreateFramebuffer(m_Device.GetDevice(), &framebufferInfo, nullptr, &m_SwapchainFramebuffers[i]) != VK_SUCCESS) { throw std::runtime_error("failed to create framebuffer!"); }
 	}
 
+	// UI pass, one per swapchain image
+	m_UiFramebuffers.resize(GetImageCount());
+	for(size_t i = 0; i < GetImageCount(); i++) {
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass              = m_UiRenderPass;
+		framebufferInfo.attachmentCount         = 1;
+		framebufferInfo.pAttachments            = &m_PresentableImageViews[i];
+		framebufferInfo.width                   = m_SwapchainExtent.width;
+		framebufferInfo.height                  = m_SwapchainExtent.height;
+		framebufferInfo.layers                  = 1;
+
+		if(vkCreateFramebuffer(m_Device.GetDevice(), &framebufferInfo, nullptr, &m_UiFramebuffers[i]) != VK_SUCCESS) { throw std::runtime_error("failed to create framebuffer!"); }
+	}
+
 	// Shadow map
-	for(size_t i = 0; i < GetImageCount(); i++)
+	for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		std::vector<FramebufferAttachment> attachments;
 		attachments.push_back({FramebufferAttachment::Depth});
@@ -328,22 +444,44 @@ void Swapchain::CreateDepthResources() {
 	m_SwapchainDepthFormat     = FindDepthFormat();
 	VkExtent2D swapChainExtent = GetSwapchainExtent();
 
-	m_PresentableDepthImages.resize(GetImageCount());
+	// Indexed by the frame in flight, not by the swapchain image
+	m_PresentableDepthImages.resize(MAX_FRAMES_IN_FLIGHT);
 
-	for(int i = 0; i < GetImageCount(); i++) {
+	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		m_PresentableDepthImages[i] = std::make_shared<Image>(m_Device, swapChainExtent.width, swapChainExtent.height, m_SwapchainDepthFormat, VK_IMAGE_TILING_OPTIMAL,
-		                                                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+		                                                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
     }
 }
 
+void Swapchain::CreateHdrResources() {
+	VkExtent2D swapChainExtent = GetSwapchainExtent();
+
+	m_HdrImages.resize(MAX_FRAMES_IN_FLIGHT);
+	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		m_HdrImages[i] = std::make_shared<Image>(m_Device, swapChainExtent.width, swapChainExtent.height, m_HdrFormat, VK_IMAGE_TILING_OPTIMAL,
+		                                         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+}
+
 /**
  * @brief Synchronizes CPU-GPU work, submits command buffer into graphics queue and presents image 
 */
-VkResult Swapchain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
+VkResult Swapchain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t frameIndex, uint32_t* imageIndex) {
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType        = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores        = m_ImageAvailableSemaphores[m_CurrentFrame];
+	// Headless there is nothing to wait for or to present, the fence is all the synchronization
+	if(m_Device.IsHeadless()) {
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers    = buffers;
+
+		std::lock_guard<std::mutex> lock(m_Device.GetGraphicsQueueMutex());
+		vkResetFences(m_Device.GetDevice(), 1, &m_InFlightFences[frameIndex]);
+		if(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[frameIndex]) != VK_SUCCESS) { throw std::runtime_error("failed to submit draw command buffer!"); }
+		return VK_SUCCESS;
+	}
+
+	VkSemaphore waitSemaphores        = m_ImageAvailableSemaphores[frameIndex];
 	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 	submitInfo.waitSemaphoreCount     = 1;
 	submitInfo.pWaitSemaphores        = &waitSemaphores;
@@ -352,12 +490,15 @@ VkResult Swapchain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers    = buffers;
 
-	VkSemaphore signalSemaphores    = m_RenderFinishedSemaphores[m_CurrentFrame];
+	VkSemaphore signalSemaphores    = m_RenderFinishedSemaphores[frameIndex];
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores    = &signalSemaphores;
 
-	vkResetFences(m_Device.GetDevice(), 1, &m_InFlightFences[m_CurrentFrame]);
-	if(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS) { throw std::runtime_error("failed to submit draw command buffer!"); }
+	// Uploads may submit to the same queue from other threads
+	std::lock_guard<std::mutex> lock(m_Device.GetGraphicsQueueMutex());
+
+	vkResetFences(m_Device.GetDevice(), 1, &m_InFlightFences[frameIndex]);
+	if(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, m_InFlightFences[frameIndex]) != VK_SUCCESS) { throw std::runtime_error("failed to submit draw command buffer!"); }
 
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -373,8 +514,6 @@ VkResult Swapchain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 
 	auto result = vkQueuePresentKHR(m_Device.GetPresentQueue(), &presentInfo);
 
-	m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-
 	return result;
 }
 
@@ -385,14 +524,29 @@ VkResult Swapchain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_
  *
  * @return Returns result of Acquiring image from swapchain
 */
-VkResult Swapchain::AcquireNextImage(uint32_t* imageIndex) {
-	vkWaitForFences(m_Device.GetDevice(), 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+VkResult Swapchain::AcquireNextImage(uint32_t frameIndex, uint32_t* imageIndex) {
+	WaitForFrame(frameIndex);
+
+	if(m_Device.IsHeadless()) {
+		*imageIndex = frameIndex;
+		return VK_SUCCESS;
+	}
 
-	VkResult result = vkAcquireNextImageKHR(m_Device.GetDevice(), m_Swapchain, std::numeric_limits<uint64_t>::max(), m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, imageIndex);
+	VkResult result = vkAcquireNextImageKHR(m_Device.GetDevice(), m_Swapchain, std::numeric_limits<uint64_t>::max(), m_ImageAvailableSemaphores[frameIndex], VK_NULL_HANDLE, imageIndex);
 
 	return result;
 }
 
+/**
+ * @brief Blocks until the GPU finished the last frame submitted with `frameIndex`
+*/
+void Swapchain::WaitForFrame(uint32_t frameIndex) { vkWaitForFences(m_Device.GetDevice(), 1, &m_InFlightFences[frameIndex], VK_TRUE, UINT64_MAX); }
+
+/**
+ * @brief Blocks until the GPU finished every frame submitted so far, the fences of unused frames are created signaled
+*/
+void Swapchain::WaitForFrames() { vkWaitForFences(m_Device.GetDevice(), static_cast<uint32_t>(m_InFlightFences.size()), m_InFlightFences.data(), VK_TRUE, UINT64_MAX); }
+
 /**
  * @brief Creates objects for explicit synchronization
 */
@@ -425,4 +579,9 @@ VkFramebuffer Swapchain::GetGeometryFrameBuffer(int index)
 VkFramebuffer Swapchain::GetShadowMapFrameBuffer(int index) 
 { 
 	return m_ShadowMapFramebuffer[index]->GetFramebuffer(); 
+}
+
+VkFramebuffer Swapchain::GetUiFrameBuffer(uint32_t imageIndex) 
+{ 
+	return m_UiFramebuffers[imageIndex]; 
 }
\ No newline at end of file
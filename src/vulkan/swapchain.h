@@ -8,21 +8,36 @@
 #include <vector>
 #include <vulkan/vulkan.h>
 
+/**
+ * @brief How the swapchain presents, changing any of it recreates the swapchain
+ */
+struct PresentSettings {
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;    // falls back to FIFO when the surface doesn't support it
+	uint32_t imageCount          = 2;                           // clamped to what the surface allows
+	uint32_t framesInFlight      = 2;                           // 1 to MAX_FRAMES_IN_FLIGHT
+};
+
 class Swapchain {
 public:
-	static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-	Swapchain(Device& deviceRef, VkExtent2D windowExtent);
-	Swapchain(Device& deviceRef, VkExtent2D windowExtent, std::shared_ptr<Swapchain> previousSwapchain);
+	// Per frame resources everywhere are allocated for this many frames, PresentSettings::framesInFlight of them are used
+	static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+	Swapchain(Device& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings);
+	Swapchain(Device& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings, std::shared_ptr<Swapchain> previousSwapchain);
 	~Swapchain();
 
 	Swapchain(const Swapchain&)            = delete;
 	Swapchain& operator=(const Swapchain&) = delete;
 
 	VkRenderPass GetGeometryRenderPass() { return m_GeometryRenderPass; }
+	// Same attachments as the geometry pass, loads what it left behind and leaves the HDR image to the post processing
+	VkRenderPass GetGeometryLateRenderPass() { return m_GeometryLateRenderPass; }
+	// Draws on top of the tonemapped swapchain image and presents it
+	VkRenderPass GetUiRenderPass() { return m_UiRenderPass; }
 	VkRenderPass GetShadowMapRenderPass() { return m_ShadowMapRenderPass; }
 
 	VkFramebuffer GetGeometryFrameBuffer(int index);
 	VkFramebuffer GetShadowMapFrameBuffer(int index);
+	VkFramebuffer GetUiFrameBuffer(uint32_t imageIndex);
 
 	uint32_t GetWidth() { return m_SwapchainExtent.width; }
 
@@ -30,12 +45,32 @@ public:
 
 	VkFormat GetSwapchainImageFormat() { return m_SwapchainImageFormat; }
 
+	VkFormat GetDepthFormat() { return m_SwapchainDepthFormat; }
+
+	std::shared_ptr<Image> GetDepthImage(int index) { return m_PresentableDepthImages[index]; }
+
+	VkFormat GetHdrFormat() { return m_HdrFormat; }
+
+	std::shared_ptr<Image> GetHdrImage(int index) { return m_HdrImages[index]; }
+
+	VkImage GetPresentableImage(uint32_t imageIndex) { return m_PresentableImages[imageIndex]; }
+
+	VkImageView GetPresentableImageView(uint32_t imageIndex) { return m_PresentableImageViews[imageIndex]; }
+
 	size_t GetImageCount() { return m_PresentableImageViews.size(); }
 
 	VkExtent2D GetSwapchainExtent() { return m_SwapchainExtent; }
 
-	VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
-	VkResult AcquireNextImage(uint32_t* imageIndex);
+	// The present mode that was actually picked
+	VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
+
+	uint32_t GetFramesInFlight() const { return m_Settings.framesInFlight; }
+
+	// `frameIndex` is the frame in flight, the caller cycles it through GetFramesInFlight()
+	VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t frameIndex, uint32_t* imageIndex);
+	VkResult AcquireNextImage(uint32_t frameIndex, uint32_t* imageIndex);
+	void WaitForFrame(uint32_t frameIndex);
+	void WaitForFrames();
 
 	bool CompareSwapFormats(const Swapchain& swapChain) const { return swapChain.m_SwapchainDepthFormat == m_SwapchainDepthFormat && swapChain.m_SwapchainImageFormat == m_SwapchainImageFormat; }
 
@@ -43,27 +78,34 @@ public:
 
 private:
 	void CreateSwapchain();
+	void CreateOffscreenImages();
 	void CreateImageViews();
 	void CreateDepthResources();
+	void CreateHdrResources();
 	void CreateRenderPass();
 	void CreateFramebuffers();
 	void CreateSyncObjects();
 
 	VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-	VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+	VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, VkPresentModeKHR requested);
 	VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 	VkFormat FindDepthFormat();
+	VkFormat FindHdrFormat();
 
 	std::shared_ptr<Swapchain> m_OldSwapchain;
-	VkSwapchainKHR m_Swapchain;
+	VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
 	Device& m_Device;
 	VkExtent2D m_WindowExtent;
+	PresentSettings m_Settings;
+	VkPresentModeKHR m_PresentMode;
 
-	size_t m_CurrentFrame = 0;
 	std::vector<VkFramebuffer> m_SwapchainFramebuffers;
 
 	std::vector<std::shared_ptr<Image>> m_PresentableDepthImages;
+	std::vector<std::shared_ptr<Image>> m_HdrImages;    // geometry is rendered here, the post processing writes the swapchain images
+	std::vector<VkFramebuffer> m_UiFramebuffers;
 	std::vector<VkImage> m_PresentableImages;
+	std::vector<std::shared_ptr<Image>> m_OffscreenImages;    // headless only, they own m_PresentableImages
 	std::vector<VkImageView> m_PresentableImageViews;
 
 	std::vector<std::shared_ptr<Framebuffer>> m_ShadowMapFramebuffer; // this has to be a pointer for some unknown to mankind reason...
@@ -74,8 +116,11 @@ private:
 
 	VkFormat m_SwapchainImageFormat;
 	VkFormat m_SwapchainDepthFormat;
+	VkFormat m_HdrFormat;
 	VkExtent2D m_SwapchainExtent;
 
 	VkRenderPass m_GeometryRenderPass;
+	VkRenderPass m_GeometryLateRenderPass;
+	VkRenderPass m_UiRenderPass;
 	VkRenderPass m_ShadowMapRenderPass;
 };
\ No newline at end of file
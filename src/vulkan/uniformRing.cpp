@@ -0,0 +1,64 @@
+#include "uniformRing.h"
+
+#include "../utilities.h"
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @param frameCount Number of regions, has to cover every frame the GPU and the CPU can be working on at the same time
+ */
+UniformRing::UniformRing(Device& device, DescriptorPool& pool, uint32_t frameCount, VkDeviceSize bytesPerFrame): m_Device(device), m_FrameCount(frameCount) {
+	m_Alignment     = std::max<VkDeviceSize>(m_Device.GetDeviceProperties().limits.minUniformBufferOffsetAlignment, 16);
+	m_BytesPerFrame = (bytesPerFrame + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+	// The descriptor range is read starting at the dynamic offset, so the last push needs MAX_PUSH_SIZE bytes behind it
+	VkDeviceSize size = m_BytesPerFrame * m_FrameCount + MAX_PUSH_SIZE;
+	m_Buffer          = std::make_unique<Buffer>(m_Device, size, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	m_Buffer->Map();
+
+	m_DescriptorSetLayout = CreateDescriptorSetLayout(m_Device);
+
+	VkDescriptorBufferInfo bufferInfo = m_Buffer->DescriptorInfo(MAX_PUSH_SIZE, 0);
+	DescriptorWriter writer(*m_DescriptorSetLayout, pool);
+	writer.WriteBuffer(0, &bufferInfo);
+	if(!writer.Build(m_DescriptorSet)) { throw std::runtime_error("failed to allocate uniform ring descriptor set!"); }
+
+	m_Frame = m_FrameCount - 1;
+	BeginFrame();
+}
+
+/**
+ * @brief Layout of the ring descriptor set, pipelines that read from the ring have to use it for that set
+ */
+std::shared_ptr<DescriptorSetLayout> UniformRing::CreateDescriptorSetLayout(Device& device) {
+	auto layoutBuilder = DescriptorSetLayout::Builder(device);
+	layoutBuilder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+	return layoutBuilder.Build();
+}
+
+/**
+ * @brief Moves to the next frame region. The region is only reused after frameCount frames, by then the GPU is done reading it.
+ */
+void UniformRing::BeginFrame() {
+	m_Frame      = (m_Frame + 1) % m_FrameCount;
+	m_FrameStart = m_Frame * m_BytesPerFrame;
+	m_Head       = m_FrameStart;
+}
+
+/**
+ * @brief Copies `data` into the current frame region
+ *
+ * @return Dynamic offset of the data
+ */
+uint32_t UniformRing::Push(const void* data, VkDeviceSize size) {
+	ASSERT(size <= MAX_PUSH_SIZE);    // Won't be visible through the descriptor range
+
+	if(m_Head + size > m_FrameStart + m_BytesPerFrame) { throw std::runtime_error("uniform ring frame region is full!"); }
+
+	VkDeviceSize offset = m_Head;
+	memcpy(static_cast<char*>(m_Buffer->GetMappedMemory()) + offset, data, static_cast<size_t>(size));
+	m_Head = (offset + size + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+	return static_cast<uint32_t>(offset);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "buffer.h"
+#include "descriptors.h"
+#include "device.h"
+
+#include <memory>
+
+/**
+ * @brief Persistently mapped ring of per-frame uniform data bound with dynamic offsets.
+ *
+ * The buffer is split into one region per frame the CPU can be working on. Every frame
+ * BeginFrame() moves to the next region and Push() copies a struct into it, returning the
+ * offset to pass to vkCmdBindDescriptorSets. All pushes share one descriptor set with a single
+ * UNIFORM_BUFFER_DYNAMIC binding, so no Uniform or descriptor set has to be created per frame.
+ * The memory is host coherent, so no flush is needed after writing.
+ */
+class UniformRing {
+public:
+	// Range of the dynamic descriptor, every pushed struct has to fit in it
+	static constexpr VkDeviceSize MAX_PUSH_SIZE = 1024;
+
+	UniformRing(Device& device, DescriptorPool& pool, uint32_t frameCount, VkDeviceSize bytesPerFrame = 64 * 1024);
+	~UniformRing() = default;
+
+	UniformRing(const UniformRing&)            = delete;
+	UniformRing& operator=(const UniformRing&) = delete;
+
+	static std::shared_ptr<DescriptorSetLayout> CreateDescriptorSetLayout(Device& device);
+
+	void BeginFrame();
+	uint32_t Push(const void* data, VkDeviceSize size);
+
+	template <typename T> inline uint32_t Push(const T& data) { return Push(&data, sizeof(T)); }
+
+	inline VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+
+	inline VkDeviceSize GetFrameUsage() const { return m_Head - m_FrameStart; }
+
+private:
+	Device& m_Device;
+
+	std::unique_ptr<Buffer> m_Buffer;
+	std::shared_ptr<DescriptorSetLayout> m_DescriptorSetLayout;
+	VkDescriptorSet m_DescriptorSet;
+
+	uint32_t m_FrameCount;
+	uint32_t m_Frame = 0;
+	VkDeviceSize m_BytesPerFrame;
+	VkDeviceSize m_Alignment;
+	VkDeviceSize m_FrameStart = 0;
+	VkDeviceSize m_Head       = 0;
+};
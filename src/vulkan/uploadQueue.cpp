@@ -0,0 +1,461 @@
+#include "uploadQueue.h"
+
+#include "../utilities.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// Everything an uploaded resource can be used as afterwards
+static constexpr VkAccessFlags UPLOAD_DST_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+UploadQueue::UploadQueue(Device& device): m_Device(device) {
+	QueueFamilyIndices indices = m_Device.FindPhysicalQueueFamilies();
+	m_TransferFamily           = indices.transferFamily;
+	m_GraphicsFamily           = indices.graphicsFamily;
+	m_SeparateFamilies         = m_TransferFamily != m_GraphicsFamily;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex        = m_TransferFamily;
+	poolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	if(vkCreateCommandPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_TransferCommandPool) != VK_SUCCESS) { throw std::runtime_error("failed to create transfer command pool!"); }
+
+	if(m_SeparateFamilies) {
+		poolInfo.queueFamilyIndex = m_GraphicsFamily;
+		if(vkCreateCommandPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_AcquireCommandPool) != VK_SUCCESS) { throw std::runtime_error("failed to create acquire command pool!"); }
+	}
+
+	/*
+        A timeline semaphore is a single 64 bit counter that the GPU bumps when a submission finishes.
+        Each batch signals its own value, so one semaphore can answer "is batch N done?" for every batch
+        without a fence per submission, and the CPU can wait on (or just poll) any value.
+    */
+	VkSemaphoreTypeCreateInfo timelineInfo = {};
+	timelineInfo.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue              = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext                 = &timelineInfo;
+	if(vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &m_Timeline) != VK_SUCCESS) { throw std::runtime_error("failed to create upload timeline semaphore!"); }
+
+	// Signals from two queues can execute in any order, so each queue gets its own timeline to keep the values increasing
+	if(m_SeparateFamilies && vkCreateSemaphore(m_Device.GetDevice(), &semaphoreInfo, nullptr, &m_TransferTimeline) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create transfer timeline semaphore!");
+	}
+
+	m_Ring = std::make_unique<Buffer>(m_Device, RING_SIZE, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	m_Ring->Map();
+
+	BeginBatch();
+}
+
+UploadQueue::~UploadQueue() {
+	WaitIdle();
+
+	m_InFlight.clear();
+	m_FreeBatches.clear();
+	m_Recording = {};
+	m_Ring.reset();
+
+	// Destroying the pools frees every command buffer allocated from them
+	vkDestroyCommandPool(m_Device.GetDevice(), m_TransferCommandPool, nullptr);
+	if(m_AcquireCommandPool != VK_NULL_HANDLE) vkDestroyCommandPool(m_Device.GetDevice(), m_AcquireCommandPool, nullptr);
+	vkDestroySemaphore(m_Device.GetDevice(), m_Timeline, nullptr);
+	if(m_TransferTimeline != VK_NULL_HANDLE) vkDestroySemaphore(m_Device.GetDevice(), m_TransferTimeline, nullptr);
+}
+
+/**
+ * @brief Copies `data` to the staging ring and records a copy into `dstBuffer`.
+ * The buffer must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT and must not be used before the batch completed.
+ */
+void UploadQueue::UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+	if(size == 0) return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VkBuffer stagingBuffer;
+	VkDeviceSize stagingOffset;
+	void* mapped;
+	AllocateStaging(size, 16, stagingBuffer, stagingOffset, mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
+
+	VkBufferCopy copyRegion {};
+	copyRegion.srcOffset = stagingOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size      = size;
+	vkCmdCopyBuffer(m_Recording.transferCommandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+
+	// Only needed to hand the buffer over to the graphics family, otherwise a single global barrier covers every buffer
+	if(m_SeparateFamilies) {
+		VkBufferMemoryBarrier barrier {};
+		barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		barrier.buffer              = dstBuffer;
+		barrier.offset              = dstOffset;
+		barrier.size                = size;
+		m_Recording.bufferBarriers.push_back(barrier);
+	}
+
+	m_Recording.empty = false;
+}
+
+/**
+ * @brief Copies `data` to the staging ring and records the copy into `image`.
+ * The image is moved from UNDEFINED to TRANSFER_DST for the copy and ends up in `finalLayout`.
+ *
+ * @param regions Copy regions, bufferOffset is relative to `data`
+ * @param generateMips Fill the levels of `subresourceRange` after the first one by blitting down from level 0,
+ * the image needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT and a format that supports linear blits
+ */
+void UploadQueue::UploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange,
+                              VkImageLayout finalLayout, bool generateMips) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VkBuffer stagingBuffer;
+	VkDeviceSize stagingOffset;
+	void* mapped;
+	AllocateStaging(size, std::max<VkDeviceSize>(16, m_Device.GetDeviceProperties().limits.optimalBufferCopyOffsetAlignment), stagingBuffer, stagingOffset, mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
+
+	VkImageMemoryBarrier barrier {};
+	barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image               = image;
+	barrier.subresourceRange    = subresourceRange;
+	barrier.srcAccessMask       = 0;
+	barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(m_Recording.transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	std::vector<VkBufferImageCopy> stagingRegions = regions;
+	for(auto& region : stagingRegions) region.bufferOffset += stagingOffset;
+	vkCmdCopyBufferToImage(m_Recording.transferCommandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(stagingRegions.size()), stagingRegions.data());
+
+	m_Recording.empty = false;
+
+	if(generateMips) {
+		m_Recording.mipChains.push_back({image, regions[0].imageExtent, subresourceRange.levelCount, subresourceRange.layerCount, finalLayout});
+		// On the same family the blits follow the copies in the same command buffer, nothing to hand over
+		if(!m_SeparateFamilies) return;
+	}
+
+	// The transition to the final layout is recorded with the rest of the batch on submit, mip
+	// chains stay in TRANSFER_DST for the blits and are only handed over to the graphics family
+	barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout     = generateMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : finalLayout;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	if(m_SeparateFamilies) {
+		barrier.srcQueueFamilyIndex = m_TransferFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+	}
+	m_Recording.imageBarriers.push_back(barrier);
+}
+
+uint64_t UploadQueue::Submit() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return SubmitLocked();
+}
+
+/**
+ * @brief Submits the batch that is being recorded.
+ *
+ * @return Timeline value that is reached once every upload recorded so far is done
+ */
+uint64_t UploadQueue::SubmitLocked() {
+	if(m_Recording.empty) return m_NextValue;
+
+	VkCommandBuffer transferCommandBuffer = m_Recording.transferCommandBuffer;
+	if(m_SeparateFamilies) {
+		// Release: only the source half of the ownership transfer, the graphics queue does the acquire
+		vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, static_cast<uint32_t>(m_Recording.bufferBarriers.size()),
+		                     m_Recording.bufferBarriers.data(), static_cast<uint32_t>(m_Recording.imageBarriers.size()), m_Recording.imageBarriers.data());
+	}
+	else {
+		RecordMipChains(transferCommandBuffer);
+
+		VkMemoryBarrier memoryBarrier {};
+		memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = UPLOAD_DST_ACCESS;
+		for(auto& barrier : m_Recording.imageBarriers) barrier.dstAccessMask = UPLOAD_DST_ACCESS;
+		vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr,
+		                     static_cast<uint32_t>(m_Recording.imageBarriers.size()), m_Recording.imageBarriers.data());
+	}
+	vkEndCommandBuffer(transferCommandBuffer);
+
+	// Both submissions of a batch use the same value, m_Timeline is signalled by the one that finishes the batch
+	uint64_t value = ++m_NextValue;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+	timelineInfo.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.signalSemaphoreValueCount     = 1;
+	timelineInfo.pSignalSemaphoreValues        = &value;
+
+	VkSubmitInfo submitInfo         = {};
+	submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext                = &timelineInfo;
+	submitInfo.commandBufferCount   = 1;
+	submitInfo.pCommandBuffers      = &transferCommandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores    = m_SeparateFamilies ? &m_TransferTimeline : &m_Timeline;
+
+	if(m_SeparateFamilies) {
+		{
+			std::lock_guard<std::mutex> queueLock(m_Device.GetTransferQueueMutex());
+			if(vkQueueSubmit(m_Device.GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) { throw std::runtime_error("failed to submit upload batch!"); }
+		}
+
+		// Acquire on the graphics queue, waits for the copies on the GPU only
+		VkCommandBuffer acquireCommandBuffer = m_Recording.acquireCommandBuffer;
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(acquireCommandBuffer, &beginInfo);
+
+		for(auto& barrier : m_Recording.bufferBarriers) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = UPLOAD_DST_ACCESS;
+		}
+		for(auto& barrier : m_Recording.imageBarriers) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = UPLOAD_DST_ACCESS;
+		}
+		vkCmdPipelineBarrier(acquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, static_cast<uint32_t>(m_Recording.bufferBarriers.size()),
+		                     m_Recording.bufferBarriers.data(), static_cast<uint32_t>(m_Recording.imageBarriers.size()), m_Recording.imageBarriers.data());
+		RecordMipChains(acquireCommandBuffer);
+		vkEndCommandBuffer(acquireCommandBuffer);
+
+		VkPipelineStageFlags waitStage       = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues    = &value;
+
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores    = &m_TransferTimeline;
+		submitInfo.pWaitDstStageMask  = &waitStage;
+		submitInfo.pCommandBuffers    = &acquireCommandBuffer;
+		submitInfo.pSignalSemaphores  = &m_Timeline;
+
+		std::lock_guard<std::mutex> queueLock(m_Device.GetGraphicsQueueMutex());
+		if(vkQueueSubmit(m_Device.GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) { throw std::runtime_error("failed to submit upload acquire!"); }
+	}
+	else {
+		// Same family means the transfer queue is the graphics queue
+		std::lock_guard<std::mutex> queueLock(m_Device.GetGraphicsQueueMutex());
+		if(vkQueueSubmit(m_Device.GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) { throw std::runtime_error("failed to submit upload batch!"); }
+	}
+
+	m_Recording.value = value;
+	m_InFlight.push_back(std::move(m_Recording));
+	m_Recording = {};
+	BeginBatch();
+
+	Retire(false);
+	return m_NextValue;
+}
+
+/**
+ * @brief Blits the mip chains of every image in the batch down from level 0. All images take each step together,
+ * so there is one barrier per level instead of one per level and image.
+ */
+void UploadQueue::RecordMipChains(VkCommandBuffer commandBuffer) {
+	if(m_Recording.mipChains.empty()) return;
+
+	auto levelBarrier = [](const MipChain& chain, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+		VkImageMemoryBarrier barrier {};
+		barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout           = oldLayout;
+		barrier.newLayout           = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image               = chain.image;
+		barrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, chain.layerCount};
+		barrier.srcAccessMask       = srcAccess;
+		barrier.dstAccessMask       = dstAccess;
+		return barrier;
+	};
+
+	uint32_t maxLevelCount = 0;
+	for(const MipChain& chain : m_Recording.mipChains) maxLevelCount = std::max(maxLevelCount, chain.levelCount);
+
+	std::vector<VkImageMemoryBarrier> barriers;
+	for(uint32_t level = 1; level < maxLevelCount; level++) {
+		// The previous level was just written, it becomes the source of this one
+		barriers.clear();
+		for(const MipChain& chain : m_Recording.mipChains) {
+			if(level < chain.levelCount) {
+				barriers.push_back(levelBarrier(chain, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+			}
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		for(const MipChain& chain : m_Recording.mipChains) {
+			if(level >= chain.levelCount) continue;
+
+			VkImageBlit blit {};
+			blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, chain.layerCount};
+			blit.srcOffsets[1]  = {static_cast<int32_t>(std::max(chain.extent.width >> (level - 1), 1u)), static_cast<int32_t>(std::max(chain.extent.height >> (level - 1), 1u)), 1};
+			blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, chain.layerCount};
+			blit.dstOffsets[1]  = {static_cast<int32_t>(std::max(chain.extent.width >> level, 1u)), static_cast<int32_t>(std::max(chain.extent.height >> level, 1u)), 1};
+			vkCmdBlitImage(commandBuffer, chain.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, chain.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		}
+	}
+
+	// Every level but the last one was a blit source, the last one was only written
+	barriers.clear();
+	for(const MipChain& chain : m_Recording.mipChains) {
+		if(chain.levelCount > 1) {
+			barriers.push_back(levelBarrier(chain, 0, chain.levelCount - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, chain.finalLayout, VK_ACCESS_TRANSFER_READ_BIT, UPLOAD_DST_ACCESS));
+		}
+		barriers.push_back(levelBarrier(chain, chain.levelCount - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, chain.finalLayout, VK_ACCESS_TRANSFER_WRITE_BIT, UPLOAD_DST_ACCESS));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+bool UploadQueue::IsComplete(uint64_t value) {
+	uint64_t completed = 0;
+	vkGetSemaphoreCounterValue(m_Device.GetDevice(), m_Timeline, &completed);
+	return completed >= value;
+}
+
+void UploadQueue::Wait(uint64_t value) {
+	{
+		// Waiting for something that was never submitted would block forever
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if(value > m_NextValue) SubmitLocked();
+	}
+
+	VkSemaphoreWaitInfo waitInfo {};
+	waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores    = &m_Timeline;
+	waitInfo.pValues        = &value;
+	vkWaitSemaphores(m_Device.GetDevice(), &waitInfo, UINT64_MAX);
+}
+
+void UploadQueue::WaitIdle() {
+	uint64_t value = Submit();
+	Wait(value);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Retire(false);
+}
+
+void UploadQueue::BeginBatch() {
+	if(!m_FreeBatches.empty()) {
+		m_Recording = std::move(m_FreeBatches.back());
+		m_FreeBatches.pop_back();
+	}
+	else {
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool        = m_TransferCommandPool;
+		allocInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(m_Device.GetDevice(), &allocInfo, &m_Recording.transferCommandBuffer);
+
+		if(m_SeparateFamilies) {
+			allocInfo.commandPool = m_AcquireCommandPool;
+			vkAllocateCommandBuffers(m_Device.GetDevice(), &allocInfo, &m_Recording.acquireCommandBuffer);
+		}
+	}
+
+	m_Recording.empty     = true;
+	m_Recording.value     = 0;
+	m_Recording.ringBytes = 0;
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(m_Recording.transferCommandBuffer, &beginInfo);
+}
+
+/**
+ * @brief Recycles batches the GPU is done with. Batches finish in submission order so their staging
+ * ranges are always the oldest part of the ring.
+ *
+ * @param wait Block until at least the oldest in-flight batch is done
+ */
+void UploadQueue::Retire(bool wait) {
+	if(wait && !m_InFlight.empty()) {
+		uint64_t value = m_InFlight.front().value;
+		VkSemaphoreWaitInfo waitInfo {};
+		waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores    = &m_Timeline;
+		waitInfo.pValues        = &value;
+		vkWaitSemaphores(m_Device.GetDevice(), &waitInfo, UINT64_MAX);
+	}
+
+	uint64_t completed = 0;
+	vkGetSemaphoreCounterValue(m_Device.GetDevice(), m_Timeline, &completed);
+
+	while(!m_InFlight.empty() && m_InFlight.front().value <= completed) {
+		Batch batch = std::move(m_InFlight.front());
+		m_InFlight.pop_front();
+
+		m_RingUsed -= batch.ringBytes;
+		batch.temporaryBuffers.clear();
+		batch.bufferBarriers.clear();
+		batch.imageBarriers.clear();
+		batch.mipChains.clear();
+		vkResetCommandBuffer(batch.transferCommandBuffer, 0);
+		if(batch.acquireCommandBuffer != VK_NULL_HANDLE) vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+		m_FreeBatches.push_back(std::move(batch));
+	}
+
+	if(m_RingUsed == 0) m_RingHead = 0;
+}
+
+/**
+ * @brief Reserves `size` bytes of staging memory for the batch being recorded.
+ * When the ring is full the oldest batches are waited for (submitting the current one if it is the only user).
+ */
+void UploadQueue::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer& buffer, VkDeviceSize& offset, void*& mapped) {
+	// Huge uploads would stall the ring for everyone, give them their own staging buffer that dies with the batch
+	if(size > RING_SIZE / 4) {
+		auto staging = std::make_unique<Buffer>(m_Device, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		staging->Map();
+		buffer = staging->GetBuffer();
+		offset = 0;
+		mapped = staging->GetMappedMemory();
+		m_Recording.temporaryBuffers.push_back(std::move(staging));
+		return;
+	}
+
+	while(true) {
+		VkDeviceSize start = AlignUp(m_RingHead, alignment);
+		VkDeviceSize needed;
+		if(start + size <= RING_SIZE) { needed = start - m_RingHead + size; }
+		else {
+			// Does not fit before the end, skip the tail of the ring and wrap around
+			start  = 0;
+			needed = RING_SIZE - m_RingHead + size;
+		}
+
+		if(m_RingUsed + needed <= RING_SIZE) {
+			m_RingHead = start + size;
+			m_RingUsed += needed;
+			m_Recording.ringBytes += needed;
+
+			buffer = m_Ring->GetBuffer();
+			offset = start;
+			mapped = static_cast<char*>(m_Ring->GetMappedMemory()) + start;
+			return;
+		}
+
+		if(!m_InFlight.empty()) { Retire(true); }
+		else {
+			ASSERT(!m_Recording.empty);    // Ring is full but nothing uses it
+			SubmitLocked();
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "buffer.h"
+#include "device.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Batched, non-blocking uploads of buffer and image data.
+ *
+ * Data is copied into a persistently mapped staging ring and the copies are recorded into the
+ * current batch. Submit() sends the whole batch at once (to the dedicated transfer queue if the
+ * device has one) and returns a timeline semaphore value, IsComplete/Wait can then be used to
+ * find out when the data has landed. Staging space is recycled once the batch that used it
+ * completed, uploads bigger than a quarter of the ring get their own temporary staging buffer.
+ *
+ * With a separate transfer family the resources are released on the transfer queue and
+ * acquired on the graphics queue by a small second submission that waits on the transfer one.
+ * The returned value is only reached once that acquire (and any mip blits) ran.
+ *
+ * Images can ask for their mip chain to be generated from level 0. Blits need a graphics queue, so
+ * they are recorded for the whole batch at once on submit, into the transfer command buffer when it
+ * runs on the graphics family and into the acquire command buffer otherwise.
+ */
+class UploadQueue {
+public:
+	UploadQueue(Device& device);
+	~UploadQueue();
+
+	UploadQueue(const UploadQueue&)            = delete;
+	UploadQueue& operator=(const UploadQueue&) = delete;
+
+	void UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+	void UploadImage(VkImage image, const void* data, VkDeviceSize size, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange,
+	                 VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, bool generateMips = false);
+
+	uint64_t Submit();
+	bool IsComplete(uint64_t value);
+	void Wait(uint64_t value);
+	void WaitIdle();
+
+	inline bool HasDedicatedTransferQueue() const { return m_SeparateFamilies; }
+
+private:
+	static constexpr VkDeviceSize RING_SIZE = 32ull * 1024 * 1024;
+
+	struct MipChain {
+		VkImage image;
+		VkExtent3D extent;
+		uint32_t levelCount;
+		uint32_t layerCount;
+		VkImageLayout finalLayout;
+	};
+
+	struct Batch {
+		VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer acquireCommandBuffer  = VK_NULL_HANDLE;
+		uint64_t value                        = 0;
+		VkDeviceSize ringBytes                = 0;
+		bool empty                            = true;
+		std::vector<std::unique_ptr<Buffer>> temporaryBuffers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::vector<MipChain> mipChains;
+	};
+
+	void BeginBatch();
+	void Retire(bool wait);
+	void AllocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer& buffer, VkDeviceSize& offset, void*& mapped);
+	uint64_t SubmitLocked();
+	void RecordMipChains(VkCommandBuffer commandBuffer);
+
+	Device& m_Device;
+	uint32_t m_TransferFamily;
+	uint32_t m_GraphicsFamily;
+	bool m_SeparateFamilies;
+
+	VkCommandPool m_TransferCommandPool;
+	VkCommandPool m_AcquireCommandPool = VK_NULL_HANDLE;
+	VkSemaphore m_Timeline;                            // reached once a batch is usable on the graphics queue
+	VkSemaphore m_TransferTimeline = VK_NULL_HANDLE;    // copies done, only with separate families
+	uint64_t m_NextValue           = 0;                 // last value handed to a batch
+
+	std::unique_ptr<Buffer> m_Ring;
+	VkDeviceSize m_RingHead = 0;
+	VkDeviceSize m_RingUsed = 0;
+
+	Batch m_Recording;
+	std::deque<Batch> m_InFlight;
+	std::vector<Batch> m_FreeBatches;
+
+	std::mutex m_Mutex;
+};
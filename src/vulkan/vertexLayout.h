@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+/**
+ * @brief One vertex attribute: the C++ type that is stored in the vertex and the format the shader reads it as
+ */
+template <typename T, VkFormat Format> struct VertexAttribute {
+	using Type                      = T;
+	static constexpr VkFormat format = Format;
+};
+
+/**
+ * @brief Compile time vertex input description of a tightly packed vertex.
+ *
+ * Attributes get consecutive locations and offsets in the order they are listed, so the vertex
+ * struct has to declare its members in the same order without padding. Use
+ * static_assert(sizeof(Vertex) == Layout::STRIDE) next to the struct to catch mismatches.
+ */
+template <typename... Attributes> struct VertexLayout {
+	static constexpr uint32_t ATTRIBUTE_COUNT = sizeof...(Attributes);
+	static constexpr uint32_t STRIDE          = (static_cast<uint32_t>(sizeof(typename Attributes::Type)) + ...);
+
+	static constexpr VkVertexInputBindingDescription BINDING = {0, STRIDE, VK_VERTEX_INPUT_RATE_VERTEX};
+
+	static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> ATTRIBUTES = []() {
+		std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> attributes {};
+		constexpr std::array<VkFormat, ATTRIBUTE_COUNT> formats {Attributes::format...};
+		constexpr std::array<uint32_t, ATTRIBUTE_COUNT> sizes {static_cast<uint32_t>(sizeof(typename Attributes::Type))...};
+
+		uint32_t offset = 0;
+		for(uint32_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+			attributes[i] = {i, 0, formats[i], offset};
+			offset += sizes[i];
+		}
+		return attributes;
+	}();
+
+	static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions() { return {BINDING}; }
+
+	static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() { return {ATTRIBUTES.begin(), ATTRIBUTES.end()}; }
+};
@@ -2,7 +2,10 @@
 
 #include <stdexcept>
 
-Window::Window(int width, int height, std::string name): m_Width(width), m_Height(height), m_Name(name) {
+Window::Window(int width, int height, std::string name, bool headless): m_Width(width), m_Height(height), m_Name(name) {
+	// GLFW isn't even initialized, it fails without a display
+	if(headless) return;
+
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
@@ -13,11 +16,14 @@ Window::Window(int width, int height, std::string name): m_Width(width), m_Heigh
 }
 
 Window::~Window() {
+	if(IsHeadless()) return;
+
 	glfwDestroyWindow(m_Window);
 	glfwTerminate();
 }
 
 void Window::CreateWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
+	if(IsHeadless()) { throw std::runtime_error("a headless window has no surface"); }
 	if(glfwCreateWindowSurface(instance, m_Window, nullptr, surface) != VK_SUCCESS) { throw std::runtime_error("failed to create window surface"); }
 }
 
@@ -8,7 +8,8 @@
 
 class Window {
 public:
-	Window(int width, int height, std::string name);
+	// A headless window has no GLFW window and no surface, the swapchain renders into offscreen images instead
+	Window(int width, int height, std::string name, bool headless = false);
 	~Window();
 
 	Window(const Window&)            = delete;
@@ -20,7 +21,11 @@ public:
 
 	inline void ResetWindowResizedFlag() { m_Resized = false; }
 
-	inline bool ShouldClose() { return glfwWindowShouldClose(m_Window); }
+	inline bool ShouldClose() { return m_CloseRequested || (m_Window != nullptr && glfwWindowShouldClose(m_Window)); }
+
+	inline void Close() { m_CloseRequested = true; }
+
+	inline bool IsHeadless() const { return m_Window == nullptr; }
 
 	inline VkExtent2D GetExtent() { return {static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height)}; }
 
@@ -32,7 +37,8 @@ private:
 	int m_Width;
 	int m_Height;
 	std::string m_Name;
-	bool m_Resized = false;
+	bool m_Resized        = false;
+	bool m_CloseRequested = false;
 
-	GLFWwindow* m_Window;
+	GLFWwindow* m_Window = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "assetPack.h"
+#include "lz4.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+        Packs folders into a single AssetPack, the paths inside are stored relative to <root>. The game mounts
+        "../../assets.pack" with "../../" as its root, so the pack for it is built from the repository root
+
+            AssetPacker assets.pack . assets shaders/spv --exclude assets/cache
+
+        The caches in assets/cache are written by the game for the machine it runs on, and a stale one in the pack
+        would shadow the loose file the game rewrites, so they are left out.
+*/
+
+struct PackedFile {
+	std::string name;    // Relative to the root, with forward slashes
+	std::filesystem::path path;
+	std::vector<uint8_t> compressed;    // Empty if the file is stored as is
+	AssetPackEntry entry {};
+};
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+static void PrintUsage() { std::cout << "usage: AssetPacker <output.pack> <root> <directory>... [--exclude <directory>]... [--no-compress]\n"; }
+
+int main(int argc, char** argv) {
+	if(argc < 4) {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path output = argv[1];
+	const std::filesystem::path root   = argv[2];
+	bool compress                      = true;
+	std::vector<std::filesystem::path> directories;
+	std::vector<std::filesystem::path> excluded;
+	for(int i = 3; i < argc; i++) {
+		std::string argument = argv[i];
+		if(argument == "--no-compress") compress = false;
+		else if(argument == "--exclude" && i + 1 < argc) excluded.push_back((root / argv[++i]).lexically_normal());
+		else directories.push_back(root / argument);
+	}
+
+	try {
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<PackedFile> files;
+		for(const auto& directory : directories) {
+			if(!std::filesystem::is_directory(directory)) throw std::runtime_error("failed to pack, " + directory.string() + " is not a directory!");
+
+			for(auto it = std::filesystem::recursive_directory_iterator(directory); it != std::filesystem::recursive_directory_iterator(); ++it) {
+				const auto& item = *it;
+				if(item.is_directory() && std::find(excluded.begin(), excluded.end(), item.path().lexically_normal()) != excluded.end()) {
+					it.disable_recursion_pending();
+					continue;
+				}
+
+				// Half written caches of a running game
+				if(!item.is_regular_file() || item.path().extension() == ".tmp") continue;
+
+				PackedFile file;
+				file.path = item.path();
+				file.name = item.path().lexically_relative(root).generic_string();
+				files.push_back(std::move(file));
+			}
+		}
+
+		std::vector<char> names;
+		for(auto& file : files) {
+			file.entry.pathHash   = AssetPack::HashPath(file.name);
+			file.entry.nameOffset = static_cast<uint32_t>(names.size());
+			file.entry.nameLength = static_cast<uint32_t>(file.name.size());
+			names.insert(names.end(), file.name.begin(), file.name.end());
+		}
+		// The order AssetPack::Find searches in
+		std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.entry.pathHash != b.entry.pathHash ? a.entry.pathHash < b.entry.pathHash : a.name < b.name; });
+
+		uint64_t offset    = AssetPack::ALIGNMENT;
+		uint64_t totalSize = 0, storedSize = 0;
+		for(auto& file : files) {
+			MappedFile source;
+			bool empty = !source.Open(file.path.string());
+			if(empty && std::filesystem::file_size(file.path) != 0) throw std::runtime_error("failed to read " + file.path.string() + "!");
+			file.entry.size = empty ? 0 : source.GetSize();
+
+			// Only worth the decompression at load time if it saves a noticeable amount of reading
+			if(compress && !empty) {
+				file.compressed = Lz4::Compress(source.GetData(), source.GetSize());
+				if(file.compressed.size() > source.GetSize() - source.GetSize() / 8) file.compressed = {};
+			}
+
+			file.entry.compression = file.compressed.empty() ? AssetPack::COMPRESSION_NONE : AssetPack::COMPRESSION_LZ4;
+			file.entry.storedSize  = file.compressed.empty() ? file.entry.size : file.compressed.size();
+			file.entry.offset      = offset;
+			offset                 = AlignUp(offset + file.entry.storedSize, AssetPack::ALIGNMENT);
+
+			totalSize += file.entry.size;
+			storedSize += file.entry.storedSize;
+		}
+
+		AssetPackHeader header {};
+		header.magic       = AssetPack::MAGIC;
+		header.version     = AssetPack::VERSION;
+		header.entryCount  = static_cast<uint32_t>(files.size());
+		header.alignment   = static_cast<uint32_t>(AssetPack::ALIGNMENT);
+		header.tocOffset   = offset;
+		header.namesOffset = header.tocOffset + files.size() * sizeof(AssetPackEntry);
+		header.namesSize   = names.size();
+
+		// Written under a temporary name so a running game never maps a half written pack
+		std::filesystem::path temporaryPath = output;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream pack(temporaryPath, std::ios::binary | std::ios::trunc);
+			if(!pack) throw std::runtime_error("failed to create " + temporaryPath.string() + "!");
+
+			auto writeAt = [&](uint64_t position, const void* blob, uint64_t blobSize) {
+				static const char zeros[4096] = {};
+				for(uint64_t current = static_cast<uint64_t>(pack.tellp()); current < position; current = static_cast<uint64_t>(pack.tellp())) {
+					pack.write(zeros, static_cast<std::streamsize>(std::min<uint64_t>(position - current, sizeof(zeros))));
+				}
+				pack.write(static_cast<const char*>(blob), static_cast<std::streamsize>(blobSize));
+			};
+			writeAt(0, &header, sizeof(header));
+
+			for(const auto& file : files) {
+				if(!file.compressed.empty()) writeAt(file.entry.offset, file.compressed.data(), file.compressed.size());
+				else if(file.entry.size > 0) {
+					MappedFile source;
+					if(!source.Open(file.path.string())) throw std::runtime_error("failed to read " + file.path.string() + "!");
+					writeAt(file.entry.offset, source.GetData(), source.GetSize());
+				}
+			}
+
+			std::vector<AssetPackEntry> entries;
+			for(const auto& file : files) entries.push_back(file.entry);
+			writeAt(header.tocOffset, entries.data(), entries.size() * sizeof(AssetPackEntry));
+			writeAt(header.namesOffset, names.data(), names.size());
+
+			if(!pack) throw std::runtime_error("failed to write " + temporaryPath.string() + "!");
+		}
+		std::filesystem::rename(temporaryPath, output);
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << output.string() << ": " << files.size() << " files, " << totalSize / 1024 << " KiB stored as " << storedSize / 1024 << " KiB, pack " << std::filesystem::file_size(output) / 1024
+		          << " KiB, " << seconds << " s" << std::endl;
+	} catch(const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
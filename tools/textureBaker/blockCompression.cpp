@@ -0,0 +1,341 @@
+#include "blockCompression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+static constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+namespace {
+	/**
+	 * @brief Writes fields into a block, least significant bit first like all BC formats
+	 */
+	struct BitWriter {
+		uint8_t* bytes;
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bitCount) {
+			for(uint32_t i = 0; i < bitCount; i++, position++) {
+				if(value & (1u << i)) bytes[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+			}
+		}
+	};
+
+	struct Bc7Endpoints {
+		int quantized[2][4];    // 7 bit
+		int pBit[2];
+		int expanded[2][4];     // 8 bit, what the decoder interpolates between
+	};
+
+	struct Bc7Candidate {
+		Bc7Endpoints endpoints;
+		uint8_t indices[16];
+		float error = INFINITY;
+	};
+}
+
+static void QuantizeBc7(const float endpoints[2][4], int pBit0, int pBit1, Bc7Endpoints& out) {
+	out.pBit[0] = pBit0;
+	out.pBit[1] = pBit1;
+	for(int e = 0; e < 2; e++) {
+		for(int c = 0; c < 4; c++) {
+			int quantized       = static_cast<int>(std::lround((endpoints[e][c] - out.pBit[e]) * 0.5f));
+			out.quantized[e][c] = std::clamp(quantized, 0, 127);
+			out.expanded[e][c]  = (out.quantized[e][c] << 1) | out.pBit[e];
+		}
+	}
+}
+
+/**
+ * @brief Picks the closest of the 16 interpolated colors for every texel, returns the summed squared error
+ */
+static float AssignBc7Indices(const float texels[16][4], const Bc7Endpoints& endpoints, uint8_t indices[16]) {
+	float palette[16][4];
+	for(int i = 0; i < 16; i++) {
+		for(int c = 0; c < 4; c++) palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * endpoints.expanded[0][c] + BC7_WEIGHTS[i] * endpoints.expanded[1][c] + 32) >> 6);
+	}
+
+	float direction[4], lengthSquared = 0.0f;
+	for(int c = 0; c < 4; c++) {
+		direction[c] = palette[15][c] - palette[0][c];
+		lengthSquared += direction[c] * direction[c];
+	}
+
+	float error = 0.0f;
+	for(int t = 0; t < 16; t++) {
+		// The palette lies on a line, so only the neighbours of the projected position can be the closest
+		int first = 0, last = 15;
+		if(lengthSquared > 0.0f) {
+			float projected = 0.0f;
+			for(int c = 0; c < 4; c++) projected += (texels[t][c] - palette[0][c]) * direction[c];
+			int guess = std::clamp(static_cast<int>(std::lround(projected / lengthSquared * 15.0f)), 0, 15);
+			first     = std::max(guess - 1, 0);
+			last      = std::min(guess + 1, 15);
+		}
+
+		float bestError = INFINITY;
+		for(int i = first; i <= last; i++) {
+			float distance = 0.0f;
+			for(int c = 0; c < 4; c++) distance += (texels[t][c] - palette[i][c]) * (texels[t][c] - palette[i][c]);
+			if(distance < bestError) {
+				bestError  = distance;
+				indices[t] = static_cast<uint8_t>(i);
+			}
+		}
+		error += bestError;
+	}
+	return error;
+}
+
+/**
+ * @brief Tries all four p-bit combinations for the endpoints and keeps the best one in `best`
+ */
+static void TryBc7Endpoints(const float texels[16][4], const float endpoints[2][4], Bc7Candidate& best) {
+	for(int pBits = 0; pBits < 4; pBits++) {
+		Bc7Candidate candidate;
+		QuantizeBc7(endpoints, pBits & 1, pBits >> 1, candidate.endpoints);
+		candidate.error = AssignBc7Indices(texels, candidate.endpoints, candidate.indices);
+		if(candidate.error < best.error) best = candidate;
+	}
+}
+
+void BlockCompression::EncodeBC7(const uint8_t* texels, uint8_t* block) {
+	float colors[16][4];
+	float mean[4] = {};
+	for(int t = 0; t < 16; t++) {
+		for(int c = 0; c < 4; c++) {
+			colors[t][c] = texels[t * 4 + c];
+			mean[c] += colors[t][c] / 16.0f;
+		}
+	}
+
+	// Principal axis of the colors by power iteration on the covariance matrix
+	float covariance[4][4] = {};
+	for(int t = 0; t < 16; t++) {
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++) covariance[i][j] += (colors[t][i] - mean[i]) * (colors[t][j] - mean[j]);
+		}
+	}
+	float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+	for(int iteration = 0; iteration < 8; iteration++) {
+		float next[4] = {}, length = 0.0f;
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++) next[i] += covariance[i][j] * axis[j];
+			length = std::max(length, std::abs(next[i]));
+		}
+		if(length == 0.0f) break;
+		for(int i = 0; i < 4; i++) axis[i] = next[i] / length;
+	}
+
+	float minimum = INFINITY, maximum = -INFINITY, axisLength = 0.0f;
+	for(int c = 0; c < 4; c++) axisLength += axis[c] * axis[c];
+	for(int t = 0; t < 16; t++) {
+		float projected = 0.0f;
+		for(int c = 0; c < 4; c++) projected += (colors[t][c] - mean[c]) * axis[c];
+		minimum = std::min(minimum, projected / axisLength);
+		maximum = std::max(maximum, projected / axisLength);
+	}
+
+	float endpoints[2][4];
+	for(int c = 0; c < 4; c++) {
+		endpoints[0][c] = std::clamp(mean[c] + axis[c] * minimum, 0.0f, 255.0f);
+		endpoints[1][c] = std::clamp(mean[c] + axis[c] * maximum, 0.0f, 255.0f);
+	}
+
+	Bc7Candidate best;
+	TryBc7Endpoints(colors, endpoints, best);
+
+	// Least squares fit of the endpoints to the chosen weights, once the weights settle this stops improving
+	for(int iteration = 0; iteration < 2 && best.error > 0.0f; iteration++) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = {}, bx[4] = {};
+		for(int t = 0; t < 16; t++) {
+			float b = BC7_WEIGHTS[best.indices[t]] / 64.0f;
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for(int c = 0; c < 4; c++) {
+				ax[c] += a * colors[t][c];
+				bx[c] += b * colors[t][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if(std::abs(determinant) < 1e-6f) break;
+
+		for(int c = 0; c < 4; c++) {
+			endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+		TryBc7Endpoints(colors, endpoints, best);
+	}
+
+	// The first index is stored with one bit less, its top bit has to be 0
+	Bc7Endpoints& chosen = best.endpoints;
+	if(best.indices[0] >= 8) {
+		std::swap(chosen.quantized[0], chosen.quantized[1]);
+		std::swap(chosen.pBit[0], chosen.pBit[1]);
+		for(uint8_t& index : best.indices) index = static_cast<uint8_t>(15 - index);
+	}
+
+	std::memset(block, 0, 16);
+	BitWriter writer {block};
+	writer.Write(1u << 6, 7);    // mode 6
+	for(int c = 0; c < 4; c++) {
+		writer.Write(chosen.quantized[0][c], 7);
+		writer.Write(chosen.quantized[1][c], 7);
+	}
+	writer.Write(chosen.pBit[0], 1);
+	writer.Write(chosen.pBit[1], 1);
+	writer.Write(best.indices[0], 3);
+	for(int t = 1; t < 16; t++) writer.Write(best.indices[t], 4);
+}
+
+/**
+ * @brief Palette of a BC4 block, exactly how the decoder computes it
+ */
+static void GetBc4Palette(int endpoint0, int endpoint1, float palette[8]) {
+	palette[0] = static_cast<float>(endpoint0);
+	palette[1] = static_cast<float>(endpoint1);
+	if(endpoint0 > endpoint1) {
+		for(int i = 2; i < 8; i++) palette[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1) / 7.0f;
+	}
+	else {
+		for(int i = 2; i < 6; i++) palette[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1) / 5.0f;
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+}
+
+static float AssignBc4Indices(const float values[16], int endpoint0, int endpoint1, uint8_t indices[16]) {
+	float palette[8];
+	GetBc4Palette(endpoint0, endpoint1, palette);
+
+	float error = 0.0f;
+	for(int t = 0; t < 16; t++) {
+		float bestError = INFINITY;
+		for(int i = 0; i < 8; i++) {
+			float distance = (values[t] - palette[i]) * (values[t] - palette[i]);
+			if(distance < bestError) {
+				bestError  = distance;
+				indices[t] = static_cast<uint8_t>(i);
+			}
+		}
+		error += bestError;
+	}
+	return error;
+}
+
+void BlockCompression::EncodeBC4(const uint8_t* texels, uint32_t channel, uint8_t* block) {
+	float values[16];
+	float minimum = 255.0f, maximum = 0.0f;
+	float innerMinimum = 255.0f, innerMaximum = 0.0f;    // without pure black and white
+	for(int t = 0; t < 16; t++) {
+		values[t] = texels[t * 4 + channel];
+		minimum   = std::min(minimum, values[t]);
+		maximum   = std::max(maximum, values[t]);
+		if(values[t] > 0.0f && values[t] < 255.0f) {
+			innerMinimum = std::min(innerMinimum, values[t]);
+			innerMaximum = std::max(innerMaximum, values[t]);
+		}
+	}
+
+	int bestEndpoints[2] = {static_cast<int>(maximum), static_cast<int>(minimum)};
+	uint8_t bestIndices[16];
+	float bestError = AssignBc4Indices(values, bestEndpoints[0], bestEndpoints[1], bestIndices);
+
+	auto tryEndpoints = [&](int endpoint0, int endpoint1) {
+		uint8_t indices[16];
+		float error = AssignBc4Indices(values, endpoint0, endpoint1, indices);
+		if(error < bestError) {
+			bestError        = error;
+			bestEndpoints[0] = endpoint0;
+			bestEndpoints[1] = endpoint1;
+			std::memcpy(bestIndices, indices, sizeof(indices));
+		}
+	};
+
+	// Least squares refit of the 8 step mode, the endpoints have to stay ordered to keep the mode
+	if(bestError > 0.0f && maximum > minimum) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax = 0.0f, bx = 0.0f;
+		for(int t = 0; t < 16; t++) {
+			float b = bestIndices[t] == 0 ? 0.0f : bestIndices[t] == 1 ? 1.0f : (bestIndices[t] - 1) / 7.0f;
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			ax += a * values[t];
+			bx += b * values[t];
+		}
+		float determinant = aa * bb - ab * ab;
+		if(std::abs(determinant) > 1e-6f) {
+			int endpoint0 = std::clamp(static_cast<int>(std::lround((ax * bb - bx * ab) / determinant)), 0, 255);
+			int endpoint1 = std::clamp(static_cast<int>(std::lround((bx * aa - ax * ab) / determinant)), 0, 255);
+			if(endpoint0 > endpoint1) tryEndpoints(endpoint0, endpoint1);
+		}
+	}
+
+	// 6 step mode, 0 and 255 come for free
+	if(bestError > 0.0f && (minimum == 0.0f || maximum == 255.0f)) {
+		if(innerMinimum > innerMaximum) tryEndpoints(0, 0);
+		else tryEndpoints(static_cast<int>(innerMinimum), static_cast<int>(innerMaximum));
+	}
+
+	std::memset(block, 0, 8);
+	BitWriter writer {block};
+	writer.Write(bestEndpoints[0], 8);
+	writer.Write(bestEndpoints[1], 8);
+	for(int t = 0; t < 16; t++) writer.Write(bestIndices[t], 3);
+}
+
+void BlockCompression::EncodeBC5(const uint8_t* texels, uint8_t* block) {
+	EncodeBC4(texels, 0, block);
+	EncodeBC4(texels, 1, block + 8);
+}
+
+std::vector<uint8_t> BlockCompression::Compress(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t threadCount) {
+	uint32_t blockSize;
+	switch(format) {
+		case VK_FORMAT_BC4_UNORM_BLOCK: blockSize = 8; break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK: blockSize = 16; break;
+		default: throw std::runtime_error("failed to compress, unsupported format!");
+	}
+
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	std::vector<uint8_t> blocks(size_t(blocksX) * blocksY * blockSize);
+
+	// Rows of blocks are handed out one at a time, small mips are done by the first thread to get there
+	std::atomic<uint32_t> nextRow {0};
+	auto worker = [&]() {
+		uint8_t texels[64];
+		for(uint32_t by = nextRow++; by < blocksY; by = nextRow++) {
+			for(uint32_t bx = 0; bx < blocksX; bx++) {
+				for(uint32_t t = 0; t < 16; t++) {
+					uint32_t x = std::min(bx * 4 + t % 4, width - 1);
+					uint32_t y = std::min(by * 4 + t / 4, height - 1);
+					std::memcpy(texels + t * 4, pixels + (size_t(y) * width + x) * 4, 4);
+				}
+
+				uint8_t* block = blocks.data() + (size_t(by) * blocksX + bx) * blockSize;
+				if(format == VK_FORMAT_BC4_UNORM_BLOCK) EncodeBC4(texels, 0, block);
+				else if(format == VK_FORMAT_BC5_UNORM_BLOCK) EncodeBC5(texels, block);
+				else EncodeBC7(texels, block);
+			}
+		}
+	};
+
+	if(threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	threadCount = std::min(threadCount, blocksY);
+
+	std::vector<std::thread> threads;
+	for(uint32_t i = 1; i < threadCount; i++) threads.emplace_back(worker);
+	worker();
+	for(auto& thread : threads) thread.join();
+	return blocks;
+}
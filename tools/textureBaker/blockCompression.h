@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * @brief Block compression encoders for the formats baked textures use.
+ *
+ * BC7 blocks are always encoded in mode 6 (one subset, 7 bit RGBA endpoints with a shared p-bit, 16 weights),
+ * endpoints start on the principal axis of the block and are refined by least squares on the chosen weights.
+ * BC4 tries both the 8 step and the 6 step + 0/255 mode, so masks with pure black or white keep them exactly.
+ * BC5 is two independent BC4 blocks for red and green.
+ */
+class BlockCompression {
+public:
+	// `texels` are 16 RGBA8 pixels of a 4x4 block in row order
+	static void EncodeBC7(const uint8_t* texels, uint8_t* block);
+	static void EncodeBC5(const uint8_t* texels, uint8_t* block);
+	static void EncodeBC4(const uint8_t* texels, uint32_t channel, uint8_t* block);
+
+	// Compresses a whole RGBA8 image, partial blocks at the right and bottom repeat the edge pixels
+	static std::vector<uint8_t> Compress(VkFormat format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t threadCount = 0);
+};
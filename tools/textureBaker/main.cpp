@@ -0,0 +1,207 @@
+#include "blockCompression.h"
+#include "textures/ktxFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stbimage/stb_image.h>
+
+/*
+        Bakes source images into block compressed KTX2 textures with a full mip chain. By default the
+        output goes to the "baked" folder next to the (first) source image, where the AssetStreamer
+        looks for it, e.g.
+
+            TextureBaker albedo ../../assets/textures/spaceship_albedo.png
+            TextureBaker normal ../../assets/textures/spaceship_normal.png
+            TextureBaker metallicRoughness ../../assets/textures/spaceship_metalic.png ../../assets/textures/spaceship_roughness.png
+*/
+
+enum class TextureKind { ALBEDO, COLOR, NORMAL, MASK, METALLIC_ROUGHNESS };
+
+struct FloatImage {
+	uint32_t width  = 0;
+	uint32_t height = 0;
+	std::vector<float> pixels;    // RGBA
+};
+
+static float SrgbToLinear(float value) { return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f); }
+
+static float LinearToSrgb(float value) { return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f; }
+
+static FloatImage LoadImage(const std::string& filepath) {
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if(!pixels) throw std::runtime_error("failed to load texture image! " + filepath);
+
+	FloatImage image;
+	image.width  = static_cast<uint32_t>(width);
+	image.height = static_cast<uint32_t>(height);
+	image.pixels.resize(size_t(width) * height * 4);
+	for(size_t i = 0; i < image.pixels.size(); i++) image.pixels[i] = pixels[i] / 255.0f;
+
+	stbi_image_free(pixels);
+	return image;
+}
+
+/**
+ * @brief Converts the source image(s) into the values that are filtered, linear colors or unit normals
+ */
+static FloatImage Prepare(TextureKind kind, const std::vector<std::string>& sources) {
+	FloatImage image = LoadImage(sources[0]);
+	size_t count     = size_t(image.width) * image.height;
+
+	switch(kind) {
+		case TextureKind::ALBEDO:
+			for(size_t i = 0; i < count; i++) {
+				for(int c = 0; c < 3; c++) image.pixels[i * 4 + c] = SrgbToLinear(image.pixels[i * 4 + c]);
+			}
+			break;
+		case TextureKind::NORMAL:
+			for(size_t i = 0; i < count; i++) {
+				for(int c = 0; c < 3; c++) image.pixels[i * 4 + c] = image.pixels[i * 4 + c] * 2.0f - 1.0f;
+			}
+			break;
+		case TextureKind::METALLIC_ROUGHNESS: {
+			// Metallic goes to red and roughness to green, like the shader reads them
+			FloatImage roughness = LoadImage(sources[1]);
+			if(roughness.width != image.width || roughness.height != image.height) throw std::runtime_error("failed to pack, the metallic and roughness maps have different sizes!");
+			for(size_t i = 0; i < count; i++) {
+				image.pixels[i * 4 + 1] = roughness.pixels[i * 4];
+				image.pixels[i * 4 + 2] = 0.0f;
+				image.pixels[i * 4 + 3] = 1.0f;
+			}
+			break;
+		}
+		default: break;
+	}
+	return image;
+}
+
+/**
+ * @brief Box filters the image to half its size, normals are renormalized after averaging
+ */
+static FloatImage Downsample(TextureKind kind, const FloatImage& source) {
+	FloatImage image;
+	image.width  = std::max(source.width / 2, 1u);
+	image.height = std::max(source.height / 2, 1u);
+	image.pixels.resize(size_t(image.width) * image.height * 4);
+
+	for(uint32_t y = 0; y < image.height; y++) {
+		for(uint32_t x = 0; x < image.width; x++) {
+			float* pixel = &image.pixels[(size_t(y) * image.width + x) * 4];
+			for(uint32_t sy = y * 2; sy < std::min(y * 2 + 2, source.height); sy++) {
+				for(uint32_t sx = x * 2; sx < std::min(x * 2 + 2, source.width); sx++) {
+					for(int c = 0; c < 4; c++) pixel[c] += source.pixels[(size_t(sy) * source.width + sx) * 4 + c];
+				}
+			}
+
+			float samples = static_cast<float>((std::min(y * 2 + 2, source.height) - y * 2) * (std::min(x * 2 + 2, source.width) - x * 2));
+			for(int c = 0; c < 4; c++) pixel[c] /= samples;
+
+			if(kind == TextureKind::NORMAL) {
+				float length = std::sqrt(pixel[0] * pixel[0] + pixel[1] * pixel[1] + pixel[2] * pixel[2]);
+				if(length > 1e-6f) {
+					for(int c = 0; c < 3; c++) pixel[c] /= length;
+				}
+				else {
+					pixel[0] = pixel[1] = 0.0f;
+					pixel[2] = 1.0f;
+				}
+			}
+		}
+	}
+	return image;
+}
+
+static std::vector<uint8_t> ToRgba8(TextureKind kind, const FloatImage& image) {
+	std::vector<uint8_t> pixels(image.pixels.size());
+	for(size_t i = 0; i < image.pixels.size(); i++) {
+		float value = image.pixels[i];
+		if(kind == TextureKind::ALBEDO && i % 4 != 3) value = LinearToSrgb(value);
+		if(kind == TextureKind::NORMAL && i % 4 != 3) value = value * 0.5f + 0.5f;
+		pixels[i] = static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+	}
+	return pixels;
+}
+
+static void PrintUsage() {
+	std::cout << "usage: TextureBaker <kind> <image> [<image>] [-o <output.ktx2>] [-j <threads>]\n"
+	             "  albedo             BC7 sRGB\n"
+	             "  color              BC7\n"
+	             "  normal             BC5, x and y of the tangent space normal\n"
+	             "  mask               BC4, red channel\n"
+	             "  metallicRoughness  BC5, metallic (red of the first image) and roughness (red of the second)\n";
+}
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	const std::string kindName = argv[1];
+	TextureKind kind;
+	VkFormat format;
+	if(kindName == "albedo") kind = TextureKind::ALBEDO, format = VK_FORMAT_BC7_SRGB_BLOCK;
+	else if(kindName == "color") kind = TextureKind::COLOR, format = VK_FORMAT_BC7_UNORM_BLOCK;
+	else if(kindName == "normal") kind = TextureKind::NORMAL, format = VK_FORMAT_BC5_UNORM_BLOCK;
+	else if(kindName == "mask") kind = TextureKind::MASK, format = VK_FORMAT_BC4_UNORM_BLOCK;
+	else if(kindName == "metallicRoughness") kind = TextureKind::METALLIC_ROUGHNESS, format = VK_FORMAT_BC5_UNORM_BLOCK;
+	else {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::string> sources;
+	std::string output;
+	uint32_t threadCount = 0;
+	for(int i = 2; i < argc; i++) {
+		std::string argument = argv[i];
+		if(argument == "-o" && i + 1 < argc) output = argv[++i];
+		else if(argument == "-j" && i + 1 < argc) threadCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else sources.push_back(argument);
+	}
+	if(sources.size() != (kind == TextureKind::METALLIC_ROUGHNESS ? 2u : 1u)) {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+	if(output.empty()) output = KtxFile::GetBakedPath(sources);
+
+	try {
+		auto start = std::chrono::steady_clock::now();
+
+		FloatImage image = Prepare(kind, sources);
+		const uint32_t width  = image.width;
+		const uint32_t height = image.height;
+
+		std::vector<std::vector<uint8_t>> levels;
+		uint64_t uncompressedSize = 0;
+		while(true) {
+			std::vector<uint8_t> pixels = ToRgba8(kind, image);
+			uncompressedSize += pixels.size();
+			levels.push_back(BlockCompression::Compress(format, pixels.data(), image.width, image.height, threadCount));
+
+			if(image.width == 1 && image.height == 1) break;
+			image = Downsample(kind, image);
+		}
+
+		if(!KtxFile::Write(output, KtxFile::HashSources(sources), format, width, height, levels)) throw std::runtime_error("failed to write " + output + "!");
+
+		uint64_t compressedSize = 0;
+		for(const auto& level : levels) compressedSize += level.size();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << output << ": " << width << "x" << height << ", " << levels.size() << " mips, " << compressedSize / 1024 << " KiB (RGBA8 " << uncompressedSize / 1024 << " KiB), "
+		          << seconds << " s" << std::endl;
+	} catch(const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}